@@ -272,10 +272,10 @@ void draw_gears(void)
 void init_gears(void)
 {
     static GLfloat pos[4] = {5.f, 5.f, 10.f, 0.f};
-    static GLfloat red[4] = {1.0, 0.0, 0.0, 0.0};
-	static GLfloat green[4] = {0.0, 1.0, 0.0, 0.0};
-	static GLfloat blue[4] = {0.0, 0.0, 1.0, 0.0};
-	static GLfloat white[4] = {1.0, 1.0, 1.0, 0.0};
+    static GLfloat red[4] = {1.0, 0.0, 0.0, 1.0};
+	static GLfloat green[4] = {0.0, 1.0, 0.0, 1.0};
+	static GLfloat blue[4] = {0.0, 0.0, 1.0, 1.0};
+	static GLfloat white[4] = {1.0, 1.0, 1.0, 1.0};
 	static GLfloat shininess = 5;
 
     glLightfv(GL_LIGHT0, GL_POSITION, pos);
@@ -358,56 +358,11 @@ void renderPerformanceData(int frameNumber, double totalFrameTime)
     glMatrixMode(GL_MODELVIEW);
 }
 
-/* Copy TinyGL framebuffer (ARGB8888) to LVGL buffer (XRGB8888), processing 4 pixels at a time */
+/* Copy TinyGL framebuffer to LVGL buffer. Both are ARGB8888 (lv_color32_t is B, G, R, A in memory),
+   and TinyGL writes the fragment alpha, so the canvas composites over the screen as is */
 static void ZB_copyFrameBufferLVGL(ZBuffer *zb, lv_color32_t *lv_buf)
 {
-    uint32_t *q_ptr = (uint32_t *)frameBuffer->pbuf;  // Pointer to TinyGL framebuffer (ARGB8888 format)
-    lv_color32_t *p_ptr = lv_buf;                     // Pointer to LVGL buffer (XRGB8888 format)
-
-    int total_pixels = frameBuffer->xsize * frameBuffer->ysize;
-    int i;
-
-    // Process 4 pixels at a time
-    for (i = 0; i <= total_pixels - 4; i += 4)
-    {
-        // Pixel 1
-        uint32_t pixel1 = q_ptr[i];
-        p_ptr[i].red   = (pixel1 >> 16) & 0xFF;
-        p_ptr[i].green = (pixel1 >> 8) & 0xFF;
-        p_ptr[i].blue  = pixel1 & 0xFF;
-        p_ptr[i].alpha = 0xFF;
-
-        // Pixel 2
-        uint32_t pixel2 = q_ptr[i + 1];
-        p_ptr[i + 1].red   = (pixel2 >> 16) & 0xFF;
-        p_ptr[i + 1].green = (pixel2 >> 8) & 0xFF;
-        p_ptr[i + 1].blue  = pixel2 & 0xFF;
-        p_ptr[i + 1].alpha = 0xFF;
-
-        // Pixel 3
-        uint32_t pixel3 = q_ptr[i + 2];
-        p_ptr[i + 2].red   = (pixel3 >> 16) & 0xFF;
-        p_ptr[i + 2].green = (pixel3 >> 8) & 0xFF;
-        p_ptr[i + 2].blue  = pixel3 & 0xFF;
-        p_ptr[i + 2].alpha = 0xFF;
-
-        // Pixel 4
-        uint32_t pixel4 = q_ptr[i + 3];
-        p_ptr[i + 3].red   = (pixel4 >> 16) & 0xFF;
-        p_ptr[i + 3].green = (pixel4 >> 8) & 0xFF;
-        p_ptr[i + 3].blue  = pixel4 & 0xFF;
-        p_ptr[i + 3].alpha = 0xFF;
-    }
-
-    // Handle any remaining pixels (if total_pixels is not a multiple of 4)
-    for (; i < total_pixels; i++)
-    {
-        uint32_t pixel = q_ptr[i];
-        p_ptr[i].red   = (pixel >> 16) & 0xFF;
-        p_ptr[i].green = (pixel >> 8) & 0xFF;
-        p_ptr[i].blue  = pixel & 0xFF;
-        p_ptr[i].alpha = 0xFF;
-    }
+    memcpy(lv_buf, zb->pbuf, (size_t)zb->xsize * zb->ysize * sizeof(uint32_t));
 }
 
 
@@ -429,8 +384,7 @@ int main(int argc, char **argv)
 
     /* Create the LVGL canvas */
     canvas = lv_canvas_create(lv_scr_act());
-    lv_canvas_set_buffer(canvas, cbuf, CANVAS_WIDTH, CANVAS_HEIGHT, LV_COLOR_FORMAT_NATIVE);
-    lv_canvas_fill_bg(canvas, lv_color_hex3(0x000), LV_OPA_COVER);
+    lv_canvas_set_buffer(canvas, cbuf, CANVAS_WIDTH, CANVAS_HEIGHT, LV_COLOR_FORMAT_ARGB8888);
     lv_obj_center(canvas);
 
     /* Initialize TinyGL framebuffer */
@@ -465,10 +419,10 @@ int main(int argc, char **argv)
     glTranslatef(0.0, 0.0, -20.0);
 
     static GLfloat pos[4] = {5, 5, 10, 0.0}; // Light at infinity.
-	static GLfloat red[4] = {1.0, 0.0, 0.0, 0.0};
-	static GLfloat green[4] = {0.0, 1.0, 0.0, 0.0};
-	static GLfloat blue[4] = {0.0, 0.0, 1.0, 0.0};
-	static GLfloat white[4] = {1.0, 1.0, 1.0, 0.0};
+	static GLfloat red[4] = {1.0, 0.0, 0.0, 1.0};
+	static GLfloat green[4] = {0.0, 1.0, 0.0, 1.0};
+	static GLfloat blue[4] = {0.0, 0.0, 1.0, 1.0};
+	static GLfloat white[4] = {1.0, 1.0, 1.0, 1.0};
 	static GLfloat shininess = 5;
 	glLightfv(GL_LIGHT0, GL_POSITION, pos);
 	glLightfv(GL_LIGHT0, GL_DIFFUSE, white);
@@ -0,0 +1,1119 @@
+/* cases.c */
+/*
+ * Small renders of single features, for the image compare tests.
+ * raw_cases <case> draws one case and writes it to <case>.png. It exits with 1 if a state check of the case failed.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/GL/gl.h"
+#include "../include/zbuffer.h"
+
+#define STBIW_ASSERT(x) /* a comment */
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "../include-demo/stb_image_write.h"
+
+typedef unsigned char uchar;
+
+#ifndef M_PI
+#define M_PI 3.14159265
+#endif
+
+#define SIZE_X 256
+#define SIZE_Y 128
+
+static ZBuffer* frameBuffer = NULL;
+/* state checks that failed, the case fails if there is any */
+static GLint failures = 0;
+
+static void check(GLint ok, const char* what) {
+	if (!ok) {
+		printf("check failed: %s\n", what);
+		failures++;
+	}
+}
+
+/* every depth function against a ramp: one column per function, in GL_NEVER..GL_ALWAYS order */
+static void caseDepthFunc(void) {
+	GLint i;
+	glEnable(GL_DEPTH_TEST);
+	for (i = 0; i < 8; i++) {
+		GLfloat x0 = -1 + i * 0.25f, x1 = x0 + 0.25f;
+		/* the ramp goes from z -0.8 at the bottom to z 0.8 at the top */
+		glDepthFunc(GL_ALWAYS);
+		glBegin(GL_QUADS);
+		glColor3f(0.8f, 0.1f, 0.1f);
+		glVertex3f(x0, -1, -0.8f);
+		glVertex3f(x1, -1, -0.8f);
+		glColor3f(0.1f, 0.1f, 0.8f);
+		glVertex3f(x1, 1, 0.8f);
+		glVertex3f(x0, 1, 0.8f);
+		glEnd();
+		/* a flat quad at z 0 over the middle of the column */
+		glDepthFunc(GL_NEVER + i);
+		glColor3f(0.1f, 0.9f, 0.1f);
+		glRectf(x0 + 0.05f, -0.9f, x1 - 0.05f, 0.9f);
+	}
+	/* the same ramp again passes GL_EQUAL everywhere: the GL_NEVER column turns yellow */
+	glDepthFunc(GL_EQUAL);
+	glDepthMask(GL_FALSE);
+	glColor3f(1, 1, 0);
+	glBegin(GL_QUADS);
+	glVertex3f(-1, -1, -0.8f);
+	glVertex3f(-0.75f, -1, -0.8f);
+	glVertex3f(-0.75f, 1, 0.8f);
+	glVertex3f(-1, 1, 0.8f);
+	glEnd();
+	glDepthMask(GL_TRUE);
+}
+
+/*
+ * blend states over red, green, blue and gray bands, one column each, with the alpha going from 0 on the left of the
+ * column to 1 on its right: GL_ONE, GL_ONE, then GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA and GL_SRC_ALPHA, GL_ONE, which
+ * have their own span writers, and GL_FUNC_REVERSE_SUBTRACT with GL_SRC_ALPHA, GL_ONE, which has not
+ */
+static void caseBlend(void) {
+	static const GLenum factors[4][2] = {{GL_ONE, GL_ONE}, {GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA}, {GL_SRC_ALPHA, GL_ONE}, {GL_SRC_ALPHA, GL_ONE}};
+	GLint i;
+	for (i = 0; i < 4; i++) {
+		glColor3f(i == 0 || i == 3 ? 0.8f : 0.1f, i == 1 || i == 3 ? 0.5f : 0.1f, i == 2 || i == 3 ? 0.8f : 0.1f);
+		glRectf(-1, -1 + i * 0.5f, 1, -0.5f + i * 0.5f);
+	}
+	glEnable(GL_BLEND);
+	for (i = 0; i < 4; i++) {
+		GLfloat x0 = -1 + i * 0.5f, x1 = x0 + 0.45f;
+		glBlendFunc(factors[i][0], factors[i][1]);
+		glBlendEquation(i == 3 ? GL_FUNC_REVERSE_SUBTRACT : GL_FUNC_ADD);
+		glBegin(GL_QUADS);
+		glColor4f(0.2f, 0.6f, 1, 0);
+		glVertex2f(x0, -0.95f);
+		glColor4f(0.2f, 0.6f, 1, 1);
+		glVertex2f(x1, -0.95f);
+		glVertex2f(x1, 0.95f);
+		glColor4f(0.2f, 0.6f, 1, 0);
+		glVertex2f(x0, 0.95f);
+		glEnd();
+	}
+	glBlendEquation(GL_FUNC_ADD);
+	glDisable(GL_BLEND);
+}
+
+/*
+ * the alpha channel of the framebuffer: the clear alpha, a flat quad, a triangle with alpha interpolated from 0 to 1
+ * and a line, then white weighted by it with GL_DST_ALPHA, GL_ZERO, so the render shows the alpha as gray
+ */
+static void caseAlpha(void) {
+	static PIXEL image[SIZE_X * SIZE_Y];
+	glClearColor(0, 0, 0, 0.25f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glColor4f(1, 0, 0, 0.5f);
+	glRectf(-0.9f, -0.8f, -0.4f, 0.8f);
+	glBegin(GL_TRIANGLES);
+	glColor4f(0, 1, 0, 0);
+	glVertex2f(-0.3f, -0.8f);
+	glColor4f(0, 1, 0, 1);
+	glVertex2f(0.4f, -0.8f);
+	glColor4f(0, 1, 0, 0.5f);
+	glVertex2f(0.05f, 0.8f);
+	glEnd();
+	glBegin(GL_LINES);
+	glColor4f(0, 0, 1, 0.75f);
+	glVertex2f(0.5f, -0.8f);
+	glVertex2f(0.9f, 0.8f);
+	glEnd();
+
+	/* before the blend, in the middle of the clear area and of the flat quad */
+	if (TGL_FEATURE_RENDER_BITS == 32) {
+		ZB_copyFrameBuffer(frameBuffer, image, SIZE_X * sizeof(PIXEL));
+		check(abs((GLint)GET_ALPHA(image[4 * SIZE_X + 4]) - 64) <= 1, "the clear color alpha is stored");
+		check(abs((GLint)GET_ALPHA(image[SIZE_Y / 2 * SIZE_X + SIZE_X / 5]) - 128) <= 1, "the glColor4f alpha is stored");
+	}
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_DST_ALPHA, GL_ZERO);
+	glColor4f(1, 1, 1, 1);
+	glRectf(-1, -1, 1, 1);
+	glDisable(GL_BLEND);
+}
+
+/* a 2 pixel checker on a receding plane, with GL_NEAREST on the left, and GL_LINEAR_MIPMAP_LINEAR and GL_LINEAR on the right */
+static void caseMipmap(void) {
+	static uchar texels[64 * 64 * 3];
+	GLuint tex;
+	GLint i, x, y;
+	for (y = 0; y < 64; y++)
+		for (x = 0; x < 64; x++)
+			memset(texels + 3 * (y * 64 + x), ((x >> 1) ^ (y >> 1)) & 1 ? 240 : 20, 3);
+	glGenTextures(1, &tex);
+	glBindTexture(GL_TEXTURE_2D, tex);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexImage2D(GL_TEXTURE_2D, 0, 3, 64, 64, 0, GL_RGB, GL_UNSIGNED_BYTE, texels);
+
+	glMatrixMode(GL_PROJECTION);
+	glFrustum(-1, 1, -0.5, 0.5, 1, 20);
+	glMatrixMode(GL_MODELVIEW);
+	glEnable(GL_TEXTURE_2D);
+	glColor3f(1, 1, 1);
+	for (i = 0; i < 2; i++) {
+		GLfloat x0 = i ? 0.05f : -2.05f, x1 = x0 + 2;
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, i ? GL_LINEAR : GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, i ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST);
+		glBegin(GL_QUADS);
+		glTexCoord2f(0, 0);
+		glVertex3f(x0, -1, -1.2f);
+		glTexCoord2f(0.5f, 0);
+		glVertex3f(x1, -1, -1.2f);
+		glTexCoord2f(0.5f, 8);
+		glVertex3f(x1, 1, -18);
+		glTexCoord2f(0, 8);
+		glVertex3f(x0, 1, -18);
+		glEnd();
+	}
+	glDisable(GL_TEXTURE_2D);
+	glDeleteTextures(1, &tex);
+}
+
+/*
+ * a 24x40 texture, kept at that size, repeated 2.5 times across a quad. GL_NEAREST on the left, GL_LINEAR on the
+ * right. each texel row is a gradient with a red first column and a blue last row, which show where it wraps
+ */
+static void caseNPOT(void) {
+	static uchar texels[24 * 40 * 3];
+	GLuint tex;
+	GLint i, x, y, w = 0, h = 0;
+	for (y = 0; y < 40; y++)
+		for (x = 0; x < 24; x++) {
+			uchar* t = texels + 3 * (y * 24 + x);
+			t[0] = x == 0 ? 255 : x * 8;
+			t[1] = y * 6;
+			t[2] = y == 39 ? 255 : 40;
+		}
+	glGenTextures(1, &tex);
+	glBindTexture(GL_TEXTURE_2D, tex);
+	glTexImage2D(GL_TEXTURE_2D, 0, 3, 24, 40, 0, GL_RGB, GL_UNSIGNED_BYTE, texels);
+	glGetTexturePixmap(tex, 0, &w, &h);
+	check(w == 24 && h == 40, "the texture keeps its size");
+	glEnable(GL_TEXTURE_2D);
+	glColor3f(1, 1, 1);
+	for (i = 0; i < 2; i++) {
+		GLfloat x0 = i ? 0.05f : -0.95f, x1 = x0 + 0.9f;
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, i ? GL_LINEAR : GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, i ? GL_LINEAR : GL_NEAREST);
+		glBegin(GL_QUADS);
+		glTexCoord2f(0, 0);
+		glVertex2f(x0, -0.9f);
+		glTexCoord2f(2.5f, 0);
+		glVertex2f(x1, -0.9f);
+		glTexCoord2f(2.5f, 1.5f);
+		glVertex2f(x1, 0.9f);
+		glTexCoord2f(0, 1.5f);
+		glVertex2f(x0, 0.9f);
+		glEnd();
+	}
+	glDisable(GL_TEXTURE_2D);
+	glDeleteTextures(1, &tex);
+}
+
+/*
+ * the same 13 x 5 texels uploaded as GL_RGBA and GL_BGRA, in bytes and in GL_UNSIGNED_INT_8_8_8_8 and _REV. the
+ * width is no multiple of 4, so the texels after the last group of 4 are converted on their own. every upload must
+ * make the same texture, with alpha and without: the top row is blended, the bottom row is opaque next to GL_RGB
+ */
+#define TEXELS_X 13
+#define TEXELS_Y 5
+static void caseTexelFormats(void) {
+	static const GLint formats[6][2] = {
+		{GL_RGBA, GL_UNSIGNED_BYTE}, {GL_BGRA, GL_UNSIGNED_BYTE},
+		{GL_RGBA, GL_UNSIGNED_INT_8_8_8_8}, {GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV},
+		{GL_BGRA, GL_UNSIGNED_INT_8_8_8_8}, {GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV},
+	};
+	static GLuint texels[6][TEXELS_X * TEXELS_Y];
+	static uchar rgb[TEXELS_X * TEXELS_Y * 3];
+	GLuint tex[13];
+	GLint i, j, w, h, same = 1, exact = 1;
+	PIXEL *first, *opaque;
+	for (i = 0; i < TEXELS_X * TEXELS_Y; i++) {
+		GLuint r = i * 19 & 255, g = i / TEXELS_X * 60, b = 255 - i * 3, a = 255 - i % TEXELS_X * 18;
+		uchar* t = (uchar*)texels[0] + 4 * i;
+		t[0] = r;
+		t[1] = g;
+		t[2] = b;
+		t[3] = a;
+		t = (uchar*)texels[1] + 4 * i;
+		t[0] = b;
+		t[1] = g;
+		t[2] = r;
+		t[3] = a;
+		texels[2][i] = r << 24 | g << 16 | b << 8 | a;
+		texels[3][i] = a << 24 | b << 16 | g << 8 | r;
+		texels[4][i] = b << 24 | g << 16 | r << 8 | a;
+		texels[5][i] = a << 24 | r << 16 | g << 8 | b;
+		rgb[3 * i + 0] = r;
+		rgb[3 * i + 1] = g;
+		rgb[3 * i + 2] = b;
+	}
+	glGenTextures(13, tex);
+	for (i = 0; i < 13; i++) {
+		glBindTexture(GL_TEXTURE_2D, tex[i]);
+		if (i < 12)
+			glTexImage2D(GL_TEXTURE_2D, 0, i < 6 ? GL_RGBA : GL_RGB, TEXELS_X, TEXELS_Y, 0, formats[i % 6][0], formats[i % 6][1],
+						 texels[i % 6]);
+		else
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, TEXELS_X, TEXELS_Y, 0, GL_RGB, GL_UNSIGNED_BYTE, rgb);
+	}
+
+	first = glGetTexturePixmap(tex[0], 0, &w, &h);
+	opaque = glGetTexturePixmap(tex[12], 0, &w, &h);
+	check(first != NULL && opaque != NULL && w == TEXELS_X && h == TEXELS_Y, "the textures are made");
+	if (failures)
+		return;
+	for (i = 0; i < TEXELS_X * TEXELS_Y; i++) {
+		PIXEL p = first[i];
+		exact &= ((GET_RED(p) ^ rgb[3 * i]) & 0xf8) == 0 && ((GET_GREEN(p) ^ rgb[3 * i + 1]) & 0xf8) == 0 &&
+				 ((GET_BLUE(p) ^ rgb[3 * i + 2]) & 0xf8) == 0;
+#if TGL_FEATURE_RENDER_BITS == 32
+		exact &= p >> 24 == ((uchar*)texels[0])[4 * i + 3];
+#endif
+	}
+	check(exact, "GL_RGBA bytes keep their color and alpha");
+	for (i = 1; i < 12; i++) {
+		PIXEL* p = glGetTexturePixmap(tex[i], 0, &w, &h);
+		for (j = 0; j < TEXELS_X * TEXELS_Y; j++)
+			same &= p[j] == (i < 6 ? first : opaque)[j];
+	}
+	check(same, "every format and type makes the same texels");
+
+	glEnable(GL_TEXTURE_2D);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glColor3f(1, 1, 1);
+	for (i = 0; i < 13; i++) {
+		GLfloat x0 = -0.97f + (i < 6 ? i : i - 6) * 0.28f, y0 = i < 6 ? 0.05f : -0.9f;
+		if (i == 6)
+			glDisable(GL_BLEND);
+		glBindTexture(GL_TEXTURE_2D, tex[i]);
+		glBegin(GL_QUADS);
+		glTexCoord2f(0, 0);
+		glVertex2f(x0, y0);
+		glTexCoord2f(1, 0);
+		glVertex2f(x0 + 0.26f, y0);
+		glTexCoord2f(1, 1);
+		glVertex2f(x0 + 0.26f, y0 + 0.85f);
+		glTexCoord2f(0, 1);
+		glVertex2f(x0, y0 + 0.85f);
+		glEnd();
+	}
+	glDisable(GL_TEXTURE_2D);
+	glDeleteTextures(13, tex);
+}
+
+/*
+ * names of lists and textures: 5000 lists, of which every other one is deleted, are generated again from the
+ * deleted ones, and a list and a texture with names far above the others work. 32 of the lists are drawn, a column
+ * of them with the large name
+ */
+#define NAMES 5000
+static void caseNames(void) {
+	static GLuint textures[NAMES];
+	GLuint first = glGenLists(NAMES), list, big = 1000000;
+	GLint i;
+	check(first != 0, "glGenLists of a large range");
+	for (i = 0; i < NAMES; i++) {
+		glNewList(first + i, GL_COMPILE);
+		glColor3f((i & 7) / 7.0f, ((i >> 3) & 3) / 3.0f, 0.6f);
+		glRectf(0, 0, 0.2f, 0.4f);
+		glEndList();
+	}
+	for (i = 1; i < NAMES; i += 2)
+		glDeleteLists(first + i, 1);
+	check(glIsList(first) && !glIsList(first + 1), "deleted lists are gone, the others kept");
+	list = glGenLists(1);
+	check(list > first && list < first + NAMES && !glIsList(first + NAMES), "the name of a deleted list is generated again");
+	glDeleteLists(list, 1);
+
+	glNewList(big, GL_COMPILE);
+	glColor3f(1, 1, 1);
+	glRectf(0, 0, 0.2f, 0.4f);
+	glEndList();
+	check(glIsList(big), "a list with a name of its own");
+
+	glGenTextures(NAMES, textures);
+	for (i = 0; i < NAMES; i++)
+		glBindTexture(GL_TEXTURE_2D, textures[i]);
+	glDeleteTextures(NAMES / 2, textures);
+	check(!glIsTexture(textures[0]) && glIsTexture(textures[NAMES - 1]), "deleted textures are gone, the others kept");
+	glBindTexture(GL_TEXTURE_2D, 70000);
+	check(glIsTexture(70000), "a texture with a name of its own");
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDeleteTextures(NAMES / 2, textures + NAMES / 2);
+
+	for (i = 0; i < 32; i++) {
+		glLoadIdentity();
+		glTranslatef(-0.95f + (i & 7) * 0.24f, -0.95f + (i >> 3) * 0.48f, 0);
+		glCallList((i & 7) == 7 ? big : first + 2 * i);
+	}
+	glLoadIdentity();
+	glDeleteLists(first, NAMES);
+	glDeleteLists(big, 1);
+}
+
+/*
+ * display lists of many sizes in the command arena: 16 columns of strips, each a list with its own number of strips.
+ * the even columns are deleted and compiled again with other sizes, between lists that are compiled and deleted at once,
+ * so their buffers come back from the free lists and the trimmed ends of others
+ */
+static void arenaList(GLuint list, GLint column, GLint n) {
+	GLint k;
+	glNewList(list, GL_COMPILE);
+	for (k = 0; k < n; k++) {
+		glColor3f(column / 15.0f, k / 120.0f, 1 - column / 15.0f);
+		glRectf(column * 16 + 1, k + 4, column * 16 + 15, k + 5);
+	}
+	glEndList();
+}
+
+static void caseArena(void) {
+	GLuint first = glGenLists(16), spare = glGenLists(1);
+	GLint i, j;
+	/* pixel coordinates */
+	glTranslatef(-1, -1, 0);
+	glScalef(2.0f / SIZE_X, 2.0f / SIZE_Y, 1);
+	for (i = 0; i < 16; i++)
+		arenaList(first + i, i, (i * 53) % 120 + 1);
+	for (i = 0; i < 16; i += 2)
+		glDeleteLists(first + i, 1);
+	check(!glIsList(first) && glIsList(first + 1), "deleted lists are gone, the others kept");
+	for (i = 0; i < 16; i += 2) {
+		for (j = 0; j < 8; j++) {
+			arenaList(spare, i, (i * 7 + j * 31) % 120 + 1);
+			glDeleteLists(spare, 1);
+		}
+		arenaList(first + i, i, 120 - (i * 53) % 120);
+	}
+	for (i = 0; i < 16; i++)
+		glCallList(first + i);
+	glLoadIdentity();
+	glDeleteLists(first, 16);
+}
+
+/*
+ * calls for the peephole pass of glEndList: repeated and overridden attributes, a run of matrix calls and four
+ * triangle blocks with only attributes between them. the list of them is checked to draw what they draw
+ */
+static void peepholeCalls(void) {
+	GLint i;
+	glColor3f(1, 0, 0);
+	glColor3f(0.2f, 0.8f, 0.3f);
+	glNormal3f(0, 0, 1);
+	glNormal3f(0, 0, 1);
+	glShadeModel(GL_FLAT);
+	glShadeModel(GL_SMOOTH);
+	glTranslatef(-0.5f, 0, 0);
+	glRotatef(20, 0, 0, 1);
+	glScalef(0.8f, 1.6f, 1);
+	for (i = 0; i < 4; i++) {
+		glBegin(GL_TRIANGLES);
+		glColor3f(0.2f, 0.8f, 0.3f);
+		glVertex3f(-0.4f, -0.4f + i * 0.2f, 0);
+		glColor3f(0.2f, 0.8f, 0.3f);
+		glVertex3f(0.4f, -0.4f + i * 0.2f, 0);
+		glColor3f(1, 1 - i * 0.25f, i * 0.25f);
+		glVertex3f(0, -0.3f + i * 0.2f, 0);
+		glEnd();
+		glColor3f(0.2f, 0.8f, 0.3f);
+	}
+}
+
+static void casePeephole(void) {
+	GLuint list = glGenLists(1);
+	GLint ops[2], i, same = 1;
+	PIXEL* pixels = malloc(2 * sizeof(PIXEL) * SIZE_X * SIZE_Y);
+	glNewList(list, GL_COMPILE);
+	peepholeCalls();
+	glEndList();
+	glGetIntegerv(GL_LIST_OP_COUNT, ops);
+	check(ops[0] == 45, "the list is compiled from its 45 calls");
+#if TGL_FEATURE_LIST_PEEPHOLE == 1 && TGL_FEATURE_LIST_MESHES == 1
+	check(ops[1] == 6, "the list is left with a color, normal, shade model, matrix, triangle mesh and color");
+#endif
+
+	/* the calls, then the list, on a cleared frame */
+	peepholeCalls();
+	glLoadIdentity();
+	ZB_copyFrameBuffer(frameBuffer, pixels, SIZE_X * sizeof(PIXEL));
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glCallList(list);
+	glLoadIdentity();
+	ZB_copyFrameBuffer(frameBuffer, pixels + SIZE_X * SIZE_Y, SIZE_X * sizeof(PIXEL));
+	for (i = 0; i < SIZE_X * SIZE_Y; i++)
+		same &= pixels[i] == pixels[i + SIZE_X * SIZE_Y];
+	check(same, "the list draws what its calls draw");
+	free(pixels);
+	glDeleteLists(list, 1);
+}
+
+/* a BC1 compressed texture on a receding plane, next to the same texture uncompressed. nothing is clipped */
+static void caseBC1(void) {
+	GLuint tex[2];
+	GLint i, x, y;
+	uchar* texels = malloc(64 * 64 * 3);
+	for (y = 0; y < 64; y++)
+		for (x = 0; x < 64; x++) {
+			uchar* t = texels + 3 * (y * 64 + x);
+			t[0] = x * 4;
+			t[1] = y * 4;
+			t[2] = ((x >> 3) ^ (y >> 3)) & 1 ? 255 : 32;
+		}
+	glGenTextures(2, tex);
+	for (i = 0; i < 2; i++) {
+		glBindTexture(GL_TEXTURE_2D, tex[i]);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexImage2D(GL_TEXTURE_2D, 0, i ? 3 : GL_COMPRESSED_RGB_S3TC_DXT1_EXT, 64, 64, 0, GL_RGB, GL_UNSIGNED_BYTE, texels);
+	}
+	free(texels);
+
+	glMatrixMode(GL_PROJECTION);
+	glFrustum(-1, 1, -0.5, 0.5, 1, 10);
+	glMatrixMode(GL_MODELVIEW);
+	glEnable(GL_TEXTURE_2D);
+	glColor3f(1, 1, 1);
+	for (i = 0; i < 2; i++) {
+		GLfloat x0 = i ? 0.1f : -2.1f, x1 = x0 + 2;
+		glBindTexture(GL_TEXTURE_2D, tex[i]);
+		glBegin(GL_QUADS);
+		glTexCoord2f(0, 0);
+		glVertex3f(x0, -1, -2.5f);
+		glTexCoord2f(2, 0);
+		glVertex3f(x1, -1, -2.5f);
+		glTexCoord2f(2, 3);
+		glVertex3f(x1, 0.2f, -8);
+		glTexCoord2f(0, 3);
+		glVertex3f(x0, 0.2f, -8);
+		glEnd();
+	}
+	glDisable(GL_TEXTURE_2D);
+	glDeleteTextures(2, tex);
+}
+
+/* a wavy grid of GRID * GRID vertices, and the indices of its triangles. returns their count */
+#define GRID 24
+static GLfloat vertices[GRID * GRID * 3], normals[GRID * GRID * 3], colors[GRID * GRID * 3];
+static GLushort indices[(GRID - 1) * (GRID - 1) * 6];
+
+static GLint makeGrid(void) {
+	GLint x, y, n = 0;
+	for (y = 0; y < GRID; y++)
+		for (x = 0; x < GRID; x++) {
+			GLint i = 3 * (y * GRID + x);
+			GLfloat u = x * 2 * M_PI / (GRID - 1), v = y * 2 * M_PI / (GRID - 1);
+			vertices[i + 0] = -1 + 2.0f * x / (GRID - 1);
+			vertices[i + 1] = -1 + 2.0f * y / (GRID - 1);
+			vertices[i + 2] = 0.2f * sinf(u) * cosf(v);
+			normals[i + 0] = -0.2f * cosf(u) * cosf(v) * M_PI;
+			normals[i + 1] = 0.2f * sinf(u) * sinf(v) * M_PI;
+			normals[i + 2] = 1;
+			colors[i + 0] = (GLfloat)x / (GRID - 1);
+			colors[i + 1] = 0.5f;
+			colors[i + 2] = (GLfloat)y / (GRID - 1);
+		}
+	for (y = 0; y < GRID - 1; y++)
+		for (x = 0; x < GRID - 1; x++) {
+			GLushort i = y * GRID + x;
+			indices[n++] = i;
+			indices[n++] = i + 1;
+			indices[n++] = i + GRID;
+			indices[n++] = i + 1;
+			indices[n++] = i + GRID + 1;
+			indices[n++] = i + GRID;
+		}
+	return n;
+}
+
+/* the lit grid seen from above at an angle */
+static void gridView(void) {
+	static GLfloat pos[4] = {1, 1, 2, 0};
+	static GLfloat white[4] = {1, 1, 1, 1};
+	glMatrixMode(GL_PROJECTION);
+	glFrustum(-1, 1, -0.5, 0.5, 1, 10);
+	glMatrixMode(GL_MODELVIEW);
+	glTranslatef(0, 0, -2.5f);
+	glRotatef(-50, 1, 0, 0);
+	glScalef(1.5f, 1, 1);
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_LIGHTING);
+	glEnable(GL_LIGHT0);
+	glEnable(GL_NORMALIZE);
+	glEnable(GL_COLOR_MATERIAL);
+	glLightfv(GL_LIGHT0, GL_POSITION, pos);
+	glLightfv(GL_LIGHT0, GL_DIFFUSE, white);
+}
+
+/* a lit indexed grid drawn with glDrawElements, reusing most vertices from the post-transform cache */
+static void caseElements(void) {
+	GLint n = makeGrid();
+	gridView();
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_NORMAL_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(3, GL_FLOAT, 0, vertices);
+	glNormalPointer(GL_FLOAT, 0, normals);
+	glColorPointer(3, GL_FLOAT, 0, colors);
+	glDrawElements(GL_TRIANGLES, n, GL_UNSIGNED_SHORT, indices);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisableClientState(GL_NORMAL_ARRAY);
+	glDisableClientState(GL_COLOR_ARRAY);
+}
+
+/*
+ * the grid as one glBegin/glEnd block in a display list, baked into a mesh of its distinct vertices and an index
+ * array, on the right. on the left the same triangles go through glDrawArrays, which shades every one of their
+ * vertices with the same batched code: both halves must match
+ */
+static void caseListMesh(void) {
+	static GLfloat v[sizeof(indices) / sizeof(indices[0]) * 3], nv[sizeof(v) / sizeof(v[0])], cv[sizeof(v) / sizeof(v[0])];
+#if TGL_FEATURE_LIST_MESHES == 1
+	static PIXEL image[SIZE_X * SIZE_Y];
+	GLint x, y, same = 1;
+#endif
+	GLint n = makeGrid(), i, j;
+	GLuint list = glGenLists(1);
+	for (i = 0; i < n; i++)
+		for (j = 0; j < 3; j++) {
+			v[3 * i + j] = vertices[3 * indices[i] + j];
+			nv[3 * i + j] = normals[3 * indices[i] + j];
+			cv[3 * i + j] = colors[3 * indices[i] + j];
+		}
+	glNewList(list, GL_COMPILE);
+	glBegin(GL_TRIANGLES);
+	for (i = 0; i < n; i++) {
+		glColor3fv(cv + 3 * i);
+		glNormal3fv(nv + 3 * i);
+		glVertex3fv(v + 3 * i);
+	}
+	glEnd();
+	glEndList();
+
+	gridView();
+	glViewport(0, 0, SIZE_X / 2, SIZE_Y);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_NORMAL_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(3, GL_FLOAT, 0, v);
+	glNormalPointer(GL_FLOAT, 0, nv);
+	glColorPointer(3, GL_FLOAT, 0, cv);
+	glDrawArrays(GL_TRIANGLES, 0, n);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisableClientState(GL_NORMAL_ARRAY);
+	glDisableClientState(GL_COLOR_ARRAY);
+	glViewport(SIZE_X / 2, 0, SIZE_X / 2, SIZE_Y);
+	glCallList(list);
+	glDeleteLists(list, 1);
+
+	/* without meshes the list goes through glVertex, which can differ from the batches by rounding */
+#if TGL_FEATURE_LIST_MESHES == 1
+	ZB_copyFrameBuffer(frameBuffer, image, SIZE_X * sizeof(PIXEL));
+	for (y = 0; y < SIZE_Y; y++)
+		for (x = 0; x < SIZE_X / 2; x++)
+			same &= image[y * SIZE_X + x] == image[y * SIZE_X + x + SIZE_X / 2];
+	check(same, "the indexed list mesh draws what glDrawArrays draws");
+#endif
+}
+
+/*
+ * the unlit grid scaled past the screen edges and the near plane: glDrawArrays transforms it in batches, which must
+ * draw what glArrayElement draws one vertex at a time
+ */
+static void caseDrawArrays(void) {
+	static GLfloat v[sizeof(indices) / sizeof(indices[0]) * 3], cv[sizeof(v) / sizeof(v[0])];
+	static PIXEL image[2 * SIZE_X * SIZE_Y];
+	GLint n = makeGrid(), i, j, same = 1;
+	for (i = 0; i < n; i++)
+		for (j = 0; j < 3; j++) {
+			v[3 * i + j] = vertices[3 * indices[i] + j];
+			cv[3 * i + j] = colors[3 * indices[i] + j];
+		}
+	gridView();
+	glDisable(GL_LIGHTING);
+	glTranslatef(0.3f, 0.2f, 0);
+	glScalef(1.2f, 2.2f, 3);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(3, GL_FLOAT, 0, v);
+	glColorPointer(3, GL_FLOAT, 0, cv);
+	glBegin(GL_TRIANGLES);
+	for (i = 0; i < n; i++)
+		glArrayElement(i);
+	glEnd();
+	ZB_copyFrameBuffer(frameBuffer, image, SIZE_X * sizeof(PIXEL));
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glDrawArrays(GL_TRIANGLES, 0, n);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisableClientState(GL_COLOR_ARRAY);
+	ZB_copyFrameBuffer(frameBuffer, image + SIZE_X * SIZE_Y, SIZE_X * sizeof(PIXEL));
+	for (i = 0; i < SIZE_X * SIZE_Y; i++)
+		same &= image[i] == image[i + SIZE_X * SIZE_Y];
+	check(same, "glDrawArrays draws what glArrayElement draws");
+}
+
+/*
+ * a textured quad 4 times the size of the screen, on its left half, drawn within the guard band, and one 40 times its
+ * size on its right half, reaching past it and clipped. both must cover their half. a quad 3 times the size of a viewport
+ * in the middle must not be drawn outside of it. over them, triangles reaching behind the eye are clipped by the near plane
+ */
+static void guardQuad(GLfloat x0, GLfloat y0, GLfloat x1, GLfloat y1) {
+	glBegin(GL_QUADS);
+	glTexCoord2f(2 * x0, 2 * y0);
+	glVertex3f(x0, y0, 0);
+	glTexCoord2f(2 * x1, 2 * y0);
+	glVertex3f(x1, y0, 0);
+	glTexCoord2f(2 * x1, 2 * y1);
+	glVertex3f(x1, y1, 0);
+	glTexCoord2f(2 * x0, 2 * y1);
+	glVertex3f(x0, y1, 0);
+	glEnd();
+}
+
+static void caseGuardBand(void) {
+	static uchar texels[16 * 16 * 3];
+	static PIXEL image[2 * SIZE_X * SIZE_Y];
+	GLuint tex;
+	GLint i, x, y, covered = 1, inside = 1;
+	PIXEL clear;
+	for (y = 0; y < 16; y++)
+		for (x = 0; x < 16; x++) {
+			uchar* t = texels + 3 * (y * 16 + x);
+			t[0] = ((x >> 2) ^ (y >> 2)) & 1 ? 230 : 40;
+			t[1] = x * 16;
+			t[2] = y * 16;
+		}
+	glGenTextures(1, &tex);
+	glBindTexture(GL_TEXTURE_2D, tex);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, 3, 16, 16, 0, GL_RGB, GL_UNSIGNED_BYTE, texels);
+
+	ZB_copyFrameBuffer(frameBuffer, image, SIZE_X * sizeof(PIXEL));
+	clear = image[0];
+	glEnable(GL_TEXTURE_2D);
+	glColor3f(1, 1, 1);
+	guardQuad(-4, -4, 0, 4);
+	guardQuad(0, -40, 40, 40);
+	glDisable(GL_TEXTURE_2D);
+	glDeleteTextures(1, &tex);
+	ZB_copyFrameBuffer(frameBuffer, image, SIZE_X * sizeof(PIXEL));
+	for (i = 0; i < SIZE_X * SIZE_Y; i++)
+		covered &= image[i] != clear;
+	check(covered, "the quads cover the screen");
+
+	glViewport(SIZE_X / 4, SIZE_Y / 4, SIZE_X / 2, SIZE_Y / 2);
+	glColor3f(0.9f, 0.9f, 0.2f);
+	glRotatef(20, 0, 0, 1);
+	glRectf(-3, -3, 3, 3);
+	ZB_copyFrameBuffer(frameBuffer, image + SIZE_X * SIZE_Y, SIZE_X * sizeof(PIXEL));
+	for (y = 0; y < SIZE_Y; y++)
+		for (x = 0; x < SIZE_X; x++)
+			if (x < SIZE_X / 4 || x >= SIZE_X * 3 / 4 || y < SIZE_Y / 4 || y >= SIZE_Y * 3 / 4)
+				inside &= image[y * SIZE_X + x] == image[(y + SIZE_Y) * SIZE_X + x];
+	check(inside, "a quad larger than the viewport is not drawn outside of it");
+
+	glViewport(0, 0, SIZE_X, SIZE_Y);
+	glLoadIdentity();
+	glMatrixMode(GL_PROJECTION);
+	glFrustum(-1, 1, -0.5f, 0.5f, 1, 10);
+	glMatrixMode(GL_MODELVIEW);
+	glBegin(GL_TRIANGLES);
+	for (i = 0; i < 3; i++) {
+		GLfloat x0 = -1.5f + i * 1.5f;
+		glColor3f(1, 0.2f * i, 0);
+		glVertex3f(x0 - 0.8f, 0.8f, -4);
+		glColor3f(0, 1, 0.5f * i);
+		glVertex3f(x0 + 0.8f, 0.8f, -4);
+		glColor3f(0.3f, 0, 1);
+		glVertex3f(x0, -1, 1);
+	}
+	glEnd();
+}
+
+/* a tall quad facing z, or facing x + z when tilted */
+static void normalQuad(GLfloat tilt) {
+	glBegin(GL_QUADS);
+	glNormal3f(tilt, 0, 1);
+	glVertex3f(-0.2f, -0.8f, 0.2f * tilt);
+	glVertex3f(0.2f, -0.8f, -0.2f * tilt);
+	glVertex3f(0.2f, 0.8f, -0.2f * tilt);
+	glVertex3f(-0.2f, 0.8f, 0.2f * tilt);
+	glEnd();
+}
+
+/*
+ * lit quads, in the right half, whose normals go through the normal matrix: with a non-uniform scale, with a rotation
+ * and a uniform scale, and with the same 3x3 behind a translation. the middle pixel of each is checked against the
+ * diffuse term of a light along z. in the left half, the grid scaled non-uniformly under three lights: a directional
+ * one, a local one with attenuation and a specular spot
+ */
+static void caseLights(void) {
+	static GLfloat black[4] = {0, 0, 0, 1}, white[4] = {1, 1, 1, 1}, eye[4] = {0, 0, 1, 0};
+	static GLfloat pos1[4] = {-1, 0.5f, 0.5f, 1}, color1[4] = {1, 0.5f, 0.2f, 1};
+	static GLfloat pos2[4] = {0.3f, 0.8f, 0, 1}, dir2[3] = {-0.3f, -0.8f, -2.5f}, color2[4] = {0.3f, 0.6f, 1, 1};
+	static PIXEL image[SIZE_X * SIZE_Y];
+	/* the diffuse term, 0 to 255, of each quad: n.z of (1/4, 0, 1), of (sin 60, 0, cos 60), and the same */
+	static const GLint expect[3] = {247, 127, 127};
+	GLint i, n = makeGrid();
+
+	glEnable(GL_LIGHTING);
+	glEnable(GL_LIGHT0);
+	glEnable(GL_NORMALIZE);
+	glLightModelfv(GL_LIGHT_MODEL_AMBIENT, black);
+	glLightfv(GL_LIGHT0, GL_POSITION, eye);
+	glLightfv(GL_LIGHT0, GL_DIFFUSE, white);
+	glMaterialfv(GL_FRONT_AND_BACK, GL_AMBIENT, black);
+	glMaterialfv(GL_FRONT_AND_BACK, GL_DIFFUSE, white);
+	for (i = 0; i < 3; i++) {
+		glViewport(SIZE_X / 2 + i * 43, 0, 42, SIZE_Y);
+		if (i == 0) {
+			glScalef(4, 1, 1);
+		} else if (i == 1) {
+			glLoadIdentity();
+			glRotatef(60, 0, 1, 0);
+			glScalef(2, 2, 2);
+		} else {
+			glTranslatef(0, 0, 0.05f);
+		}
+		normalQuad(i == 0);
+	}
+	glLoadIdentity();
+	ZB_copyFrameBuffer(frameBuffer, image, SIZE_X * sizeof(PIXEL));
+	for (i = 0; i < 3; i++) {
+		GLint r = GET_RED(image[SIZE_Y / 2 * SIZE_X + SIZE_X / 2 + i * 43 + 21]);
+		check(r > expect[i] - 6 && r < expect[i] + 6, "the normal matrix of a quad");
+	}
+
+	/* the spot in eye coordinates, pointing at the middle of the grid */
+	glViewport(0, 0, SIZE_X / 2, SIZE_Y);
+	glEnable(GL_LIGHT2);
+	glLightfv(GL_LIGHT2, GL_POSITION, pos2);
+	glLightfv(GL_LIGHT2, GL_DIFFUSE, color2);
+	glLightfv(GL_LIGHT2, GL_SPECULAR, white);
+	glLightfv(GL_LIGHT2, GL_SPOT_DIRECTION, dir2);
+	glLightf(GL_LIGHT2, GL_SPOT_CUTOFF, 20);
+	glLightf(GL_LIGHT2, GL_SPOT_EXPONENT, 4);
+	gridView();
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	glFrustum(-0.6f, 0.6f, -0.6f, 0.6f, 1, 10);
+	glMatrixMode(GL_MODELVIEW);
+	glScalef(0.7f, 1, 2.5f);
+	glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, white);
+	glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, 20);
+	glSetEnableSpecular(GL_TRUE);
+	glEnable(GL_LIGHT1);
+	glLightfv(GL_LIGHT1, GL_POSITION, pos1);
+	glLightfv(GL_LIGHT1, GL_DIFFUSE, color1);
+	glLightf(GL_LIGHT1, GL_LINEAR_ATTENUATION, 0.5f);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_NORMAL_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(3, GL_FLOAT, 0, vertices);
+	glNormalPointer(GL_FLOAT, 0, normals);
+	glColorPointer(3, GL_FLOAT, 0, colors);
+	glDrawElements(GL_TRIANGLES, n, GL_UNSIGNED_SHORT, indices);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisableClientState(GL_NORMAL_ARRAY);
+	glDisableClientState(GL_COLOR_ARRAY);
+}
+
+/* the lit grid in four columns, with a shininess of 5, 20, 20.1 and 80, drawn one glArrayElement at a time */
+static const GLfloat shininess[4] = {5, 20, 20.1f, 80};
+
+static void specularColumns(void) {
+	static GLfloat white[4] = {1, 1, 1, 1}, above[4] = {0, 1, -0.17f, 0};
+	GLint i, j, n = makeGrid();
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_LIGHTING);
+	glEnable(GL_LIGHT0);
+	glEnable(GL_NORMALIZE);
+	glEnable(GL_COLOR_MATERIAL);
+	glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, white);
+	glSetEnableSpecular(GL_TRUE);
+	glLightModeli(GL_LIGHT_MODEL_LOCAL_VIEWER, GL_TRUE);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_NORMAL_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(3, GL_FLOAT, 0, vertices);
+	glNormalPointer(GL_FLOAT, 0, normals);
+	glColorPointer(3, GL_FLOAT, 0, colors);
+	for (i = 0; i < 4; i++) {
+		glViewport(i * SIZE_X / 4, 0, SIZE_X / 4, SIZE_Y);
+		glMatrixMode(GL_PROJECTION);
+		glLoadIdentity();
+		glFrustum(-0.5f, 0.5f, -1, 1, 1, 10);
+		glMatrixMode(GL_MODELVIEW);
+		glLoadIdentity();
+		/* from above, so that it reflects off the grid into the eye */
+		glLightfv(GL_LIGHT0, GL_POSITION, above);
+		glTranslatef(0, 0, -2.5f);
+		glRotatef(-50, 1, 0, 0);
+		glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, shininess[i]);
+		glBegin(GL_TRIANGLES);
+		for (j = 0; j < n; j++)
+			glArrayElement(indices[j]);
+		glEnd();
+	}
+	glLoadIdentity();
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glDisableClientState(GL_NORMAL_ARRAY);
+	glDisableClientState(GL_COLOR_ARRAY);
+}
+
+/*
+ * the specular tables: a shininess of 20 looks its exponent up in the shared table made for it, 20.1 has none and
+ * computes it. both columns must nearly match. glClose frees the tables, and after glInit they are made again the same
+ */
+static void caseSpecular(void) {
+	static PIXEL image[2 * SIZE_X * SIZE_Y];
+	GLint x, y, c, near = 1, same = 1;
+	specularColumns();
+	ZB_copyFrameBuffer(frameBuffer, image, SIZE_X * sizeof(PIXEL));
+	for (y = 0; y < SIZE_Y; y++)
+		for (x = SIZE_X / 4; x < SIZE_X / 2; x++) {
+			PIXEL a = image[y * SIZE_X + x], b = image[y * SIZE_X + x + SIZE_X / 4];
+			c = abs(GET_RED(a) - GET_RED(b)) + abs(GET_GREEN(a) - GET_GREEN(b)) + abs(GET_BLUE(a) - GET_BLUE(b));
+			near &= c <= 6;
+		}
+	check(near, "the table of a shininess of 20 gives the exponent of 20.1 computed without one");
+
+	glClose();
+	glInit(frameBuffer);
+	glClearColor(0.1f, 0.1f, 0.1f, 1);
+	glShadeModel(GL_SMOOTH);
+	specularColumns();
+	ZB_copyFrameBuffer(frameBuffer, image + SIZE_X * SIZE_Y, SIZE_X * sizeof(PIXEL));
+	for (x = 0; x < SIZE_X * SIZE_Y; x++)
+		same &= image[x] == image[x + SIZE_X * SIZE_Y];
+	check(same, "the tables made again after glClose light the same");
+}
+
+/* the same spiral three times: thin, 5 pixels wide, and 3 pixels wide antialiased and blended */
+#define SPIRAL 200
+static void casePolyline(void) {
+	static GLfloat points[SPIRAL * 3], colors[SPIRAL * 4];
+	GLint i, j;
+	for (i = 0; i < SPIRAL; i++) {
+		GLfloat a = i * 6 * M_PI / SPIRAL, r = 0.05f + 0.9f * i / SPIRAL;
+		points[3 * i + 0] = r * cosf(a) * 0.3f;
+		points[3 * i + 1] = r * sinf(a) * 0.9f;
+		points[3 * i + 2] = 0;
+		colors[4 * i + 0] = 1 - (GLfloat)i / SPIRAL;
+		colors[4 * i + 1] = 0.3f;
+		colors[4 * i + 2] = (GLfloat)i / SPIRAL;
+		colors[4 * i + 3] = 1;
+	}
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	for (j = 0; j < 3; j++) {
+		glLoadIdentity();
+		glTranslatef(-0.66f + j * 0.66f, 0, 0);
+		glLineWidth(j == 0 ? 1 : j == 1 ? 5 : 3);
+		if (j == 2) {
+			glEnable(GL_LINE_SMOOTH);
+			glEnable(GL_BLEND);
+		}
+		glDrawPolyline(SPIRAL, points, j == 1 ? NULL : colors);
+	}
+	glDisable(GL_LINE_SMOOTH);
+	glDisable(GL_BLEND);
+	glLineWidth(1);
+}
+
+/*
+ * glColorMask with some of the channels: glClear into blue only, a smooth triangle into red only, a blended quad into
+ * green and blue, lines into green only, then alpha alone, shown by blending white with GL_DST_ALPHA
+ */
+static void caseColorMask(void) {
+	GLint i;
+	glColorMask(GL_FALSE, GL_FALSE, GL_TRUE, GL_TRUE);
+	glClearColor(0.5f, 0.5f, 0.6f, 1);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glColorMask(GL_TRUE, GL_FALSE, GL_FALSE, GL_TRUE);
+	glBegin(GL_TRIANGLES);
+	glColor3f(1, 1, 1);
+	glVertex2f(-0.95f, -0.9f);
+	glColor3f(0.5f, 1, 1);
+	glVertex2f(-0.55f, -0.9f);
+	glColor3f(0, 1, 1);
+	glVertex2f(-0.75f, 0.9f);
+	glEnd();
+	glColorMask(GL_FALSE, GL_TRUE, GL_TRUE, GL_TRUE);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glColor4f(1, 0.9f, 0.1f, 0.5f);
+	glRectf(-0.45f, -0.9f, -0.05f, 0.9f);
+	glDisable(GL_BLEND);
+	glColorMask(GL_FALSE, GL_TRUE, GL_FALSE, GL_TRUE);
+	glColor3f(1, 1, 1);
+	glBegin(GL_LINES);
+	for (i = 0; i < 8; i++) {
+		glVertex2f(0.05f, -0.9f + i * 0.25f);
+		glVertex2f(0.45f, -0.8f + i * 0.2f);
+	}
+	glEnd();
+	/* alpha 0.25 in the middle of the last column, then white weighted by it */
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_TRUE);
+	glColor4f(1, 0, 0, 0.25f);
+	glRectf(0.55f, -0.5f, 0.95f, 0.5f);
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_DST_ALPHA, GL_ONE_MINUS_DST_ALPHA);
+	glColor4f(1, 1, 1, 1);
+	glRectf(0.6f, -0.9f, 0.9f, 0.9f);
+	glDisable(GL_BLEND);
+}
+
+#if TGL_FEATURE_TILED_RASTER == 1
+/*
+ * glTexSubImage2D with the tiled rasterizer. A texture sampled by queued triangles is updated in a second buffer, and
+ * the quads drawn before the update keep the old texels. One that no queued triangle samples is updated in place.
+ * Columns: checker, checker with a red square, checker with a red and a blue square, and the second texture
+ */
+static void caseSubImage(void) {
+	static uchar checker[16 * 16 * 3], red[8 * 8 * 3], blue[4 * 4 * 3];
+	GLuint tex[2];
+	GLint i, x, y, w, h;
+	void *before, *after;
+	for (y = 0; y < 16; y++)
+		for (x = 0; x < 16; x++)
+			memset(checker + 3 * (y * 16 + x), ((x >> 2) ^ (y >> 2)) & 1 ? 220 : 60, 3);
+	for (i = 0; i < 8 * 8; i++) {
+		red[3 * i] = 255;
+		red[3 * i + 1] = red[3 * i + 2] = 0;
+	}
+	for (i = 0; i < 4 * 4; i++) {
+		blue[3 * i] = blue[3 * i + 1] = 0;
+		blue[3 * i + 2] = 255;
+	}
+	check(ZB_setTiledRaster(frameBuffer, 1), "ZB_setTiledRaster");
+	glGenTextures(2, tex);
+	for (i = 0; i < 2; i++) {
+		glBindTexture(GL_TEXTURE_2D, tex[i]);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexImage2D(GL_TEXTURE_2D, 0, 3, 16, 16, 0, GL_RGB, GL_UNSIGNED_BYTE, checker);
+	}
+	glEnable(GL_TEXTURE_2D);
+	glColor3f(1, 1, 1);
+	for (i = 0; i < 4; i++) {
+		GLfloat x0 = -0.95f + i * 0.5f;
+		glBindTexture(GL_TEXTURE_2D, tex[i == 3]);
+		glBegin(GL_QUADS);
+		glTexCoord2f(0, 0);
+		glVertex2f(x0, -0.8f);
+		glTexCoord2f(1, 0);
+		glVertex2f(x0 + 0.4f, -0.8f);
+		glTexCoord2f(1, 1);
+		glVertex2f(x0 + 0.4f, 0.8f);
+		glTexCoord2f(0, 1);
+		glVertex2f(x0, 0.8f);
+		glEnd();
+		if (i == 0) {
+			before = glGetTexturePixmap(tex[0], 0, &w, &h);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 4, 4, 8, 8, GL_RGB, GL_UNSIGNED_BYTE, red);
+			after = glGetTexturePixmap(tex[0], 0, &w, &h);
+			check(before != after, "a texture sampled by queued triangles moves to its second buffer");
+		} else if (i == 1) {
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 10, 2, 4, 4, GL_RGB, GL_UNSIGNED_BYTE, blue);
+		} else if (i == 2) {
+			glBindTexture(GL_TEXTURE_2D, tex[1]);
+			before = glGetTexturePixmap(tex[1], 0, &w, &h);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 8, 8, GL_RGB, GL_UNSIGNED_BYTE, red);
+			after = glGetTexturePixmap(tex[1], 0, &w, &h);
+			check(before == after, "a texture no queued triangle samples is updated in place");
+		}
+	}
+	glDisable(GL_TEXTURE_2D);
+	ZB_setTiledRaster(frameBuffer, 0);
+	glDeleteTextures(2, tex);
+}
+#endif
+
+static const struct {
+	const char* name;
+	void (*draw)(void);
+} cases[] = {
+	{"depthfunc", caseDepthFunc},
+	{"blend", caseBlend},
+	{"alpha", caseAlpha},
+	{"mipmap", caseMipmap},
+	{"npot", caseNPOT},
+	{"texels", caseTexelFormats},
+	{"names", caseNames},
+	{"arena", caseArena},
+	{"peephole", casePeephole},
+	{"bc1", caseBC1},
+	{"elements", caseElements},
+	{"polyline", casePolyline},
+	{"colormask", caseColorMask},
+#if TGL_FEATURE_TILED_RASTER == 1
+	{"subimage", caseSubImage},
+#endif
+	{"listmesh", caseListMesh},
+	{"drawarrays", caseDrawArrays},
+	{"guardband", caseGuardBand},
+	{"lights", caseLights},
+	{"specular", caseSpecular},
+};
+
+int main(int argc, char** argv) {
+	PIXEL* imbuf = NULL;
+	uchar* pbuf = NULL;
+	char filename[64];
+	GLint i, c = -1;
+	for (i = 0; argc > 1 && i < (GLint)(sizeof(cases) / sizeof(cases[0])); i++)
+		if (!strcmp(argv[1], cases[i].name))
+			c = i;
+	if (c < 0) {
+		printf("usage: %s", argv[0]);
+		for (i = 0; i < (GLint)(sizeof(cases) / sizeof(cases[0])); i++)
+			printf("%s%s", i ? "|" : " ", cases[i].name);
+		printf("\n");
+		return 1;
+	}
+
+	if (TGL_FEATURE_RENDER_BITS == 32)
+		frameBuffer = ZB_open(SIZE_X, SIZE_Y, ZB_MODE_RGBA, 0);
+	else
+		frameBuffer = ZB_open(SIZE_X, SIZE_Y, ZB_MODE_5R6G5B, 0);
+	if (!frameBuffer) {
+		printf("ZB_open failed!\n");
+		return 1;
+	}
+	glInit(frameBuffer);
+	glViewport(0, 0, SIZE_X, SIZE_Y);
+	glClearColor(0.1f, 0.1f, 0.1f, 1);
+	glShadeModel(GL_SMOOTH);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	cases[c].draw();
+
+	imbuf = calloc(1, sizeof(PIXEL) * SIZE_X * SIZE_Y);
+	pbuf = malloc(3 * SIZE_X * SIZE_Y);
+	ZB_copyFrameBuffer(frameBuffer, imbuf, SIZE_X * sizeof(PIXEL));
+	for (i = 0; i < SIZE_X * SIZE_Y; i++) {
+		pbuf[3 * i + 0] = GET_RED(imbuf[i]);
+		pbuf[3 * i + 1] = GET_GREEN(imbuf[i]);
+		pbuf[3 * i + 2] = GET_BLUE(imbuf[i]);
+	}
+	snprintf(filename, sizeof(filename), "%s.png", cases[c].name);
+	stbi_write_png(filename, SIZE_X, SIZE_Y, 3, pbuf, 0);
+	free(imbuf);
+	free(pbuf);
+	glClose();
+	ZB_close(frameBuffer);
+	return failures != 0;
+}
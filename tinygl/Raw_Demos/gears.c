@@ -49,6 +49,7 @@ typedef unsigned char uchar;
 #define M_PI 3.14159265
 #endif
 int override_drawmodes = 0;
+int print_list_ops = 0;
 GLubyte stipplepattern[128] = {0xAA, 0xAA, 0xAA, 0xAA, 0x55, 0x55, 0x55, 0x55, 0xAA, 0xAA, 0xAA, 0xAA, 0x55, 0x55, 0x55, 0x55,
 							   0xAA, 0xAA, 0xAA, 0xAA, 0x55, 0x55, 0x55, 0x55, 0xAA, 0xAA, 0xAA, 0xAA, 0x55, 0x55, 0x55, 0x55,
 
@@ -240,6 +241,15 @@ void draw() {
 	glPopMatrix();
 }
 
+/* the ops of the list just compiled, before and after glEndList optimizes it */
+static void printListOps(const char* name) {
+	GLint ops[2];
+	if (!print_list_ops)
+		return;
+	glGetIntegerv(GL_LIST_OP_COUNT, ops);
+	printf("%s: %d ops, %d after glEndList\n", name, ops[0], ops[1]);
+}
+
 void initScene() {
 	// static GLfloat pos[4] = {0.408248290463863, 0.408248290463863, 0.816496580927726, 0.0 }; //Light at infinity.
 	static GLfloat pos[4] = {5, 5, 10, 0.0}; // Light at infinity.
@@ -274,6 +284,7 @@ void initScene() {
 	glColor3fv(blue);
 	gear(1.0, 4.0, 1.0, 20, 0.7); // The largest gear.
 	glEndList();
+	printListOps("gear1");
 
 	gear2 = glGenLists(1);
 	glNewList(gear2, GL_COMPILE);
@@ -282,6 +293,7 @@ void initScene() {
 	glColor3fv(red);
 	gear(0.5, 2.0, 2.0, 10, 0.7); // The small gear with the smaller hole, to the right.
 	glEndList();
+	printListOps("gear2");
 
 	gear3 = glGenLists(1);
 	glNewList(gear3, GL_COMPILE);
@@ -290,6 +302,7 @@ void initScene() {
 	glColor3fv(green);
 	gear(1.3, 2.0, 0.5, 10, 0.7); // The small gear above with the large hole.
 	glEndList();
+	printListOps("gear3");
 	// glEnable( GL_NORMALIZE );
 }
 
@@ -303,6 +316,9 @@ int main(int argc, char** argv) {
 	unsigned int setenspec = 1;
 	unsigned int dotext = 1;
 	unsigned int blending = 0;
+	unsigned int tiled = 0;
+	unsigned int halfspace = 0;
+	const char* outname = "render.png";
 	if (argc > 1) {
 		char* larg = "";
 		for (int i = 1; i < argc; i++) {
@@ -310,6 +326,8 @@ int main(int argc, char** argv) {
 				winSizeX = atoi(argv[i]);
 			if (!strcmp(larg, "-h"))
 				winSizeY = atoi(argv[i]);
+			if (!strcmp(larg, "-o"))
+				outname = argv[i];
 			if (!strcmp(argv[i],"-flat"))
 				flat = 1;
 			if (!strcmp(argv[i],"-smooth"))
@@ -324,6 +342,12 @@ int main(int argc, char** argv) {
 				override_drawmodes = 2;
 			if (!strcmp(argv[i],"-notext"))
 				dotext = 0;
+			if (!strcmp(argv[i],"-tiled"))
+				tiled = 1;
+			if (!strcmp(argv[i],"-halfspace"))
+				halfspace = 1;
+			if (!strcmp(argv[i],"-listops"))
+				print_list_ops = 1;
 			larg = argv[i];
 		}
 	}
@@ -340,6 +364,10 @@ int main(int argc, char** argv) {
 	else
 	 frameBuffer = ZB_open(winSizeX, winSizeY, ZB_MODE_5R6G5B, 0);
 	if(!frameBuffer){printf("\nZB_open failed!");exit(1);}
+#if TGL_FEATURE_TILED_RASTER == 1
+	if(tiled) ZB_setTiledRaster(frameBuffer, 1);
+#endif
+	if(halfspace) ZB_setRasterizer(frameBuffer, ZB_RASTER_HALFSPACE);
 	glInit(frameBuffer);
 
 	//Print version info
@@ -422,7 +450,7 @@ if(flat)	glShadeModel(GL_FLAT); else glShadeModel(GL_SMOOTH);
 			pbuf[3*i+1] = GET_GREEN(imbuf[i]);
 			pbuf[3*i+2] = GET_BLUE(imbuf[i]);
 		}
-		stbi_write_png("render.png", winSizeX, winSizeY, 3, pbuf, 0);
+		stbi_write_png(outname, winSizeX, winSizeY, 3, pbuf, 0);
 		free(imbuf);
 		free(pbuf);
 	} else if(TGL_FEATURE_RENDER_BITS == 16){
@@ -433,7 +461,7 @@ if(flat)	glShadeModel(GL_FLAT); else glShadeModel(GL_SMOOTH);
 			pbuf[3*i+1] = GET_GREEN(imbuf[i]);
 			pbuf[3*i+2] = GET_BLUE(imbuf[i]);
 		}
-		stbi_write_png("render.png", winSizeX, winSizeY, 3, pbuf, 0);
+		stbi_write_png(outname, winSizeX, winSizeY, 3, pbuf, 0);
 		free(imbuf);
 		free(pbuf);
 	}
@@ -38,6 +38,10 @@ GLuint do1D = 0;
 GLint Row1D = 30;
 GLint dorect = 0;
 GLfloat texture_mult = 1.0;
+GLint texture_format = 3; /* -dxt stores the textures compressed */
+GLint dostream = 0; /* -stream replaces a square of tex every frame, like a video feed */
+GLint tex_w = 0, tex_h = 0;
+#define STREAM_SIZE 64
 GLuint loadRGBTexture(unsigned char* buf, unsigned int w, unsigned int h) {
 	GLuint t = 0;
 	glGenTextures(1, &t);
@@ -57,7 +61,7 @@ GLuint loadRGBTexture(unsigned char* buf, unsigned int w, unsigned int h) {
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	if (!do1D)
-		glTexImage2D(GL_TEXTURE_2D, 0, 3, w, h, 0, GL_RGB, GL_UNSIGNED_BYTE, buf);
+		glTexImage2D(GL_TEXTURE_2D, 0, texture_format, w, h, 0, GL_RGB, GL_UNSIGNED_BYTE, buf);
 	else
 		glTexImage1D(GL_TEXTURE_1D, 0, 3, w, 0, GL_RGB, GL_UNSIGNED_BYTE, buf + Row1D * w * 3);
 	return t;
@@ -73,11 +77,31 @@ GLuint postProcessingStep(GLint x, GLint y, GLuint pixel, GLushort z) {
 #endif
 }
 
+void streamTexture(GLint frame) {
+	static GLubyte texels[STREAM_SIZE * STREAM_SIZE * 4];
+	GLint x, y;
+	if (tex_w < STREAM_SIZE || tex_h < STREAM_SIZE)
+		return;
+	for (y = 0; y < STREAM_SIZE; y++)
+		for (x = 0; x < STREAM_SIZE; x++) {
+			GLubyte* p = texels + 4 * (x + y * STREAM_SIZE);
+			p[0] = (x * 4 + frame * 3) & 255;
+			p[1] = (y * 4 + frame) & 255;
+			p[2] = ((x ^ y) * 4) & 255;
+			p[3] = 255;
+		}
+	glTexSubImage2D(GL_TEXTURE_2D, 0, (frame * 2) % (tex_w - STREAM_SIZE + 1), (tex_h - STREAM_SIZE) / 2, STREAM_SIZE, STREAM_SIZE, GL_BGRA,
+					GL_UNSIGNED_BYTE, texels);
+}
+
 void draw() {
+	static GLint frame = 0;
 	glClearColor(0.0, 0.0, 0.0, 0.0);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	glEnable(GL_TEXTURE_2D);
 	glBindTexture(GL_TEXTURE_2D, tex);
+	if (dostream && !do1D && texture_format == 3)
+		streamTexture(frame++);
 
 	if (dorect)
 		glColor3f(1.0, 1.0, 1.0);
@@ -129,6 +153,8 @@ void initScene() {
 		uchar* source_data = stbi_load("texture.png", &sw, &sh, &sc, 3);
 		if (source_data) {
 			tex = loadRGBTexture(source_data, sw, sh);
+			tex_w = sw;
+			tex_h = sh;
 			free(source_data);
 		} else {
 			printf("\nCan't load texture!\n");
@@ -160,6 +186,10 @@ int main(int argc, char** argv) {
 				doPostProcess = 1;
 			if (!strcmp(argv[i], "-rect"))
 				dorect = 1;
+			if (!strcmp(argv[i], "-dxt"))
+				texture_format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+			if (!strcmp(argv[i], "-stream"))
+				dostream = 1;
 			if (!strcmp(larg, "-w"))
 				winSizeX = atoi(argv[i]);
 			if (!strcmp(larg, "-h"))
@@ -32,6 +32,7 @@ enum {
 	GL_4_BYTES			= 0x1409,
 	GL_UNSIGNED_SHORT_5_6_5 = 0x140A,
 	GL_UNSIGNED_INT_8_8_8_8 = 0x140B,
+	GL_UNSIGNED_INT_8_8_8_8_REV = 0x8367,
 
 	/* Primitives */
 	GL_LINES			= 0x0001,
@@ -157,6 +158,7 @@ enum {
 	GL_MAX_DISPLAY_LISTS = 0xf006,
 	GL_ERROR_CHECK_LEVEL = 0xf007,
 	GL_IS_SPECULAR_ENABLED = 0xf008,
+	GL_LIST_OP_COUNT = 0xf009,
 	
 	/* Depth buffer */
 	GL_NEVER			= 0x0200,
@@ -373,6 +375,7 @@ enum {
 	GL_DITHER			= 0x0BD0,
 	GL_RGB				= 0x1907,
 	GL_RGBA				= 0x1908,
+	GL_BGRA				= 0x80E1,
 
 	/* Implementation limits */
 	GL_MAX_LIST_NESTING		= 0x0B31,
@@ -528,6 +531,7 @@ enum {
 	GL_TEXTURE_HEIGHT		= 0x1001,
 	GL_TEXTURE_BORDER		= 0x1005,
 	GL_TEXTURE_COMPONENTS		= 0x1003,
+	GL_COMPRESSED_RGB_S3TC_DXT1_EXT	= 0x83F0,
 	GL_NEAREST_MIPMAP_NEAREST	= 0x2700,
 	GL_NEAREST_MIPMAP_LINEAR	= 0x2702,
 	GL_LINEAR_MIPMAP_NEAREST	= 0x2701,
@@ -794,12 +798,17 @@ void glReadPixels(	GLint x,
 void glDrawArrays(	GLenum mode,
  					GLint first,
  					GLsizei count);
+void glDrawElements(	GLenum mode,
+ 					GLsizei count,
+ 					GLenum type,
+ 					const GLvoid* indices);
 
 void glSetEnableSpecular(GLint s); 
 void* glGetTexturePixmap(GLint text, GLint level, GLint* xsize, GLint* ysize); 
 void glDrawText(const GLubyte* text, GLint x, GLint y, GLuint pixel); 
 void glTextSize(GLTEXTSIZE mode); 
 void glPlotPixel(GLint x, GLint y, GLuint pixel); 
+void glDrawPolyline(GLsizei n, const GLfloat* points, const GLfloat* colors);
 
 #define PROTO_GL1(name)				\
 void gl ## name ## 1f(GLfloat);	\
@@ -897,6 +906,9 @@ void glTexImage2D( GLint target, GLint level, GLint components,
 void glTexImage1D( GLint target, GLint level, GLint components,
 		    		GLint width, GLint border,
                     GLint format, GLint type, void *pixels);
+void glTexSubImage2D( GLint target, GLint level, GLint xoffset, GLint yoffset,
+		    GLint width, GLint height,
+                    GLint format, GLint type, void *pixels);
 void glCopyTexImage2D(	GLenum target,
 					 	GLint level,
 					 	GLenum internalformat,
@@ -969,9 +981,12 @@ void glPolygonOffset(GLfloat factor, GLfloat units);
 void glBlendFunc(GLint, GLint);
 void glBlendEquation(GLenum mode);
 void glDepthMask(GLint);
+void glDepthFunc(GLenum func);
+void glColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha);
 
 /* Point Size */
 void glPointSize(GLfloat);
+void glLineWidth(GLfloat);
 
 /* Raster rendering */
 void glRasterPos2f(GLfloat, GLfloat);
@@ -990,8 +1005,6 @@ void glPostProcess(GLuint (*postprocess)(GLint x, GLint y, GLuint pixel, GLushor
   /*
 
   
-inline void glLineWidth(GLfloat) {}
-inline void glDepthFunc(GLint) {}
 
 inline void glTexEnvf(GLint, GLint, GLint) {}
 inline void glOrtho(GLfloat,GLfloat,GLfloat,GLfloat,GLfloat,GLfloat){}
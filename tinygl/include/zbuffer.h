@@ -9,9 +9,18 @@
 #include "GL/gl.h"
 
 
+#if TGL_FEATURE_DEPTH_BITS == 16
 #define ZB_Z_BITS 16
-
 #define ZB_POINT_Z_FRAC_BITS 14
+/* one depth value */
+typedef GLushort ZPIXEL;
+#elif TGL_FEATURE_DEPTH_BITS == 24
+#define ZB_Z_BITS 24
+#define ZB_POINT_Z_FRAC_BITS 6
+typedef GLuint ZPIXEL;
+#else
+#error "wrong TGL_FEATURE_DEPTH_BITS"
+#endif
 
 
 
@@ -47,12 +56,16 @@
 #define COLOR_G_GET16(g) ((((g)) >> 13) & 0x07E0)
 #define COLOR_B_GET16(b) (((b) >> 19) & 31)
 
+/* a is a 0..255 byte, see ZB_ALPHA */
 #if TGL_FEATURE_RENDER_BITS == 32
 #define RGB_TO_PIXEL(r,g,b) \
   ( COLOR_R_GET32(r) | COLOR_G_GET32(g) | COLOR_B_GET32(b) )
+#define RGBA_TO_PIXEL(r,g,b,a) \
+  ( RGB_TO_PIXEL(r,g,b) | ((GLuint)(a) << 24) )
 #elif TGL_FEATURE_RENDER_BITS == 16
 #define RGB_TO_PIXEL(r,g,b) \
 	( COLOR_R_GET16(r) | COLOR_G_GET16(g) | COLOR_B_GET16(b)  )
+#define RGBA_TO_PIXEL(r,g,b,a) RGB_TO_PIXEL(r,g,b)
 #endif
 /*This is how textures are sampled. if you want to do some sort of fancy texture filtering,*/
 /*you do it here.*/
@@ -60,6 +73,18 @@
  (*(PIXEL*)( (GLbyte*)texture + 															\
  ST_TO_TEXTURE_BYTE_OFFSET(s,t) 								\
  ))
+/*The same for textures of any size: the fraction of the texture coordinate, scaled by the size.*/
+#define ZB_ST_FRAC_BITS (1+TGL_FEATURE_TEXTURE_POW2+ZB_POINT_S_FRAC_BITS)
+#if ZB_ST_FRAC_BITS + TGL_FEATURE_TEXTURE_MAX_POW2 > 31
+#error "TGL_FEATURE_TEXTURE_MAX_POW2 is too large for TGL_FEATURE_TEXTURE_POW2"
+#endif
+#define ZB_S_FRAC(s) ((GLuint)(s) & ((1<<ZB_ST_FRAC_BITS)-1))
+#define ZB_T_FRAC(t) (((GLuint)(t) >> (ZB_POINT_T_FRAC_BITS-ZB_POINT_S_FRAC_BITS)) & ((1<<ZB_ST_FRAC_BITS)-1))
+/* size of mip level l, the sides halve down to 1 */
+#define ZB_TEXTURE_LEVEL_SIZE(size, l) ((size) >> (l) ? (size) >> (l) : 1)
+#define TEXTURE_SIZED_SAMPLE(texture, s, t, xsize, ysize)                                                                                                      \
+ (texture[((ZB_S_FRAC(s) * (xsize)) >> ZB_ST_FRAC_BITS) +                                                                                                      \
+ ((ZB_T_FRAC(t) * (ysize)) >> ZB_ST_FRAC_BITS) * (xsize)])
 /* display modes */
 #define ZB_MODE_5R6G5B  1  /* true color 16 bits */
 #define ZB_MODE_INDEX   2  /* color index 8 bits */
@@ -67,10 +92,62 @@
 #define ZB_MODE_RGB24   4  /* 24 bit rgb mode */
 #define ZB_NB_COLORS    225 /* number of colors for 8 bit display */
 
+/* triangle rasterizers */
+#define ZB_RASTER_SCANLINE  0
+#define ZB_RASTER_HALFSPACE 1
+#if TGL_FEATURE_HALFSPACE_RASTER == 1
+#define ZB_RASTERIZERS 2
+#else
+#define ZB_RASTERIZERS 1
+#endif
+
+/* triangle kernels */
+#define ZB_FILL_FLAT              0
+#define ZB_FILL_SMOOTH            1
+#define ZB_FILL_TEXTURED          2 /* TGL_FEATURE_TEXTURE_DIM square textures */
+#define ZB_FILL_DEPTH_ONLY        3
+#define ZB_FILL_TEXTURED_SIZED    4 /* other sizes */
+#if TGL_FEATURE_TEXTURE_FILTER == 1
+#define ZB_FILL_TEXTURED_FILTERED 5 /* any size, see ZB_setTextureFilter */
+#define ZB_FILL_FILTER_MODES      1
+#else
+#define ZB_FILL_FILTER_MODES      0
+#endif
+#if TGL_FEATURE_TEXTURE_COMPRESSION == 1
+#define ZB_FILL_TEXTURED_BC1      (5 + ZB_FILL_FILTER_MODES) /* any size, BC1 compressed */
+#define ZB_FILL_MODES             (6 + ZB_FILL_FILTER_MODES)
+#else
+#define ZB_FILL_MODES             (5 + ZB_FILL_FILTER_MODES)
+#endif
+
+/* the depth test of lines, points and glDrawPixels. larger z is closer: GL_LESS passes when z > zpix */
+#if TGL_FEATURE_DEPTH_FUNC == 1
+#define ZB_DEPTH_PASS(func, z, zpix)                                                                                                                           \
+	((func) == GL_LEQUAL     ? (z) >= (zpix)                                                                                                                   \
+	 : (func) == GL_LESS     ? (z) > (zpix)                                                                                                                    \
+	 : (func) == GL_EQUAL    ? (z) == (zpix)                                                                                                                   \
+	 : (func) == GL_GEQUAL   ? (z) <= (zpix)                                                                                                                   \
+	 : (func) == GL_GREATER  ? (z) < (zpix)                                                                                                                    \
+	 : (func) == GL_NOTEQUAL ? (z) != (zpix)                                                                                                                   \
+	                         : (func) == GL_ALWAYS)
+/* depth functions under which nothing behind the hierarchical Z bound can pass */
+#define ZB_DEPTH_CULLS(func) ((func) == GL_LEQUAL || (func) == GL_LESS || (func) == GL_EQUAL)
+#else
+#define ZB_DEPTH_PASS(func, z, zpix) ((void)(func), (z) >= (zpix))
+#define ZB_DEPTH_CULLS(func) 1
+#endif
+
 
 
 #define TGL_CLAMPI(imp) ( (imp>0)?((imp>COLOR_MASK)?COLOR_MASK:imp):0   )
 
+/* alpha to a 0..255 blend weight. alpha is stored like r, g, b, so 1.0 is 0xfe, which is stretched to 0xff */
+#define ZB_ALPHA(a) ((((a) >> COLOR_SHIFT) & 0xff) + ((((a) >> COLOR_SHIFT) & 0xff) >> 7))
+/* x * a / 255 for bytes, rounded */
+#define TGL_MUL255(x, a) (((x) * (a) + 128 + (((x) * (a) + 128) >> 8)) >> 8)
+/* scale a blend operand by a weight */
+#define TGL_BLEND_ALPHA(c, a) (TGL_MUL255(((c) >> COLOR_SHIFT) & 0xff, (a)) << COLOR_SHIFT)
+
 
 
 
@@ -85,6 +162,11 @@
 #define GET_RED(p) ((p>>16)&0xff)
 #define GET_GREEN(p) ((p>>8)&0xff)
 #define GET_BLUE(p) (p&0xff)
+/* the top byte is the alpha channel */
+#define GET_ALPHAER(p) ((p >> 8) & 0xff0000)
+#define GET_ALPHA(p) ((p>>24)&0xff)
+/* the bits of the channels glColorMask lets through */
+#define ZB_COLOR_MASK(r, g, b, a) (((r) ? 0xff0000u : 0) | ((g) ? 0xff00u : 0) | ((b) ? 0xffu : 0) | ((a) ? 0xff000000u : 0))
 typedef GLuint PIXEL;
 #define PSZB 4
 #define PSZSH 5
@@ -99,7 +181,11 @@ typedef GLuint PIXEL;
 #define GET_RED(p) ((p & 0xF800)>>8)
 #define GET_GREEN(p) ((p & 0x07E0)>>3)
 #define GET_BLUE(p) ((p & 31)<<3)
-
+/* no alpha channel, it reads as opaque */
+#define GET_ALPHAER(p) (0xff0000)
+#define GET_ALPHA(p) (0xff)
+/* the bits of the channels glColorMask lets through. there is no alpha to mask */
+#define ZB_COLOR_MASK(r, g, b, a) (((r) ? 0xF800 : 0) | ((g) ? 0x07E0 : 0) | ((b) ? 0x001F : 0))
 
 typedef GLushort PIXEL;
 #define PSZB 2 
@@ -110,15 +196,37 @@ typedef GLushort PIXEL;
 #error "wrong TGL_FEATURE_RENDER_BITS"
 #endif
 
+#if TGL_FEATURE_TEXTURE_COMPRESSION == 1
+/* two 5R6G5B colors, then 2 bits per texel of the 4x4 block */
+#define ZB_BC1_BLOCK_SIZE 8
+#define ZB_BC1_BLOCKS(xsize, ysize) ((((xsize) + 3) >> 2) * (((ysize) + 3) >> 2))
+/* decoded blocks kept by a textured kernel, a power of 2. neighbouring blocks of a row use different entries */
+#define ZB_BLOCK_CACHE_SIZE 4
+typedef struct {
+	GLint block[ZB_BLOCK_CACHE_SIZE]; /* block index + 1, 0 for an empty entry */
+	GLuint bits[ZB_BLOCK_CACHE_SIZE];  /* 2 bit palette index per texel */
+	PIXEL palette[ZB_BLOCK_CACHE_SIZE][4];
+} ZBBlockCache;
+#endif
+
 #if TGL_FEATURE_LIT_TEXTURES == 1
 #define RGB_MIX_FUNC(rr, gg, bb, tpix) \
 	RGB_TO_PIXEL( \
-		((rr * GET_RED(tpix))>>8),\
-		((gg * GET_GREEN(tpix))>>8),\
-		((bb * GET_BLUE(tpix))>>8)\
+		((rr * GET_RED(tpix))>>8),                                                                                                                             \
+		((gg * GET_GREEN(tpix))>>8),                                                                                                                           \
+		((bb * GET_BLUE(tpix))>>8)                                                                                                                             \
+	)
+/* GL_MODULATE on the alpha channel too, aa is a 0..255 byte */
+#define RGBA_MIX_FUNC(rr, gg, bb, aa, tpix) \
+	RGBA_TO_PIXEL( \
+		((rr * GET_RED(tpix))>>8),                                                                                                                             \
+		((gg * GET_GREEN(tpix))>>8),                                                                                                                           \
+		((bb * GET_BLUE(tpix))>>8),                                                                                                                            \
+		TGL_MUL255(aa, GET_ALPHA(tpix))                                                                                                                        \
 	)
 #else
 #define RGB_MIX_FUNC(rr, gg, bb, tpix)(tpix)
+#define RGBA_MIX_FUNC(rr, gg, bb, aa, tpix)(tpix)
 #endif
 
 
@@ -126,134 +234,197 @@ typedef GLushort PIXEL;
 #define TGL_NO_BLEND_FUNC(source, dest){dest = source;}
 #define TGL_NO_BLEND_FUNC_RGB(rr, gg, bb, dest){dest = RGB_TO_PIXEL(rr,gg,bb);}
 
+/* glColorMask with every channel on */
+#define ZB_COLOR_MASK_ALL ((PIXEL)~0)
+/* newpix in the bits of mask, oldpix in the others */
+#define ZB_MASK_PIXEL(newpix, oldpix, mask) (((newpix) & (mask)) | ((oldpix) & ~(mask)))
+/*
+ * Whether colour writes go through TGL_BLEND_FUNC, which reads the pixel back: for blending, or to keep the channels
+ * a partial glColorMask leaves alone. Without blending it stores the source with GL_ONE, GL_ZERO.
+ */
+#if TGL_FEATURE_BLEND == 1
+#define ZB_MERGES_COLOR(zb) ((zb)->enable_blend || (zb)->color_mask != ZB_COLOR_MASK_ALL)
+#else
+#define ZB_MERGES_COLOR(zb) ((zb)->color_mask != ZB_COLOR_MASK_ALL)
+#endif
+
 #if TGL_FEATURE_BLEND == 1
-#define TGL_BLEND_VARS GLuint zbblendeq = zb->blendeq; GLuint sfactor = zb->sfactor; GLuint dfactor = zb->dfactor;
+#define TGL_BLEND_VARS																	\
+	GLuint zbblendeq = zb->enable_blend ? zb->blendeq : GL_FUNC_ADD;					\
+	GLuint sfactor = zb->enable_blend ? zb->sfactor : GL_ONE;							\
+	GLuint dfactor = zb->enable_blend ? zb->dfactor : GL_ZERO;							\
+	PIXEL zbcm = zb->color_mask;
 
 /*SORCERY to achieve 32 bit signed integer clamping*/
 
 
-#define TGL_BLEND_SWITCH_CASE(sr,sg,sb,dr,dg,db,dest) 									\
-		switch(zbblendeq){															\
+#define TGL_BLEND_SWITCH_CASE(sr,sg,sb,sa,dr,dg,db,da,dest)								\
+		switch(zbblendeq){																\
 			case GL_FUNC_ADD:															\
 			default:																	\
-				sr+=dr;sg+=dg;sb+=db;													\
+				sr+=dr;sg+=dg;sb+=db;sa+=da;											\
 				sr = TGL_CLAMPI(sr);													\
 				sg = TGL_CLAMPI(sg);													\
 				sb = TGL_CLAMPI(sb);													\
-				dest = RGB_TO_PIXEL(sr,sg,sb);											\
+				sa = TGL_CLAMPI(sa);													\
+				dest = RGBA_TO_PIXEL(sr,sg,sb,sa >> COLOR_SHIFT);						\
 			break;																		\
 			case GL_FUNC_SUBTRACT:														\
-				sr-=dr;sg-=dg;sb-=db;													\
+				sr-=dr;sg-=dg;sb-=db;sa-=da;											\
 				sr = TGL_CLAMPI(sr);													\
 				sg = TGL_CLAMPI(sg);													\
 				sb = TGL_CLAMPI(sb);													\
-				dest = RGB_TO_PIXEL(sr,sg,sb);											\
+				sa = TGL_CLAMPI(sa);													\
+				dest = RGBA_TO_PIXEL(sr,sg,sb,sa >> COLOR_SHIFT);						\
 			break;																		\
 			case GL_FUNC_REVERSE_SUBTRACT:												\
-				sr=dr-sr;sg=dg-sg;sb=db-sb;												\
+				sr=dr-sr;sg=dg-sg;sb=db-sb;sa=da-sa;									\
 				sr = TGL_CLAMPI(sr);													\
 				sg = TGL_CLAMPI(sg);													\
 				sb = TGL_CLAMPI(sb);													\
-				dest = RGB_TO_PIXEL(sr,sg,sb);											\
+				sa = TGL_CLAMPI(sa);													\
+				dest = RGBA_TO_PIXEL(sr,sg,sb,sa >> COLOR_SHIFT);						\
 			break;																		\
-			  																			\
 		}
 
+/* scale the four operands of one side by a 0..255 weight */
+#define TGL_BLEND_SCALE(r,g,b,a,w){														\
+	GLint _w = (w);																		\
+	r = TGL_BLEND_ALPHA(r, _w);															\
+	g = TGL_BLEND_ALPHA(g, _w);															\
+	b = TGL_BLEND_ALPHA(b, _w);															\
+	a = TGL_BLEND_ALPHA(a, _w);}
 
-
-
-#define TGL_BLEND_FUNC(source, dest){													\
-	{																					\
-	GLuint sr, sg, sb, dr, dg, db;														\
-	{	GLuint temp = source;																\
-	sr = GET_REDDER(temp); sg = GET_GREENER(temp); sb = GET_BLUEER(temp);						\
-	temp = dest;																			\
-	dr = GET_REDDER(temp); dg = GET_GREENER(temp); db = GET_BLUEER(temp);}						\
-		/*printf("\nShould never reach this point!");*/									\
-		switch(sfactor){															\
+#define TGL_BLEND_FACTORS(sr,sg,sb,sa,dr,dg,db,da,alpha)								\
+		switch(sfactor){																\
 			case GL_ONE:																\
 			default:																	\
 			break;																		\
 			case GL_ONE_MINUS_SRC_COLOR:												\
-			sr = ~sr & COLOR_MASK;															\
-			sg = ~sg & COLOR_MASK;															\
-			sb = ~sb & COLOR_MASK;															\
+			sr = ~sr & COLOR_MASK;														\
+			sg = ~sg & COLOR_MASK;														\
+			sb = ~sb & COLOR_MASK;														\
+			sa = ~sa & COLOR_MASK;														\
 			break;																		\
 			case GL_ZERO:																\
-			sr=0;sg=0;sb=0;break;														\
+			sr=0;sg=0;sb=0;sa=0;														\
+			break;																		\
+			case GL_SRC_ALPHA:															\
+			TGL_BLEND_SCALE(sr,sg,sb,sa,alpha)											\
+			break;																		\
+			case GL_ONE_MINUS_SRC_ALPHA:												\
+			TGL_BLEND_SCALE(sr,sg,sb,sa,255 - (alpha))									\
+			break;																		\
+			case GL_DST_ALPHA:															\
+			TGL_BLEND_SCALE(sr,sg,sb,sa,da >> COLOR_SHIFT)								\
+			break;																		\
+			case GL_ONE_MINUS_DST_ALPHA:												\
+			TGL_BLEND_SCALE(sr,sg,sb,sa,255 - (da >> COLOR_SHIFT))						\
 			break;																		\
 		}																				\
-		switch(dfactor){															\
+		switch(dfactor){																\
 				case GL_ONE:															\
 				default:																\
 				break;																	\
 				case GL_ONE_MINUS_DST_COLOR:											\
-				dr = ~dr & COLOR_MASK;														\
-				dg = ~dg & COLOR_MASK;														\
-				db = ~db & COLOR_MASK;														\
+				dr = ~dr & COLOR_MASK;													\
+				dg = ~dg & COLOR_MASK;													\
+				db = ~db & COLOR_MASK;													\
+				da = ~da & COLOR_MASK;													\
 				break;																	\
 				case GL_ZERO:															\
-				dr=0;dg=0;db=0;break;													\
+				dr=0;dg=0;db=0;da=0;													\
+				break;																	\
+				case GL_SRC_ALPHA:														\
+				TGL_BLEND_SCALE(dr,dg,db,da,alpha)										\
+				break;																	\
+				case GL_ONE_MINUS_SRC_ALPHA:											\
+				TGL_BLEND_SCALE(dr,dg,db,da,255 - (alpha))								\
+				break;																	\
+				case GL_DST_ALPHA:														\
+				TGL_BLEND_SCALE(dr,dg,db,da,da >> COLOR_SHIFT)							\
+				break;																	\
+				case GL_ONE_MINUS_DST_ALPHA:											\
+				TGL_BLEND_SCALE(dr,dg,db,da,255 - (da >> COLOR_SHIFT))					\
 				break;																	\
-			}																			\
-		TGL_BLEND_SWITCH_CASE(sr,sg,sb,dr,dg,db,dest)									\
+			}
+
+
+
+#define TGL_BLEND_FUNC(source, alpha, dest){											\
+	{																					\
+	GLint sr, sg, sb, sa = (alpha) << COLOR_SHIFT, dr, dg, db, da;						\
+	PIXEL _old = dest;																	\
+	{	GLuint temp = source;															\
+	sr = GET_REDDER(temp); sg = GET_GREENER(temp); sb = GET_BLUEER(temp);				\
+	temp = _old;																		\
+	dr = GET_REDDER(temp); dg = GET_GREENER(temp); db = GET_BLUEER(temp); da = GET_ALPHAER(temp);}	\
+		TGL_BLEND_FACTORS(sr,sg,sb,sa,dr,dg,db,da,alpha)								\
+		TGL_BLEND_SWITCH_CASE(sr,sg,sb,sa,dr,dg,db,da,dest)								\
+		dest = ZB_MASK_PIXEL(dest, _old, zbcm);											\
 	}																					\
 } 
 
-#define TGL_BLEND_FUNC_RGB(rr, gg, bb, dest){											\
+#define TGL_BLEND_FUNC_RGB(rr, gg, bb, alpha, dest){									\
 	{																					\
-		GLint sr = rr & COLOR_MASK, sg = gg & COLOR_MASK, sb = bb & COLOR_MASK, dr, dg, db;			\
-		{GLuint temp = dest;																\
-		dr = GET_REDDER(temp); dg = GET_GREENER(temp); db = GET_BLUEER(temp);}					\
-	/*printf("\nShould never reach this point!");*/										\
-		switch(sfactor){																\
-			case GL_ONE:																\
-			default:																	\
-			break;																		\
-			case GL_ONE_MINUS_SRC_COLOR:												\
-			sr = ~sr & COLOR_MASK;															\
-			sg = ~sg & COLOR_MASK;															\
-			sb = ~sb & COLOR_MASK;															\
-			break;																		\
-			case GL_ZERO:																\
-			sr=0;sg=0;sb=0;break;														\
-			break;																		\
-		}																				\
-		switch(dfactor){															\
-				case GL_ONE:															\
-				default:																\
-				break;																	\
-				case GL_ONE_MINUS_DST_COLOR:											\
-				dr = ~dr & COLOR_MASK;														\
-				dg = ~dg & COLOR_MASK;														\
-				db = ~db & COLOR_MASK;														\
-				break;																	\
-				case GL_ZERO:															\
-				dr=0;dg=0;db=0;break;													\
-				break;																	\
-		}																				\
-		TGL_BLEND_SWITCH_CASE(sr,sg,sb,dr,dg,db,dest)									\
+		GLint sr = rr & COLOR_MASK, sg = gg & COLOR_MASK, sb = bb & COLOR_MASK, sa = (alpha) << COLOR_SHIFT, dr, dg, db, da;	\
+		PIXEL _old = dest;																\
+		{GLuint temp = _old;															\
+		dr = GET_REDDER(temp); dg = GET_GREENER(temp); db = GET_BLUEER(temp); da = GET_ALPHAER(temp);}	\
+		TGL_BLEND_FACTORS(sr,sg,sb,sa,dr,dg,db,da,alpha)								\
+		TGL_BLEND_SWITCH_CASE(sr,sg,sb,sa,dr,dg,db,da,dest)								\
+		dest = ZB_MASK_PIXEL(dest, _old, zbcm);											\
 	}																					\
 } 
 
 #else
-#define TGL_BLEND_VARS /* a comment */
-#define TGL_BLEND_FUNC(source, dest){dest = source;}
-#define TGL_BLEND_FUNC_RGB(rr, gg, bb, dest){dest = RGB_TO_PIXEL(rr,gg,bb);}
+#define TGL_BLEND_VARS PIXEL zbcm = zb->color_mask;
+#define TGL_BLEND_FUNC(source, alpha, dest){dest = ZB_MASK_PIXEL(source, dest, zbcm);}
+#define TGL_BLEND_FUNC_RGB(rr, gg, bb, alpha, dest){dest = ZB_MASK_PIXEL(RGBA_TO_PIXEL(rr,gg,bb,alpha), dest, zbcm);}
 #endif
 
 
+#if TGL_FEATURE_SIMD_SPANS == 1
+/* span writers draw the leading n & ~(lanes - 1) pixels of a span and return how many they drew */
+typedef GLint (*ZB_spanFlatFunc)(PIXEL *pp, ZPIXEL *pz, GLint n, GLuint z, GLint dzdx,
+		 PIXEL color, GLint zbdt, GLint zbdw);
+typedef GLint (*ZB_spanSmoothFunc)(PIXEL *pp, ZPIXEL *pz, GLint n, GLuint z, GLint dzdx,
+		 GLint r, GLint g, GLint b, GLint a, GLint drdx, GLint dgdx, GLint dbdx, GLint dadx, GLint zbdt, GLint zbdw);
+/* depth only, always writes depth */
+typedef GLint (*ZB_spanDepthFunc)(ZPIXEL *pz, GLint n, GLuint z, GLint dzdx, GLint zbdt);
+#if TGL_FEATURE_BLEND == 1
+/* blended smooth span with a ZBufferPoint alpha. flat spans pass zero gradients */
+typedef GLint (*ZB_spanBlendFunc)(PIXEL *pp, ZPIXEL *pz, GLint n, GLuint z, GLint dzdx,
+		 GLint r, GLint g, GLint b, GLint a, GLint drdx, GLint dgdx, GLint dbdx, GLint dadx, GLint zbdt, GLint zbdw);
+/* the blend states with their own span writer, all with GL_FUNC_ADD */
+#define ZB_SPAN_BLEND_ADD       0 /* GL_ONE, GL_ONE */
+#define ZB_SPAN_BLEND_ALPHA     1 /* GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA */
+#define ZB_SPAN_BLEND_ALPHA_ADD 2 /* GL_SRC_ALPHA, GL_ONE */
+#define ZB_SPAN_BLENDS          3
+#endif
+#endif
+
 typedef struct {
 
     
     
-    GLushort *zbuf;
+    ZPIXEL *zbuf;
     PIXEL *pbuf;
     PIXEL *current_texture;
+    GLint texture_xsize, texture_ysize;
+#if TGL_FEATURE_TEXTURE_FILTER == 1
+    /* mip levels of the current texture, the last one is texture_levels[texture_max_level]. see ZB_setTextureFilter */
+    PIXEL *texture_levels[TGL_FEATURE_TEXTURE_MAX_POW2 + 1];
+    GLint texture_max_level;
+    GLint texture_min_linear, texture_mag_linear;
+#endif
     
 
 	/* point size*/
     GLfloat pointsize;
+    /* glLineWidth and GL_LINE_SMOOTH, see ZB_polyline */
+    GLfloat linewidth;
+    GLint line_smooth;
 
 
 
@@ -272,17 +443,53 @@ typedef struct {
     /* depth */
     GLint depth_test;
     GLint depth_write;
+    /* GL_NEVER ... GL_ALWAYS */
+    GLenum depth_func;
+    /* the PIXEL bits glColorMask lets through, see ZB_COLOR_MASK */
+    PIXEL color_mask;
+    /* 0 when that is none of them: only depth is drawn */
+    GLint color_write;
     GLubyte frame_buffer_allocated;
+    /* triangle scissor rectangle, inclusive. the whole buffer unless drawing a tile */
+    GLint clip_xmin, clip_xmax, clip_ymin, clip_ymax;
+    /* ZB_RASTER_* */
+    GLint rasterizer;
+#if TGL_FEATURE_TILED_RASTER == 1
+    /* deferred triangle bins, NULL in immediate mode */
+    struct ZBTiles *tiles;
+#endif
+#if TGL_FEATURE_HIZ == 1
+    /* farthest depth of each TGL_HIZ_POW2 block, -1 when it must be read back from zbuf */
+    GLint *hiz;
+    GLint hiz_xsize, hiz_ysize;
+#endif
+#if TGL_FEATURE_SIMD_SPANS == 1
+    /* NULL when the CPU has no usable vector unit */
+    ZB_spanFlatFunc span_flat;
+    ZB_spanSmoothFunc span_smooth;
+    ZB_spanDepthFunc span_depth;
+#if TGL_FEATURE_BLEND == 1
+    /* indexed by ZB_SPAN_BLEND_*, never NULL. see ZB_spanBlend */
+    ZB_spanBlendFunc span_blend[ZB_SPAN_BLENDS];
+#endif
+#endif
 } ZBuffer;
 
 typedef struct {
   GLint x,y,z;     /* integer coordinates in the zbuffer */
   GLint s,t;       /* coordinates for the mapping */
-  GLint r,g,b;     /* color indexes */
+  GLint r,g,b,a;   /* color indexes, a is only used for blending */
   
   GLfloat sz,tz;   /* temporary coordinates for mapping */
 } ZBufferPoint;
 
+/* a polyline point. x and y keep their fraction: the center of pixel i is at i + 0.5 */
+typedef struct {
+  GLfloat x,y;
+  GLint z;
+  GLint r,g,b,a;
+} ZBufferLinePoint;
+
 /* zbuffer.c */
 
 ZBuffer *ZB_open(int xsize,int ysize,int mode,
@@ -296,9 +503,11 @@ void ZB_close(ZBuffer *zb);
 
 void ZB_resize(ZBuffer *zb,void *frame_buffer,GLint xsize,GLint ysize);
 void ZB_clear(ZBuffer *zb,GLint clear_z,GLint z,
-	      GLint clear_color,GLint r,GLint g,GLint b);
+	      GLint clear_color,GLint r,GLint g,GLint b,GLint a);
 /* linesize is in BYTES */
 void ZB_copyFrameBuffer(ZBuffer *zb,void *buf,GLint linesize);
+/* select the triangle rasterizer, ZB_RASTER_SCANLINE or ZB_RASTER_HALFSPACE. returns 0 if unavailable. */
+GLint ZB_setRasterizer(ZBuffer *zb, GLint rasterizer);
 
 /* zdither.c */
 
@@ -314,10 +523,17 @@ void ZB_ditherFrameBuffer(ZBuffer *zb,unsigned char *dest,
 void ZB_plot(ZBuffer *zb,ZBufferPoint *p);
 void ZB_line(ZBuffer *zb,ZBufferPoint *p1,ZBufferPoint *p2);
 void ZB_line_z(ZBuffer * zb, ZBufferPoint * p1, ZBufferPoint * p2);
+/* the segments between the n points of p. p[-1] comes before them unless first is set, p[n] after them unless last is */
+void ZB_polyline(ZBuffer *zb, ZBufferLinePoint *p, GLint n, GLint first, GLint last);
 
 /* ztriangle.c */
 
-void ZB_setTexture(ZBuffer *zb, PIXEL *texture);
+void ZB_setTexture(ZBuffer *zb, PIXEL *texture, GLint xsize, GLint ysize);
+#if TGL_FEATURE_TEXTURE_FILTER == 1
+/* call after ZB_setTexture. mipmap is NULL or the levels 1 and up, halving each side down to 1x1, one after the other.
+   returns 1 when the filtered textured kernels are needed, 0 for GL_NEAREST without mipmaps */
+GLint ZB_setTextureFilter(ZBuffer *zb, PIXEL *mipmap, GLint min_filter, GLint mag_filter);
+#endif
 
 void ZB_fillTriangleFlat(ZBuffer *zb,
 		 ZBufferPoint *p1,ZBufferPoint *p2,ZBufferPoint *p3);
@@ -343,9 +559,123 @@ void ZB_fillTriangleMappingPerspective(ZBuffer *zb,
 void ZB_fillTriangleMappingPerspectiveNOBLEND(ZBuffer *zb,
                     ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2);
 
+/* writes depth only, see glColorMask */
+void ZB_fillTriangleDepthOnly(ZBuffer *zb,
+		 ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2);
+
+/* textures of any size */
+void ZB_fillTriangleMappingPerspectiveSized(ZBuffer *zb,
+                    ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2);
+void ZB_fillTriangleMappingPerspectiveSizedNOBLEND(ZBuffer *zb,
+                    ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2);
+
+#if TGL_FEATURE_TEXTURE_COMPRESSION == 1
+/* BC1 compressed textures, current_texture points at the blocks */
+void ZB_fillTriangleMappingPerspectiveBC1(ZBuffer *zb,
+                    ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2);
+void ZB_fillTriangleMappingPerspectiveBC1NOBLEND(ZBuffer *zb,
+                    ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2);
+#endif
+
+#if TGL_FEATURE_TEXTURE_FILTER == 1
+/* bilinear and/or mipmapped, see ZB_setTextureFilter */
+void ZB_fillTriangleMappingPerspectiveFiltered(ZBuffer *zb,
+                    ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2);
+void ZB_fillTriangleMappingPerspectiveFilteredNOBLEND(ZBuffer *zb,
+                    ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2);
+#endif
+
 typedef void (*ZB_fillTriangleFunc)(ZBuffer  *,
 	    ZBufferPoint *,ZBufferPoint *,ZBufferPoint *);
 
+/* indexed by [depth function - GL_NEVER][rasterizer][ZB_FILL_MODES][blend] */
+extern const ZB_fillTriangleFunc ZB_fillTriangleFuncs[8][ZB_RASTERIZERS][ZB_FILL_MODES][2];
+
+#if TGL_FEATURE_HALFSPACE_RASTER == 1
+void ZB_fillTriangleHalfSpaceFlat(ZBuffer *zb,
+		 ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2);
+void ZB_fillTriangleHalfSpaceFlatNOBLEND(ZBuffer *zb,
+		 ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2);
+void ZB_fillTriangleHalfSpaceSmooth(ZBuffer *zb,
+		 ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2);
+void ZB_fillTriangleHalfSpaceSmoothNOBLEND(ZBuffer *zb,
+		 ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2);
+void ZB_fillTriangleHalfSpaceMappingPerspective(ZBuffer *zb,
+		 ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2);
+void ZB_fillTriangleHalfSpaceMappingPerspectiveNOBLEND(ZBuffer *zb,
+		 ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2);
+void ZB_fillTriangleHalfSpaceDepthOnly(ZBuffer *zb,
+		 ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2);
+void ZB_fillTriangleHalfSpaceMappingPerspectiveSized(ZBuffer *zb,
+		 ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2);
+void ZB_fillTriangleHalfSpaceMappingPerspectiveSizedNOBLEND(ZBuffer *zb,
+		 ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2);
+#if TGL_FEATURE_TEXTURE_COMPRESSION == 1
+void ZB_fillTriangleHalfSpaceMappingPerspectiveBC1(ZBuffer *zb,
+		 ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2);
+void ZB_fillTriangleHalfSpaceMappingPerspectiveBC1NOBLEND(ZBuffer *zb,
+		 ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2);
+#endif
+#if TGL_FEATURE_TEXTURE_FILTER == 1
+void ZB_fillTriangleHalfSpaceMappingPerspectiveFiltered(ZBuffer *zb,
+		 ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2);
+void ZB_fillTriangleHalfSpaceMappingPerspectiveFilteredNOBLEND(ZBuffer *zb,
+		 ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2);
+#endif
+#endif
+
+/* ztile.c */
+
+#if TGL_FEATURE_TILED_RASTER == 1
+/* switch between immediate (the default) and deferred tile-binned rasterization */
+GLint ZB_setTiledRaster(ZBuffer *zb, GLint enable);
+void ZB_queueTriangle(ZBuffer *zb, ZB_fillTriangleFunc fill,
+		 ZBufferPoint *p0,ZBufferPoint *p1,ZBufferPoint *p2);
+/* draw every queued triangle, one thread per tile */
+void ZB_flushTiles(ZBuffer *zb);
+void ZB_discardTiles(ZBuffer *zb);
+/*
+ identifies the triangles queued since the last flush (or discard), 0 when there are none.
+ memory they reference is free again once the value has changed
+*/
+GLuint ZB_tileBatch(ZBuffer *zb);
+#define ZB_FLUSH_TILES(zb) {if ((zb)->tiles) ZB_flushTiles(zb);}
+#define ZB_TILE_BATCH(zb) ((zb)->tiles ? ZB_tileBatch(zb) : 0)
+#else
+#define ZB_FLUSH_TILES(zb) /* a comment */
+#define ZB_TILE_BATCH(zb) 0
+#endif
+
+/* zhiz.c */
+
+#if TGL_FEATURE_HIZ == 1
+GLint ZB_hizAlloc(ZBuffer *zb);
+void ZB_hizFree(ZBuffer *zb);
+void ZB_hizClear(ZBuffer *zb, GLint z);
+/* call after writing depth values in the rectangle (inclusive) by other means than ZB_clear */
+void ZB_hizInvalidate(ZBuffer *zb, GLint xmin, GLint ymin, GLint xmax, GLint ymax);
+/* 1 if no depth value of the rectangle (inclusive) is <= zmax, so nothing there can pass the depth test */
+GLint ZB_hizOccluded(ZBuffer *zb, GLint xmin, GLint ymin, GLint xmax, GLint ymax, GLint zmax);
+/* upper bound of the depth values a triangle can write */
+GLint ZB_hizNearest(ZBufferPoint *p0, ZBufferPoint *p1, ZBufferPoint *p2);
+/* triangle setup: 1 if the triangle is hidden, otherwise marks the blocks where it may lower depth values as stale */
+GLint ZB_hizTriangle(ZBuffer *zb, ZBufferPoint *p0, ZBufferPoint *p1, ZBufferPoint *p2);
+#define ZB_HIZ_INVALIDATE(zb, xmin, ymin, xmax, ymax) ZB_hizInvalidate(zb, xmin, ymin, xmax, ymax)
+#else
+#define ZB_HIZ_INVALIDATE(zb, xmin, ymin, xmax, ymax) /* a comment */
+#endif
+
+/* zspan.c */
+
+#if TGL_FEATURE_SIMD_SPANS == 1
+/* pick the span writers for this CPU */
+void ZB_initSpans(ZBuffer *zb);
+#if TGL_FEATURE_BLEND == 1
+/* the span writer for the current blend state, NULL if it has none */
+ZB_spanBlendFunc ZB_spanBlend(ZBuffer *zb);
+#endif
+#endif
+
 /* memory.c */
 #if TGL_FEATURE_CUSTOM_MALLOC == 1
 void gl_free(void *p);
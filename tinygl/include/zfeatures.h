@@ -30,6 +30,19 @@ And because some systems may have float types which are incompatible with it.
 #define TGL_FEATURE_ARRAYS         1
 
 #define TGL_FEATURE_DISPLAYLISTS   1
+/*
+glEndList bakes the Begin/End blocks of a list that only hold glVertex, glNormal, glColor and glTexCoord calls
+into arrays, which glCallList feeds to the vertex pipeline in one loop instead of decoding each call.
+A vertex repeated in a block is stored once, with an index array, and shaded once per glCallList.
+*/
+#define TGL_FEATURE_LIST_MESHES    1
+/*
+Before that, glEndList drops the glColor, glNormal, glTexCoord and glShadeModel calls of a list that set what is
+already set or is set again before being used, folds runs of matrix calls into one, and joins consecutive
+glBegin/glEnd blocks of points, lines, triangles or quads. glGetIntegerv(GL_LIST_OP_COUNT) gives the calls
+of the last list compiled before and after.
+*/
+#define TGL_FEATURE_LIST_PEEPHOLE  1
 
 #define TGL_FEATURE_LIT_TEXTURES   1
 /*Enable the patternized "discard"-ing of pixels.*/
@@ -46,9 +59,26 @@ the maximum number of vertices in a polygon is defined in zgl.h
 #define TGL_FEATURE_BLEND 			1
 
 #define TGL_FEATURE_BLEND_DRAW_PIXELS 0
-/*The width of textures as a power of 2. The default is 8, or 256x256 textures.*/
+/*
+Textures can have any size up to 2^TGL_FEATURE_TEXTURE_MAX_POW2 on each side, power of two or not,
+and are stored at that size. 2^TGL_FEATURE_TEXTURE_POW2 square textures (256x256 by default) are drawn
+by kernels with the size built in, other sizes by slightly slower ones that wrap s and t with a multiply.
+*/
 #define TGL_FEATURE_TEXTURE_POW2	8
 #define TGL_FEATURE_TEXTURE_DIM		(1<<TGL_FEATURE_TEXTURE_POW2)
+#define TGL_FEATURE_TEXTURE_MAX_POW2 11
+#define TGL_FEATURE_TEXTURE_MAX_DIM	(1<<TGL_FEATURE_TEXTURE_MAX_POW2)
+/*
+GL_TEXTURE_MIN_FILTER and GL_TEXTURE_MAG_FILTER: bilinear sampling and mipmaps.
+The mip chain of a texture is only built once a mipmap minification filter is set on it,
+and textures left at GL_NEAREST keep using the unfiltered kernels.
+*/
+#define TGL_FEATURE_TEXTURE_FILTER	1
+/*
+glTexImage2D with the GL_COMPRESSED_RGB_S3TC_DXT1_EXT internal format: the image is stored as BC1 blocks,
+4 bits per texel instead of TGL_FEATURE_RENDER_BITS, and decoded a 4x4 block at a time while drawing.
+*/
+#define TGL_FEATURE_TEXTURE_COMPRESSION	1
 
 /*A stipple pattern is 128 bytes in size.*/
 #define TGL_POLYGON_STIPPLE_BYTES 128
@@ -57,8 +87,22 @@ the maximum number of vertices in a polygon is defined in zgl.h
 #define TGL_POLYGON_STIPPLE_MASK_X 31
 #define TGL_POLYGON_STIPPLE_MASK_Y 31
 
-/*Use lookup tables for calculating specular light.*/
-#define TGL_FEATURE_SPECULAR_BUFFERS 0
+/*
+Triangles that cross the sides of the viewport are drawn as they are, and scissored by the rasterizers,
+as long as they stay within TGL_GUARD_BAND pixels of it. Only the near and far planes, and the triangles
+that reach past the guard band, are clipped. Lines and points are always clipped, and so is everything when the
+viewport does not cover the whole zbuffer.
+The rasterizers use 32 bit fixed point, which bounds the guard band to a few thousand pixels.
+*/
+#define TGL_FEATURE_GUARD_BAND 1
+#define TGL_GUARD_BAND 2048
+
+/*
+Use lookup tables for the specular light of glVertex and glArrayElement, about 3 times faster than pow.
+There is a table per shininess that is a multiple of 1/4, made on first use and shared by all threads.
+Batched vertices (display lists and glDrawArrays) use pow, which vectorizes.
+*/
+#define TGL_FEATURE_SPECULAR_BUFFERS 1
 
 /*Prevent ZB_copyFrameBuffer from copying certain colors.*/
 #define TGL_FEATURE_NO_COPY_COLOR 0
@@ -81,6 +125,58 @@ the maximum number of vertices in a polygon is defined in zgl.h
 
 #define TGL_FEATURE_MULTITHREADED_ZB_COPYBUFFER 0
 
+/*
+Deferred, tile-binned triangle rasterization (see ZB_setTiledRaster in zbuffer.h).
+Triangles are queued per screen tile and drawn by one thread per tile when the zbuffer is flushed.
+Immediate rasterization stays the default until it is enabled at runtime.
+*/
+#define TGL_FEATURE_TILED_RASTER 1
+/*Tiles are 2^6 (64x64) pixels.*/
+#define TGL_TILE_POW2 6
+/*The queue is flushed automatically once this many triangles are pending.*/
+#define TGL_TILE_MAX_TRIANGLES 65536
+
+/*
+Block based half-space (edge function) triangle rasterizer, selectable at runtime with ZB_setRasterizer.
+The scanline rasterizer remains the default.
+*/
+#define TGL_FEATURE_HALFSPACE_RASTER 1
+
+/*
+Vectorized (AVX2 or SSE4.1) span writers for flat, smooth, depth only and blended triangles, see zspan.c,
+and SSSE3 swizzles for 32 bit texture uploads, see image_util.c.
+The instruction set is detected at runtime; other CPUs and the 16 bit mode use the scalar kernels.
+*/
+#define TGL_FEATURE_SIMD_SPANS 1
+
+/*
+Hierarchical Z, see zhiz.c. The zbuffer keeps the farthest depth of every 2^TGL_HIZ_POW2 sized block,
+and triangles (and half-space blocks) that are entirely behind it are rejected before being scan converted.
+*/
+#define TGL_FEATURE_HIZ 1
+/*Blocks are 2^3 (8x8) pixels, the half-space rasterizer block size.*/
+#define TGL_HIZ_POW2 3
+
+/*
+Depth buffer precision, 16 or 24 bits.
+16 bit depth is stored as a GLushort per pixel. 24 bit depth is stored as a GLuint per pixel:
+the zbuffer takes twice the memory, and every depth test and write moves twice the bytes,
+which costs a few percent of fill rate on depth bound scenes. Use it for long scenes with
+fine details close to each other, which z-fight with 16 bits.
+Both modes use the same 30 bit fixed point depth interpolator, only the split between the
+stored bits and the fractional bits changes, so the triangle setup cost is the same.
+*/
+#define TGL_FEATURE_DEPTH_BITS 16
+
+/*
+glDepthFunc. The triangle kernels are compiled once for each of GL_LEQUAL, GL_LESS, GL_EQUAL and
+GL_ALWAYS, so their comparison costs nothing per pixel. The other functions share one more set that
+compares at runtime. Five sets instead of one take the triangle kernels from about 0.4 MB to 2 MB of
+code on x86-64, and their compile time grows to match.
+Disable it to keep the library small: glDepthFunc is then accepted but triangles always use GL_LEQUAL.
+*/
+#define TGL_FEATURE_DEPTH_FUNC 1
+
 /*
 !!!!!WARNING!!!!!
 TGL_FEATURE_ALIGNAS assumes that the implementation's malloc (AND REALLOC) are 16-byte aligned.
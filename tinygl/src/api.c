@@ -186,6 +186,24 @@ void glPolygonMode(GLint face, GLint mode) {
 	gl_add_op(p);
 }
 
+void glDepthFunc(GLenum func) {
+	GLParam p[2];
+#define NEED_CONTEXT
+#include "error_check_no_context.h"
+#if TGL_FEATURE_ERROR_CHECK == 1
+	if (func < GL_NEVER || func > GL_ALWAYS)
+#define ERROR_FLAG GL_INVALID_ENUM
+#include "error_check.h"
+#else
+	if (func < GL_NEVER || func > GL_ALWAYS)
+		return;
+#endif
+		p[0].op = OP_DepthFunc;
+	p[1].i = func;
+
+	gl_add_op(p);
+}
+
 void glDepthMask(GLint i) {
 #include "error_check_no_context.h"
 	gl_get_context()->zb->depth_write = (i == GL_TRUE);
@@ -527,6 +545,23 @@ void glTexImage1D(GLint target, GLint level, GLint components, GLint width, GLin
 	gl_add_op(p);
 }
 
+void glTexSubImage2D(GLint target, GLint level, GLint xoffset, GLint yoffset, GLint width, GLint height, GLint format, GLint type, void* pixels) {
+	GLParam p[10];
+#include "error_check_no_context.h"
+	p[0].op = OP_TexSubImage2D;
+	p[1].i = target;
+	p[2].i = level;
+	p[3].i = xoffset;
+	p[4].i = yoffset;
+	p[5].i = width;
+	p[6].i = height;
+	p[7].i = format;
+	p[8].i = type;
+	p[9].p = pixels;
+
+	gl_add_op(p);
+}
+
 void glBindTexture(GLint target, GLint texture) {
 	GLParam p[3];
 #include "error_check_no_context.h"
@@ -552,18 +587,14 @@ void glTexEnvi(GLint target, GLint pname, GLint param) {
 }
 
 void glTexParameteri(GLint target, GLint pname, GLint param) {
-
+	GLParam p[4];
 #include "error_check_no_context.h"
+	p[0].op = OP_TexParameter;
+	p[1].i = target;
+	p[2].i = pname;
+	p[3].i = param;
 
-
-
-
-
-
-
-
-
-
+	gl_add_op(p);
 }
 
 /*
@@ -632,8 +663,7 @@ void glCallList(GLuint list) {
 
 	gl_add_op(p);
 }
-void glFlush(void) { /* nothing to do */
-}
+void glFlush(void) { ZB_FLUSH_TILES(gl_get_context()->zb); }
 
 void glHint(GLint target, GLint mode) {
 #include "error_check_no_context.h"
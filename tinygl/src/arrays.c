@@ -7,17 +7,18 @@
 static GLint free_buffer(GLint handle) {
 	GLContext* c = gl_get_context();
 	GLSharedState* s = &(c->shared_state);
-	if (handle == 0 || handle > MAX_BUFFERS)
+	GLBuffer* buf;
+	if (handle == 0)
 		return 1; 
 
-	handle--;
-	if (s->buffers[handle]) { 
-		if (c->boundarraybuffer == (handle + 1))
+	buf = gl_deleteName(&s->buffers, handle);
+	if (buf) { 
+		if (c->boundarraybuffer == handle)
 			c->boundarraybuffer = 0;
-		if (s->buffers[handle]->data) 
+		if (buf->data) 
 		{
-			void* d = s->buffers[handle]->data;
-			gl_free(s->buffers[handle]->data); 
+			void* d = buf->data;
+			gl_free(buf->data); 
 			
 			if (c->vertex_array == d) {
 				c->vertex_array = NULL;
@@ -36,8 +37,7 @@ static GLint free_buffer(GLint handle) {
 				c->client_states &= ~TEXCOORD_ARRAY;
 			}
 		}
-		gl_free(s->buffers[handle]); 
-		s->buffers[handle] = NULL;   
+		gl_free(buf); 
 		return 0;
 	} else {
 		return 0;
@@ -46,10 +46,9 @@ static GLint free_buffer(GLint handle) {
 static GLint check_buffer(GLint handle) { 
 	GLContext* c = gl_get_context();
 	GLSharedState* s = &(c->shared_state);
-	if (handle == 0 || handle > MAX_BUFFERS)
+	if (handle == 0)
 		return 2; 
-	handle--;
-	if (s->buffers[handle])
+	if (gl_findName(&s->buffers, handle))
 		return 1;
 	return 0;
 }
@@ -64,23 +63,19 @@ static GLBuffer* get_buffer(GLint handle) {
 	GLSharedState* s;
 	c = gl_get_context();
 	s = &(c->shared_state);
-	if (handle == 0 || handle > MAX_BUFFERS)
-		return NULL;
-	handle--;
-	return s->buffers[handle];
+	return gl_findName(&s->buffers, handle);
 }
 static GLint create_buffer(GLint handle) {
 	GLContext* c = gl_get_context();
 	GLSharedState* s = &(c->shared_state);
-	if (handle == 0 || handle > MAX_BUFFERS)
+	GLBuffer* buf;
+	if (handle == 0)
 		return 1; 
-	handle--;	 
-	if (s->buffers[handle])
-		free_buffer(handle + 1); 
-	
-	s->buffers[handle] = gl_zalloc(sizeof(GLBuffer));
+	buf = gl_zalloc(sizeof(GLBuffer));
 
-	if (!(s->buffers[handle])) {
+	if (!buf || !gl_setName(&s->buffers, handle, buf)) {
+		if (buf)
+			gl_free(buf);
 #if TGL_FEATURE_ERROR_CHECK == 1
 #define ERROR_FLAG GL_OUT_OF_MEMORY
 #define RETVAL 1
@@ -89,8 +84,8 @@ static GLint create_buffer(GLint handle) {
 		gl_fatal_error("GL_OUT_OF_MEMORY");
 #endif
 	}
-	s->buffers[handle]->data = NULL;
-	s->buffers[handle]->size = 0;
+	buf->data = NULL;
+	buf->size = 0;
 	return 0;
 }
 
@@ -98,25 +93,11 @@ void glGenBuffers(GLsizei n, GLuint* buffers) {
 	GLint i;
 	GLContext* c = gl_get_context();
 #include "error_check.h"
-	if (n > MAX_BUFFERS)
+	if (!gl_genNames(&c->shared_state.buffers, n, buffers))
 		goto error;
-
-	{
-		GLint n_left = n;
-		GLuint names[MAX_BUFFERS];
-		for (i = 1; i <= MAX_BUFFERS && n_left > 0; i++)
-			if (!check_buffer(i))
-				names[(n_left--) - 1] = i;
-
-		if (n_left)
-			goto error; 
-		for (i = 0; i < n; i++) {
-			create_buffer(names[i]);
-
-
+	for (i = 0; i < n; i++) {
+		create_buffer(buffers[i]);
 #include "error_check.h"
-			buffers[i] = names[i];
-		}
 	}
 	return;
 error:
@@ -195,7 +176,7 @@ void glBindBufferAsArray(GLenum target, GLuint buffer,
 		return;
 #endif
 	}
-	GLBuffer* buf = c->shared_state.buffers[buffer - 1];
+	GLBuffer* buf = get_buffer(buffer);
 	if (!buf || (buf->data == NULL) || (buf->size == 0)) {
 #if TGL_FEATURE_ERROR_CHECK == 1
 #define ERROR_FLAG GL_INVALID_OPERATION
@@ -250,7 +231,7 @@ void* glMapBuffer(GLenum target, GLenum access) {
 		handle = c->boundcolorbuffer;
 	{
 		if (check_buffer(handle) == 1)
-			return c->shared_state.buffers[handle - 1]->data;
+			return get_buffer(handle)->data;
 	}
 #if TGL_FEATURE_ERROR_CHECK == 1
 #define RETVAL NULL
@@ -278,7 +259,7 @@ void glBufferData(GLenum target, GLsizei size, const void* data,
 	if (target == GL_COLOR_BUFFER)
 		handle = c->boundcolorbuffer;
 	if (check_buffer(handle) == 1)
-		buf = c->shared_state.buffers[handle - 1];
+		buf = get_buffer(handle);
 	else {
 #if TGL_FEATURE_ERROR_CHECK == 1
 #define ERROR_FLAG GL_INVALID_ENUM
@@ -307,11 +288,10 @@ void glBufferData(GLenum target, GLsizei size, const void* data,
 		memcpy(buf->data, data, size);
 }
 
-void glopArrayElement(GLParam* param) {
+/* makes the color, normal and texture coordinates of element idx current */
+static void array_attributes(GLContext* c, GLint idx) {
 	GLint i;
-	GLContext* c = gl_get_context();
 	GLint states = c->client_states;
-	GLint idx = param[1].i;
 
 	if (states & COLOR_ARRAY) {
 		GLParam p[5];
@@ -338,7 +318,15 @@ void glopArrayElement(GLParam* param) {
 		c->current_tex_coord.Z = (size > 2) ? c->texcoord_array[i + 2] : 0.0f;
 		c->current_tex_coord.W = (size > 3) ? c->texcoord_array[i + 3] : 1.0f;
 	}
-	if (states & VERTEX_ARRAY) {
+}
+
+void glopArrayElement(GLParam* param) {
+	GLint i;
+	GLContext* c = gl_get_context();
+	GLint idx = param[1].i;
+
+	array_attributes(c, idx);
+	if (c->client_states & VERTEX_ARRAY) {
 		GLParam p[5];
 		GLint size = c->vertex_array_size;
 		i = idx * (size + c->vertex_array_stride);
@@ -358,15 +346,160 @@ void glArrayElement(GLint i) {
 	gl_add_op(p);
 }
 
+/* the n elements of the arrays from first on, or the ones in indices, as a batch of c->batch */
+static void gather_batch(GLContext* c, const GLuint* indices, GLint first, GLint n) {
+	GLVertexBatch* b = &c->batch;
+	GLint states = c->client_states;
+	GLint i, j, e, size, stride;
+	GLfloat* a;
+
+	b->n = n;
+	b->normal_start = b->color_start = b->tex_coord_start = 0;
+	for (j = 0; j < 4; j++)
+		b->coord[j] = b->in[j];
+	size = c->vertex_array_size;
+	stride = size + c->vertex_array_stride;
+	for (i = 0; i < n; i++) {
+		e = indices ? (GLint)indices[i] : first + i;
+		a = c->vertex_array + e * stride;
+		b->in[0][i] = a[0];
+		b->in[1][i] = a[1];
+		b->in[2][i] = (size > 2) ? a[2] : 0.0f;
+		b->in[3][i] = (size > 3) ? a[3] : 1.0f;
+	}
+
+	for (j = 0; j < 3; j++)
+		b->normal[j] = (states & NORMAL_ARRAY) ? b->in[4 + j] : NULL;
+	if (states & NORMAL_ARRAY) {
+		stride = 3 + c->normal_array_stride;
+		for (i = 0; i < n; i++) {
+			e = indices ? (GLint)indices[i] : first + i;
+			a = c->normal_array + e * stride;
+			for (j = 0; j < 3; j++)
+				b->in[4 + j][i] = a[j];
+		}
+	}
+
+	for (j = 0; j < 4; j++)
+		b->color[j] = (states & COLOR_ARRAY) ? b->in[7 + j] : NULL;
+	if (states & COLOR_ARRAY) {
+		size = c->color_array_size;
+		stride = size + c->color_array_stride;
+		for (i = 0; i < n; i++) {
+			e = indices ? (GLint)indices[i] : first + i;
+			a = c->color_array + e * stride;
+			for (j = 0; j < 3; j++)
+				b->in[7 + j][i] = a[j];
+			b->in[10][i] = (size > 3) ? a[3] : 1.0f;
+		}
+	}
+
+	for (j = 0; j < 4; j++)
+		b->tex_coord[j] = (states & TEXCOORD_ARRAY) ? b->in[11 + j] : NULL;
+	if (states & TEXCOORD_ARRAY) {
+		size = c->texcoord_array_size;
+		stride = size + c->texcoord_array_stride;
+		for (i = 0; i < n; i++) {
+			e = indices ? (GLint)indices[i] : first + i;
+			a = c->texcoord_array + e * stride;
+			b->in[11][i] = a[0];
+			b->in[12][i] = a[1];
+			b->in[13][i] = (size > 2) ? a[2] : 0.0f;
+			b->in[14][i] = (size > 3) ? a[3] : 1.0f;
+		}
+	}
+}
+
 void glDrawArrays(GLenum mode, GLint first, GLsizei count) {
 	GLint i;
 	GLint end;
-	
-#include "error_check_no_context.h"
+	GLContext* c = gl_get_context();
+#include "error_check.h"
 	end = first + count;
 	glBegin(mode);
-	for (i = first; i < end; i++)
-		glArrayElement(i);
+	/* display lists keep the ArrayElement calls */
+	if (!c->compile_flag && (c->client_states & VERTEX_ARRAY)) {
+		for (i = first; i < end; i += VERTEX_BATCH_SIZE) {
+			gather_batch(c, NULL, i, end - i < VERTEX_BATCH_SIZE ? end - i : VERTEX_BATCH_SIZE);
+			gl_vertex_batch(c, &c->batch);
+		}
+	} else {
+		for (i = first; i < end; i++)
+			glArrayElement(i);
+	}
+	glEnd();
+}
+
+static GLuint element(GLenum type, const GLvoid* indices, GLint i) {
+	switch (type) {
+	case GL_UNSIGNED_BYTE:
+		return ((const GLubyte*)indices)[i];
+	case GL_UNSIGNED_SHORT:
+		return ((const GLushort*)indices)[i];
+	default:
+		return ((const GLuint*)indices)[i];
+	}
+}
+
+/*
+ each element missing from the post-transform cache is shaded once, in batches, and the cached vertices are copied
+ to the primitives. a batch ends before a miss would replace a cache entry that the batch already uses
+*/
+void glDrawElements(GLenum mode, GLsizei count, GLenum type, const GLvoid* indices) {
+	GLContext* c = gl_get_context();
+	GLuint misses[VERTEX_BATCH_SIZE];
+	GLVertex* out[VERTEX_BATCH_SIZE];
+	GLubyte used[VERTEX_CACHE_SIZE];
+	GLuint e;
+	GLint i, j, n, slot;
+#include "error_check.h"
+#if TGL_FEATURE_ERROR_CHECK == 1
+	if (type != GL_UNSIGNED_BYTE && type != GL_UNSIGNED_SHORT && type != GL_UNSIGNED_INT)
+#define ERROR_FLAG GL_INVALID_ENUM
+#include "error_check.h"
+	if (count < 0)
+#define ERROR_FLAG GL_INVALID_VALUE
+#include "error_check.h"
+#else
+	if ((type != GL_UNSIGNED_BYTE && type != GL_UNSIGNED_SHORT && type != GL_UNSIGNED_INT) || count < 0)
+		return;
+#endif
+	glBegin(mode);
+	/* display lists keep the ArrayElement calls */
+	if (c->compile_flag || !(c->client_states & VERTEX_ARRAY)) {
+		for (i = 0; i < count; i++)
+			glArrayElement(element(type, indices, i));
+		glEnd();
+		return;
+	}
+
+	/* empty: i + 1 is in another slot, every index is valid */
+	for (i = 0; i < VERTEX_CACHE_SIZE; i++)
+		c->vertex_cache_index[i] = i + 1;
+	for (i = 0; i < count;) {
+		memset(used, 0, sizeof(used));
+		for (j = i, n = 0; j < count; j++) {
+			e = element(type, indices, j);
+			slot = e & (VERTEX_CACHE_SIZE - 1);
+			if (c->vertex_cache_index[slot] != e) {
+				if (used[slot] || n == VERTEX_BATCH_SIZE)
+					break;
+				c->vertex_cache_index[slot] = e;
+				misses[n] = e;
+				out[n++] = &c->vertex_cache[slot];
+			}
+			used[slot] = 1;
+		}
+		if (n > 0) {
+			gather_batch(c, misses, 0, n);
+			gl_shade_batch(c, &c->batch, out);
+		}
+		for (; i < j; i++)
+			gl_draw_vertex(c, &c->vertex_cache[element(type, indices, i) & (VERTEX_CACHE_SIZE - 1)]);
+	}
+	/* the attributes left by the last element, as glArrayElement leaves them */
+	if (count > 0)
+		array_attributes(c, element(type, indices, count - 1));
 	glEnd();
 }
 
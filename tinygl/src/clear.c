@@ -15,12 +15,22 @@ void glopClearDepth(GLParam* p) {
 void glopClear(GLParam* p) {
 	GLContext* c = gl_get_context();
 	GLint mask = p[1].i;
-	GLint z = 0;
+	GLfloat d = c->clear_depth;
+	GLint z;
 	GLint r = (GLint)(c->clear_color.v[0] * COLOR_MULT_MASK);
 	GLint g = (GLint)(c->clear_color.v[1] * COLOR_MULT_MASK);
 	GLint b = (GLint)(c->clear_color.v[2] * COLOR_MULT_MASK);
+	GLint a = (GLint)(c->clear_color.v[3] * COLOR_MULT_MASK);
 
-	/* TODO : correct value of Z */
+	/* depth 1.0 is the farthest, zbuffer value 0 (see gl_eval_viewport) */
+	if (d < 0)
+		d = 0;
+	if (d > 1)
+		d = 1;
+	z = (GLint)((1.0f - d) * ((1 << ZB_Z_BITS) - 1) + 0.5f);
 
-	ZB_clear(c->zb, mask & GL_DEPTH_BUFFER_BIT, z, mask & GL_COLOR_BUFFER_BIT, r, g, b);
+	/* glColorMask applies to glClear too */
+	if (!c->zb->color_write)
+		mask &= ~GL_COLOR_BUFFER_BIT;
+	ZB_clear(c->zb, mask & GL_DEPTH_BUFFER_BIT, z, mask & GL_COLOR_BUFFER_BIT, r, g, b, a);
 }
@@ -23,6 +23,8 @@ static void gl_transform_to_viewport_clip_c(GLVertex* v) { /* MARK: NOT_INLINED_
 	v->zp.r = (GLint)(v->color.v[0] * COLOR_CORRECTED_MULT_MASK + COLOR_MIN_MULT) & COLOR_MASK;
 	v->zp.g = (GLint)(v->color.v[1] * COLOR_CORRECTED_MULT_MASK + COLOR_MIN_MULT) & COLOR_MASK;
 	v->zp.b = (GLint)(v->color.v[2] * COLOR_CORRECTED_MULT_MASK + COLOR_MIN_MULT) & COLOR_MASK;
+	/* clamped, so interpolated alpha cannot wrap around. see ZB_ALPHA */
+	v->zp.a = (GLint)(clampf(v->color.v[3], 0, 1) * COLOR_CORRECTED_MULT_MASK + COLOR_MIN_MULT) & COLOR_MASK;
 
 	/* texture */
 
@@ -116,7 +118,7 @@ static void GLinterpolate(GLVertex* q, GLVertex* p0, GLVertex* p1, GLfloat t) {
 #ifdef _OPENMP
 #pragma omp simd
 #endif
-	for (i = 0; i < 3; i++)
+	for (i = 0; i < 4; i++)
 		q->color.v[i] = p0->color.v[i] + (p1->color.v[i] - p0->color.v[i]) * t;
 }
 
@@ -207,6 +209,7 @@ void gl_draw_line(GLVertex* p1, GLVertex* p2) {
 
 /*Triangles*/
 
+/* interpolates the attributes of the new vertex q, whose pc is set */
 static void updateTmp(GLVertex* q, GLVertex* p0, GLVertex* p1, GLfloat t) { 
 	GLContext* c = gl_get_context();
 	{
@@ -214,6 +217,7 @@ static void updateTmp(GLVertex* q, GLVertex* p0, GLVertex* p1, GLfloat t) {
 		q->color.v[0] = p0->color.v[0] + (p1->color.v[0] - p0->color.v[0]) * t;
 		q->color.v[1] = p0->color.v[1] + (p1->color.v[1] - p0->color.v[1]) * t;
 		q->color.v[2] = p0->color.v[2] + (p1->color.v[2] - p0->color.v[2]) * t;
+		q->color.v[3] = p0->color.v[3] + (p1->color.v[3] - p0->color.v[3]) * t;
 	}
 
 #if TGL_OPTIMIZATION_HINT_BRANCH_COST < 1
@@ -225,165 +229,175 @@ static void updateTmp(GLVertex* q, GLVertex* p0, GLVertex* p1, GLfloat t) {
 	}
 
 	q->clip_code = gl_clipcode(q->pc.X, q->pc.Y, q->pc.Z, q->pc.W);
-	if (q->clip_code == 0)
-		gl_transform_to_viewport_clip_c(q);
 }
 
-static void gl_draw_triangle_clip(GLVertex* p0, GLVertex* p1, GLVertex* p2, GLint clip_bit); 
+/* culls and draws a triangle whose vertices are mapped to the viewport */
+static inline void gl_draw_triangle_visible(GLContext* c, GLVertex* p0, GLVertex* p1, GLVertex* p2) {
+	GLint front;
+	GLfloat norm;
+	norm = (GLfloat)(p1->zp.x - p0->zp.x) * (GLfloat)(p2->zp.y - p0->zp.y) - (GLfloat)(p2->zp.x - p0->zp.x) * (GLfloat)(p1->zp.y - p0->zp.y);
 
-void gl_draw_triangle(GLVertex* p0, GLVertex* p1, GLVertex* p2) {
-	GLContext* c = gl_get_context();
-	GLint co, cc[3], front;
-
-	cc[0] = p0->clip_code;
-	cc[1] = p1->clip_code;
-	cc[2] = p2->clip_code;
-
-	co = cc[0] | cc[1] | cc[2];
-
-	/* we handle the non clipped case here to go faster */
-	if (co == 0) {
-		GLfloat norm;
-		norm = (GLfloat)(p1->zp.x - p0->zp.x) * (GLfloat)(p2->zp.y - p0->zp.y) - (GLfloat)(p2->zp.x - p0->zp.x) * (GLfloat)(p1->zp.y - p0->zp.y);
+	if (norm == 0) 
+		return;
 
-		if (norm == 0) 
-			return;
+	front = norm < 0.0;
+	front = front ^ c->current_front_face; 
 
-		front = norm < 0.0;
-		front = front ^ c->current_front_face; 
-
-		/* back face culling */
-		if (c->cull_face_enabled) {
-			/* most used case first */
-			if (c->current_cull_face == GL_BACK) {
-				if (front == 0)
-					return;
-				c->draw_triangle_front(p0, p1, p2);
-			} else if (c->current_cull_face == GL_FRONT) {
-				if (front != 0)
-					return;
-				c->draw_triangle_back(p0, p1, p2);
-			} else {
+	/* back face culling */
+	if (c->cull_face_enabled) {
+		/* most used case first */
+		if (c->current_cull_face == GL_BACK) {
+			if (front == 0)
 				return;
-			}
+			c->draw_triangle_front(p0, p1, p2);
+		} else if (c->current_cull_face == GL_FRONT) {
+			if (front != 0)
+				return;
+			c->draw_triangle_back(p0, p1, p2);
 		} else {
-			/* no culling */
-			if (front) {
-				c->draw_triangle_front(p0, p1, p2);
-			} else {
-				c->draw_triangle_back(p0, p1, p2);
-			}
+			return;
 		}
 	} else {
-		/* GLint c_and = cc[0] & cc[1] & cc[2];*/
-		if ((cc[0] & cc[1] & cc[2]) == 0) { /* Don't draw a triangle with no points*/
-			gl_draw_triangle_clip(p0, p1, p2, 0);
+		/* no culling */
+		if (front) {
+			c->draw_triangle_front(p0, p1, p2);
+		} else {
+			c->draw_triangle_back(p0, p1, p2);
 		}
 	}
 }
 
-static void gl_draw_triangle_clip(GLVertex* p0, GLVertex* p1, GLVertex* p2, GLint clip_bit) {
-	
-	GLint co, c_and, co1, cc[3], edge_flag_tmp, clip_mask;
-	
-	GLVertex* q[3];
+#if TGL_FEATURE_GUARD_BAND == 1
+/* nonzero when v is outside of the guard band, see gl_eval_viewport */
+static GLint gl_guardcode(GLContext* c, GLVertex* v) {
+	GLfloat gx = c->viewport.guard_x * v->pc.W, gy = c->viewport.guard_y * v->pc.W;
+	return !(v->pc.W > 0) | (v->pc.X < -gx) | (v->pc.X > gx) | (v->pc.Y < -gy) | (v->pc.Y > gy);
+}
+#endif
+
+static void gl_draw_triangle_clip(GLContext* c, GLVertex* p0, GLVertex* p1, GLVertex* p2, GLint planes); 
+
+void gl_draw_triangle(GLVertex* p0, GLVertex* p1, GLVertex* p2) {
+	GLContext* c = gl_get_context();
+	GLint co, cc[3];
 
 	cc[0] = p0->clip_code;
 	cc[1] = p1->clip_code;
 	cc[2] = p2->clip_code;
 
 	co = cc[0] | cc[1] | cc[2];
-	if (co == 0) {
-		gl_draw_triangle(p0, p1, p2);
-	} else {
-
-		c_and = cc[0] & cc[1] & cc[2];
-		/* the triangle is completely outside */
-		if (c_and != 0)
-			return;
-
-		/* find the next direction to clip */
-		while (clip_bit < 6 && (co & (1 << clip_bit)) == 0) {
-			clip_bit++;
-		}
 
-		/* this test can be true only in case of rounding errors */
-		if (clip_bit == 6) { /* The 2 bit and the 4 bit.*/
-#if 0
-      tgl_warning("Error:\n");tgl_warning("%f %f %f %f\n",p0->pc.X,p0->pc.Y,p0->pc.Z,p0->pc.W);tgl_warning("%f %f %f %f\n",p1->pc.X,p1->pc.Y,p1->pc.Z,p1->pc.W);tgl_warning("%f %f %f %f\n",p2->pc.X,p2->pc.Y,p2->pc.Z,p2->pc.W);
+	/* we handle the non clipped case here to go faster */
+	if (co == 0) {
+		gl_draw_triangle_visible(c, p0, p1, p2);
+		return;
+	}
+	/* Don't draw a triangle with no points*/
+	if ((cc[0] & cc[1] & cc[2]) != 0)
+		return;
+#if TGL_FEATURE_GUARD_BAND == 1
+	/*
+	 filled triangles only need to be clipped to the near and far planes, and to the sides of the viewport
+	 when they reach past the guard band. the rasterizers scissor the rest of them to the zbuffer
+	*/
+	if (c->draw_triangle_front == gl_draw_triangle_fill && c->draw_triangle_back == gl_draw_triangle_fill) {
+		if (gl_guardcode(c, p0) | gl_guardcode(c, p1) | gl_guardcode(c, p2)) {
+			gl_draw_triangle_clip(c, p0, p1, p2, co);
+		} else if (co & (CLIP_ZMIN | CLIP_ZMAX)) {
+			gl_draw_triangle_clip(c, p0, p1, p2, co & (CLIP_ZMIN | CLIP_ZMAX));
+		} else {
+#if TGL_OPTIMIZATION_HINT_BRANCH_COST < 2
+			/* only the vertices inside of the viewport were mapped to it */
+			if (cc[0])
+				gl_transform_to_viewport_clip_c(p0);
+			if (cc[1])
+				gl_transform_to_viewport_clip_c(p1);
+			if (cc[2])
+				gl_transform_to_viewport_clip_c(p2);
 #endif
-			return;
+			gl_draw_triangle_visible(c, p0, p1, p2);
 		}
+		return;
+	}
+#endif
+	gl_draw_triangle_clip(c, p0, p1, p2, co);
+}
+
+/* a triangle clipped to the 6 planes has at most 3 + 6 vertices, and each plane makes at most 2 new ones */
+#define CLIP_MAX_VERTICES (3 + 6)
 
-		clip_mask = 1 << clip_bit;
-		co1 = (cc[0] ^ cc[1] ^ cc[2]) & clip_mask;
-
-		if (co1) {
-			/* one point outside */
-
-			if (cc[0] & clip_mask) {
-				q[0] = p0;
-				q[1] = p1;
-				q[2] = p2;
-			} else if (cc[1] & clip_mask) {
-				q[0] = p1;
-				q[1] = p2;
-				q[2] = p0;
-			} else {
-				q[0] = p2;
-				q[1] = p0;
-				q[2] = p1;
-			}
-			{
-				GLVertex tmp1, tmp2;
-				GLfloat tt;
-				tt = clip_proc[clip_bit](&tmp1.pc, &q[0]->pc, &q[1]->pc);
-				updateTmp(&tmp1, q[0], q[1], tt);
-
-				tt = clip_proc[clip_bit](&tmp2.pc, &q[0]->pc, &q[2]->pc);
-				updateTmp(&tmp2, q[0], q[2], tt);
-
-				tmp1.edge_flag = q[0]->edge_flag;
-				edge_flag_tmp = q[2]->edge_flag;
-				q[2]->edge_flag = 0;
-				gl_draw_triangle_clip(&tmp1, q[1], q[2], clip_bit + 1);
-
-				tmp2.edge_flag = 1;
-				tmp1.edge_flag = 0;
-				q[2]->edge_flag = edge_flag_tmp;
-				gl_draw_triangle_clip(&tmp2, &tmp1, q[2], clip_bit + 1);
-			}
-		} else {
-			/* two points outside */
-
-			if ((cc[0] & clip_mask) == 0) {
-				q[0] = p0;
-				q[1] = p1;
-				q[2] = p2;
-			} else if ((cc[1] & clip_mask) == 0) {
-				q[0] = p1;
-				q[1] = p2;
-				q[2] = p0;
-			} else {
-				q[0] = p2;
-				q[1] = p0;
-				q[2] = p1;
-			}
-			{
-				GLVertex tmp1, tmp2;
-				GLfloat tt;
-				tt = clip_proc[clip_bit](&tmp1.pc, &q[0]->pc, &q[1]->pc);
-				updateTmp(&tmp1, q[0], q[1], tt);
 
-				tt = clip_proc[clip_bit](&tmp2.pc, &q[0]->pc, &q[2]->pc);
-				updateTmp(&tmp2, q[0], q[2], tt);
+/*
+ Sutherland-Hodgman: the triangle is clipped to each plane in turn, as a polygon of pointers to its vertices and to
+ the new ones, and the result is drawn as a fan. edges made by the clipping are drawn in line mode, the diagonals of
+ the fan are not
+*/
+static void gl_draw_triangle_clip(GLContext* c, GLVertex* p0, GLVertex* p1, GLVertex* p2, GLint planes) {
+	GLVertex tmp[2 * 6];
+	GLVertex* poly[2][CLIP_MAX_VERTICES];
+	GLVertex **in = poly[0], **out = poly[1], **swap;
+	GLVertex *a, *b, *q;
+	GLint i, n, m, nt = 0, plane, mask, edge0, edge2;
+	GLfloat t;
 
-				tmp1.edge_flag = 1;
-				tmp2.edge_flag = q[2]->edge_flag;
-				gl_draw_triangle_clip(q[0], &tmp1, &tmp2, clip_bit + 1);
+	in[0] = p0;
+	in[1] = p1;
+	in[2] = p2;
+	n = 3;
+	for (plane = 0; plane < 6; plane++) {
+		mask = 1 << plane;
+		if ((planes & mask) == 0)
+			continue;
+		m = 0;
+		for (i = 0; i < n; i++) {
+			a = in[i];
+			b = in[i + 1 < n ? i + 1 : 0];
+			if ((a->clip_code & mask) == 0)
+				out[m++] = a;
+			if ((a->clip_code ^ b->clip_code) & mask) {
+				q = &tmp[nt++];
+				/* always from the vertex inside, so an edge shared by two triangles is cut at the same point */
+				if (a->clip_code & mask) {
+					t = clip_proc[plane](&q->pc, &b->pc, &a->pc);
+					updateTmp(q, b, a, t);
+					q->edge_flag = a->edge_flag;
+				} else {
+					t = clip_proc[plane](&q->pc, &a->pc, &b->pc);
+					updateTmp(q, a, b, t);
+					q->edge_flag = 1;
+				}
+				out[m++] = q;
 			}
 		}
+		/* completely outside, or a sliver lost to rounding errors */
+		if (m < 3)
+			return;
+		swap = in;
+		in = out;
+		out = swap;
+		n = m;
+	}
+
+	/* only the vertices left are mapped to the viewport, they may still be outside of it but inside of the guard band */
+	for (i = 0; i < n; i++) {
+		if (in[i] != p0 && in[i] != p1 && in[i] != p2)
+			gl_transform_to_viewport_clip_c(in[i]);
+#if TGL_OPTIMIZATION_HINT_BRANCH_COST < 2
+		else if (in[i]->clip_code)
+			gl_transform_to_viewport_clip_c(in[i]);
+#endif
 	}
+	edge0 = in[0]->edge_flag;
+	for (i = 1; i < n - 1; i++) {
+		edge2 = in[i + 1]->edge_flag;
+		if (i > 1)
+			in[0]->edge_flag = 0;
+		if (i + 1 < n - 1)
+			in[i + 1]->edge_flag = 0;
+		gl_draw_triangle_visible(c, in[0], in[i], in[i + 1]);
+		in[i + 1]->edge_flag = edge2;
+	}
+	in[0]->edge_flag = edge0;
 }
 
 /* see vertex.c to see how the draw functions are assigned.*/
@@ -398,48 +412,67 @@ int count_triangles, count_triangles_textured, count_pixels;
 /* see vertex.c to see how the draw functions are assigned.*/
 void gl_draw_triangle_fill(GLVertex* p0, GLVertex* p1, GLVertex* p2) { 
 	GLContext* c = gl_get_context();
-	if (c->texture_2d_enabled) {
-		/* if(c->current_texture)*/
+	ZB_fillTriangleFunc fill;
+	GLint mode, depth, blend;
+	if (!c->zb->color_write) {
+		/* depth pre-pass: nothing to draw without depth writes */
+		if (!c->zb->depth_write)
+			return;
+		mode = ZB_FILL_DEPTH_ONLY;
+	} else if (c->texture_2d_enabled && GL_IMAGE_DEFINED(&c->current_texture->images[0])) {
+		/* without an image texturing is disabled, as for an incomplete texture */
 #if TGL_FEATURE_LIT_TEXTURES == 1
 		if (c->current_shade_model != GL_SMOOTH) {
 			p1->zp.r = p2->zp.r;
 			p1->zp.g = p2->zp.g;
 			p1->zp.b = p2->zp.b;
+			p1->zp.a = p2->zp.a;
 
 			p0->zp.r = p2->zp.r;
 			p0->zp.g = p2->zp.g;
 			p0->zp.b = p2->zp.b;
+			p0->zp.a = p2->zp.a;
 		}
 #endif
 
-		ZB_setTexture(c->zb, c->current_texture->images[0].pixmap);
-#if TGL_FEATURE_BLEND == 1
-		if (c->zb->enable_blend)
-			ZB_fillTriangleMappingPerspective(c->zb, &p0->zp, &p1->zp, &p2->zp);
-		else
-			ZB_fillTriangleMappingPerspectiveNOBLEND(c->zb, &p0->zp, &p1->zp, &p2->zp);
-#else
-		ZB_fillTriangleMappingPerspectiveNOBLEND(c->zb, &p0->zp, &p1->zp, &p2->zp);
+		{
+			GLImage* im = &c->current_texture->images[0];
+#if TGL_FEATURE_TEXTURE_COMPRESSION == 1
+			if (im->blocks) {
+				/* the BC1 kernels decode the blocks themselves, unfiltered */
+				ZB_setTexture(c->zb, (PIXEL*)im->blocks, im->xsize, im->ysize);
+				mode = ZB_FILL_TEXTURED_BC1;
+			} else
 #endif
-	} else if (c->current_shade_model == GL_SMOOTH) {
-#if TGL_FEATURE_BLEND == 1
-		if (c->zb->enable_blend)
-			ZB_fillTriangleSmooth(c->zb, &p0->zp, &p1->zp, &p2->zp);
-		else
-			ZB_fillTriangleSmoothNOBLEND(c->zb, &p0->zp, &p1->zp, &p2->zp);
-#else
-		ZB_fillTriangleSmoothNOBLEND(c->zb, &p0->zp, &p1->zp, &p2->zp);
+			{
+				ZB_setTexture(c->zb, im->pixmap, im->xsize, im->ysize);
+				mode = (im->xsize == TGL_FEATURE_TEXTURE_DIM && im->ysize == TGL_FEATURE_TEXTURE_DIM) ? ZB_FILL_TEXTURED : ZB_FILL_TEXTURED_SIZED;
+#if TGL_FEATURE_TEXTURE_FILTER == 1
+				if (ZB_setTextureFilter(c->zb, c->current_texture->mipmap, c->current_texture->min_filter, c->current_texture->mag_filter))
+					mode = ZB_FILL_TEXTURED_FILTERED;
 #endif
+			}
+		}
+	} else if (c->current_shade_model == GL_SMOOTH) {
+		mode = ZB_FILL_SMOOTH;
 	} else {
-#if TGL_FEATURE_BLEND == 1
-		if (c->zb->enable_blend)
-			ZB_fillTriangleFlat(c->zb, &p0->zp, &p1->zp, &p2->zp);
-		else
-			ZB_fillTriangleFlatNOBLEND(c->zb, &p0->zp, &p1->zp, &p2->zp);
-#else
-		ZB_fillTriangleFlatNOBLEND(c->zb, &p0->zp, &p1->zp, &p2->zp);
-#endif
+		mode = ZB_FILL_FLAT;
+	}
+	/* the blend kernels also keep the channels glColorMask leaves alone */
+	blend = ZB_MERGES_COLOR(c->zb) != 0;
+	/* without the depth test every fragment passes */
+	depth = (c->zb->depth_test ? c->zb->depth_func : GL_ALWAYS) - GL_NEVER;
+	fill = ZB_fillTriangleFuncs[depth][c->zb->rasterizer][mode][blend];
+#if TGL_FEATURE_TILED_RASTER == 1
+	if (c->zb->tiles) {
+		ZB_queueTriangle(c->zb, fill, &p0->zp, &p1->zp, &p2->zp);
+		/* see glTexSubImage2D */
+		if (mode != ZB_FILL_FLAT && mode != ZB_FILL_SMOOTH && mode != ZB_FILL_DEPTH_ONLY)
+			c->current_texture->queued_batch = ZB_tileBatch(c->zb);
+		return;
 	}
+#endif
+	fill(c->zb, &p0->zp, &p1->zp, &p2->zp);
 }
 
 /* Render a clipped triangle in line mode */
@@ -117,6 +117,15 @@ const GLubyte* extensions_string =
 #if TGL_FEATURE_32_BITS == 1
 																						 "TGL_FEATURE_32_BITS "
 #endif
+#if TGL_FEATURE_SIMD_SPANS == 1
+																						 "TGL_FEATURE_SIMD_SPANS "
+#endif
+#if TGL_FEATURE_HIZ == 1
+																						 "TGL_FEATURE_HIZ "
+#endif
+#if TGL_FEATURE_DEPTH_FUNC == 1
+																						 "TGL_FEATURE_DEPTH_FUNC "
+#endif
 #if COMPILETIME_TINYGL_COMPAT_TEST == 1
 																						 "TGL_COMPILETIME_TINYGL_COMPAT_TEST "
 #endif
@@ -139,6 +148,10 @@ const GLubyte* extensions_string =
 																						 "TGL_FEATURE_MULTITHREADED_ZB_COPYBUFFER "
 #endif
 
+#if TGL_FEATURE_TILED_RASTER == 1
+																						 "TGL_FEATURE_TILED_RASTER "
+#endif
+
 #else
 																						 "TGL_FEATURE_SINGLE_THREADED "
 #endif
@@ -176,10 +189,11 @@ void glGetIntegerv(GLint pname, GLint* params) {
 	i = 0;
 	switch (pname) {
 	case GL_MAX_BUFFERS:
-		*params = MAX_BUFFERS;
+		/* buffer, list and texture names are only limited by memory, see names.c */
+		*params = 0x7fffffff;
 		break;
 	case GL_TEXTURE_HASH_TABLE_SIZE:
-		*params = TEXTURE_HASH_TABLE_SIZE;
+		*params = gl_nameSlots(&c->shared_state.textures);
 		break;
 
 	case GL_LIGHT15:
@@ -251,6 +265,9 @@ void glGetIntegerv(GLint pname, GLint* params) {
 	case GL_BLEND:
 		*params = c->zb->enable_blend;
 		break;
+	case GL_LINE_SMOOTH:
+		*params = c->zb->line_smooth;
+		break;
 	case GL_SHADE_MODEL:
 		*params = c->current_shade_model;
 		break;
@@ -475,7 +492,7 @@ void glGetIntegerv(GLint pname, GLint* params) {
 #endif
 		break;
 	case GL_MAX_DISPLAY_LISTS:
-		*params = MAX_DISPLAY_LISTS;
+		*params = 0x7fffffff;
 		break;
 	case GL_ERROR_CHECK_LEVEL:
 #if TGL_FEATURE_STRICT_OOM_CHECKS == 1
@@ -490,6 +507,10 @@ void glGetIntegerv(GLint pname, GLint* params) {
 	case GL_IS_SPECULAR_ENABLED:
 		*params = c->zEnableSpecular;
 		break;
+	case GL_LIST_OP_COUNT:
+		params[0] = c->list_ops[0];
+		params[1] = c->list_ops[1];
+		break;
 	case GL_MAX_MODELVIEW_STACK_DEPTH:
 		*params = MAX_MODELVIEW_STACK_DEPTH;
 		break;
@@ -527,7 +548,7 @@ void glGetIntegerv(GLint pname, GLint* params) {
 		*params = ((c->offset_states & TGL_OFFSET_LINE) != 0);
 		break;
 	case GL_DEPTH_BITS:
-		*params = 16;
+		*params = ZB_Z_BITS;
 		break;
 	case GL_POLYGON_OFFSET_POINT:
 		*params = ((c->offset_states & TGL_OFFSET_POINT) != 0);
@@ -542,7 +563,7 @@ void glGetIntegerv(GLint pname, GLint* params) {
 		*params = MAX_LIGHTS;
 		break;
 	case GL_MAX_TEXTURE_SIZE:
-		*params = TGL_FEATURE_TEXTURE_DIM; /* not completely true, but... */
+		*params = TGL_FEATURE_TEXTURE_MAX_DIM;
 		break;
 	case GL_CULL_FACE:
 		*params = c->cull_face_enabled;
@@ -564,7 +585,13 @@ void glGetIntegerv(GLint pname, GLint* params) {
 		*params = (c->zb->depth_test == 1);
 		break;
 	case GL_DEPTH_FUNC:
-		*params = GL_LESS;
+		*params = c->zb->depth_func;
+		break;
+	case GL_COLOR_WRITEMASK:
+		params[0] = c->color_mask[0];
+		params[1] = c->color_mask[1];
+		params[2] = c->color_mask[2];
+		params[3] = c->color_mask[3];
 		break;
 
 	default:
@@ -616,7 +643,7 @@ void glGetFloatv(GLint pname, GLfloat* v) {
 		}
 	} break;
 	case GL_LINE_WIDTH:
-		*v = 1.0f;
+		*v = c->zb->linewidth;
 		break;
 	case GL_DEPTH_CLEAR_VALUE:
 		*v = 1; /* This is not entirely true, but... good enough?*/
@@ -644,7 +671,8 @@ void glGetFloatv(GLint pname, GLfloat* v) {
 		*v = c->rastervertex.ec.Z;
 		break;
 	case GL_LINE_WIDTH_RANGE:
-		v[0] = v[1] = 1.0f;
+		v[0] = 1.0f;
+		v[1] = MAX_LINE_WIDTH;
 		break;
 	case GL_POINT_SIZE:
 		/* case GL_POINT_SIZE_MIN:*/
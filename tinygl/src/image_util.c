@@ -1,5 +1,13 @@
+#include <string.h>
 #include "zgl.h"
 
+#if TGL_FEATURE_SIMD_SPANS == 1 && TGL_FEATURE_RENDER_BITS == 32 && defined(__GNUC__) && !defined(__TINYC__) && (defined(__x86_64__) || defined(__i386__))
+#define TGL_SWIZZLE_X86 1
+#include <immintrin.h>
+#else
+#define TGL_SWIZZLE_X86 0
+#endif
+
 /*
  * image conversion
  */
@@ -19,6 +27,7 @@ void gl_convertRGB_to_5R6G5B(GLushort* pixmap, GLubyte* rgb, GLint xsize, GLint
 /*
  This actually converts to ARGB!!!
  This is the format of the entire engine!!!
+ RGB images are opaque, alpha is 0xff.
 */
 void gl_convertRGB_to_8A8R8G8B(GLuint* pixmap, GLubyte* rgb, GLint xsize, GLint ysize) {
 	GLint i, n;
@@ -27,11 +36,110 @@ void gl_convertRGB_to_8A8R8G8B(GLuint* pixmap, GLubyte* rgb, GLint xsize, GLint
 	p = rgb;
 	n = xsize * ysize;
 	for (i = 0; i < n; i++) {
-		pixmap[i] = (((GLuint)p[0]) << 16) | (((GLuint)p[1]) << 8) | (((GLuint)p[2]));
+		pixmap[i] = 0xff000000 | (((GLuint)p[0]) << 16) | (((GLuint)p[1]) << 8) | (((GLuint)p[2]));
 		p += 3;
 	}
 }
 
+#if TGL_FEATURE_TEXTURE_COMPRESSION == 1
+#define STB_DXT_STATIC
+#define STB_DXT_IMPLEMENTATION
+#include "../include-demo/stb_dxt.h"
+
+/*
+ BC1 (DXT1) compression, 8 bytes per 4x4 block, see ZB_BC1_BLOCK_SIZE.
+ The source texels are bytes apart, with the channels at the offsets of order, see gl_texelLayout.
+ Blocks past the right or bottom edge repeat the last column or row.
+*/
+void gl_convertTexels_to_BC1(GLubyte* blocks, const GLubyte* src, GLint xsize, GLint ysize, GLint bytes, const GLubyte* order) {
+	GLubyte block[16 * 4];
+	GLint bx, by, x, y;
+	for (by = 0; by < ysize; by += 4)
+		for (bx = 0; bx < xsize; bx += 4) {
+			for (y = 0; y < 4; y++)
+				for (x = 0; x < 4; x++) {
+					GLint sx = bx + x < xsize ? bx + x : xsize - 1;
+					GLint sy = by + y < ysize ? by + y : ysize - 1;
+					const GLubyte* p = src + bytes * (sx + sy * xsize);
+					GLubyte* q = block + 4 * (x + 4 * y);
+					q[0] = p[order[1]];
+					q[1] = p[order[2]];
+					q[2] = p[order[3]];
+					q[3] = 0xff;
+				}
+			stb_compress_dxt_block(blocks, block, 0, STB_DXT_NORMAL);
+			blocks += ZB_BC1_BLOCK_SIZE;
+		}
+}
+#endif
+
+/* byte offset of the bits 8*shift up of a GLuint in memory */
+static GLint gl_byteOffset(GLint shift) {
+	const GLuint v = 0x03020100;
+	const GLubyte* b = (const GLubyte*)&v;
+	GLint i;
+	for (i = 0; i < 3; i++)
+		if (b[i] == shift)
+			break;
+	return i;
+}
+
+void gl_texelLayout(GLubyte* order, GLint format, GLint type) {
+	/* byte offset of the first, second, third and fourth component of the format */
+	GLint c[4], i;
+	for (i = 0; i < 4; i++)
+		c[i] = type == GL_UNSIGNED_INT_8_8_8_8 ? gl_byteOffset(3 - i) : type == GL_UNSIGNED_INT_8_8_8_8_REV ? gl_byteOffset(i) : i;
+	order[0] = c[3];
+	order[1] = c[format == GL_BGRA ? 2 : 0];
+	order[2] = c[1];
+	order[3] = c[format == GL_BGRA ? 0 : 2];
+}
+
+#if TGL_SWIZZLE_X86 == 1
+/* 4 texels per step, the swizzle is one byte shuffle. returns the number of texels done */
+__attribute__((target("ssse3"))) static GLint gl_swizzleSSSE3(PIXEL* pixmap, const GLubyte* src, GLint n, const GLubyte* order, GLint opaque) {
+	GLubyte m[16];
+	__m128i mask, alpha;
+	GLint i, k;
+	/* little endian: PIXEL bytes are blue, green, red, alpha */
+	for (i = 0; i < 16; i += 4)
+		for (k = 0; k < 4; k++)
+			m[i + k] = i + order[3 - k];
+	mask = _mm_loadu_si128((const __m128i*)m);
+	alpha = _mm_set1_epi32(opaque ? 0xff000000 : 0);
+	n &= ~3;
+	for (i = 0; i < n; i += 4) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(src + 4 * i));
+		_mm_storeu_si128((__m128i*)(pixmap + i), _mm_or_si128(_mm_shuffle_epi8(v, mask), alpha));
+	}
+	return n;
+}
+#endif
+
+void gl_convertTexels(PIXEL* pixmap, const GLubyte* src, GLint n, const GLubyte* order, GLint opaque) {
+	GLint i = 0;
+#if TGL_FEATURE_RENDER_BITS == 32
+	if (!opaque && order[0] == gl_byteOffset(3) && order[1] == gl_byteOffset(2) && order[2] == gl_byteOffset(1) && order[3] == gl_byteOffset(0)) {
+		memcpy(pixmap, src, n * sizeof(PIXEL));
+		return;
+	}
+#if TGL_SWIZZLE_X86 == 1
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("ssse3"))
+		i = gl_swizzleSSSE3(pixmap, src, n, order, opaque);
+#endif
+	for (; i < n; i++) {
+		const GLubyte* p = src + 4 * i;
+		pixmap[i] = ((GLuint)(opaque ? 0xff : p[order[0]]) << 24) | ((GLuint)p[order[1]] << 16) | ((GLuint)p[order[2]] << 8) | p[order[3]];
+	}
+#else
+	for (; i < n; i++) {
+		const GLubyte* p = src + 4 * i;
+		pixmap[i] = ((p[order[1]] & 0xF8) << 8) | ((p[order[2]] & 0xFC) << 3) | ((p[order[3]] & 0xF8) >> 3);
+	}
+#endif
+}
+
 /*
  * linear GLinterpolation with xf,yf normalized to 2^16
  */
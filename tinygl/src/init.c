@@ -5,14 +5,7 @@ static const GLContext empty_gl_ctx = {0};
 
 static void initSharedState(GLContext* c) {
 	GLSharedState* s = &c->shared_state;
-	s->lists = gl_zalloc(sizeof(GLList*) * MAX_DISPLAY_LISTS);
-	if (!s->lists)
-		gl_fatal_error("TINYGL_CANNOT_INIT_OOM");
-	s->texture_hash_table = gl_zalloc(sizeof(GLTexture*) * TEXTURE_HASH_TABLE_SIZE);
-	if (!s->texture_hash_table)
-		gl_fatal_error("TINYGL_CANNOT_INIT_OOM");
-	s->buffers = gl_zalloc(sizeof(GLBuffer*) * MAX_BUFFERS);
-	if (!s->buffers)
+	if (!gl_initNames(&s->lists) || !gl_initNames(&s->textures) || !gl_initNames(&s->buffers))
 		gl_fatal_error("TINYGL_CANNOT_INIT_OOM");
 	alloc_texture(0);
 #include "error_check.h"
@@ -21,49 +14,20 @@ static void initSharedState(GLContext* c) {
 static void endSharedState(GLContext* c) {
 	GLSharedState* s = &c->shared_state;
 	GLint i;
-	GLList* l;
-	GLParamBuffer *pb, *pb1;
-	GLTexture *t, *n;
-	for (i = 0; i < MAX_DISPLAY_LISTS; i++)
-		if (s->lists[i]) {
-			l = s->lists[i];
-			pb = l->first_op_buffer;
-			while (pb != NULL) {
-				pb1 = pb->next;
-				gl_free(pb);
-				pb = pb1;
-			}
-			gl_free(l);
-			s->lists[i] = NULL;
-		}
-	gl_free(s->lists);
-	for (i = 0; i < TEXTURE_HASH_TABLE_SIZE; i++) {
-		t = s->texture_hash_table[i];
-		while (t) {
-			GLTexture** ht;
-			if (t->prev == NULL) {
-				ht = &c->shared_state.texture_hash_table[t->handle & TEXTURE_HASH_TABLE_MASK];
-				*ht = t->next;
-			} else {
-				t->prev->next = t->next;
-			}
-			n = t->next;
-			if (t->next != NULL)
-				t->next->prev = t->prev;
-			gl_free(t);
-			t = n;
-		}
-	}
-	gl_free(s->texture_hash_table);
-	for (i = 0; i < MAX_BUFFERS; i++) {
-		if (s->buffers[i]) {
-			if (s->buffers[i]->data) {
-				gl_free(s->buffers[i]->data);
-			}
-			gl_free(s->buffers[i]);
+	GLBuffer* b;
+	/* the op buffers of the lists all belong to the arena */
+	glEndLists();
+	gl_endNames(&s->lists);
+	gl_endOpArena(&s->op_arena);
+	glEndTextures();
+	gl_endNames(&s->textures);
+	for (i = 0; i < gl_nameSlots(&s->buffers); i++)
+		if ((b = gl_nameAt(&s->buffers, i)) != NULL) {
+			if (b->data)
+				gl_free(b->data);
+			gl_free(b);
 		}
-	}
-	gl_free(s->buffers);
+	gl_endNames(&s->buffers);
 }
 
 #if TGL_FEATURE_TINYGL_RUNTIME_COMPAT_TEST == 1
@@ -214,6 +178,7 @@ void glInit(void* zbuffer1) {
 		l->attenuation[1] = 0;
 		l->attenuation[2] = 0;
 		l->enabled = 0;
+		gl_light_update(l);
 	}
 	c->first_light = NULL;
 	c->ambient_light_model = gl_V4_New(0.2, 0.2, 0.2, 1);
@@ -229,6 +194,10 @@ void glInit(void* zbuffer1) {
 		m->diffuse = gl_V4_New(0.8, 0.8, 0.8, 1);
 		m->specular = gl_V4_New(0, 0, 0, 1);
 		m->shininess = 0;
+		m->shininess_i = 0;
+#if TGL_FEATURE_SPECULAR_BUFFERS == 1
+		m->specbuf = specbuf_get_buffer(0);
+#endif
 	}
 	c->current_color_material_mode = GL_FRONT_AND_BACK;
 	c->current_color_material_type = GL_AMBIENT_AND_DIFFUSE;
@@ -248,7 +217,7 @@ void glInit(void* zbuffer1) {
 	c->current_color.X = 1.0;
 	c->current_color.Y = 1.0;
 	c->current_color.Z = 1.0;
-	c->current_color.W = 0.0;
+	c->current_color.W = 1.0;
 
 	c->current_normal.X = 1.0;
 	c->current_normal.Y = 0.0;
@@ -280,7 +249,7 @@ void glInit(void* zbuffer1) {
 	c->clear_color.v[1] = 0;
 	c->clear_color.v[2] = 0;
 	c->clear_color.v[3] = 0;
-	c->clear_depth = 0;
+	c->clear_depth = 1;
 
 	/* selection */
 #if TGL_FEATURE_ALT_RENDERMODES == 1
@@ -317,6 +286,7 @@ void glInit(void* zbuffer1) {
 	glLoadIdentity();
 
 	c->matrix_model_projection_updated = 1;
+	c->matrix_model_view_inv_updated = 1;
 
 	/* opengl 1.1 arrays */
 	c->client_states = 0;
@@ -327,17 +297,17 @@ void glInit(void* zbuffer1) {
 	/* clear the resize callback function pointer */
 	c->gl_resize_viewport = NULL;
 
-	/* specular buffer */
-#if TGL_FEATURE_SPECULAR_BUFFERS == 1
-	c->specbuf_first = NULL;
-	c->specbuf_used_counter = 0;
-	c->specbuf_num_buffers = 0;
-#endif
 	c->zEnableSpecular = 0;
 	/* depth test */
 	c->zb->depth_test = 0;
 	c->zb->depth_write = 1;
+	c->zb->depth_func = GL_LEQUAL;
+	c->color_mask[0] = c->color_mask[1] = c->color_mask[2] = c->color_mask[3] = 1;
+	c->zb->color_mask = ZB_COLOR_MASK_ALL;
+	c->zb->color_write = 1;
 	c->zb->pointsize = 1;
+	c->zb->linewidth = 1;
+	c->zb->line_smooth = 0;
 
 	/* raster position */
 	c->rasterpos.X = 0;
@@ -361,16 +331,12 @@ void glClose(void) {
 	for (i = 0; i < 3; i++) {
 		gl_free(c->matrix_stack[i]);
 	}
-	i = 0;
 #if TGL_FEATURE_SPECULAR_BUFFERS == 1
-	{
-		GLSpecBuf *b, *n = NULL;
-		for (b = c->specbuf_first; b != NULL; b = n) {
-			n = b->next;
-			gl_free(b);
-			i++;
-		}
-	}
+	specbuf_free_all();
+#endif
+#if TGL_FEATURE_LIST_MESHES == 1
+	if (c->mesh_vertex)
+		gl_free(c->mesh_vertex);
 #endif
 	endSharedState(c);
 	gl_ctx = empty_gl_ctx;
@@ -43,7 +43,9 @@ void glopMaterial(GLParam* p) {
 	case GL_SHININESS:
 		m->shininess = v[0];
 #if TGL_FEATURE_SPECULAR_BUFFERS == 1
-		m->shininess_i = (v[0] / 128.0f) * SPECULAR_BUFFER_SIZE;
+		m->shininess_i = clampf(v[0] / 128.0f, 0, 1) * SPECULAR_BUFFER_SIZE;
+		/* only the shininess that a table is exact for, the others use pow */
+		m->specbuf = m->shininess_i * 128.0f / SPECULAR_BUFFER_SIZE == v[0] ? specbuf_get_buffer(m->shininess_i) : NULL;
 #endif
 		break;
 	case GL_AMBIENT_AND_DIFFUSE:
@@ -73,6 +75,20 @@ void glopColorMaterial(GLParam* p) {
 	c->current_color_material_type = type;
 }
 
+void gl_light_update(GLLight* l) {
+	GLfloat len;
+	if (l->position.v[3] != 0)
+		return;
+	/* see the specular light of gl_shade_vertex */
+	l->half.X = l->norm_position.X;
+	l->half.Y = l->norm_position.Y;
+	l->half.Z = l->norm_position.Z - 1.0;
+	len = sqrt(l->half.X * l->half.X + l->half.Y * l->half.Y + l->half.Z * l->half.Z);
+	l->half_inv_length = len > 1E-3 ? 1 / len : 0;
+	l->spot_dot = -(l->norm_position.X * l->norm_spot_direction.X + l->norm_position.Y * l->norm_spot_direction.Y +
+					l->norm_position.Z * l->norm_spot_direction.Z);
+}
+
 void glopLight(GLParam* p) {
 	GLContext* c = gl_get_context();
 	GLint light = p[1].i;
@@ -124,6 +140,7 @@ void glopLight(GLParam* p) {
 			/* gl_V3_Norm(&l->norm_position);*/
 			gl_V3_Norm_Fast(&l->norm_position);
 		}
+		gl_light_update(l);
 	} break;
 	case GL_SPOT_DIRECTION:
 		for (i = 0; i < 3; i++) {
@@ -131,6 +148,7 @@ void glopLight(GLParam* p) {
 			l->norm_spot_direction.v[i] = v.v[i];
 		}
 		gl_V3_Norm_Fast(&l->norm_spot_direction);
+		gl_light_update(l);
 		break;
 	case GL_SPOT_EXPONENT:
 		l->spot_exponent = v.v[0];
@@ -203,6 +221,8 @@ void gl_enable_disable_light(GLint light, GLint v) {
 	if (v && !l->enabled) {
 		l->enabled = 1;
 		l->next = c->first_light;
+		if (l->next != NULL)
+			l->next->prev = l;
 		c->first_light = l;
 		l->prev = NULL;
 	} else if (!v && l->enabled) {
@@ -301,16 +321,18 @@ void gl_shade_vertex(GLVertex* v) {
 
 			/* spot light */
 			if (l->spot_cutoff != 180) {
-				dot_spot = -(d.X * l->norm_spot_direction.v[0] + d.Y * l->norm_spot_direction.v[1] + d.Z * l->norm_spot_direction.v[2]);
+				if (l->position.v[3] == 0)
+					dot_spot = l->spot_dot;
+				else
+					dot_spot = -(d.X * l->norm_spot_direction.v[0] + d.Y * l->norm_spot_direction.v[1] + d.Z * l->norm_spot_direction.v[2]);
 				if (twoside && dot_spot < 0)
 					dot_spot = -dot_spot;
 				if (dot_spot < l->cos_spot_cutoff) {
 					/* no contribution */
 					continue;
 				} else {
-					/* TODO: pow table for spot_exponent?*/
 					if (l->spot_exponent > 0) {
-						att = att * pow(dot_spot, l->spot_exponent);
+						att = att * gl_fast_pow(dot_spot, l->spot_exponent);
 					}
 				}
 				
@@ -319,6 +341,7 @@ void gl_shade_vertex(GLVertex* v) {
 
 			/* specular light */
 			if (c->zEnableSpecular) {
+				GLfloat inv_length = 0;
 				if (c->local_light_model) {
 					V3 vcoord;
 					vcoord.X = v->ec.X;
@@ -327,8 +350,12 @@ void gl_shade_vertex(GLVertex* v) {
 					
 					gl_V3_Norm_Fast(&vcoord);
 					s.X = d.X - vcoord.X;
-					s.Y = d.Y - vcoord.X;
-					s.Z = d.Z - vcoord.X;
+					s.Y = d.Y - vcoord.Y;
+					s.Z = d.Z - vcoord.Z;
+				} else if (l->position.v[3] == 0) {
+					/* precomputed by gl_light_update */
+					s = l->half;
+					inv_length = l->half_inv_length;
 				} else {
 					
 					s.X = d.X; 
@@ -341,40 +368,30 @@ void gl_shade_vertex(GLVertex* v) {
 					dot_spec = -dot_spec;
 				if (dot_spec > 0) {
 #if TGL_FEATURE_SPECULAR_BUFFERS == 1
-					GLSpecBuf* specbuf;
 					GLint idx;
 #endif
 					dot_spec = clampf(dot_spec, 0, 1);
+					if (c->local_light_model || l->position.v[3] != 0) {
 #if TGL_FEATURE_FISR == 1
-					tmp = fastInvSqrt(s.X * s.X + s.Y * s.Y + s.Z * s.Z); 
-					
-					{ dot_spec = dot_spec * tmp; }
-					
+						inv_length = fastInvSqrt(s.X * s.X + s.Y * s.Y + s.Z * s.Z);
 #else
-					
-					tmp = sqrt(s.X * s.X + s.Y * s.Y + s.Z * s.Z);
-					if (tmp > 1E-3) {
-						dot_spec = dot_spec / tmp;
-					} else
-						dot_spec = 0;
-#endif
-					/* dot_spec= pow(dot_spec,m->shininess);*/
-#if TGL_FEATURE_SPECULAR_BUFFERS == 1
-					specbuf = specbuf_get_buffer(c, m->shininess_i, m->shininess);
-/* Check for GL_OUT_OF_MEMORY*/
-#if TGL_FEATURE_ERROR_CHECK == 1
-#include "error_check.h"
+						tmp = sqrt(s.X * s.X + s.Y * s.Y + s.Z * s.Z);
+						inv_length = tmp > 1E-3 ? 1 / tmp : 0;
 #endif
-#else
-					dot_spec = pow(dot_spec, m->shininess);
-#endif
-
+					}
+					dot_spec = dot_spec * inv_length;
 #if TGL_FEATURE_SPECULAR_BUFFERS == 1
-					idx = (GLint)(dot_spec * SPECULAR_BUFFER_SIZE);
-					if (idx > SPECULAR_BUFFER_SIZE)
-						idx = SPECULAR_BUFFER_SIZE; /* NOTE by GEK: this is poorly written, it's actually 1 larger.*/
-					dot_spec = specbuf->buf[idx];
+					if (m->specbuf != NULL) {
+						/* interpolated between the two nearest entries */
+						GLfloat f = dot_spec * SPECULAR_BUFFER_SIZE;
+						idx = (GLint)f;
+						if (idx >= SPECULAR_BUFFER_SIZE)
+							dot_spec = m->specbuf->buf[SPECULAR_BUFFER_SIZE];
+						else
+							dot_spec = m->specbuf->buf[idx] + (f - idx) * (m->specbuf->buf[idx + 1] - m->specbuf->buf[idx]);
+					} else
 #endif
+						dot_spec = gl_fast_pow(dot_spec, m->shininess);
 					lR += dot_spec * l->specular.v[0] * m->specular.v[0];
 					lG += dot_spec * l->specular.v[1] * m->specular.v[1];
 					lB += dot_spec * l->specular.v[2] * m->specular.v[2];
@@ -392,3 +409,180 @@ void gl_shade_vertex(GLVertex* v) {
 	v->color.v[2] = clampf(B, 0, 1);
 	v->color.v[3] = A;
 }
+
+/* x = x >= min ? x^y : 0, for the k values of a batch */
+static void batch_pow(GLfloat* x, GLfloat y, GLfloat min, GLint k) {
+	GLfloat p[VERTEX_BATCH_SIZE];
+	GLint i;
+	for (i = 0; i < k; i++)
+		p[i] = gl_fast_pow(x[i], y);
+	/* in a loop of its own: the compiler does not vectorize a pow that is only taken under a condition */
+	for (i = 0; i < k; i++)
+		x[i] = x[i] >= min ? p[i] : 0;
+}
+
+/*
+ the lighting model of gl_shade_vertex, one light at a time over all of the vertices, in loops without branches that
+ the compiler vectorizes. with GL_COLOR_MATERIAL the material changes from vertex to vertex, so the lights are summed
+ into separate ambient, diffuse and specular terms, which are multiplied by the material of each vertex at the end
+*/
+void gl_shade_batch_lights(GLContext* c, GLVertexBatch* b, GLint i0, GLint k) {
+	GLfloat amb[3][VERTEX_BATCH_SIZE], dif[3][VERTEX_BATCH_SIZE], spe[3][VERTEX_BATCH_SIZE];
+	/* of the current light at each vertex: direction, attenuation, spot factor, and specular half vector */
+	GLfloat d[3][VERTEX_BATCH_SIZE], att[VERTEX_BATCH_SIZE], spot[VERTEX_BATCH_SIZE];
+	GLfloat h[3][VERTEX_BATCH_SIZE], spec[VERTEX_BATCH_SIZE];
+	/* direction from the eye, for a local viewer */
+	GLfloat eye[3][VERTEX_BATCH_SIZE];
+	GLfloat mat[4][VERTEX_BATCH_SIZE];
+	GLfloat la[3], ld[3], ls[3];
+	GLfloat (*n)[VERTEX_BATCH_SIZE] = b->normal_ec;
+	GLfloat *nx = n[0], *ny = n[1], *nz = n[2];
+	GLMaterial* m = &c->materials[0];
+	GLLight* l;
+	GLint i, j, s, tracked;
+	GLint twoside = c->light_model_two_side, local = c->local_light_model, specular = c->zEnableSpecular;
+
+	if (c->normalize_enabled)
+		for (i = 0; i < k; i++) {
+			GLfloat len = n[0][i] * n[0][i] + n[1][i] * n[1][i] + n[2][i] * n[2][i];
+			len = len > 0 ? gl_inv_sqrt(len) : 1;
+			n[0][i] *= len;
+			n[1][i] *= len;
+			n[2][i] *= len;
+		}
+	if (specular && local)
+		for (i = 0; i < k; i++) {
+			GLfloat len = b->ec[0][i] * b->ec[0][i] + b->ec[1][i] * b->ec[1][i] + b->ec[2][i] * b->ec[2][i];
+			len = len > 0 ? gl_inv_sqrt(len) : 1;
+			for (j = 0; j < 3; j++)
+				eye[j][i] = b->ec[j][i] * len;
+		}
+	memset(amb, 0, sizeof(amb));
+	memset(dif, 0, sizeof(dif));
+	memset(spe, 0, sizeof(spe));
+	memset(spec, 0, sizeof(spec));
+
+	for (l = c->first_light; l != NULL; l = l->next) {
+		GLint is_spot = l->spot_cutoff != 180;
+		GLfloat cutoff = is_spot ? l->cos_spot_cutoff : -2, exponent = is_spot ? l->spot_exponent : 0;
+
+		if (l->position.v[3] == 0) {
+			/* at infinity: the same direction and spot factor for every vertex */
+			GLfloat f = 1, dot_spot = twoside ? fabsf(l->spot_dot) : l->spot_dot;
+			if (is_spot)
+				f = dot_spot < cutoff ? 0 : gl_fast_pow(dot_spot, exponent);
+			for (j = 0; j < 3; j++)
+				for (i = 0; i < k; i++)
+					d[j][i] = l->norm_position.v[j];
+			for (i = 0; i < k; i++) {
+				att[i] = 1;
+				spot[i] = f;
+			}
+		} else {
+			for (i = 0; i < k; i++) {
+				GLfloat dist, inv, dot_spot;
+				for (j = 0; j < 3; j++)
+					d[j][i] = l->position.v[j] - b->ec[j][i];
+				dist = d[0][i] * d[0][i] + d[1][i] * d[1][i] + d[2][i] * d[2][i];
+				inv = gl_inv_sqrt(dist);
+				dist *= inv;
+				inv = dist > 1E-3 ? inv : 1;
+				for (j = 0; j < 3; j++)
+					d[j][i] *= inv;
+				att[i] = 1 / (l->attenuation[0] + dist * (l->attenuation[1] + dist * l->attenuation[2]));
+				dot_spot = -(d[0][i] * l->norm_spot_direction.X + d[1][i] * l->norm_spot_direction.Y + d[2][i] * l->norm_spot_direction.Z);
+				spot[i] = twoside ? fabsf(dot_spot) : dot_spot;
+			}
+			batch_pow(spot, exponent, cutoff, k);
+		}
+
+		if (specular) {
+			GLfloat inv_length = l->half_inv_length;
+			if (local) {
+				for (j = 0; j < 3; j++)
+					for (i = 0; i < k; i++)
+						h[j][i] = d[j][i] - eye[j][i];
+			} else if (l->position.v[3] == 0) {
+				/* precomputed by gl_light_update */
+				for (j = 0; j < 3; j++)
+					for (i = 0; i < k; i++)
+						h[j][i] = l->half.v[j];
+			} else {
+				for (j = 0; j < 3; j++)
+					for (i = 0; i < k; i++)
+						h[j][i] = d[j][i] - (j == 2);
+			}
+			for (i = 0; i < k; i++) {
+				GLfloat inv, dot_spec;
+				inv = h[0][i] * h[0][i] + h[1][i] * h[1][i] + h[2][i] * h[2][i];
+				inv = local || l->position.v[3] != 0 ? (inv > 1E-6f ? gl_inv_sqrt(inv) : 0) : inv_length;
+				dot_spec = n[0][i] * h[0][i] + n[1][i] * h[1][i] + n[2][i] * h[2][i];
+				dot_spec = twoside ? fabsf(dot_spec) : dot_spec;
+				spec[i] = (dot_spec < 1 ? dot_spec : 1) * inv;
+			}
+			/* not the specular tables: in a vectorized loop, the polynomial is faster than gathering from them */
+			batch_pow(spec, m->shininess, 1E-6f, k);
+		}
+
+		for (j = 0; j < 3; j++) {
+			la[j] = l->ambient.v[j];
+			ld[j] = l->diffuse.v[j];
+			ls[j] = l->specular.v[j];
+		}
+		for (i = 0; i < k; i++) {
+			GLfloat a, sp, dot = nx[i] * d[0][i] + ny[i] * d[1][i] + nz[i] * d[2][i];
+			dot = twoside ? fabsf(dot) : dot;
+			/* the spot factor only applies to lit vertices, and those outside of the cone get no light at all */
+			a = att[i] * (dot > 0 ? spot[i] : 1);
+			sp = dot > 0 ? spec[i] : 0;
+			dot = dot > 0 ? dot : 0;
+			for (j = 0; j < 3; j++) {
+				amb[j][i] += a * la[j];
+				dif[j][i] += a * dot * ld[j];
+				spe[j][i] += a * sp * ls[j];
+			}
+		}
+	}
+
+	/* batch_vertex sets the material of the vertices from color_start on to their color */
+	tracked = c->color_material_enabled && c->current_color_material_mode != GL_BACK ? c->current_color_material_type : 0;
+	s = b->color[0] == NULL ? k : b->color_start - i0;
+	s = s < 0 ? 0 : s > k ? k : s;
+	for (j = 0; j < 4; j++) {
+		for (i = 0; i < k; i++) {
+			mat[0][i] = m->emission.v[j];
+			mat[1][i] = m->ambient.v[j];
+			mat[2][i] = m->diffuse.v[j];
+			mat[3][i] = m->specular.v[j];
+		}
+		for (i = s; i < k && tracked; i++) {
+			GLfloat v = clampf(b->color[j][i0 + i], 0, 1);
+			switch (tracked) {
+			case GL_EMISSION:
+				mat[0][i] = v;
+				break;
+			case GL_AMBIENT:
+				mat[1][i] = v;
+				break;
+			case GL_DIFFUSE:
+				mat[2][i] = v;
+				break;
+			case GL_SPECULAR:
+				mat[3][i] = v;
+				break;
+			case GL_AMBIENT_AND_DIFFUSE:
+				mat[1][i] = v;
+				mat[2][i] = v;
+				break;
+			}
+		}
+		if (j == 3) {
+			/* the alpha of the diffuse material */
+			for (i = 0; i < k; i++)
+				b->lit[3][i] = mat[2][i];
+		} else {
+			for (i = 0; i < k; i++)
+				b->lit[j][i] = clampf(mat[0][i] + mat[1][i] * (c->ambient_light_model.v[j] + amb[j][i]) + mat[2][i] * dif[j][i] + mat[3][i] * spe[j][i], 0, 1);
+		}
+	}
+}
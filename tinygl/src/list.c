@@ -1,3 +1,5 @@
+#include <stddef.h>
+
 #include "msghandling.h"
 #include "zgl.h"
 
@@ -21,14 +23,115 @@ GLint op_table_size[] = {
 #include "opinfo.h"
 };
 
-static GLList* find_list(GLuint list) { return gl_get_context()->shared_state.lists[list]; }
+#define OP_BUFFER_HEADER offsetof(GLParamBuffer, ops)
+#define OP_BUFFER_BYTES(size) (OP_BUFFER_HEADER + (size) * sizeof(GLParam))
+
+/* the size class of a buffer of size GLParams, -1 below OP_BUFFER_MIN_SIZE */
+static GLint op_buffer_class(GLint size) {
+	GLint i = -1;
+	while (i + 1 < OP_BUFFER_CLASSES && size >= (OP_BUFFER_MIN_SIZE << 2 * (i + 1)))
+		i++;
+	return i;
+}
+
+/* buffers too small for any class are left unused until glClose */
+static void free_op_buffer(GLParamArena* a, GLParamBuffer* pb) {
+	GLint i = op_buffer_class(pb->size);
+	if (i >= 0) {
+		pb->next = a->free[i];
+		a->free[i] = pb;
+	}
+}
+
+/* the bytes from p to end as a free buffer */
+static void free_op_bytes(GLParamArena* a, GLubyte* p, GLubyte* end) {
+	GLParamBuffer* pb = (GLParamBuffer*)p;
+	if (end - p < (GLint)OP_BUFFER_BYTES(OP_BUFFER_MIN_SIZE))
+		return;
+	pb->size = (end - p - OP_BUFFER_HEADER) / sizeof(GLParam);
+	free_op_buffer(a, pb);
+}
+
+/* a buffer of at least the size of class i, from its free list or the newest block. NULL when out of memory */
+static GLParamBuffer* alloc_op_buffer(GLParamArena* a, GLint i) {
+	GLint size = OP_BUFFER_MIN_SIZE << 2 * i;
+	GLParamBuffer* pb = a->free[i];
+	if (pb != NULL) {
+		a->free[i] = pb->next;
+	} else {
+		if (a->top == NULL || a->end - a->top < (GLint)OP_BUFFER_BYTES(size)) {
+			GLArenaBlock* b = gl_malloc(OP_ARENA_BLOCK_SIZE);
+			if (b == NULL)
+				return NULL;
+			/* what is left of the previous block is not lost */
+			if (a->top != NULL)
+				free_op_bytes(a, a->top, a->end);
+			b->next = a->blocks;
+			a->blocks = b;
+			a->top = (GLubyte*)b + sizeof(GLArenaBlock);
+			a->end = (GLubyte*)b + OP_ARENA_BLOCK_SIZE;
+		}
+		pb = (GLParamBuffer*)a->top;
+		pb->size = size;
+		a->top += OP_BUFFER_BYTES(size);
+	}
+	pb->next = NULL;
+	return pb;
+}
+
+/* gives back what follows the first used GLParams of the last buffer of a list */
+static void trim_op_buffer(GLParamArena* a, GLParamBuffer* pb, GLint used) {
+	GLubyte* end = (GLubyte*)pb + OP_BUFFER_BYTES(pb->size);
+	if (used < OP_BUFFER_MIN_SIZE)
+		used = OP_BUFFER_MIN_SIZE;
+	if (used >= pb->size)
+		return;
+	pb->size = used;
+	/* the newest buffer of the block: bump back */
+	if (end == a->top)
+		a->top = (GLubyte*)pb + OP_BUFFER_BYTES(used);
+	else
+		free_op_bytes(a, (GLubyte*)pb + OP_BUFFER_BYTES(used), end);
+}
+
+void gl_endOpArena(GLParamArena* a) {
+	GLArenaBlock *b, *n;
+	for (b = a->blocks; b != NULL; b = n) {
+		n = b->next;
+		gl_free(b);
+	}
+	memset(a, 0, sizeof(GLParamArena));
+}
+
+static void free_meshes(GLList* l) {
+	GLMesh *m, *m1;
+	for (m = l->meshes; m != NULL; m = m1) {
+		m1 = m->next;
+		gl_free(m);
+	}
+	l->meshes = NULL;
+}
+
+void glEndLists() {
+	GLContext* c = gl_get_context();
+	GLList* l;
+	GLint i;
+	for (i = 0; i < gl_nameSlots(&c->shared_state.lists); i++)
+		if ((l = gl_nameAt(&c->shared_state.lists, i)) != NULL) {
+			free_meshes(l);
+			gl_free(l);
+		}
+}
+
+static GLList* find_list(GLuint list) { return gl_findName(&gl_get_context()->shared_state.lists, list); }
 
 static void delete_list(GLint list) {
 	GLContext* c = gl_get_context();
 	GLParamBuffer *pb, *pb1;
 	GLList* l;
 
-	l = find_list(list);
+	/* a name from glGenLists without a list is just released */
+	l = gl_deleteName(&c->shared_state.lists, list);
 	if (l == NULL) { 
 		return;
 	}
@@ -38,17 +141,17 @@ static void delete_list(GLint list) {
 	pb = l->first_op_buffer;
 	while (pb != NULL) {
 		pb1 = pb->next;
-		gl_free(pb);
+		free_op_buffer(&c->shared_state.op_arena, pb);
 		pb = pb1;
 	}
+	free_meshes(l);
 
 	gl_free(l);
-	c->shared_state.lists[list] = NULL;
 }
 void glDeleteLists(GLuint list, GLuint range) {
 	GLuint i;
 #include "error_check_no_context.h"
-	for (i = 0; i < list + range; i++)
+	for (i = 0; i < range; i++)
 		glDeleteList(list + i);
 }
 void glDeleteList(GLuint list) {
@@ -63,7 +166,7 @@ static GLList* alloc_list(GLint list) {
 #define RETVAL NULL
 #include "error_check.h"
 	l = gl_zalloc(sizeof(GLList));
-	ob = gl_zalloc(sizeof(GLParamBuffer));
+	ob = alloc_op_buffer(&c->shared_state.op_arena, 0);
 
 #if TGL_FEATURE_ERROR_CHECK
 	if (!l || !ob)
@@ -82,7 +185,17 @@ static GLList* alloc_list(GLint list) {
 
 	ob->ops[0].op = OP_EndList;
 
-	c->shared_state.lists[list] = l;
+	if (!gl_setName(&c->shared_state.lists, list, l)) {
+		free_op_buffer(&c->shared_state.op_arena, ob);
+		gl_free(l);
+#if TGL_FEATURE_ERROR_CHECK == 1
+#define ERROR_FLAG GL_OUT_OF_MEMORY
+#define RETVAL NULL
+#include "error_check.h"
+#else
+		return NULL;
+#endif
+	}
 	return l;
 }
 /*
@@ -131,6 +244,467 @@ void glCallLists(GLsizei n, GLenum type, const GLuint* lists) {
 	for (i = 0; i < n; i++)
 		glCallList(c->listbase + lists[i]);
 }
+
+/* the op after p, following the jumps to the next buffers */
+static GLParam* next_op(GLParam* p) {
+	p += op_table_size[p[0].op];
+	while (p[0].op == OP_NextBuffer)
+		p = (GLParam*)p[1].p;
+	return p;
+}
+
+static GLParam* first_op(GLList* l) {
+	GLParam* p = l->first_op_buffer->ops;
+	while (p[0].op == OP_NextBuffer)
+		p = (GLParam*)p[1].p;
+	return p;
+}
+
+static GLint count_ops(GLList* l) {
+	GLParam* p;
+	GLint n = 0;
+	for (p = first_op(l); p[0].op != OP_EndList; p = next_op(p))
+		n++;
+	return n;
+}
+
+/*
+ the passes of glEndList recompile the list into new buffers: begin_rewrite starts them,
+ and end_rewrite ends them and releases the old ones. the list is left as it is when out of memory
+*/
+static GLParamBuffer* begin_rewrite(GLContext* c) {
+	GLParamBuffer* pb = alloc_op_buffer(&c->shared_state.op_arena, 0);
+	if (pb != NULL) {
+		c->current_op_buffer = pb;
+		c->current_op_buffer_index = 0;
+	}
+	return pb;
+}
+
+static void end_rewrite(GLContext* c, GLList* l, GLParamBuffer* pb) {
+	GLParamBuffer* pb1;
+	GLParam q[1];
+	q[0].op = OP_EndList;
+	gl_compile_op(q);
+	for (pb1 = l->first_op_buffer; pb1 != NULL; pb1 = l->first_op_buffer) {
+		l->first_op_buffer = pb1->next;
+		free_op_buffer(&c->shared_state.op_arena, pb1);
+	}
+	l->first_op_buffer = pb;
+}
+
+#if TGL_FEATURE_LIST_PEEPHOLE == 1
+/* ShadeModel, Normal, TexCoord and Color, which only the last of a run of them needs to be kept of */
+#define LIST_ATTRIBUTES 4
+
+typedef struct GLPeephole {
+	/* the last attribute ops of the optimized list so far, and the ones not written yet */
+	GLParam known[LIST_ATTRIBUTES][8];
+	GLParam pending[LIST_ATTRIBUTES][8];
+	GLint is_known[LIST_ATTRIBUTES], is_pending[LIST_ATTRIBUTES];
+	/* a run of matrix ops, applied to matrix */
+	M4 matrix;
+	GLParam* matrix_op;
+	GLint matrix_ops, matrix_load, matrix_kinds;
+} GLPeephole;
+
+static GLint attribute_index(GLint op) {
+	switch (op) {
+	case OP_ShadeModel:
+		return 0;
+	case OP_Normal:
+		return 1;
+	case OP_TexCoord:
+		return 2;
+	case OP_Color:
+		return 3;
+	default:
+		return -1;
+	}
+}
+
+/* the ops known not to change the attributes, or what setting them again does (color material) */
+static GLint keeps_attributes(GLint op) {
+	switch (op) {
+	case OP_Begin:
+	case OP_Vertex:
+	case OP_End:
+	case OP_EdgeFlag:
+	case OP_MatrixMode:
+	case OP_LoadMatrix:
+	case OP_LoadIdentity:
+	case OP_MultMatrix:
+	case OP_PushMatrix:
+	case OP_PopMatrix:
+	case OP_Rotate:
+	case OP_Translate:
+	case OP_Scale:
+	case OP_CullFace:
+	case OP_FrontFace:
+	case OP_PolygonMode:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+static GLint is_matrix_op(GLint op) {
+	return op == OP_LoadMatrix || op == OP_LoadIdentity || op == OP_MultMatrix || op == OP_Rotate || op == OP_Translate ||
+		   op == OP_Scale;
+}
+
+/* the vertices of each primitive of the Begin/End blocks that can be joined, 0 for the others */
+static GLint primitive_size(GLint mode) {
+	switch (mode) {
+	case GL_POINTS:
+		return 1;
+	case GL_LINES:
+		return 2;
+	case GL_TRIANGLES:
+		return 3;
+	case GL_QUADS:
+		return 4;
+	default:
+		return 0;
+	}
+}
+
+static void flush_attributes(GLPeephole* s) {
+	GLint i, j, n;
+	for (i = 0; i < LIST_ATTRIBUTES; i++) {
+		if (!s->is_pending[i])
+			continue;
+		s->is_pending[i] = 0;
+		n = op_table_size[s->pending[i][0].op];
+		for (j = 1; s->is_known[i] && j < n; j++)
+			if (s->known[i][j].i != s->pending[i][j].i)
+				break;
+		if (s->is_known[i] && j == n)
+			continue;
+		gl_compile_op(s->pending[i]);
+		memcpy(s->known[i], s->pending[i], n * sizeof(GLParam));
+		s->is_known[i] = 1;
+	}
+}
+
+/* the ops of a run are applied to an identity matrix, with the functions that execute them */
+static void add_matrix_op(GLContext* c, GLPeephole* s, GLParam* p) {
+	M4* m = c->matrix_stack_ptr[c->matrix_mode];
+	GLint updated = c->matrix_model_projection_updated;
+	if (s->matrix_ops == 0) {
+		gl_M4_Id(&s->matrix);
+		s->matrix_op = p;
+		s->matrix_load = 0;
+		s->matrix_kinds = 0;
+	}
+	s->matrix_ops++;
+	s->matrix_kinds |= 1 << (p[0].op == OP_Translate ? 0 : p[0].op == OP_Scale ? 1 : 2);
+	if (p[0].op == OP_LoadMatrix || p[0].op == OP_LoadIdentity)
+		s->matrix_load = 1;
+	c->matrix_stack_ptr[c->matrix_mode] = &s->matrix;
+	op_table_func[p[0].op](p);
+	c->matrix_stack_ptr[c->matrix_mode] = m;
+	c->matrix_model_projection_updated = updated;
+}
+
+/* a run of matrix ops as a single Translate, Scale, MultMatrix or LoadMatrix */
+static void flush_matrix(GLPeephole* s) {
+	GLParam q[17];
+	GLint i;
+	if (s->matrix_ops == 0)
+		return;
+	if (s->matrix_ops == 1) {
+		gl_compile_op(s->matrix_op);
+	} else if (!s->matrix_load && s->matrix_kinds == 1) {
+		q[0].op = OP_Translate;
+		for (i = 0; i < 3; i++)
+			q[i + 1].f = s->matrix.m[i][3];
+		gl_compile_op(q);
+	} else if (!s->matrix_load && s->matrix_kinds == 2) {
+		q[0].op = OP_Scale;
+		for (i = 0; i < 3; i++)
+			q[i + 1].f = s->matrix.m[i][i];
+		gl_compile_op(q);
+	} else {
+		/* column major, as glLoadMatrixf and glMultMatrixf take them */
+		q[0].op = s->matrix_load ? OP_LoadMatrix : OP_MultMatrix;
+		for (i = 0; i < 16; i++)
+			q[i + 1].f = s->matrix.m[i & 3][i >> 2];
+		gl_compile_op(q);
+	}
+	s->matrix_ops = 0;
+}
+
+/* the Begin that the End at p can be joined with, as nothing but attributes come between them, or NULL */
+static GLParam* join_begin(GLParam* p, GLint mode, GLint vertices) {
+	GLint size = primitive_size(mode);
+	if (size == 0 || vertices % size != 0)
+		return NULL;
+	for (p = next_op(p); p[0].op == OP_Normal || p[0].op == OP_TexCoord || p[0].op == OP_Color; p = next_op(p))
+		;
+	return p[0].op == OP_Begin && p[1].i == mode ? p : NULL;
+}
+
+/*
+ removes the ops that set an attribute to the value it already has, or that are overridden before being used,
+ folds runs of matrix ops into one, and joins Begin/End blocks of independent primitives of the same type
+*/
+static void peephole_list(GLContext* c, GLList* l) {
+	GLPeephole s;
+	GLParamBuffer* pb;
+	GLParam *p, *skip = NULL;
+	GLint i, mode = 0, vertices = 0;
+
+	pb = begin_rewrite(c);
+	if (pb == NULL)
+		return;
+	memset(&s, 0, sizeof(GLPeephole));
+	for (p = first_op(l); p[0].op != OP_EndList; p = next_op(p)) {
+		GLint op = p[0].op;
+		if (p == skip) {
+			skip = NULL;
+			continue;
+		}
+		if ((i = attribute_index(op)) >= 0) {
+			memcpy(s.pending[i], p, op_table_size[op] * sizeof(GLParam));
+			s.is_pending[i] = 1;
+			continue;
+		}
+		if (is_matrix_op(op)) {
+			add_matrix_op(c, &s, p);
+			continue;
+		}
+		if (op == OP_End && (skip = join_begin(p, mode, vertices)) != NULL)
+			continue;
+
+		flush_matrix(&s);
+		flush_attributes(&s);
+		if (!keeps_attributes(op))
+			memset(s.is_known, 0, sizeof(s.is_known));
+		if (op == OP_Begin) {
+			mode = p[1].i;
+			vertices = 0;
+		} else if (op == OP_Vertex) {
+			vertices++;
+		}
+		gl_compile_op(p);
+	}
+	flush_matrix(&s);
+	flush_attributes(&s);
+	end_rewrite(c, l, pb);
+}
+#endif
+
+#if TGL_FEATURE_LIST_MESHES == 1
+/*
+ checks that the Begin at p is followed by nothing but vertices, normals, colors and texture coordinates
+ up to its End, and that no attribute is set after the last vertex. returns the op after the End, or NULL
+*/
+static GLParam* scan_mesh(GLParam* p, GLint* n, GLint* normals, GLint* colors, GLint* tex_coords) {
+	GLint last = OP_Begin;
+	*n = *normals = *colors = *tex_coords = 0;
+	for (p = next_op(p); p[0].op != OP_End; p = next_op(p)) {
+		switch (p[0].op) {
+		case OP_Vertex:
+			(*n)++;
+			break;
+		case OP_Normal:
+			*normals = 1;
+			break;
+		case OP_Color:
+			*colors = 1;
+			break;
+		case OP_TexCoord:
+			*tex_coords = 1;
+			break;
+		default:
+			return NULL;
+		}
+		last = p[0].op;
+	}
+	if (*n == 0 || last != OP_Vertex)
+		return NULL;
+	return next_op(p);
+}
+
+/*
+ whether the size arrays of an attribute hold the same values for vertices u and i. current_u and current_i are
+ set when the vertex has the current value of the context instead, which matches no stored value
+*/
+static GLint same_attribute(GLfloat** a, GLint size, GLint u, GLint current_u, GLint i, GLint current_i) {
+	GLint j;
+	if (a[0] == NULL || current_u || current_i)
+		return current_u == current_i;
+	for (j = 0; j < size; j++)
+		if (a[j][u] != a[j][i])
+			return 0;
+	return 1;
+}
+
+static void move_attribute(GLfloat** a, GLint size, GLint u, GLint i) {
+	GLint j;
+	for (j = 0; a[0] != NULL && j < size; j++)
+		a[j][u] = a[j][i];
+}
+
+static GLuint vertex_hash(GLMesh* m, GLint i) {
+	GLuint h = 2166136261u, u;
+	GLint j;
+	for (j = 0; j < 3; j++) {
+		memcpy(&u, &m->coord[j][i], sizeof(u));
+		h = (h ^ u) * 16777619u;
+	}
+	return h;
+}
+
+/*
+ stores each distinct vertex of m once, in the order they first appear, and draws them through index. vertex i
+ only moves down, to the count of distinct vertices before it, so the arrays are packed in place. the vertices
+ before a *_start come first, so the new *_start is the count of distinct ones among them.
+ m is left as it is when no vertex repeats, or without memory for the hash table
+*/
+static void index_mesh(GLMesh* m, GLuint* index) {
+	GLint size, i, k, u, nu = 0, normal_start = 0, color_start = 0, tex_coord_start = 0;
+	GLint* table;
+	for (size = 1; size < 2 * m->n; size <<= 1)
+		;
+	table = gl_malloc(size * sizeof(GLint));
+	if (table == NULL)
+		return;
+	for (k = 0; k < size; k++)
+		table[k] = -1;
+	for (i = 0; i < m->n; i++) {
+		for (k = vertex_hash(m, i) & (size - 1); (u = table[k]) >= 0; k = (k + 1) & (size - 1))
+			if (same_attribute(m->coord, 4, u, 0, i, 0) && same_attribute(m->normal, 3, u, u < normal_start, i, i < m->normal_start) &&
+				same_attribute(m->color, 4, u, u < color_start, i, i < m->color_start) &&
+				same_attribute(m->tex_coord, 4, u, u < tex_coord_start, i, i < m->tex_coord_start))
+				break;
+		if (u < 0) {
+			u = table[k] = nu++;
+			move_attribute(m->coord, 4, u, i);
+			move_attribute(m->normal, 3, u, i);
+			move_attribute(m->color, 4, u, i);
+			move_attribute(m->tex_coord, 4, u, i);
+			normal_start += i < m->normal_start;
+			color_start += i < m->color_start;
+			tex_coord_start += i < m->tex_coord_start;
+		}
+		index[i] = u;
+	}
+	gl_free(table);
+	if (nu == m->n)
+		return;
+	m->index = index;
+	m->n = nu;
+	m->normal_start = normal_start;
+	m->color_start = color_start;
+	m->tex_coord_start = tex_coord_start;
+}
+
+/* the GLMesh of the n vertices of the Begin/End block at p. NULL when out of memory */
+static GLMesh* bake_mesh(GLParam* p, GLint n, GLint normals, GLint colors, GLint tex_coords) {
+	GLMesh* m;
+	GLfloat* f;
+	GLint i, j;
+	/* the index array follows the attributes */
+	m = gl_malloc(sizeof(GLMesh) + (4 + 3 * normals + 4 * colors + 4 * tex_coords) * n * sizeof(GLfloat) + n * sizeof(GLuint));
+	if (m == NULL)
+		return NULL;
+	memset(m, 0, sizeof(GLMesh));
+	m->mode = p[1].i;
+	m->n = m->count = n;
+	m->normal_start = m->color_start = m->tex_coord_start = n;
+	f = (GLfloat*)(m + 1);
+	for (j = 0; j < 4; j++, f += n)
+		m->coord[j] = f;
+	for (j = 0; normals && j < 3; j++, f += n)
+		m->normal[j] = f;
+	for (j = 0; colors && j < 4; j++, f += n)
+		m->color[j] = f;
+	for (j = 0; tex_coords && j < 4; j++, f += n)
+		m->tex_coord[j] = f;
+
+	/* the current values are written to every vertex from the first one that follows them */
+	for (i = 0, p = next_op(p); p[0].op != OP_End; p = next_op(p)) {
+		switch (p[0].op) {
+		case OP_Normal:
+			if (m->normal_start == n)
+				m->normal_start = i;
+			for (j = 0; j < 3; j++)
+				m->normal[j][n - 1] = p[j + 1].f;
+			break;
+		case OP_Color:
+			if (m->color_start == n)
+				m->color_start = i;
+			for (j = 0; j < 4; j++)
+				m->color[j][n - 1] = p[j + 1].f;
+			break;
+		case OP_TexCoord:
+			if (m->tex_coord_start == n)
+				m->tex_coord_start = i;
+			for (j = 0; j < 4; j++)
+				m->tex_coord[j][n - 1] = p[j + 1].f;
+			break;
+		default:
+			for (j = 0; j < 4; j++)
+				m->coord[j][i] = p[j + 1].f;
+			/* the last vertex is its own scratch space */
+			if (i < n - 1) {
+				for (j = 0; normals && j < 3; j++)
+					m->normal[j][i] = m->normal[j][n - 1];
+				for (j = 0; colors && j < 4; j++)
+					m->color[j][i] = m->color[j][n - 1];
+				for (j = 0; tex_coords && j < 4; j++)
+					m->tex_coord[j][i] = m->tex_coord[j][n - 1];
+			}
+			i++;
+			break;
+		}
+	}
+	index_mesh(m, (GLuint*)f);
+	return m;
+}
+
+/*
+ recompiles the list being ended into new buffers, with each Begin/End block that only
+ holds vertex data replaced by a Mesh op. the list is left as it is if there is none
+*/
+static void bake_list(GLContext* c, GLList* l) {
+	GLParamBuffer* pb;
+	GLParam *p, *end, q[2];
+	GLint n, normals, colors, tex_coords;
+	GLMesh* m;
+
+	for (p = first_op(l); p[0].op != OP_EndList; p = next_op(p))
+		if (p[0].op == OP_Begin && scan_mesh(p, &n, &normals, &colors, &tex_coords) != NULL)
+			break;
+	if (p[0].op == OP_EndList)
+		return;
+	pb = begin_rewrite(c);
+	if (pb == NULL)
+		return;
+
+	for (p = first_op(l); p[0].op != OP_EndList;) {
+		end = NULL;
+		m = NULL;
+		if (p[0].op == OP_Begin && (end = scan_mesh(p, &n, &normals, &colors, &tex_coords)) != NULL)
+			m = bake_mesh(p, n, normals, colors, tex_coords);
+		if (m != NULL) {
+			m->next = l->meshes;
+			l->meshes = m;
+			q[0].op = OP_Mesh;
+			q[1].p = m;
+			gl_compile_op(q);
+			p = end;
+		} else {
+			gl_compile_op(p);
+			p = next_op(p);
+		}
+	}
+	end_rewrite(c, l, pb);
+}
+#endif
+
 void gl_compile_op(GLParam* p) {
 	GLContext* c = gl_get_context();
 	GLint op, op_size;
@@ -143,9 +717,10 @@ void gl_compile_op(GLParam* p) {
 	ob = c->current_op_buffer;
 
 	/* we should be able to add a NextBuffer opcode */
-	if ((index + op_size) > (OP_BUFFER_MAX_SIZE - 2)) {
-
-		ob1 = gl_zalloc(sizeof(GLParamBuffer));
+	if ((index + op_size) > (ob->size - 2)) {
+		/* each buffer of a list is a size class larger than the previous one, up to OP_BUFFER_MAX_SIZE */
+		i = op_buffer_class(ob->size) + 1;
+		ob1 = alloc_op_buffer(&c->shared_state.op_arena, i < OP_BUFFER_CLASSES ? i : OP_BUFFER_CLASSES - 1);
 
 #if TGL_FEATURE_ERROR_CHECK == 1
 		if (!ob1)
@@ -159,7 +734,7 @@ void gl_compile_op(GLParam* p) {
 
 		ob->next = ob1;
 		ob->ops[index].op = OP_NextBuffer;
-		ob->ops[index + 1].p = (void*)ob1;
+		ob->ops[index + 1].p = (void*)ob1->ops;
 
 		c->current_op_buffer = ob1;
 		ob = ob1;
@@ -245,6 +820,7 @@ void glNewList(GLuint list, GLint mode) {
 #endif
 		c->current_op_buffer = l->first_op_buffer;
 	c->current_op_buffer_index = 0;
+	c->current_list = l;
 
 	c->compile_flag = 1;
 	c->exec_flag = (mode == GL_COMPILE_AND_EXECUTE);
@@ -265,6 +841,15 @@ void glEndList(void) {
 		/* end of list */
 		p[0].op = OP_EndList;
 	gl_compile_op(p);
+	c->list_ops[0] = count_ops(c->current_list);
+#if TGL_FEATURE_LIST_PEEPHOLE == 1
+	peephole_list(c, c->current_list);
+#endif
+#if TGL_FEATURE_LIST_MESHES == 1
+	bake_list(c, c->current_list);
+#endif
+	c->list_ops[1] = count_ops(c->current_list);
+	trim_op_buffer(&c->shared_state.op_arena, c->current_op_buffer, c->current_op_buffer_index);
 
 	c->compile_flag = 0;
 	c->exec_flag = 1;
@@ -278,26 +863,18 @@ GLint glIsList(GLuint list) {
 }
 
 GLuint glGenLists(GLint range) {
-	GLint count, i, list;
-	GLList** lists;
+	GLint i;
+	GLuint list;
 	GLContext* c = gl_get_context();
 #define RETVAL 0
 #include "error_check.h"
-	lists = c->shared_state.lists;
-	count = 0;
-	for (i = 0; i < MAX_DISPLAY_LISTS; i++) {
-		if (lists[i] == NULL) {
-			count++;
-			if (count == range) {
-				list = i - range + 1;
-				for (i = 0; i < range; i++) {
-					alloc_list(list + i);
-				}
-				return list;
-			}
-		} else {
-			count = 0;
-		}
-	}
-	return 0;
+	if (range <= 0)
+		return 0;
+	/* O(range), names of deleted lists are reused first */
+	list = gl_genNameRange(&c->shared_state.lists, range);
+	if (list == 0)
+		return 0;
+	for (i = 0; i < range; i++)
+		alloc_list(list + i);
+	return list;
 }
@@ -10,7 +10,8 @@ void gl_print_matrix(const GLfloat* m) {
 
 static void gl_matrix_update() {
 	GLContext* c = gl_get_context();
-	c->matrix_model_projection_updated = (c->matrix_mode <= 1);
+	/* the texture matrix too: glBegin tests if it is the identity */
+	c->matrix_model_projection_updated = 1;
 }
 
 void glopMatrixMode(GLParam* p) {
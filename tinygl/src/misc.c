@@ -87,6 +87,24 @@ void glPointSize(GLfloat f) {
 	gl_add_op(p);
 }
 
+void glopLineWidth(GLParam* p) {
+	GLContext* c = gl_get_context();
+	c->zb->linewidth = clampf(p[1].f, 0, MAX_LINE_WIDTH);
+}
+void glLineWidth(GLfloat width) {
+	GLParam p[2];
+#define NEED_CONTEXT
+#include "error_check_no_context.h"
+#if TGL_FEATURE_ERROR_CHECK == 1
+	if (width <= 0)
+#define ERROR_FLAG GL_INVALID_VALUE
+#include "error_check.h"
+#endif
+	p[0].op = OP_LineWidth;
+	p[1].f = width;
+	gl_add_op(p);
+}
+
 void glopEnableDisable(GLParam* p) {
 	GLContext* c = gl_get_context();
 	GLint code = p[1].i;
@@ -98,6 +116,8 @@ void glopEnableDisable(GLParam* p) {
 		break;
 	case GL_LIGHTING:
 		c->lighting_enabled = v;
+		/* glBegin only multiplies the modelview and projection when lighting is off */
+		c->matrix_model_projection_updated = 1;
 		break;
 	case GL_COLOR_MATERIAL:
 		c->color_material_enabled = v;
@@ -108,6 +128,9 @@ void glopEnableDisable(GLParam* p) {
 	case GL_BLEND:
 		c->zb->enable_blend = v;
 		break;
+	case GL_LINE_SMOOTH:
+		c->zb->line_smooth = v;
+		break;
 	case GL_NORMALIZE:
 		c->normalize_enabled = v;
 		break;
@@ -153,6 +176,31 @@ void glopShadeModel(GLParam* p) {
 	c->current_shade_model = code;
 }
 
+void glopDepthFunc(GLParam* p) {
+	GLContext* c = gl_get_context();
+	c->zb->depth_func = p[1].i;
+}
+
+void glColorMask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha) {
+	GLParam p[5];
+#include "error_check_no_context.h"
+	p[0].op = OP_ColorMask;
+	p[1].i = red;
+	p[2].i = green;
+	p[3].i = blue;
+	p[4].i = alpha;
+	gl_add_op(p);
+}
+void glopColorMask(GLParam* p) {
+	GLContext* c = gl_get_context();
+	GLint i;
+	for (i = 0; i < 4; i++)
+		c->color_mask[i] = p[i + 1].i != 0;
+	/* a partial mask is drawn through the blend kernels, see ZB_MERGES_COLOR */
+	c->zb->color_mask = ZB_COLOR_MASK(p[1].i, p[2].i, p[3].i, p[4].i);
+	c->zb->color_write = c->zb->color_mask != 0;
+}
+
 void glopCullFace(GLParam* p) {
 	GLContext* c = gl_get_context();
 	GLint code = p[1].i;
@@ -256,4 +304,4 @@ void glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format
 	/* TODO: implement read pixels.*/
 }
 
-void glFinish() { return; }
+void glFinish() { ZB_FLUSH_TILES(gl_get_context()->zb); }
@@ -0,0 +1,183 @@
+/*
+ * Name tables, for the textures, display lists and buffers of the shared state.
+ *
+ * Open addressing with linear probing, keyed by the name. A slot is empty when its value is NULL,
+ * and deleted (a tombstone, skipped by lookups but reused by inserts) or reserved (a generated name
+ * without an object yet) when it is one of the markers below. The table doubles once 3/4 of its
+ * slots are used, and is rehashed in place of growing when most of them are tombstones.
+ *
+ * Deleted names that were generated go on a free list and are generated again before new ones, so names
+ * stay small. Names chosen by the application (glBindTexture or glNewList on an unused name) do not, so a
+ * name is never on the free list twice.
+ */
+
+#include <string.h>
+
+#include "zgl.h"
+
+static char deleted_marker, reserved_marker;
+#define NAME_DELETED ((void*)&deleted_marker)
+#define NAME_RESERVED ((void*)&reserved_marker)
+
+#define NAME_TABLE_MIN_BITS 6
+
+/* fibonacci hashing, the top bits of the product */
+#define NAME_HASH(t, name) ((GLuint)((name)*2654435761u) >> (32 - (t)->bits))
+
+GLint gl_initNames(GLNameTable* t) {
+	memset(t, 0, sizeof(GLNameTable));
+	t->bits = NAME_TABLE_MIN_BITS;
+	t->slots = gl_zalloc(sizeof(GLNameSlot) << t->bits);
+	t->next_name = 1;
+	return t->slots != NULL;
+}
+
+void gl_endNames(GLNameTable* t) {
+	if (t->slots)
+		gl_free(t->slots);
+	if (t->free_names)
+		gl_free(t->free_names);
+	memset(t, 0, sizeof(GLNameTable));
+}
+
+/* the slot of name, or -1 */
+static GLint find_slot(const GLNameTable* t, GLuint name) {
+	GLuint mask = (1u << t->bits) - 1;
+	GLuint i = NAME_HASH(t, name);
+	while (t->slots[i].value != NULL) {
+		if (t->slots[i].name == name && t->slots[i].value != NAME_DELETED)
+			return i;
+		i = (i + 1) & mask;
+	}
+	return -1;
+}
+
+void* gl_findName(const GLNameTable* t, GLuint name) {
+	GLint i = find_slot(t, name);
+	if (i < 0 || t->slots[i].value == NAME_RESERVED)
+		return NULL;
+	return t->slots[i].value;
+}
+
+void* gl_nameAt(const GLNameTable* t, GLint slot) {
+	void* value = t->slots[slot].value;
+	return value == NAME_DELETED || value == NAME_RESERVED ? NULL : value;
+}
+
+GLint gl_nameSlots(const GLNameTable* t) { return 1 << t->bits; }
+
+/* rehash into 2^bits slots, dropping the tombstones */
+static GLint resize(GLNameTable* t, GLint bits) {
+	GLNameSlot* old = t->slots;
+	GLint i, n = 1 << t->bits;
+	GLuint mask = (1u << bits) - 1;
+	GLNameSlot* slots = gl_zalloc(sizeof(GLNameSlot) << bits);
+	if (slots == NULL)
+		return 0;
+	t->slots = slots;
+	t->bits = bits;
+	for (i = 0; i < n; i++)
+		if (old[i].value != NULL && old[i].value != NAME_DELETED) {
+			GLuint j = NAME_HASH(t, old[i].name);
+			while (slots[j].value != NULL)
+				j = (j + 1) & mask;
+			slots[j] = old[i];
+		}
+	t->used = t->count;
+	gl_free(old);
+	return 1;
+}
+
+GLint gl_setName(GLNameTable* t, GLuint name, void* value) {
+	GLuint mask, i;
+	GLint slot = find_slot(t, name);
+	if (slot >= 0) {
+		t->slots[slot].value = value;
+		return 1;
+	}
+	if ((t->used + 1) * 4 > (3 << t->bits)) {
+		/* grow unless half of the used slots are tombstones */
+		if (!resize(t, t->count * 2 > t->used ? t->bits + 1 : t->bits))
+			return 0;
+	}
+	mask = (1u << t->bits) - 1;
+	i = NAME_HASH(t, name);
+	while (t->slots[i].value != NULL && t->slots[i].value != NAME_DELETED)
+		i = (i + 1) & mask;
+	if (t->slots[i].value == NULL)
+		t->used++;
+	t->slots[i].name = name;
+	t->slots[i].generated = value == NAME_RESERVED;
+	t->slots[i].value = value;
+	t->count++;
+	if (name >= t->next_name)
+		t->next_name = name + 1;
+	return 1;
+}
+
+void* gl_deleteName(GLNameTable* t, GLuint name) {
+	void* value;
+	GLint slot = find_slot(t, name);
+	if (slot < 0)
+		return NULL;
+	value = t->slots[slot].value;
+	t->slots[slot].value = NAME_DELETED;
+	t->count--;
+	/* without memory for the free list the name is just not reused */
+	if (t->slots[slot].generated) {
+		if (t->free_count == t->free_max) {
+			GLint max = t->free_max ? t->free_max * 2 : 64;
+			GLuint* names = gl_malloc(max * sizeof(GLuint));
+			if (names != NULL) {
+				if (t->free_names) {
+					memcpy(names, t->free_names, t->free_count * sizeof(GLuint));
+					gl_free(t->free_names);
+				}
+				t->free_names = names;
+				t->free_max = max;
+			}
+		}
+		if (t->free_count < t->free_max)
+			t->free_names[t->free_count++] = name;
+	}
+	return value == NAME_RESERVED ? NULL : value;
+}
+
+GLint gl_genNames(GLNameTable* t, GLint n, GLuint* names) {
+	GLint i;
+	for (i = 0; i < n; i++) {
+		GLuint name = 0;
+		/* a freed name may have been bound again since */
+		while (t->free_count > 0 && name == 0) {
+			name = t->free_names[--t->free_count];
+			if (find_slot(t, name) >= 0)
+				name = 0;
+		}
+		if (name == 0) {
+			while (find_slot(t, t->next_name) >= 0)
+				t->next_name++;
+			name = t->next_name;
+		}
+		if (!gl_setName(t, name, NAME_RESERVED))
+			return 0;
+		names[i] = name;
+	}
+	return 1;
+}
+
+GLuint gl_genNameRange(GLNameTable* t, GLint range) {
+	GLuint name;
+	GLint i;
+	if (range == 1)
+		return gl_genNames(t, 1, &name) ? name : 0;
+	/* consecutive names are always new ones */
+	for (name = t->next_name, i = 0; i < range; i++)
+		if (find_slot(t, name + i) >= 0) {
+			name += i + 1;
+			i = -1;
+		}
+	for (i = 0; i < range; i++)
+		if (!gl_setName(t, name + i, NAME_RESERVED))
+			return 0;
+	return name;
+}
@@ -40,8 +40,10 @@ ADD_OP(LoadName, 1, "%d")
 
 ADD_OP(TexImage2D, 9, "%d %d %d  %d %d %d  %d %d %d")
 ADD_OP(TexImage1D, 8, "%d %d  %d %d %d  %d %d %d")
+ADD_OP(TexSubImage2D, 9, "%d %d  %d %d %d %d  %d %d %d")
 ADD_OP(CopyTexImage2D, 8, "%d %d %d %d  %d %d %d %d")
 ADD_OP(BindTexture, 2, "%C %d")
+ADD_OP(TexParameter, 3, "%C %C %C")
 
 
 
@@ -57,6 +59,7 @@ ADD_OP(CallList, 1, "%d")
 /* special opcodes */
 ADD_OP(EndList, 0, "")
 ADD_OP(NextBuffer, 1, "%p")
+ADD_OP(Mesh, 1, "%p")
 
 /* opengl 1.1 arrays */
 ADD_OP(ArrayElement, 1, "%d")
@@ -74,8 +77,15 @@ ADD_OP(PolygonOffset, 2, "%f %f")
 ADD_OP(BlendEquation, 1, "%d")
 ADD_OP(BlendFunc, 2, "%d %d")
 
+/* depth */
+ADD_OP(DepthFunc, 1, "%C")
+
+/* color mask */
+ADD_OP(ColorMask, 4, "%d %d %d %d")
+
 /* point size */
 ADD_OP(PointSize, 1, "%f")
+ADD_OP(LineWidth, 1, "%f")
 
 /* raster position */
 ADD_OP(RasterPos, 4, "%f %f %f %f")
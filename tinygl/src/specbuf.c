@@ -5,56 +5,80 @@
 
 #if TGL_FEATURE_SPECULAR_BUFFERS == 1
 
-static void calc_buf(GLSpecBuf* buf, const GLfloat shininess) {
+/*
+ The tables are shared by the whole process, one per quantized shininess, and never change once they are published:
+ readers only load a pointer, with no lock, so any number of threads can light vertices at the same time.
+ A missing table is computed outside of any lock, and published under a critical section that only writers take.
+ When two threads compute the same table the one that publishes it second frees its copy.
+ Without OpenMP there is a single thread, and the pragmas go away.
+*/
+static GLSpecBuf* specbuf_table[MAX_SPECULAR_BUFFERS];
+
+static void calc_buf(GLSpecBuf* buf, const GLint shininess_i) {
 	GLint i;
-	GLfloat val, inc;
-	val = 0.0f;
-	inc = 1.0f / SPECULAR_BUFFER_SIZE;
+	GLfloat v, shininess = shininess_i * 128.0f / SPECULAR_BUFFER_SIZE;
+	buf->shininess_i = shininess_i;
 	for (i = 0; i <= SPECULAR_BUFFER_SIZE; i++) {
-		buf->buf[i] = pow(val, shininess);
-		val += inc;
+		v = pow((GLfloat)i / SPECULAR_BUFFER_SIZE, shininess);
+		/* denormals are slow to interpolate, and too small to light anything */
+		buf->buf[i] = v < 1E-30f ? 0 : v;
 	}
 }
 
-GLSpecBuf* specbuf_get_buffer(GLContext* c, const GLint shininess_i, const GLfloat shininess) {
-	GLSpecBuf *found, *oldest;
-	found = oldest = c->specbuf_first;
-	while (found && found->shininess_i != shininess_i) {
-		if (found->last_used < oldest->last_used) {
-			oldest = found;
-		}
-		found = found->next;
-	}
-	if (found) { /* hey, found one! */
-		found->last_used = c->specbuf_used_counter++;
+static GLSpecBuf* specbuf_load(GLint shininess_i) {
+	GLSpecBuf* buf;
+#ifdef _OPENMP
+#pragma omp atomic read
+#endif
+	buf = specbuf_table[shininess_i];
+	/* the table is read after the pointer to it */
+#ifdef _OPENMP
+#pragma omp flush
+#endif
+	return buf;
+}
+
+const GLSpecBuf* specbuf_get_buffer(GLint shininess_i) {
+	GLSpecBuf *buf, *found;
+	shininess_i = shininess_i < 0 ? 0 : shininess_i > SPECULAR_BUFFER_SIZE ? SPECULAR_BUFFER_SIZE : shininess_i;
+	found = specbuf_load(shininess_i);
+	if (found != NULL)
 		return found;
-	}
-	if (oldest == NULL || c->specbuf_num_buffers < MAX_SPECULAR_BUFFERS) {
-		/* create new buffer */
-		GLSpecBuf* buf = gl_malloc(sizeof(GLSpecBuf));
-#if TGL_FEATURE_ERROR_CHECK == 1
-		if (!buf)
-#define ERROR_FLAG GL_OUT_OF_MEMORY
-#define RETVAL NULL
-#include "error_check.h"
-#else
-		
-		
+	buf = gl_malloc(sizeof(GLSpecBuf));
+	if (buf == NULL)
+		return NULL;
+	calc_buf(buf, shininess_i);
+#ifdef _OPENMP
+#pragma omp critical(tgl_specbuf)
 #endif
-			c->specbuf_num_buffers++;
-		buf->next = c->specbuf_first;
-		c->specbuf_first = buf;
-		buf->last_used = c->specbuf_used_counter++;
-		buf->shininess_i = shininess_i;
-		calc_buf(buf, shininess);
-		return buf;
+	{
+		found = specbuf_table[shininess_i];
+		if (found == NULL) {
+			/* the table is written before the pointer to it */
+#ifdef _OPENMP
+#pragma omp flush
+#pragma omp atomic write
+#endif
+			specbuf_table[shininess_i] = buf;
+			found = buf;
+			buf = NULL;
+		}
 	}
-	/* overwrite the lru buffer */
-	/*tgl_trace("overwriting spec buffer :(\n");*/
-	oldest->shininess_i = shininess_i;
-	oldest->last_used = c->specbuf_used_counter++;
-	calc_buf(oldest, shininess);
-	return oldest;
+	if (buf != NULL)
+		gl_free(buf);
+	return found;
+}
+
+void specbuf_free_all(void) {
+	GLint i;
+#ifdef _OPENMP
+#pragma omp critical(tgl_specbuf)
+#endif
+	for (i = 0; i < MAX_SPECULAR_BUFFERS; i++)
+		if (specbuf_table[i] != NULL) {
+			gl_free(specbuf_table[i]);
+			specbuf_table[i] = NULL;
+		}
 }
 
 #endif
@@ -2,19 +2,10 @@
  * Texture Manager
  */
 
+#include "msghandling.h"
 #include "zgl.h"
 
-static GLTexture* find_texture(GLint h) {
-	GLTexture* t;
-	GLContext* c = gl_get_context();
-	t = c->shared_state.texture_hash_table[h & TEXTURE_HASH_TABLE_MASK];
-	while (t != NULL) {
-		if (t->handle == h)
-			return t;
-		t = t->next;
-	}
-	return NULL;
-}
+static GLTexture* find_texture(GLint h) { return gl_findName(&gl_get_context()->shared_state.textures, h); }
 
 GLboolean glAreTexturesResident(GLsizei n, const GLuint* textures, GLboolean* residences) {
 #define RETVAL GL_FALSE
@@ -65,25 +56,166 @@ void* glGetTexturePixmap(GLint text, GLint level, GLint* xsize, GLint* ysize) {
 	return tex->images[level].pixmap;
 }
 
+#if TGL_FEATURE_TILED_RASTER == 1
+/* the tiles must have been flushed */
+static void free_spare(GLTexture* t) {
+	if (t->spare) {
+		gl_free(t->spare);
+		t->spare = NULL;
+	}
+#if TGL_FEATURE_TEXTURE_FILTER == 1
+	if (t->spare_mipmap) {
+		gl_free(t->spare_mipmap);
+		t->spare_mipmap = NULL;
+	}
+#endif
+}
+#else
+#define free_spare(t) /* a comment */
+#endif
+
+static void free_texture_data(GLTexture* t) {
+	GLint i;
+	for (i = 0; i < MAX_TEXTURE_LEVELS; i++) {
+		if (t->images[i].pixmap)
+			gl_free(t->images[i].pixmap);
+#if TGL_FEATURE_TEXTURE_COMPRESSION == 1
+		if (t->images[i].blocks)
+			gl_free(t->images[i].blocks);
+#endif
+	}
+#if TGL_FEATURE_TEXTURE_FILTER == 1
+	if (t->mipmap)
+		gl_free(t->mipmap);
+#endif
+	free_spare(t);
+	gl_free(t);
+}
+
 static void free_texture(GLContext* c, GLint h) {
-	GLTexture *t, **ht;
+	GLTexture* t = gl_deleteName(&c->shared_state.textures, h);
+	/* queued triangles may still sample it */
+	ZB_FLUSH_TILES(c->zb);
+	free_texture_data(t);
+}
+
+/* frees every texture, at glClose */
+void glEndTextures() {
+	GLContext* c = gl_get_context();
+	GLTexture* t;
+	GLint i;
+	ZB_FLUSH_TILES(c->zb);
+	for (i = 0; i < gl_nameSlots(&c->shared_state.textures); i++)
+		if ((t = gl_nameAt(&c->shared_state.textures, i)) != NULL)
+			free_texture_data(t);
+}
+
+/* the texels of an image are reallocated when its size changes, and NULL if that fails */
+static PIXEL* alloc_image(GLContext* c, GLTexture* t, GLint level, GLint xsize, GLint ysize) {
+	GLImage* im = &t->images[level];
+	/* queued triangles may still sample the old texels */
+	ZB_FLUSH_TILES(c->zb);
+#if TGL_FEATURE_TEXTURE_COMPRESSION == 1
+	if (im->blocks) {
+		gl_free(im->blocks);
+		im->blocks = NULL;
+	}
+#endif
+	if (im->pixmap == NULL || im->xsize != xsize || im->ysize != ysize) {
+		if (im->pixmap)
+			gl_free(im->pixmap);
+		im->pixmap = gl_malloc(xsize * ysize * sizeof(PIXEL));
+#if TGL_FEATURE_TEXTURE_FILTER == 1
+		/* the mip chain is sized after level 0 */
+		if (level == 0 && t->mipmap) {
+			gl_free(t->mipmap);
+			t->mipmap = NULL;
+		}
+#endif
+		if (level == 0)
+			free_spare(t);
+	}
+	if (im->pixmap == NULL)
+		xsize = ysize = 0;
+	im->xsize = xsize;
+	im->ysize = ysize;
+	return im->pixmap;
+}
 
-	t = find_texture(h);
-	if (t->prev == NULL) {
-		ht = &c->shared_state.texture_hash_table[t->handle & TEXTURE_HASH_TABLE_MASK];
-		*ht = t->next;
-	} else {
-		t->prev->next = t->next;
+#if TGL_FEATURE_TEXTURE_COMPRESSION == 1
+/* the same for a compressed image, it replaces the texels */
+static GLubyte* alloc_blocks(GLContext* c, GLTexture* t, GLint level, GLint xsize, GLint ysize) {
+	GLImage* im = &t->images[level];
+	ZB_FLUSH_TILES(c->zb);
+	if (im->pixmap) {
+		gl_free(im->pixmap);
+		im->pixmap = NULL;
+	}
+	if (level == 0)
+		free_spare(t);
+	if (im->blocks == NULL || im->xsize != xsize || im->ysize != ysize) {
+		if (im->blocks)
+			gl_free(im->blocks);
+		im->blocks = gl_malloc(ZB_BC1_BLOCKS(xsize, ysize) * ZB_BC1_BLOCK_SIZE);
 	}
-	if (t->next != NULL)
-		t->next->prev = t->prev;
+	if (im->blocks == NULL)
+		xsize = ysize = 0;
+	im->xsize = xsize;
+	im->ysize = ysize;
+	return im->blocks;
+}
+#define TEXTURE_COMPONENTS_OK(n) ((n) == 3 || (n) == 4 || (n) == GL_RGB || (n) == GL_RGBA || (n) == GL_COMPRESSED_RGB_S3TC_DXT1_EXT)
+#else
+#define TEXTURE_COMPONENTS_OK(n) ((n) == 3 || (n) == 4 || (n) == GL_RGB || (n) == GL_RGBA)
+#endif
+/* internal formats without alpha */
+#define TEXTURE_COMPONENTS_OPAQUE(n) ((n) != 4 && (n) != GL_RGBA)
+
+/* bytes per texel of the supported client formats, 0 for the others. order is set like gl_texelLayout */
+static GLint texel_format(GLint format, GLint type, GLubyte* order) {
+	if (format == GL_RGB && type == GL_UNSIGNED_BYTE) {
+		order[0] = order[1] = 0;
+		order[2] = 1;
+		order[3] = 2;
+		return 3;
+	}
+	if ((format == GL_RGBA || format == GL_BGRA) &&
+		(type == GL_UNSIGNED_BYTE || type == GL_UNSIGNED_INT_8_8_8_8 || type == GL_UNSIGNED_INT_8_8_8_8_REV)) {
+		gl_texelLayout(order, format, type);
+		return 4;
+	}
+	return 0;
+}
 
-	gl_free(t);
+/* w * h client texels into an image xsize texels wide */
+static void convert_texels(PIXEL* dst, GLint xsize, const GLubyte* src, GLint w, GLint h, GLint bytes, const GLubyte* order, GLint opaque) {
+	GLint y;
+	/* whole rows are converted in one go */
+	if (w == xsize) {
+		w *= h;
+		h = 1;
+	}
+	for (y = 0; y < h; y++, dst += xsize, src += w * bytes) {
+		if (bytes == 4)
+			gl_convertTexels(dst, src, w, order, opaque);
+		else
+#if TGL_FEATURE_RENDER_BITS == 32
+			gl_convertRGB_to_8A8R8G8B(dst, (GLubyte*)src, w, 1);
+#elif TGL_FEATURE_RENDER_BITS == 16
+			gl_convertRGB_to_5R6G5B(dst, (GLubyte*)src, w, 1);
+#else
+#error Bad TGL_FEATURE_RENDER_BITS
+#endif
+	}
+}
+
+static GLint valid_image_size(GLint xsize, GLint ysize) {
+	return xsize > 0 && ysize > 0 && xsize <= TGL_FEATURE_TEXTURE_MAX_DIM && ysize <= TGL_FEATURE_TEXTURE_MAX_DIM;
 }
 
 GLTexture* alloc_texture(GLint h) {
 	GLContext* c = gl_get_context();
-	GLTexture *t, **ht;
+	GLTexture* t;
 #define RETVAL NULL
 #include "error_check.h"
 	t = gl_zalloc(sizeof(GLTexture));
@@ -96,19 +228,120 @@ GLTexture* alloc_texture(GLint h) {
 		gl_fatal_error("GL_OUT_OF_MEMORY");
 #endif
 
-		ht = &c->shared_state.texture_hash_table[h & TEXTURE_HASH_TABLE_MASK];
-
-	t->next = *ht;
-	t->prev = NULL;
-	if (t->next != NULL)
-		t->next->prev = t;
-	*ht = t;
+	if (!gl_setName(&c->shared_state.textures, h, t)) {
+		gl_free(t);
+#if TGL_FEATURE_ERROR_CHECK == 1
+#define ERROR_FLAG GL_OUT_OF_MEMORY
+#define RETVAL NULL
+#include "error_check.h"
+#else
+		gl_fatal_error("GL_OUT_OF_MEMORY");
+#endif
+	}
 
 	t->handle = h;
+#if TGL_FEATURE_TEXTURE_FILTER == 1
+	/* not the GL defaults, unfiltered sampling is what tinygl always did */
+	t->min_filter = GL_NEAREST;
+	t->mag_filter = GL_NEAREST;
+#endif
 
 	return t;
 }
 
+#if TGL_FEATURE_TEXTURE_FILTER == 1
+
+static GLint mipmap_filter(GLint filter) { return filter != GL_NEAREST && filter != GL_LINEAR; }
+
+/* texels of levels 1 and up of a xsize * ysize texture */
+static GLint mipmap_size(GLint xsize, GLint ysize) {
+	GLint n = 0;
+	while (xsize > 1 || ysize > 1) {
+		xsize = ZB_TEXTURE_LEVEL_SIZE(xsize, 1);
+		ysize = ZB_TEXTURE_LEVEL_SIZE(ysize, 1);
+		n += xsize * ysize;
+	}
+	return n;
+}
+
+/*
+ 2x2 box filter of every level into the next one. a side of 1 is filtered 1x2, an odd one drops its last texel.
+ only the texels that depend on the x0 <= x < x1, y0 <= y < y1 rectangle of images[0] are filtered
+*/
+static void build_mipmaps(GLTexture* t, GLint x0, GLint y0, GLint x1, GLint y1) {
+	PIXEL* src = t->images[0].pixmap;
+	PIXEL* dst = t->mipmap;
+	GLint xsize = t->images[0].xsize, ysize = t->images[0].ysize;
+	GLint w, h, i, j;
+	while (xsize > 1 || ysize > 1) {
+		w = ZB_TEXTURE_LEVEL_SIZE(xsize, 1);
+		h = ZB_TEXTURE_LEVEL_SIZE(ysize, 1);
+		/* the rectangle in the next level */
+		x0 >>= 1;
+		y0 >>= 1;
+		x1 = (x1 + 1) >> 1 < w ? (x1 + 1) >> 1 : w;
+		y1 = (y1 + 1) >> 1 < h ? (y1 + 1) >> 1 : h;
+		for (j = y0; j < y1; j++) {
+			PIXEL* row0 = src + 2 * j * xsize;
+			PIXEL* row1 = ysize > 1 ? row0 + xsize : row0;
+			for (i = x0; i < x1; i++) {
+				GLint i0 = xsize > 1 ? 2 * i : i, i1 = xsize > 1 ? 2 * i + 1 : i;
+				GLuint p0 = row0[i0], p1 = row0[i1];
+				GLuint p2 = row1[i0], p3 = row1[i1];
+#if TGL_FEATURE_RENDER_BITS == 32
+				GLuint rb = ((p0 & 0xff00ff) + (p1 & 0xff00ff) + (p2 & 0xff00ff) + (p3 & 0xff00ff) + 0x20002) >> 2;
+				GLuint ag = (((p0 >> 8) & 0xff00ff) + ((p1 >> 8) & 0xff00ff) + ((p2 >> 8) & 0xff00ff) + ((p3 >> 8) & 0xff00ff) + 0x20002) >> 2;
+				dst[i + j * w] = (rb & 0xff00ff) | ((ag & 0xff00ff) << 8);
+#else
+				GLuint rb = ((p0 & 0xf81f) + (p1 & 0xf81f) + (p2 & 0xf81f) + (p3 & 0xf81f) + 0x1002) >> 2;
+				GLuint g = ((p0 & 0x07e0) + (p1 & 0x07e0) + (p2 & 0x07e0) + (p3 & 0x07e0) + 0x40) >> 2;
+				dst[i + j * w] = (rb & 0xf81f) | (g & 0x07e0);
+#endif
+			}
+		}
+		src = dst;
+		dst += w * h;
+		xsize = w;
+		ysize = h;
+	}
+}
+
+/* the mip chain follows images[0] as long as a mipmap filter is set. x0, y0, x1, y1 is the part of images[0] that changed */
+static void update_mipmap_rect(GLContext* c, GLTexture* t, GLint x0, GLint y0, GLint x1, GLint y1) {
+	/* compressed images are not mipmapped */
+	if (!mipmap_filter(t->min_filter) || t->images[0].pixmap == NULL) {
+		if (t->mipmap) {
+			ZB_FLUSH_TILES(c->zb);
+			gl_free(t->mipmap);
+			t->mipmap = NULL;
+#if TGL_FEATURE_TILED_RASTER == 1
+			if (t->spare_mipmap) {
+				gl_free(t->spare_mipmap);
+				t->spare_mipmap = NULL;
+			}
+#endif
+		}
+		return;
+	}
+	/* a 1x1 image */
+	if (mipmap_size(t->images[0].xsize, t->images[0].ysize) == 0)
+		return;
+	if (t->mipmap == NULL) {
+		t->mipmap = gl_malloc(mipmap_size(t->images[0].xsize, t->images[0].ysize) * sizeof(PIXEL));
+		/* without a chain the mipmap filters sample level 0 */
+		if (t->mipmap == NULL)
+			return;
+		x0 = y0 = 0;
+		x1 = t->images[0].xsize;
+		y1 = t->images[0].ysize;
+	}
+	build_mipmaps(t, x0, y0, x1, y1);
+}
+
+static void update_mipmaps(GLContext* c, GLTexture* t) { update_mipmap_rect(c, t, 0, 0, t->images[0].xsize, t->images[0].ysize); }
+
+#endif
+
 void glInitTextures() {
 	/* textures */
 	GLContext* c = gl_get_context();
@@ -118,20 +351,15 @@ void glInitTextures() {
 
 void glGenTextures(GLint n, GLuint* textures) {
 	GLContext* c = gl_get_context();
-	GLint max, i;
-	GLTexture* t;
 #include "error_check.h"
-	max = 0;
-	for (i = 0; i < TEXTURE_HASH_TABLE_SIZE; i++) {
-		t = c->shared_state.texture_hash_table[i];
-		while (t != NULL) {
-			if (t->handle > max)
-				max = t->handle;
-			t = t->next;
-		}
-	}
-	for (i = 0; i < n; i++) {
-		textures[i] = max + i + 1; /* MARK: How texture handles are created.*/
+	/* names are reserved until they are bound or deleted */
+	if (!gl_genNames(&c->shared_state.textures, n, textures)) {
+#if TGL_FEATURE_ERROR_CHECK == 1
+#define ERROR_FLAG GL_OUT_OF_MEMORY
+#include "error_check.h"
+#else
+		gl_fatal_error("GL_OUT_OF_MEMORY");
+#endif
 	}
 }
 
@@ -141,13 +369,19 @@ void glDeleteTextures(GLint n, const GLuint* textures) {
 	GLContext* c = gl_get_context();
 #include "error_check.h"
 	for (i = 0; i < n; i++) {
+		/* the default texture is never deleted */
+		if (textures[i] == 0)
+			continue;
 		t = find_texture(textures[i]);
-		if (t != NULL && t != 0) {
+		if (t != NULL) {
 			if (t == c->current_texture) {
 				glBindTexture(GL_TEXTURE_2D, 0);
 #include "error_check.h"
 			}
 			free_texture(c, textures[i]);
+		} else {
+			/* a generated name that was never bound */
+			gl_deleteName(&c->shared_state.textures, textures[i]);
 		}
 	}
 }
@@ -203,7 +437,6 @@ void glCopyTexImage2D(GLenum target,
 	gl_add_op(p);
 }
 void glopCopyTexImage2D(GLParam* p) {
-	GLImage* im;
 	PIXEL* data;
 	GLint i, j;
 	GLint target = p[1].i;
@@ -216,9 +449,8 @@ void glopCopyTexImage2D(GLParam* p) {
 	GLContext* c = gl_get_context();
 	y -= h;
 
-	if (c->readbuffer != GL_FRONT || c->current_texture == NULL || target != GL_TEXTURE_2D || border != 0 ||
-		w != TGL_FEATURE_TEXTURE_DIM || /*TODO Implement image interp*/
-		h != TGL_FEATURE_TEXTURE_DIM) {
+	if (c->readbuffer != GL_FRONT || c->current_texture == NULL || target != GL_TEXTURE_2D || level != 0 || border != 0 ||
+		!valid_image_size(w, h)) {
 #if TGL_FEATURE_ERROR_CHECK == 1
 #define ERROR_FLAG GL_INVALID_OPERATION
 #include "error_check.h"
@@ -226,11 +458,16 @@ void glopCopyTexImage2D(GLParam* p) {
 		return;
 #endif
 	}
-	im = &c->current_texture->images[level];
-	data = c->current_texture->images[level].pixmap;
-	im->xsize = TGL_FEATURE_TEXTURE_DIM;
-	im->ysize = TGL_FEATURE_TEXTURE_DIM;
-	/* TODO implement the scaling and stuff that the GL spec says it should have.*/
+	/* also flushes the tiles, the copy reads pbuf */
+	data = alloc_image(c, c->current_texture, level, w, h);
+	if (data == NULL) {
+#if TGL_FEATURE_ERROR_CHECK == 1
+#define ERROR_FLAG GL_OUT_OF_MEMORY
+#include "error_check.h"
+#else
+		gl_fatal_error("GL_OUT_OF_MEMORY");
+#endif
+	}
 #if TGL_FEATURE_MULTITHREADED_COPY_TEXIMAGE_2D == 1
 #ifdef _OPENMP
 #pragma omp parallel for
@@ -245,6 +482,9 @@ void glopCopyTexImage2D(GLParam* p) {
 			data[i + j * w] = c->zb->pbuf[((i + x) % (c->zb->xsize)) + ((j + y) % (c->zb->ysize)) * (c->zb->xsize)];
 		}
 #endif
+#if TGL_FEATURE_TEXTURE_FILTER == 1
+	update_mipmaps(c, c->current_texture);
+#endif
 }
 
 void glopTexImage1D(GLParam* p) {
@@ -258,9 +498,7 @@ void glopTexImage1D(GLParam* p) {
 	GLint format = p[6].i;
 	GLint type = p[7].i;
 	void* pixels = p[8].p;
-	GLImage* im;
-	GLubyte* pixels1;
-	GLint do_free=0;
+	PIXEL* data;
 	GLContext* c = gl_get_context();
 	{
 #if TGL_FEATURE_ERROR_CHECK == 1
@@ -275,38 +513,35 @@ void glopTexImage1D(GLParam* p) {
 			gl_fatal_error("glTexImage2D: combination of parameters not handled!!");
 #endif
 	}
-	if (width != TGL_FEATURE_TEXTURE_DIM || height != TGL_FEATURE_TEXTURE_DIM) {
-		pixels1 = gl_malloc(TGL_FEATURE_TEXTURE_DIM * TGL_FEATURE_TEXTURE_DIM * 3); /* GUARDED*/
-		if (pixels1 == NULL) {
+	/* stored at its own size */
+	if (!valid_image_size(width, height)) {
+#if TGL_FEATURE_ERROR_CHECK == 1
+#define ERROR_FLAG GL_INVALID_VALUE
+#include "error_check.h"
+#else
+		tgl_warning("glTexImage1D: texture size not handled");
+		return;
+#endif
+	}
+	data = alloc_image(c, c->current_texture, level, width, height);
+	if (data == NULL) {
 #if TGL_FEATURE_ERROR_CHECK == 1
 #define ERROR_FLAG GL_OUT_OF_MEMORY
 #include "error_check.h"
 #else
-			gl_fatal_error("GL_OUT_OF_MEMORY");
+		gl_fatal_error("GL_OUT_OF_MEMORY");
 #endif
-		}
-		/* no GLinterpolation is done here to respect the original image aliasing ! */
-		
-		gl_resizeImageNoInterpolate(pixels1, TGL_FEATURE_TEXTURE_DIM, TGL_FEATURE_TEXTURE_DIM, pixels, width, height);
-		do_free = 1;
-		width = TGL_FEATURE_TEXTURE_DIM;
-		height = TGL_FEATURE_TEXTURE_DIM; 
-	} else {
-		pixels1 = pixels;
 	}
-
-	im = &c->current_texture->images[level];
-	im->xsize = width;
-	im->ysize = height;
 #if TGL_FEATURE_RENDER_BITS == 32
-	gl_convertRGB_to_8A8R8G8B(im->pixmap, pixels1, width, height);
+	gl_convertRGB_to_8A8R8G8B(data, pixels, width, height);
 #elif TGL_FEATURE_RENDER_BITS == 16
-	gl_convertRGB_to_5R6G5B(im->pixmap, pixels1, width, height);
+	gl_convertRGB_to_5R6G5B(data, pixels, width, height);
 #else
 #error bad TGL_FEATURE_RENDER_BITS
 #endif
-	if (do_free)
-		gl_free(pixels1);
+#if TGL_FEATURE_TEXTURE_FILTER == 1
+	update_mipmaps(c, c->current_texture);
+#endif
 }
 void glopTexImage2D(GLParam* p) {
 	GLint target = p[1].i;
@@ -318,26 +553,35 @@ void glopTexImage2D(GLParam* p) {
 	GLint format = p[7].i;
 	GLint type = p[8].i;
 	void* pixels = p[9].p;
-	GLImage* im;
-	GLubyte* pixels1;
-	GLint do_free=0;
+	PIXEL* data;
+	GLubyte order[4];
+	GLint bytes = texel_format(format, type, order);
 	GLContext* c = gl_get_context();
 	{
 #if TGL_FEATURE_ERROR_CHECK == 1
-		if (!(c->current_texture != NULL && target == GL_TEXTURE_2D && level == 0 && components == 3 && border == 0 && format == GL_RGB &&
-			  type == GL_UNSIGNED_BYTE))
+		if (!(c->current_texture != NULL && target == GL_TEXTURE_2D && level == 0 && TEXTURE_COMPONENTS_OK(components) && border == 0 && bytes != 0))
 #define ERROR_FLAG GL_INVALID_ENUM
 #include "error_check.h"
 
 #else
-		if (!(c->current_texture != NULL && target == GL_TEXTURE_2D && level == 0 && components == 3 && border == 0 && format == GL_RGB &&
-			  type == GL_UNSIGNED_BYTE))
+		if (!(c->current_texture != NULL && target == GL_TEXTURE_2D && level == 0 && TEXTURE_COMPONENTS_OK(components) && border == 0 && bytes != 0))
 			gl_fatal_error("glTexImage2D: combination of parameters not handled!!");
 #endif
 	}
-	if (width != TGL_FEATURE_TEXTURE_DIM || height != TGL_FEATURE_TEXTURE_DIM) {
-		pixels1 = gl_malloc(TGL_FEATURE_TEXTURE_DIM * TGL_FEATURE_TEXTURE_DIM * 3); /* GUARDED*/
-		if (pixels1 == NULL) {
+	/* stored at its own size */
+	if (!valid_image_size(width, height)) {
+#if TGL_FEATURE_ERROR_CHECK == 1
+#define ERROR_FLAG GL_INVALID_VALUE
+#include "error_check.h"
+#else
+		tgl_warning("glTexImage2D: texture size not handled");
+		return;
+#endif
+	}
+#if TGL_FEATURE_TEXTURE_COMPRESSION == 1
+	if (components == GL_COMPRESSED_RGB_S3TC_DXT1_EXT) {
+		GLubyte* blocks = alloc_blocks(c, c->current_texture, level, width, height);
+		if (blocks == NULL) {
 #if TGL_FEATURE_ERROR_CHECK == 1
 #define ERROR_FLAG GL_OUT_OF_MEMORY
 #include "error_check.h"
@@ -345,28 +589,121 @@ void glopTexImage2D(GLParam* p) {
 			gl_fatal_error("GL_OUT_OF_MEMORY");
 #endif
 		}
-		/* no GLinterpolation is done here to respect the original image aliasing ! */
-		
-		gl_resizeImageNoInterpolate(pixels1, TGL_FEATURE_TEXTURE_DIM, TGL_FEATURE_TEXTURE_DIM, pixels, width, height);
-		do_free = 1;
-		width = TGL_FEATURE_TEXTURE_DIM;
-		height = TGL_FEATURE_TEXTURE_DIM;
-	} else {
-		pixels1 = pixels;
+		gl_convertTexels_to_BC1(blocks, pixels, width, height, bytes, order);
+#if TGL_FEATURE_TEXTURE_FILTER == 1
+		update_mipmaps(c, c->current_texture);
+#endif
+		return;
 	}
+#endif
+	data = alloc_image(c, c->current_texture, level, width, height);
+	if (data == NULL) {
+#if TGL_FEATURE_ERROR_CHECK == 1
+#define ERROR_FLAG GL_OUT_OF_MEMORY
+#include "error_check.h"
+#else
+		gl_fatal_error("GL_OUT_OF_MEMORY");
+#endif
+	}
+	convert_texels(data, width, pixels, width, height, bytes, order, TEXTURE_COMPONENTS_OPAQUE(components));
+#if TGL_FEATURE_TEXTURE_FILTER == 1
+	update_mipmaps(c, c->current_texture);
+#endif
+}
 
+#if TGL_FEATURE_TILED_RASTER == 1
+/*
+ makes the spare texels the current ones, a copy of them unless they are all replaced, and keeps the current ones
+ for the queued triangles. returns 0 when the spare is still sampled by them, or cannot be allocated
+*/
+static GLint swap_spare(GLContext* c, GLTexture* t, GLint whole) {
+	GLImage* im = &t->images[0];
+	PIXEL* p;
+	GLuint batch = ZB_TILE_BATCH(c->zb);
+	if (t->spare && t->spare_batch == batch)
+		return 0;
+	if (t->spare == NULL && (t->spare = gl_malloc(im->xsize * im->ysize * sizeof(PIXEL))) == NULL)
+		return 0;
+#if TGL_FEATURE_TEXTURE_FILTER == 1
+	if (t->mipmap) {
+		GLint n = mipmap_size(im->xsize, im->ysize);
+		if (t->spare_mipmap == NULL && (t->spare_mipmap = gl_malloc(n * sizeof(PIXEL))) == NULL)
+			return 0;
+		if (!whole)
+			memcpy(t->spare_mipmap, t->mipmap, n * sizeof(PIXEL));
+		p = t->mipmap;
+		t->mipmap = t->spare_mipmap;
+		t->spare_mipmap = p;
+	}
+#endif
+	if (!whole)
+		memcpy(t->spare, im->pixmap, im->xsize * im->ysize * sizeof(PIXEL));
+	p = im->pixmap;
+	im->pixmap = t->spare;
+	t->spare = p;
+	t->spare_batch = batch;
+	return 1;
+}
+/* whether triangles that sample t are queued */
+#define texture_queued(c, t) ((t)->queued_batch && (t)->queued_batch == ZB_TILE_BATCH((c)->zb))
+#else
+#define swap_spare(c, t, whole) 0
+#define texture_queued(c, t) 0
+#endif
+
+/* replaces a rectangle of an uncompressed image */
+void glopTexSubImage2D(GLParam* p) {
+	GLint target = p[1].i;
+	GLint level = p[2].i;
+	GLint xoffset = p[3].i;
+	GLint yoffset = p[4].i;
+	GLint width = p[5].i;
+	GLint height = p[6].i;
+	GLint format = p[7].i;
+	GLint type = p[8].i;
+	void* pixels = p[9].p;
+	GLImage* im;
+	GLubyte order[4];
+	GLint bytes = texel_format(format, type, order);
+	GLContext* c = gl_get_context();
+	if (c->current_texture == NULL || target != GL_TEXTURE_2D || level != 0 || bytes == 0) {
+#if TGL_FEATURE_ERROR_CHECK == 1
+#define ERROR_FLAG GL_INVALID_ENUM
+#include "error_check.h"
+#else
+		tgl_warning("glTexSubImage2D: combination of parameters not handled");
+		return;
+#endif
+	}
 	im = &c->current_texture->images[level];
-	im->xsize = width;
-	im->ysize = height;
-#if TGL_FEATURE_RENDER_BITS == 32
-	gl_convertRGB_to_8A8R8G8B(im->pixmap, pixels1, width, height);
-#elif TGL_FEATURE_RENDER_BITS == 16
-	gl_convertRGB_to_5R6G5B(im->pixmap, pixels1, width, height);
+	if (im->pixmap == NULL) {
+#if TGL_FEATURE_ERROR_CHECK == 1
+#define ERROR_FLAG GL_INVALID_OPERATION
+#include "error_check.h"
 #else
-#error Bad TGL_FEATURE_RENDER_BITS
+		tgl_warning("glTexSubImage2D: no uncompressed image");
+		return;
+#endif
+	}
+	if (xoffset < 0 || yoffset < 0 || width < 0 || height < 0 || xoffset + width > im->xsize || yoffset + height > im->ysize) {
+#if TGL_FEATURE_ERROR_CHECK == 1
+#define ERROR_FLAG GL_INVALID_VALUE
+#include "error_check.h"
+#else
+		tgl_warning("glTexSubImage2D: rectangle outside of the image");
+		return;
+#endif
+	}
+	if (width == 0 || height == 0)
+		return;
+	/* queued triangles may still sample the old texels, otherwise they are replaced in place */
+	if (texture_queued(c, c->current_texture) && !swap_spare(c, c->current_texture, width == im->xsize && height == im->ysize))
+		ZB_FLUSH_TILES(c->zb);
+	/* texels take the alpha of the client data */
+	convert_texels(im->pixmap + xoffset + yoffset * im->xsize, im->xsize, pixels, width, height, bytes, order, 0);
+#if TGL_FEATURE_TEXTURE_FILTER == 1
+	update_mipmap_rect(c, c->current_texture, xoffset, yoffset, xoffset + width, yoffset + height);
 #endif
-	if (do_free)
-		gl_free(pixels1);
 }
 
 /* TODO: not all tests are done */
@@ -396,18 +733,23 @@ void glopTexEnv(GLContext* c, GLParam* p) {
 		goto error;
 }
 */
-/* TODO: not all tests are done */
-/*
-void glopTexParameter(GLContext* c, GLParam* p) {
+void glopTexParameter(GLParam* p) {
 	GLint target = p[1].i;
 	GLint pname = p[2].i;
 	GLint param = p[3].i;
+#if TGL_FEATURE_TEXTURE_FILTER == 1
+	GLContext* c = gl_get_context();
+#endif
 
-	if (target != GL_TEXTURE_2D &&
-		target != GL_TEXTURE_1D) {
+	if (target != GL_TEXTURE_2D && target != GL_TEXTURE_1D) {
 	error:
+#if TGL_FEATURE_ERROR_CHECK == 1
+#define ERROR_FLAG GL_INVALID_ENUM
+#include "error_check.h"
+#else
 		tgl_warning("glTexParameter: unsupported option");
 		return;
+#endif
 	}
 
 	switch (pname) {
@@ -416,9 +758,26 @@ void glopTexParameter(GLContext* c, GLParam* p) {
 		if (param != GL_REPEAT)
 			goto error;
 		break;
+	case GL_TEXTURE_MAG_FILTER:
+		if (param != GL_NEAREST && param != GL_LINEAR)
+			goto error;
+#if TGL_FEATURE_TEXTURE_FILTER == 1
+		c->current_texture->mag_filter = param;
+#endif
+		break;
+	case GL_TEXTURE_MIN_FILTER:
+		if (param != GL_NEAREST && param != GL_LINEAR && param != GL_NEAREST_MIPMAP_NEAREST && param != GL_LINEAR_MIPMAP_NEAREST &&
+			param != GL_NEAREST_MIPMAP_LINEAR && param != GL_LINEAR_MIPMAP_LINEAR)
+			goto error;
+#if TGL_FEATURE_TEXTURE_FILTER == 1
+		c->current_texture->min_filter = param;
+		update_mipmaps(c, c->current_texture);
+#endif
+		break;
+	default:
+		goto error;
 	}
 }
-*/
 
 /*
 void glopPixelStore(GLContext* c, GLParam* p) {
@@ -46,30 +46,51 @@ void glopColor(GLParam* p) {
 	}
 }
 
-void glopBegin(GLParam* p) {
-	GLint type;
-	M4 tmp;
-	GLContext* c = gl_get_context();
-#if TGL_FEATURE_ERROR_CHECK == 1
-	if (c->in_begin != 0)
-#define ERROR_FLAG GL_INVALID_OPERATION
-#include "error_check.h"
-#else
-	
-#endif
-		type = p[1].i;
-	c->begin_type = type;
-	c->in_begin = 1;
-	c->vertex_n = 0;
-	c->vertex_cnt = 0;
+/*
+ The inverse transpose of the upper 3x3 of the modelview, if that changed since it was last computed:
+ a glTranslate between two blocks leaves it as it is. A rotation, times a uniform scale s, is inverted
+ as an orthogonal matrix would be (see gl_M4_InvOrtho): its inverse transpose is itself over s^2.
+*/
+static void gl_eval_normal_matrix(GLContext* c) {
+	M3 a, inv;
+	GLfloat* m = &c->matrix_stack_ptr[0]->m[0][0];
+	GLfloat d[6], s;
+	GLint i, j;
+
+	c->matrix_model_view_inv_updated = 0;
+	for (i = 0; i < 3; i++)
+		for (j = 0; j < 3; j++)
+			a.m[i][j] = m[i * 4 + j];
+	if (memcmp(&a, &c->matrix_model_view_inv_of, sizeof(M3)) == 0)
+		return;
+	c->matrix_model_view_inv_of = a;
+
+	/* the dot products of the columns */
+	for (i = 0; i < 3; i++) {
+		d[i] = a.m[0][i] * a.m[0][i] + a.m[1][i] * a.m[1][i] + a.m[2][i] * a.m[2][i];
+		j = (i + 1) % 3;
+		d[3 + i] = a.m[0][i] * a.m[0][j] + a.m[1][i] * a.m[1][j] + a.m[2][i] * a.m[2][j];
+	}
+	s = d[0] * 1E-5f;
+	if (d[0] > 0 && fabs(d[1] - d[0]) <= s && fabs(d[2] - d[0]) <= s && fabs(d[3]) <= s && fabs(d[4]) <= s && fabs(d[5]) <= s) {
+		s = fabs(d[0] - 1) <= s ? 1 : 1 / d[0];
+		for (i = 0; i < 3; i++)
+			for (j = 0; j < 3; j++)
+				c->matrix_model_view_inv.m[i][j] = a.m[i][j] * s;
+	} else {
+		gl_M3_Inv(&inv, &a);
+		for (i = 0; i < 3; i++)
+			for (j = 0; j < 3; j++)
+				c->matrix_model_view_inv.m[i][j] = inv.m[j][i];
+	}
+}
 
+void gl_update_matrices(GLContext* c) {
 	if (c->matrix_model_projection_updated) {
+		/* the inverse modelview is left to the first lit vertex, blocks without any do not pay for it */
+		c->matrix_model_view_inv_updated = 1;
 
-		if (c->lighting_enabled) {
-			/* precompute inverse modelview */
-			gl_M4_Inv(&tmp, c->matrix_stack_ptr[0]);
-			gl_M4_Transpose(&c->matrix_model_view_inv, &tmp);
-		} else {
+		if (!c->lighting_enabled) {
 			GLfloat* m = &c->matrix_model_projection.m[0][0];
 			/* precompute projection matrix */
 			gl_M4_Mul(&c->matrix_model_projection, c->matrix_stack_ptr[1], c->matrix_stack_ptr[0]);
@@ -89,6 +110,25 @@ void glopBegin(GLParam* p) {
 
 		c->matrix_model_projection_updated = 0;
 	}
+}
+
+void glopBegin(GLParam* p) {
+	GLint type;
+	GLContext* c = gl_get_context();
+#if TGL_FEATURE_ERROR_CHECK == 1
+	if (c->in_begin != 0)
+#define ERROR_FLAG GL_INVALID_OPERATION
+#include "error_check.h"
+#else
+	
+#endif
+		type = p[1].i;
+	c->begin_type = type;
+	c->in_begin = 1;
+	c->vertex_n = 0;
+	c->vertex_cnt = 0;
+
+	gl_update_matrices(c);
 	/*  viewport- this is now updated on a glViewport call. 
 	if (c->viewport.updated) {
 		gl_eval_viewport(c);
@@ -144,6 +184,8 @@ static void gl_transform_to_viewport_vertex_c(GLVertex* v) {
 	v->zp.r = (GLint)(v->color.v[0] * COLOR_CORRECTED_MULT_MASK + COLOR_MIN_MULT) & COLOR_MASK;
 	v->zp.g = (GLint)(v->color.v[1] * COLOR_CORRECTED_MULT_MASK + COLOR_MIN_MULT) & COLOR_MASK;
 	v->zp.b = (GLint)(v->color.v[2] * COLOR_CORRECTED_MULT_MASK + COLOR_MIN_MULT) & COLOR_MASK;
+	/* clamped, so interpolated alpha cannot wrap around. see ZB_ALPHA */
+	v->zp.a = (GLint)(clampf(v->color.v[3], 0, 1) * COLOR_CORRECTED_MULT_MASK + COLOR_MIN_MULT) & COLOR_MASK;
 
 	if (c->texture_2d_enabled) {
 		v->zp.s = (GLint)(v->tex_coord.X * (ZB_POINT_S_MAX - ZB_POINT_S_MIN) + ZB_POINT_S_MIN); 
@@ -173,6 +215,8 @@ static void gl_vertex_transform(GLVertex* v) {
 		v->pc.Z = (v->ec.X * m[8] + v->ec.Y * m[9] + v->ec.Z * m[10] + v->ec.W * m[11]);
 		v->pc.W = (v->ec.X * m[12] + v->ec.Y * m[13] + v->ec.Z * m[14] + v->ec.W * m[15]);
 
+		if (c->matrix_model_view_inv_updated)
+			gl_eval_normal_matrix(c);
 		m = &c->matrix_model_view_inv.m[0][0];
 		n = &c->current_normal;
 
@@ -203,43 +247,8 @@ static void gl_vertex_transform(GLVertex* v) {
 	v->clip_code = gl_clipcode(v->pc.X, v->pc.Y, v->pc.Z, v->pc.W);
 }
 
-void glopVertex(GLParam* p) {
-	GLVertex* v;
-	GLint n, i, cnt;
-	GLContext* c = gl_get_context();
-#if TGL_FEATURE_ERROR_CHECK == 1
-	if (c->in_begin == 0)
-#define ERROR_FLAG GL_INVALID_OPERATION
-#include "error_check.h"
-#else
-	
-#endif
-
-		n = c->vertex_n;
-	cnt = c->vertex_cnt;
-	cnt++;
-	c->vertex_cnt = cnt;
-
-	/* new vertex entry */
-	v = &c->vertex[n];
-	n++;
-
-	v->coord.X = p[1].f;
-	v->coord.Y = p[2].f;
-	v->coord.Z = p[3].f;
-	v->coord.W = p[4].f;
-
-	gl_vertex_transform(v);
-
-	/* color */
-
-	if (c->lighting_enabled) {
-		gl_shade_vertex(v);
-#include "error_check.h"
-		
-	} else {
-		v->color = c->current_color;
-	}
+/* the texture coordinates, window coordinates and edge flag of the transformed and lit vertex v */
+static inline void gl_vertex_map(GLContext* c, GLVertex* v) {
 	/* tex coords */
 #if TGL_OPTIMIZATION_HINT_BRANCH_COST < 1
 	if (c->texture_2d_enabled)
@@ -261,6 +270,28 @@ void glopVertex(GLParam* p) {
 
 	/* edge flag */
 	v->edge_flag = c->current_edge_flag;
+}
+
+/* lights the transformed vertex v and maps it to the viewport */
+static inline void gl_vertex_light(GLContext* c, GLVertex* v) {
+	/* color */
+
+	if (c->lighting_enabled) {
+		gl_shade_vertex(v);
+#include "error_check.h"
+		
+	} else {
+		v->color = c->current_color;
+	}
+	gl_vertex_map(c, v);
+}
+
+/* draws the primitives that the vertex at c->vertex[c->vertex_n] completes */
+static inline void gl_vertex_assemble(GLContext* c) {
+	GLint n, i, cnt;
+
+	n = c->vertex_n + 1;
+	cnt = ++c->vertex_cnt;
 
 	switch (c->begin_type) {
 	case GL_POINTS:
@@ -358,6 +389,230 @@ void glopVertex(GLParam* p) {
 	c->vertex_n = n;
 }
 
+static inline void gl_vertex(GLContext* c, GLfloat x, GLfloat y, GLfloat z, GLfloat w) {
+	GLVertex* v = &c->vertex[c->vertex_n];
+	v->coord.X = x;
+	v->coord.Y = y;
+	v->coord.Z = z;
+	v->coord.W = w;
+	gl_vertex_transform(v);
+	gl_vertex_light(c, v);
+	gl_vertex_assemble(c);
+}
+
+void gl_draw_vertex(GLContext* c, const GLVertex* v) {
+	c->vertex[c->vertex_n] = *v;
+	gl_vertex_assemble(c);
+}
+
+/* vertices i0 to i1 of in by the rows of m, to out[][i - i0]. W = 1 is assumed */
+static void transform_batch(GLfloat (*out)[VERTEX_BATCH_SIZE], const GLfloat* const* in, GLint i0, GLint i1, const GLfloat* m) {
+	const GLfloat *x = in[0] + i0, *y = in[1] + i0, *z = in[2] + i0;
+	GLint i, j, n = i1 - i0;
+	for (j = 0; j < 4; j++, m += 4) {
+		GLfloat* o = out[j];
+		for (i = 0; i < n; i++)
+			o[i] = x[i] * m[0] + y[i] * m[1] + z[i] * m[2] + m[3];
+	}
+}
+
+/* the eye and clip coordinates, eye normals, lit colors and clip codes of vertices i0 to i0 + k of b, to index i - i0 */
+static void batch_transform(GLContext* c, GLVertexBatch* b, GLint i0, GLint k) {
+	GLint i, j, s;
+	GLfloat* m;
+
+	/* the same math as gl_vertex_transform, a component at a time */
+	if (c->lighting_enabled) {
+		transform_batch(b->ec, b->coord, i0, i0 + k, &c->matrix_stack_ptr[0]->m[0][0]);
+		m = &c->matrix_stack_ptr[1]->m[0][0];
+		for (j = 0; j < 4; j++, m += 4)
+			for (i = 0; i < k; i++)
+				b->pc[j][i] = b->ec[0][i] * m[0] + b->ec[1][i] * m[1] + b->ec[2][i] * m[2] + b->ec[3][i] * m[3];
+
+		/* the vertices before normal_start all have the current normal */
+		if (c->matrix_model_view_inv_updated)
+			gl_eval_normal_matrix(c);
+		m = &c->matrix_model_view_inv.m[0][0];
+		s = b->normal[0] == NULL ? k : b->normal_start - i0;
+		s = s < 0 ? 0 : s > k ? k : s;
+		for (j = 0; j < 3; j++, m += 4) {
+			GLfloat cn = c->current_normal.X * m[0] + c->current_normal.Y * m[1] + c->current_normal.Z * m[2];
+			for (i = 0; i < s; i++)
+				b->normal_ec[j][i] = cn;
+			for (; i < k; i++)
+				b->normal_ec[j][i] = b->normal[0][i0 + i] * m[0] + b->normal[1][i0 + i] * m[1] + b->normal[2][i0 + i] * m[2];
+		}
+		gl_shade_batch_lights(c, b, i0, k);
+	} else {
+		transform_batch(b->pc, b->coord, i0, i0 + k, &c->matrix_model_projection.m[0][0]);
+		if (c->matrix_model_projection_no_w_transform)
+			for (i = 0; i < k; i++)
+				b->pc[3][i] = c->matrix_model_projection.m[3][3];
+	}
+	for (i = 0; i < k; i++)
+		b->clip_code[i] = gl_clipcode(b->pc[0][i], b->pc[1][i], b->pc[2][i], b->pc[3][i]);
+}
+
+/* makes the color and texture coordinates of vertex j of b current */
+static void batch_attributes(GLContext* c, GLVertexBatch* b, GLint j) {
+	GLParam q[5];
+	if (b->color[0] != NULL && j >= b->color_start) {
+		q[1].f = b->color[0][j];
+		q[2].f = b->color[1][j];
+		q[3].f = b->color[2][j];
+		q[4].f = b->color[3][j];
+		glopColor(q);
+	}
+	if (b->tex_coord[0] != NULL && j >= b->tex_coord_start) {
+		c->current_tex_coord.X = b->tex_coord[0][j];
+		c->current_tex_coord.Y = b->tex_coord[1][j];
+		c->current_tex_coord.Z = b->tex_coord[2][j];
+		c->current_tex_coord.W = b->tex_coord[3][j];
+	}
+}
+
+/* vertex i0 + i of b, transformed and lit by batch_transform, to v, with its attributes made current */
+static void batch_vertex(GLContext* c, GLVertexBatch* b, GLint i0, GLint i, GLVertex* v) {
+	GLint j = i0 + i;
+	batch_attributes(c, b, j);
+	v->coord.X = b->coord[0][j];
+	v->coord.Y = b->coord[1][j];
+	v->coord.Z = b->coord[2][j];
+	v->coord.W = b->coord[3][j];
+	if (c->lighting_enabled) {
+		v->ec.X = b->ec[0][i];
+		v->ec.Y = b->ec[1][i];
+		v->ec.Z = b->ec[2][i];
+		v->ec.W = b->ec[3][i];
+		v->normal.X = b->normal_ec[0][i];
+		v->normal.Y = b->normal_ec[1][i];
+		v->normal.Z = b->normal_ec[2][i];
+		v->color.X = b->lit[0][i];
+		v->color.Y = b->lit[1][i];
+		v->color.Z = b->lit[2][i];
+		v->color.W = b->lit[3][i];
+	} else {
+		v->color = c->current_color;
+	}
+	v->pc.X = b->pc[0][i];
+	v->pc.Y = b->pc[1][i];
+	v->pc.Z = b->pc[2][i];
+	v->pc.W = b->pc[3][i];
+	v->clip_code = b->clip_code[i];
+	gl_vertex_map(c, v);
+}
+
+void gl_vertex_batch(GLContext* c, GLVertexBatch* b) {
+	GLint i0, i, k;
+	V4 normal;
+
+	for (i0 = 0; i0 < b->n; i0 += VERTEX_BATCH_SIZE) {
+		k = b->n - i0 < VERTEX_BATCH_SIZE ? b->n - i0 : VERTEX_BATCH_SIZE;
+		batch_transform(c, b, i0, k);
+		for (i = 0; i < k; i++) {
+			batch_vertex(c, b, i0, i, &c->vertex[c->vertex_n]);
+			gl_vertex_assemble(c);
+		}
+	}
+
+	/* the normal left by the last vertex */
+	if (b->normal[0] != NULL && b->normal_start < b->n) {
+		normal.X = b->normal[0][b->n - 1];
+		normal.Y = b->normal[1][b->n - 1];
+		normal.Z = b->normal[2][b->n - 1];
+		normal.W = 0;
+		c->current_normal = normal;
+	}
+}
+
+void gl_shade_batch(GLContext* c, GLVertexBatch* b, GLVertex** out) {
+	GLint i;
+	batch_transform(c, b, 0, b->n);
+	for (i = 0; i < b->n; i++)
+		batch_vertex(c, b, 0, i, out[i]);
+}
+
+void glopVertex(GLParam* p) {
+	GLContext* c = gl_get_context();
+#if TGL_FEATURE_ERROR_CHECK == 1
+	if (c->in_begin == 0)
+#define ERROR_FLAG GL_INVALID_OPERATION
+#include "error_check.h"
+#endif
+	gl_vertex(c, p[1].f, p[2].f, p[3].f, p[4].f);
+}
+
+#if TGL_FEATURE_LIST_MESHES == 1
+/* shades the distinct vertices of an indexed mesh in b once, then assembles the primitives from them */
+static void mesh_elements(GLContext* c, GLMesh* m, GLVertexBatch* b) {
+	GLint i0, i, k, last;
+	if (c->mesh_vertex_size < m->n) {
+		if (c->mesh_vertex)
+			gl_free(c->mesh_vertex);
+		c->mesh_vertex = gl_malloc(m->n * sizeof(GLVertex));
+		c->mesh_vertex_size = c->mesh_vertex ? m->n : 0;
+	}
+	if (c->mesh_vertex == NULL) {
+		/* out of memory: each vertex is shaded as it is drawn */
+		for (i = 0; i < m->count; i++) {
+			batch_transform(c, b, m->index[i], 1);
+			batch_vertex(c, b, m->index[i], 0, &c->vertex[c->vertex_n]);
+			gl_vertex_assemble(c);
+		}
+	} else {
+		for (i0 = 0; i0 < m->n; i0 += VERTEX_BATCH_SIZE) {
+			k = m->n - i0 < VERTEX_BATCH_SIZE ? m->n - i0 : VERTEX_BATCH_SIZE;
+			batch_transform(c, b, i0, k);
+			for (i = 0; i < k; i++)
+				batch_vertex(c, b, i0, i, &c->mesh_vertex[i0 + i]);
+		}
+		for (i = 0; i < m->count; i++)
+			gl_draw_vertex(c, &c->mesh_vertex[m->index[i]]);
+	}
+
+	/* the attributes left by the last vertex drawn, not the last one shaded */
+	last = m->index[m->count - 1];
+	batch_attributes(c, b, last);
+	if (b->normal[0] != NULL && last >= b->normal_start) {
+		c->current_normal.X = b->normal[0][last];
+		c->current_normal.Y = b->normal[1][last];
+		c->current_normal.Z = b->normal[2][last];
+		c->current_normal.W = 0;
+	}
+}
+#endif
+
+/* a Begin/End block baked by glEndList, see GLMesh */
+void glopMesh(GLParam* p) {
+	GLMesh* m = p[1].p;
+	GLContext* c = gl_get_context();
+	GLVertexBatch* b = &c->batch;
+	GLParam q[2];
+	GLint j;
+
+	q[1].i = m->mode;
+	glopBegin(q);
+#include "error_check.h"
+	b->n = m->n;
+	for (j = 0; j < 4; j++) {
+		b->coord[j] = m->coord[j];
+		b->color[j] = m->color[j];
+		b->tex_coord[j] = m->tex_coord[j];
+	}
+	for (j = 0; j < 3; j++)
+		b->normal[j] = m->normal[j];
+	b->normal_start = m->normal_start;
+	b->color_start = m->color_start;
+	b->tex_coord_start = m->tex_coord_start;
+#if TGL_FEATURE_LIST_MESHES == 1
+	if (m->index)
+		mesh_elements(c, m, b);
+	else
+#endif
+		gl_vertex_batch(c, b);
+	glopEnd(q);
+}
+
 void glopEnd(GLParam* param) {
 	GLContext* c = gl_get_context();
 #if TGL_FEATURE_ERROR_CHECK == 1
@@ -39,7 +39,7 @@ ZBuffer* ZB_open(GLint xsize, GLint ysize, GLint mode,
 		goto error;
 	}
 
-	size = zb->xsize * zb->ysize * sizeof(GLushort);
+	size = zb->xsize * zb->ysize * sizeof(ZPIXEL);
 
 	zb->zbuf = gl_malloc(size);
 	if (zb->zbuf == NULL)
@@ -58,6 +58,25 @@ ZBuffer* ZB_open(GLint xsize, GLint ysize, GLint mode,
 	}
 
 	zb->current_texture = NULL;
+	zb->clip_xmin = 0;
+	zb->clip_xmax = zb->xsize - 1;
+	zb->clip_ymin = 0;
+	zb->clip_ymax = zb->ysize - 1;
+	zb->rasterizer = ZB_RASTER_SCANLINE;
+	/* TinyGL has always drawn with GL_LEQUAL */
+	zb->depth_func = GL_LEQUAL;
+	zb->color_mask = ZB_COLOR_MASK_ALL;
+	zb->color_write = 1;
+#if TGL_FEATURE_TILED_RASTER == 1
+	zb->tiles = NULL;
+#endif
+#if TGL_FEATURE_SIMD_SPANS == 1
+	ZB_initSpans(zb);
+#endif
+#if TGL_FEATURE_HIZ == 1
+	/* without it triangles are simply never rejected early */
+	ZB_hizAlloc(zb);
+#endif
 
 	return zb;
 error:
@@ -65,17 +84,40 @@ error:
 	return NULL;
 }
 
+GLint ZB_setRasterizer(ZBuffer* zb, GLint rasterizer) {
+	switch (rasterizer) {
+	case ZB_RASTER_SCANLINE:
+#if TGL_FEATURE_HALFSPACE_RASTER == 1
+	case ZB_RASTER_HALFSPACE:
+#endif
+		zb->rasterizer = rasterizer;
+		return 1;
+	default:
+		return 0;
+	}
+}
+
 void ZB_close(ZBuffer* zb) {
+#if TGL_FEATURE_TILED_RASTER == 1
+	ZB_setTiledRaster(zb, 0);
+#endif
 
 	if (zb->frame_buffer_allocated)
 		gl_free(zb->pbuf);
 
+#if TGL_FEATURE_HIZ == 1
+	ZB_hizFree(zb);
+#endif
 	gl_free(zb->zbuf);
 	gl_free(zb);
 }
 
 void ZB_resize(ZBuffer* zb, void* frame_buffer, GLint xsize, GLint ysize) {
 	GLint size;
+#if TGL_FEATURE_TILED_RASTER == 1
+	GLint tiled = zb->tiles != NULL;
+	ZB_setTiledRaster(zb, 0);
+#endif
 
 	/* xsize must be a multiple of 4 */
 	xsize = xsize & ~3;
@@ -83,13 +125,21 @@ void ZB_resize(ZBuffer* zb, void* frame_buffer, GLint xsize, GLint ysize) {
 	zb->xsize = xsize;
 	zb->ysize = ysize;
 	zb->linesize = (xsize * PSZB);
+	zb->clip_xmin = 0;
+	zb->clip_xmax = zb->xsize - 1;
+	zb->clip_ymin = 0;
+	zb->clip_ymax = zb->ysize - 1;
 
-	size = zb->xsize * zb->ysize * sizeof(GLushort);
+	size = zb->xsize * zb->ysize * sizeof(ZPIXEL);
 
 	gl_free(zb->zbuf);
 	zb->zbuf = gl_malloc(size);
 	if (zb->zbuf == NULL)
 		exit(1);
+#if TGL_FEATURE_HIZ == 1
+	ZB_hizFree(zb);
+	ZB_hizAlloc(zb);
+#endif
 	if (zb->frame_buffer_allocated)
 		gl_free(zb->pbuf);
 
@@ -102,6 +152,10 @@ void ZB_resize(ZBuffer* zb, void* frame_buffer, GLint xsize, GLint ysize) {
 		zb->pbuf = frame_buffer;
 		zb->frame_buffer_allocated = 0;
 	}
+#if TGL_FEATURE_TILED_RASTER == 1
+	if (tiled)
+		ZB_setTiledRaster(zb, 1);
+#endif
 }
 
 #if TGL_FEATURE_32_BITS == 1
@@ -290,6 +344,7 @@ static void ZB_copyFrameBufferRGB24(ZBuffer * zb,
 #if TGL_FEATURE_RENDER_BITS == 16
 
 void ZB_copyFrameBuffer(ZBuffer* zb, void* buf, GLint linesize) {
+	ZB_FLUSH_TILES(zb);
 
 	ZB_copyBuffer(zb, buf, linesize);
 }
@@ -304,6 +359,7 @@ void ZB_copyFrameBuffer(ZBuffer* zb, void* buf, GLint linesize) {
 
 
 void ZB_copyFrameBuffer(ZBuffer* zb, void* buf, GLint linesize) {
+	ZB_FLUSH_TILES(zb);
 	ZB_copyBuffer(zb, buf, linesize);
 }
 
@@ -355,12 +411,27 @@ static void memset_l(void* adr, GLint val, GLint count) {
 		*p++ = val;
 }
 
-void ZB_clear(ZBuffer* zb, GLint clear_z, GLint z, GLint clear_color, GLint r, GLint g, GLint b) {
+void ZB_clear(ZBuffer* zb, GLint clear_z, GLint z, GLint clear_color, GLint r, GLint g, GLint b, GLint a) {
 	GLuint color;
-	GLint y;
+	GLint x, y;
 	PIXEL* pp;
+	PIXEL zbcm = zb->color_mask;
+#if TGL_FEATURE_TILED_RASTER == 1
+	/* a full clear overwrites everything the pending triangles would draw */
+	if (clear_z && clear_color && zbcm == ZB_COLOR_MASK_ALL)
+		ZB_discardTiles(zb);
+	else
+		ZB_FLUSH_TILES(zb);
+#endif
 	if (clear_z) {
+#if TGL_FEATURE_DEPTH_BITS == 16
 		memset_s(zb->zbuf, z, zb->xsize * zb->ysize);
+#else
+		memset_l(zb->zbuf, z, zb->xsize * zb->ysize);
+#endif
+#if TGL_FEATURE_HIZ == 1
+		ZB_hizClear(zb, z);
+#endif
 	}
 	if (clear_color) {
 		pp = zb->pbuf;
@@ -370,16 +441,24 @@ void ZB_clear(ZBuffer* zb, GLint clear_z, GLint z, GLint clear_color, GLint r, G
 #if TGL_FEATURE_FORCE_CLEAR_NO_COPY_COLOR
 			color = TGL_NO_COPY_COLOR;
 #else
-			color = RGB_TO_PIXEL(r, g, b);
+			color = RGBA_TO_PIXEL(r, g, b, (a >> COLOR_SHIFT) & 0xff);
 #endif
-			memset_s(pp, color, zb->xsize);
+			if (zbcm == ZB_COLOR_MASK_ALL)
+				memset_s(pp, color, zb->xsize);
+			else
+				for (x = 0; x < zb->xsize; x++)
+					pp[x] = ZB_MASK_PIXEL(color, pp[x], zbcm);
 #elif TGL_FEATURE_RENDER_BITS == 32
 #if TGL_FEATURE_FORCE_CLEAR_NO_COPY_COLOR
 			color = TGL_NO_COPY_COLOR;
 #else
-			color = RGB_TO_PIXEL(r, g, b);
+			color = RGBA_TO_PIXEL(r, g, b, (a >> COLOR_SHIFT) & 0xff);
 #endif
-			memset_l(pp, color, zb->xsize);
+			if (zbcm == ZB_COLOR_MASK_ALL)
+				memset_l(pp, color, zb->xsize);
+			else
+				for (x = 0; x < zb->xsize; x++)
+					pp[x] = ZB_MASK_PIXEL(color, pp[x], zbcm);
 #else
 #error BADJUJU
 #endif
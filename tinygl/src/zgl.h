@@ -32,12 +32,10 @@ enum {
 
 #define POLYGON_MAX_VERTEX 4
 #endif
-/* Max # of specular light pow buffers */
-#define MAX_SPECULAR_BUFFERS 32
-
 /* # of entries in specular buffer */
 #define SPECULAR_BUFFER_SIZE 512
-/* specular buffer granularity */
+/* # of specular light pow buffers: one per shininess from 0 to 128, in steps of 128 / SPECULAR_BUFFER_SIZE */
+#define MAX_SPECULAR_BUFFERS (SPECULAR_BUFFER_SIZE + 1)
 
 
 #define MAX_MODELVIEW_STACK_DEPTH 32
@@ -46,24 +44,29 @@ enum {
 #define MAX_NAME_STACK_DEPTH 16
 #define MAX_TEXTURE_LEVELS 1
 #define MAX_LIGHTS 16
+/* glLineWidth, wide lines cost the square of their width per pixel of length */
+#define MAX_LINE_WIDTH 64
 
 #define VERTEX_ARRAY 0x0001
 #define COLOR_ARRAY 0x0002
 #define NORMAL_ARRAY 0x0004
 #define TEXCOORD_ARRAY 0x0008
 
-#define MAX_DISPLAY_LISTS 16384
+/* display list op buffers hold 16, 64, 256, 1024 then 4096 GLParams, see list.c */
+#define OP_BUFFER_MIN_SIZE 16
 #define OP_BUFFER_MAX_SIZE 4096
+#define OP_BUFFER_CLASSES 5
+/* the op buffers are carved out of blocks of this many bytes */
+#define OP_ARENA_BLOCK_SIZE (256 * 1024)
 
 #define TGL_OFFSET_FILL 0x1
 #define TGL_OFFSET_LINE 0x2
 #define TGL_OFFSET_POINT 0x4
 
+/* pow(i / SPECULAR_BUFFER_SIZE, shininess), shared by all threads and never changed once made, see specbuf.c */
 typedef struct GLSpecBuf {
 	GLint shininess_i;
-	GLint last_used;
 	GLfloat buf[SPECULAR_BUFFER_SIZE + 1];
-	struct GLSpecBuf* next;
 } GLSpecBuf;
 
 typedef struct GLLight {
@@ -79,6 +82,13 @@ typedef struct GLLight {
 	GLfloat attenuation[3];
 	/* precomputed values */
 	GLfloat cos_spot_cutoff;
+	/*
+	 of a light at infinity: the specular half vector of a viewer at infinity and its inverse length (0 if it is too
+	 short), and the cosine of the angle between the spot direction and the light. see gl_light_update
+	*/
+	V3 half;
+	GLfloat half_inv_length;
+	GLfloat spot_dot;
 
 	/* we use a linked list to know which are the enabled lights */
 	
@@ -96,13 +106,20 @@ typedef struct GLMaterial {
 	/* computed values */
 	GLint shininess_i;
 	GLint do_specular;
+#if TGL_FEATURE_SPECULAR_BUFFERS == 1
+	/* the table of shininess_i, NULL without the memory for it */
+	const GLSpecBuf* specbuf;
+#endif
 } GLMaterial;
 
 typedef struct GLViewport {
 	V3 scale;
 	V3 trans;
 	GLint xmin, ymin, xsize, ysize;
-	
+#if TGL_FEATURE_GUARD_BAND == 1
+	/* the guard band, in multiples of w, see clip.c */
+	GLfloat guard_x, guard_y;
+#endif
 } GLViewport;
 
 typedef union {
@@ -114,13 +131,48 @@ typedef union {
 } GLParam;
 
 typedef struct GLParamBuffer {
-	GLParam ops[OP_BUFFER_MAX_SIZE];
 	struct GLParamBuffer* next;
+	/* GLParams in ops */
+	GLint size;
+	GLParam ops[];
 } GLParamBuffer;
 
+/*
+ bump allocator for the op buffers of display lists. free[i] holds released buffers of at least
+ OP_BUFFER_MIN_SIZE << 2i GLParams, and less than the next size. blocks are only freed at glClose
+*/
+typedef struct GLArenaBlock {
+	struct GLArenaBlock* next;
+} GLArenaBlock;
+
+typedef struct GLParamArena {
+	GLArenaBlock* blocks;
+	/* free space of the newest block */
+	GLubyte *top, *end;
+	GLParamBuffer* free[OP_BUFFER_CLASSES];
+} GLParamArena;
+
+/*
+ a Begin/End block of a display list, baked at glEndList into one array per component.
+ the normal, color and texture coordinate arrays are NULL when the block never sets them, and their
+ first *_start vertices keep the current value of the context, as they come before the first glNormal...
+ a vertex that repeats an earlier one is stored once: the block draws the count vertices of index[] then,
+ and index is NULL when the n vertices of the arrays are drawn in order
+*/
+typedef struct GLMesh {
+	struct GLMesh* next;
+	GLint mode, n, count;
+	GLuint* index;
+	GLint normal_start, color_start, tex_coord_start;
+	GLfloat* coord[4];
+	GLfloat* normal[3];
+	GLfloat* color[4];
+	GLfloat* tex_coord[4];
+} GLMesh;
+
 typedef struct GLList {
 	GLParamBuffer* first_op_buffer;
-	/* TODO: extensions for an hash table or a better allocating scheme */
+	GLMesh* meshes;
 } GLList;
 
 typedef struct GLVertex {
@@ -138,33 +190,108 @@ typedef struct GLVertex {
 	GLint edge_flag;
 } GLVertex;
 
+/*
+ vertices drawn together by gl_vertex_batch, which transforms and clip codes VERTEX_BATCH_SIZE of them at a time,
+ one component of all of them after the other, before lighting them and assembling the primitives one by one.
+ NULL attribute arrays, and the vertices before *_start, use the current values of the context
+*/
+#define VERTEX_BATCH_SIZE 64
+/* post-transform cache of glDrawElements, direct mapped. a power of two */
+#define VERTEX_CACHE_SIZE 64
+
+typedef struct GLVertexBatch {
+	GLint n;
+	const GLfloat* coord[4];
+	const GLfloat* normal[3];
+	const GLfloat* color[4];
+	const GLfloat* tex_coord[4];
+	GLint normal_start, color_start, tex_coord_start;
+	/* for the callers that gather at most VERTEX_BATCH_SIZE vertices */
+	GLfloat in[15][VERTEX_BATCH_SIZE];
+	/* eye coordinates and normals (lighting only), and clip coordinates */
+	GLfloat ec[4][VERTEX_BATCH_SIZE];
+	GLfloat normal_ec[3][VERTEX_BATCH_SIZE];
+	GLfloat pc[4][VERTEX_BATCH_SIZE];
+	GLint clip_code[VERTEX_BATCH_SIZE];
+	/* lit colors, see gl_shade_batch_lights */
+	GLfloat lit[4][VERTEX_BATCH_SIZE];
+} GLVertexBatch;
+
 typedef struct GLImage {
-	PIXEL pixmap[TGL_FEATURE_TEXTURE_DIM * TGL_FEATURE_TEXTURE_DIM];
+	/* xsize * ysize texels, NULL until an image is specified */
+	PIXEL* pixmap;
 	GLint xsize, ysize;
+#if TGL_FEATURE_TEXTURE_COMPRESSION == 1
+	/* the BC1 blocks of a compressed image, row by row. pixmap is NULL then */
+	GLubyte* blocks;
+#endif
 } GLImage;
 
+#if TGL_FEATURE_TEXTURE_COMPRESSION == 1
+#define GL_IMAGE_DEFINED(im) ((im)->pixmap != NULL || (im)->blocks != NULL)
+#else
+#define GL_IMAGE_DEFINED(im) ((im)->pixmap != NULL)
+#endif
+
 /* textures */
 
-#define TEXTURE_HASH_TABLE_SIZE 256
-#define TEXTURE_HASH_TABLE_MASK 255
 typedef struct GLTexture {
 	GLImage images[MAX_TEXTURE_LEVELS];
-	struct GLTexture *next, *prev;
 	GLint handle;
+#if TGL_FEATURE_TEXTURE_FILTER == 1
+	GLint min_filter, mag_filter;
+	/* levels 1 and up of images[0] down to 1x1, one after the other. NULL until a mipmap filter is set */
+	PIXEL* mipmap;
+#endif
+#if TGL_FEATURE_TILED_RASTER == 1
+	/*
+	 second copy of the texels of images[0], and of the mip chain. glTexSubImage2D writes into it and swaps it
+	 with the first when queued triangles still sample the texture, instead of drawing them.
+	 spare_batch is the ZB_tileBatch of those triangles
+	*/
+	PIXEL* spare;
+#if TGL_FEATURE_TEXTURE_FILTER == 1
+	PIXEL* spare_mipmap;
+#endif
+	GLuint spare_batch;
+	/* the ZB_tileBatch of the last queued triangle that samples the texture, 0 for none */
+	GLuint queued_batch;
+#endif
 } GLTexture;
 
 /* buffers */
-#define MAX_BUFFERS 2048
 typedef struct GLBuffer {
 	void* data;
 	GLuint size;
 } GLBuffer;
 
+/* name -> object hash table, see names.c */
+typedef struct GLNameSlot {
+	GLuint name;
+	/* the name came from gl_genNames, it goes back to the free list when deleted */
+	GLint generated;
+	void* value;
+} GLNameSlot;
+
+typedef struct GLNameTable {
+	/* 2^bits slots */
+	GLNameSlot* slots;
+	GLint bits;
+	/* names in the table, and slots that are not empty (names and tombstones) */
+	GLint count, used;
+	/* deleted names, generated again first */
+	GLuint* free_names;
+	GLint free_count, free_max;
+	/* no name from next_name up has been used */
+	GLuint next_name;
+} GLNameTable;
+
 /* shared state */
 typedef struct GLSharedState {
-	GLList** lists;
-	GLTexture** texture_hash_table;
-	GLBuffer** buffers;
+	GLNameTable lists;
+	GLParamArena op_arena;
+	GLNameTable textures;
+	GLNameTable buffers;
 } GLSharedState;
 
 struct GLContext;
@@ -180,8 +307,19 @@ typedef struct GLContext {
 	GLViewport viewport;
 	GLMaterial materials[2];
 	GLVertex vertex[POLYGON_MAX_VERTEX];
+	GLVertexBatch batch;
+	/* glDrawElements: the vertex last shaded for each index modulo VERTEX_CACHE_SIZE, and that index */
+	GLVertex vertex_cache[VERTEX_CACHE_SIZE];
+	GLuint vertex_cache_index[VERTEX_CACHE_SIZE];
+#if TGL_FEATURE_LIST_MESHES == 1
+	/* the shaded vertices of an indexed GLMesh, see glopMesh */
+	GLVertex* mesh_vertex;
+	GLint mesh_vertex_size;
+#endif
 
+	/* the inverse transpose of the upper 3x3 of the modelview, which transforms normals, and that 3x3 */
 	M4 matrix_model_view_inv;
+	M3 matrix_model_view_inv_of;
 	M4 matrix_model_projection;
 	V4 ambient_light_model;
 	V4 clear_color;
@@ -197,6 +335,7 @@ typedef struct GLContext {
 	GLLight* first_light;
 	GLTexture* current_texture;
 	GLParamBuffer* current_op_buffer;
+	GLList* current_list;
 	M4* matrix_stack[3];
 	M4* matrix_stack_ptr[3];
 	gl_draw_triangle_func draw_triangle_front, draw_triangle_back;
@@ -230,6 +369,8 @@ typedef struct GLContext {
 	/* current list */
 
 	GLint current_op_buffer_index;
+	/* the ops of the last list compiled, before and after the passes of glEndList */
+	GLint list_ops[2];
 	GLint exec_flag, compile_flag, print_flag;
 	GLuint listbase;
 	/* matrix */
@@ -239,6 +380,8 @@ typedef struct GLContext {
 	GLint matrix_stack_depth_max[3];
 
 	GLint matrix_model_projection_updated;
+	/* matrix_model_view_inv may be out of date, checked on the first lit vertex, see gl_eval_normal_matrix */
+	GLint matrix_model_view_inv_updated;
 	GLint matrix_model_projection_no_w_transform;
 	GLint apply_texture_matrix;
 
@@ -251,6 +394,8 @@ typedef struct GLContext {
 	GLint current_cull_face;
 	GLint cull_face_enabled;
 	GLint normalize_enabled;
+	/* glColorMask as given, for glGet. zb->color_mask has the bits it lets through */
+	GLint color_mask[4];
 
 	/* selection */
 #if TGL_FEATURE_ALT_RENDERMODES == 1
@@ -307,13 +452,6 @@ typedef struct GLContext {
 	/* opengl blending */
 	
 
-	/* specular buffer. could probably be shared between contexts,
-	  but that wouldn't be 100% thread safe */
-#if TGL_FEATURE_SPECULAR_BUFFERS == 1
-	GLSpecBuf* specbuf_first;
-	GLint specbuf_used_counter;
-	GLint specbuf_num_buffers;
-#endif
 	GLint zEnableSpecular; 
 
 	/* raster position */
@@ -340,6 +478,10 @@ static GLContext* gl_get_context(void) { return &gl_ctx; }
 extern void (*op_table_func[])(GLParam*);
 extern GLint op_table_size[];
 extern void gl_compile_op(GLParam* p);
+/* frees the display list op buffers, at glClose */
+void gl_endOpArena(GLParamArena* a);
+/* frees every display list but their op buffers, at glClose */
+void glEndLists();
 static void gl_add_op(GLParam* p) {
 	GLContext* c = gl_get_context();
 #if TGL_FEATURE_ERROR_CHECK == 1
@@ -423,17 +565,55 @@ void gl_print_matrix(const GLfloat* m);
 void glopLoadIdentity(GLParam *p);
 void glopTranslate(GLParam *p);*/
 
+/* vertex.c */
+/* draws the vertices of b */
+void gl_vertex_batch(GLContext* c, GLVertexBatch* b);
+/* the modelview projection product and the texture matrix test, after a matrix change. glBegin calls it */
+void gl_update_matrices(GLContext* c);
+/* transforms and lights the vertices of b, at most VERTEX_BATCH_SIZE, to out[i] without drawing them */
+void gl_shade_batch(GLContext* c, GLVertexBatch* b, GLVertex** out);
+/* the next vertex of the primitives being drawn, already lit and mapped */
+void gl_draw_vertex(GLContext* c, const GLVertex* v);
+
 /* light.c */
 void gl_enable_disable_light(GLint light, GLint v);
+/* precomputes the values of a light at infinity that are the same for every vertex, after its position or spot direction changed */
+void gl_light_update(GLLight* l);
 void gl_shade_vertex(GLVertex* v);
+/* lights vertices i0 to i0 + k of b, transformed by batch_transform in vertex.c, to b->lit[][i - i0] */
+void gl_shade_batch_lights(GLContext* c, GLVertexBatch* b, GLint i0, GLint k);
 
 void glInitTextures();
 void glEndTextures();
 GLTexture* alloc_texture(GLint h);
 
+/* names.c */
+/* 0 when out of memory */
+GLint gl_initNames(GLNameTable* t);
+void gl_endNames(GLNameTable* t);
+/* the object of a name, NULL for names without one */
+void* gl_findName(const GLNameTable* t, GLuint name);
+/* adds or replaces the object of a name. 0 when out of memory */
+GLint gl_setName(GLNameTable* t, GLuint name, void* value);
+/* removes a name, returns its object */
+void* gl_deleteName(GLNameTable* t, GLuint name);
+/* n unused names, reserved until they are deleted or get an object. 0 when out of memory */
+GLint gl_genNames(GLNameTable* t, GLint n, GLuint* names);
+/* the first of range consecutive unused names, reserved the same way. 0 when out of memory */
+GLuint gl_genNameRange(GLNameTable* t, GLint range);
+/* iterate over the objects: slots 0 to gl_nameSlots - 1, gl_nameAt is NULL for slots without one */
+GLint gl_nameSlots(const GLNameTable* t);
+void* gl_nameAt(const GLNameTable* t, GLint slot);
+
 /* image_util.c */
 void gl_convertRGB_to_5R6G5B(GLushort* pixmap, GLubyte* rgb, GLint xsize, GLint ysize);
 void gl_convertRGB_to_8A8R8G8B(GLuint* pixmap, GLubyte* rgb, GLint xsize, GLint ysize);
+/* byte offsets of alpha, red, green and blue in a 32 bit texel of GL_RGBA or GL_BGRA and the given type */
+void gl_texelLayout(GLubyte* order, GLint format, GLint type);
+void gl_convertTexels(PIXEL* pixmap, const GLubyte* src, GLint n, const GLubyte* order, GLint opaque);
+#if TGL_FEATURE_TEXTURE_COMPRESSION == 1
+void gl_convertTexels_to_BC1(GLubyte* blocks, const GLubyte* src, GLint xsize, GLint ysize, GLint bytes, const GLubyte* order);
+#endif
 void gl_resizeImage(GLubyte* dest, GLint xsize_dest, GLint ysize_dest, GLubyte* src, GLint xsize_src, GLint ysize_src);
 void gl_resizeImageNoInterpolate(GLubyte* dest, GLint xsize_dest, GLint ysize_dest, GLubyte* src, GLint xsize_src, GLint ysize_src);
 
@@ -442,7 +622,10 @@ void gl_resizeImageNoInterpolate(GLubyte* dest, GLint xsize_dest, GLint ysize_de
 void gl_fatal_error(char* format, ...);
 
 /* specular buffer "api" */
-GLSpecBuf* specbuf_get_buffer(const GLint shininess_i, const GLfloat shininess);
+/* the table of shininess_i * 128 / SPECULAR_BUFFER_SIZE, made on first use; NULL if out of memory */
+const GLSpecBuf* specbuf_get_buffer(GLint shininess_i);
+/* frees the tables of the process, once no thread uses them */
+void specbuf_free_all(void);
 
 
 
@@ -468,6 +651,16 @@ static void gl_eval_viewport() {
 	v->scale.X = (v->xsize - 0.5) / 2.0;
 	v->scale.Y = -(v->ysize - 0.5) / 2.0;
 	v->scale.Z = -((zsize - 0.5) / 2.0);
+#if TGL_FEATURE_GUARD_BAND == 1
+	/* the rasterizers only scissor to the zbuffer: a viewport that does not cover it gets no guard band */
+	if (v->xmin <= 0 && v->ymin <= 0 && v->xmin + v->xsize >= c->zb->xsize && v->ymin + v->ysize >= c->zb->ysize) {
+		v->guard_x = 1 + TGL_GUARD_BAND / v->scale.X;
+		v->guard_y = 1 + TGL_GUARD_BAND / -v->scale.Y;
+	} else {
+		v->guard_x = 1;
+		v->guard_y = 1;
+	}
+#endif
 }
 
 #endif /* _tgl_zgl_h_ */
@@ -0,0 +1,290 @@
+/*
+ * Half-space (edge function) triangle rasterizer.
+ *
+ * Drop-in alternative to ztriangle.h, driven by the same macros:
+ * INTERP_Z, INTERP_RGB, INTERP_ALPHA, INTERP_STZ, DRAW_INIT() and PUT_PIXEL(_a), plus TEXTURE_LOD (see ztritex.h).
+ * PUT_PIXEL sees the same variables as in the scanline rasterizer
+ * (pp, pz, z, or1, og1, ob1, oa1, s, t, dzdx, drdx, dsdx...) so the pixel kernels can be shared.
+ *
+ * The bounding box is walked in screen aligned 8x8 blocks. Each block is rejected or accepted
+ * as a whole by testing the three edge functions at its corners; only blocks straddling an edge
+ * test coverage per pixel. There is no per-scanline edge stepping, and every block row is an
+ * independent span of at most 8 pixels, which keeps the inner loops short and branch free.
+ *
+ * Edges follow a top-left fill rule, so triangles sharing an edge never draw a pixel twice.
+ */
+
+{
+	/* edge functions: e = a * x + b * y + c, positive inside */
+	GLint a0, b0, c0, a1, b1, c1, a2, b2, c2;
+	/* corner offsets for the trivial reject (max) and accept (min) tests */
+	GLint e0max, e1max, e2max, e0min, e1min, e2min;
+	GLint area, minx, maxx, miny, maxy, bx, by;
+#if TGL_FEATURE_POLYGON_STIPPLE == 1
+	GLint the_y;
+#endif
+#if TGL_FEATURE_HIZ == 1
+	/* nearest depth of the triangle, -1 when blocks are not tested against the hierarchical Z */
+	GLint hizz = -1;
+#endif
+	GLfloat fz, fx0, fy0;
+	PIXEL* pp1;
+	ZPIXEL* pz1;
+#ifdef INTERP_Z
+	GLint dzdx;
+	GLfloat fdzdx, fdzdy;
+#endif
+#ifdef INTERP_RGB
+	GLint drdx, dgdx, dbdx;
+	GLfloat fdrdx, fdrdy, fdgdx, fdgdy, fdbdx, fdbdy;
+#endif
+#ifdef INTERP_ALPHA
+	GLint dadx;
+	GLfloat fdadx, fdady;
+#endif
+#ifdef INTERP_STZ
+	GLfloat dszdx, dszdy, dtzdx, dtzdy;
+#endif
+
+	/* same vertex order as the scanline rasterizer, DRAW_INIT may rely on it */
+	if (p1->y < p0->y) {
+		ZBufferPoint* t = p0;
+		p0 = p1;
+		p1 = t;
+	}
+	if (p2->y < p0->y) {
+		ZBufferPoint* t = p2;
+		p2 = p1;
+		p1 = p0;
+		p0 = t;
+	} else if (p2->y < p1->y) {
+		ZBufferPoint* t = p1;
+		p1 = p2;
+		p2 = t;
+	}
+
+	area = (p1->x - p0->x) * (p2->y - p0->y) - (p2->x - p0->x) * (p1->y - p0->y);
+	if (area == 0)
+		return;
+
+	minx = p0->x;
+	maxx = p0->x;
+	if (p1->x < minx) minx = p1->x;
+	if (p1->x > maxx) maxx = p1->x;
+	if (p2->x < minx) minx = p2->x;
+	if (p2->x > maxx) maxx = p2->x;
+	miny = p0->y;
+	maxy = p2->y;
+	if (minx < zb->clip_xmin) minx = zb->clip_xmin;
+	if (maxx > zb->clip_xmax) maxx = zb->clip_xmax;
+	if (miny < zb->clip_ymin) miny = zb->clip_ymin;
+	if (maxy > zb->clip_ymax) maxy = zb->clip_ymax;
+	if (minx > maxx || miny > maxy)
+		return;
+#if TGL_FEATURE_HIZ == 1
+	if (ZB_hizTriangle(zb, p0, p1, p2))
+		return;
+	if (zb->depth_test && ZB_DEPTH_CULLS(zb->depth_func) && zb->hiz)
+		hizz = ZB_hizNearest(p0, p1, p2);
+#endif
+
+#define HS_EDGE(a, b, c, pa, pb)                                                                                                                               \
+	{                                                                                                                                                          \
+		a = pa->y - pb->y;                                                                                                                                     \
+		b = pb->x - pa->x;                                                                                                                                     \
+		if (area < 0) {                                                                                                                                        \
+			a = -a;                                                                                                                                            \
+			b = -b;                                                                                                                                            \
+		}                                                                                                                                                      \
+		c = -(a * pa->x + b * pa->y);                                                                                                                          \
+		/* top-left rule: centers exactly on a bottom or right edge belong to the neighbour */                                                                            \
+		if (!(a > 0 || (a == 0 && b > 0)))                                                                                                                     \
+			c--;                                                                                                                                               \
+	}
+	HS_EDGE(a0, b0, c0, p1, p2)
+	HS_EDGE(a1, b1, c1, p2, p0)
+	HS_EDGE(a2, b2, c2, p0, p1)
+#undef HS_EDGE
+	e0max = ((a0 > 0) ? 7 * a0 : 0) + ((b0 > 0) ? 7 * b0 : 0);
+	e1max = ((a1 > 0) ? 7 * a1 : 0) + ((b1 > 0) ? 7 * b1 : 0);
+	e2max = ((a2 > 0) ? 7 * a2 : 0) + ((b2 > 0) ? 7 * b2 : 0);
+	e0min = ((a0 < 0) ? 7 * a0 : 0) + ((b0 < 0) ? 7 * b0 : 0);
+	e1min = ((a1 < 0) ? 7 * a1 : 0) + ((b1 < 0) ? 7 * b1 : 0);
+	e2min = ((a2 < 0) ? 7 * a2 : 0) + ((b2 < 0) ? 7 * b2 : 0);
+
+	/* attribute planes: value(x, y) = value(p0) + d/dx * (x - x0) + d/dy * (y - y0) */
+	fz = 1.0f / (GLfloat)area;
+	fx0 = (GLfloat)p0->x;
+	fy0 = (GLfloat)p0->y;
+	{
+		GLfloat fdx1 = (p1->x - p0->x) * fz, fdy1 = (p1->y - p0->y) * fz;
+		GLfloat fdx2 = (p2->x - p0->x) * fz, fdy2 = (p2->y - p0->y) * fz;
+		GLfloat d1, d2;
+#define HS_PLANE(v0, v1, v2, ddx, ddy)                                                                                                                         \
+	{                                                                                                                                                          \
+		d1 = (GLfloat)(v1) - (GLfloat)(v0);                                                                                                                    \
+		d2 = (GLfloat)(v2) - (GLfloat)(v0);                                                                                                                    \
+		ddx = fdy2 * d1 - fdy1 * d2;                                                                                                                           \
+		ddy = fdx1 * d2 - fdx2 * d1;                                                                                                                           \
+	}
+#ifdef INTERP_Z
+		HS_PLANE(p0->z, p1->z, p2->z, fdzdx, fdzdy)
+		dzdx = (GLint)fdzdx;
+#endif
+#ifdef INTERP_RGB
+		HS_PLANE(p0->r, p1->r, p2->r, fdrdx, fdrdy)
+		HS_PLANE(p0->g, p1->g, p2->g, fdgdx, fdgdy)
+		HS_PLANE(p0->b, p1->b, p2->b, fdbdx, fdbdy)
+		drdx = (GLint)fdrdx;
+		dgdx = (GLint)fdgdx;
+		dbdx = (GLint)fdbdx;
+#endif
+#ifdef INTERP_ALPHA
+		HS_PLANE(p0->a, p1->a, p2->a, fdadx, fdady)
+		dadx = (GLint)fdadx;
+#endif
+#ifdef INTERP_STZ
+		p0->sz = (GLfloat)p0->s * p0->z;
+		p0->tz = (GLfloat)p0->t * p0->z;
+		p1->sz = (GLfloat)p1->s * p1->z;
+		p1->tz = (GLfloat)p1->t * p1->z;
+		p2->sz = (GLfloat)p2->s * p2->z;
+		p2->tz = (GLfloat)p2->t * p2->z;
+		HS_PLANE(p0->sz, p1->sz, p2->sz, dszdx, dszdy)
+		HS_PLANE(p0->tz, p1->tz, p2->tz, dtzdx, dtzdy)
+#endif
+#undef HS_PLANE
+	}
+
+	DRAW_INIT();
+
+	for (by = miny & ~7; by <= maxy; by += 8) {
+		for (bx = minx & ~7; bx <= maxx; bx += 8) {
+			GLint e0 = a0 * bx + b0 * by + c0;
+			GLint e1 = a1 * bx + b1 * by + c1;
+			GLint e2 = a2 * bx + b2 * by + c2;
+			GLint accept, y, ylast, xfirst, xlast;
+
+			/* trivial reject: the block corner deepest inside an edge is still outside */
+			if ((e0 + e0max) < 0 || (e1 + e1max) < 0 || (e2 + e2max) < 0)
+				continue;
+#if TGL_FEATURE_HIZ == 1
+			/* everything already in the block is closer */
+			if (hizz >= 0 && ZB_hizOccluded(zb, bx, by, bx + 7, by + 7, hizz))
+				continue;
+#endif
+			/* trivial accept: the least inside corner is inside all three edges */
+			accept = (e0 + e0min) >= 0 && (e1 + e1min) >= 0 && (e2 + e2min) >= 0 && bx >= minx && (bx + 7) <= maxx;
+
+			y = (by < miny) ? miny : by;
+			ylast = (by + 7 > maxy) ? maxy : by + 7;
+			xfirst = (bx < minx) ? minx - bx : 0;
+			xlast = (bx + 7 > maxx) ? maxx - bx : 7;
+			e0 += b0 * (y - by);
+			e1 += b1 * (y - by);
+			e2 += b2 * (y - by);
+
+			for (; y <= ylast; y++, e0 += b0, e1 += b1, e2 += b2) {
+				register PIXEL* pp;
+				register GLint n, xa;
+#ifdef INTERP_Z
+				register ZPIXEL* pz;
+				register GLuint z;
+#endif
+#ifdef INTERP_RGB
+				register GLint or1, og1, ob1;
+#endif
+#ifdef INTERP_ALPHA
+				register GLint oa1;
+#endif
+#ifdef INTERP_STZ
+				register GLuint s, t;
+				GLint dsdx, dtdx;
+#endif
+				GLfloat fx, fy;
+				if (accept) {
+					xa = 0;
+					n = 7;
+				} else {
+					/* a row of a convex triangle is a single span */
+					GLint i, xb = -1;
+					xa = -1;
+					for (i = xfirst; i <= xlast; i++) {
+						if ((e0 + a0 * i) >= 0 && (e1 + a1 * i) >= 0 && (e2 + a2 * i) >= 0) {
+							if (xa < 0)
+								xa = i;
+							xb = i;
+						}
+					}
+					if (xa < 0)
+						continue;
+					n = xb - xa;
+				}
+#if TGL_FEATURE_POLYGON_STIPPLE == 1
+				the_y = y;
+#endif
+				pp1 = (PIXEL*)(zb->pbuf) + zb->xsize * y;
+				pz1 = zb->zbuf + zb->xsize * y;
+				pp = pp1 + bx + xa;
+				fx = (GLfloat)(bx + xa) - fx0;
+				fy = (GLfloat)y - fy0;
+#ifdef INTERP_Z
+				pz = pz1 + bx + xa;
+				z = (GLint)((GLfloat)p0->z + fdzdx * fx + fdzdy * fy);
+#endif
+#ifdef INTERP_RGB
+				or1 = (GLint)((GLfloat)p0->r + fdrdx * fx + fdrdy * fy);
+				og1 = (GLint)((GLfloat)p0->g + fdgdx * fx + fdgdy * fy);
+				ob1 = (GLint)((GLfloat)p0->b + fdbdx * fx + fdbdy * fy);
+#endif
+#ifdef INTERP_ALPHA
+				oa1 = (GLint)((GLfloat)p0->a + fdadx * fx + fdady * fy);
+#endif
+#ifdef INTERP_STZ
+				{
+					/* perspective correct s, t at the start of the span, linear across it */
+					GLfloat zinv = 1.0f / (GLfloat)z;
+					GLfloat ss = (p0->sz + dszdx * fx + dszdy * fy) * zinv;
+					GLfloat tt = (p0->tz + dtzdx * fx + dtzdy * fy) * zinv;
+					s = (GLint)ss;
+					t = (GLint)tt;
+					dsdx = (GLint)((dszdx - ss * fdzdx) * zinv);
+					dtdx = (GLint)((dtzdx - tt * fdzdx) * zinv);
+#ifdef TEXTURE_LOD
+					TEXTURE_LOD(ss, tt, fdzdy);
+#endif
+				}
+#endif
+				if (n == 7) {
+					PUT_PIXEL(0);
+					PUT_PIXEL(1);
+					PUT_PIXEL(2);
+					PUT_PIXEL(3);
+					PUT_PIXEL(4);
+					PUT_PIXEL(5);
+					PUT_PIXEL(6);
+					PUT_PIXEL(7);
+				} else {
+					while (n >= 0) {
+						PUT_PIXEL(0);
+#ifdef INTERP_Z
+						pz++;
+#endif
+						pp++;
+						n--;
+					}
+				}
+			}
+		}
+	}
+}
+
+#undef INTERP_Z
+#undef INTERP_RGB
+#undef INTERP_ALPHA
+#undef INTERP_ST
+#undef INTERP_STZ
+
+#undef DRAW_INIT
+#undef DRAW_LINE
+#undef PUT_PIXEL
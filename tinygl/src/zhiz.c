@@ -0,0 +1,163 @@
+/*
+ * Hierarchical Z: a coarse depth buffer for early triangle rejection.
+ *
+ * Every TGL_HIZ_DIM sized block of the zbuffer keeps a lower bound of its depth values,
+ * i.e. the farthest depth in the block (larger z is closer, see ZCMP). A triangle whose
+ * nearest depth is below the bound of every block it may touch fails the depth test
+ * everywhere and is skipped before scan conversion.
+ *
+ * Writes that could lower a depth value only mark the blocks they touch as stale (-1).
+ * Stale blocks are recomputed from zbuf when a test needs them, so the bound is exact
+ * right after that, and conservative in between. Triangles drawn with GL_LESS, GL_LEQUAL
+ * or GL_EQUAL only ever raise depth values, so they keep the bound and mark nothing.
+ *
+ * Only GL_LESS, GL_LEQUAL and GL_EQUAL reject everything behind the bound; with the other
+ * depth functions the blocks are kept up to date but nothing is culled.
+ *
+ * There is a single level of blocks, and it only holds the farthest depth. There is no
+ * nearest depth bound, so nothing is accepted without a per pixel depth test.
+ */
+
+#include <string.h>
+
+#include "../include/zbuffer.h"
+#include "msghandling.h"
+
+#if TGL_FEATURE_HIZ == 1
+
+#define TGL_HIZ_DIM (1 << TGL_HIZ_POW2)
+
+GLint ZB_hizAlloc(ZBuffer* zb) {
+	zb->hiz_xsize = (zb->xsize + TGL_HIZ_DIM - 1) >> TGL_HIZ_POW2;
+	zb->hiz_ysize = (zb->ysize + TGL_HIZ_DIM - 1) >> TGL_HIZ_POW2;
+	zb->hiz = gl_malloc(zb->hiz_xsize * zb->hiz_ysize * sizeof(GLint));
+	if (zb->hiz == NULL)
+		return 0;
+	/* the zbuffer is not initialized yet */
+	memset(zb->hiz, 0xff, zb->hiz_xsize * zb->hiz_ysize * sizeof(GLint));
+	return 1;
+}
+
+void ZB_hizFree(ZBuffer* zb) {
+	if (zb->hiz)
+		gl_free(zb->hiz);
+	zb->hiz = NULL;
+}
+
+void ZB_hizClear(ZBuffer* zb, GLint z) {
+	GLint i, n = zb->hiz_xsize * zb->hiz_ysize;
+	if (zb->hiz == NULL)
+		return;
+	z = (ZPIXEL)z;
+	for (i = 0; i < n; i++)
+		zb->hiz[i] = z;
+}
+
+void ZB_hizInvalidate(ZBuffer* zb, GLint xmin, GLint ymin, GLint xmax, GLint ymax) {
+	GLint bx, by;
+	if (zb->hiz == NULL)
+		return;
+	if (xmin < 0) xmin = 0;
+	if (ymin < 0) ymin = 0;
+	if (xmax > zb->xsize - 1) xmax = zb->xsize - 1;
+	if (ymax > zb->ysize - 1) ymax = zb->ysize - 1;
+	if (xmin > xmax || ymin > ymax)
+		return;
+	xmin >>= TGL_HIZ_POW2;
+	xmax >>= TGL_HIZ_POW2;
+	ymin >>= TGL_HIZ_POW2;
+	ymax >>= TGL_HIZ_POW2;
+	for (by = ymin; by <= ymax; by++)
+		for (bx = xmin; bx <= xmax; bx++)
+			zb->hiz[bx + by * zb->hiz_xsize] = -1;
+}
+
+/* farthest depth of a block, read back from zbuf */
+static GLint ZB_hizBlockMin(ZBuffer* zb, GLint bx, GLint by) {
+	GLint x, y, m = 0x7fffffff;
+	GLint x0 = bx << TGL_HIZ_POW2, y0 = by << TGL_HIZ_POW2;
+	GLint x1 = x0 + TGL_HIZ_DIM, y1 = y0 + TGL_HIZ_DIM;
+	if (x1 > zb->xsize)
+		x1 = zb->xsize;
+	if (y1 > zb->ysize)
+		y1 = zb->ysize;
+	for (y = y0; y < y1; y++) {
+		ZPIXEL* pz = zb->zbuf + y * zb->xsize;
+		for (x = x0; x < x1; x++)
+			if (pz[x] < m)
+				m = pz[x];
+	}
+	return m;
+}
+
+GLint ZB_hizOccluded(ZBuffer* zb, GLint xmin, GLint ymin, GLint xmax, GLint ymax, GLint zmax) {
+	GLint bx, by;
+	if (zb->hiz == NULL)
+		return 0;
+	xmin >>= TGL_HIZ_POW2;
+	xmax >>= TGL_HIZ_POW2;
+	ymin >>= TGL_HIZ_POW2;
+	ymax >>= TGL_HIZ_POW2;
+	for (by = ymin; by <= ymax; by++)
+		for (bx = xmin; bx <= xmax; bx++) {
+			GLint* h = &zb->hiz[bx + by * zb->hiz_xsize];
+			GLint m = *h;
+			/* drawing into a visible block keeps its bound, see ZB_hizTriangle */
+			if (m < 0)
+				*h = m = ZB_hizBlockMin(zb, bx, by);
+			if (m <= zmax)
+				return 0;
+		}
+	return 1;
+}
+
+GLint ZB_hizNearest(ZBufferPoint* p0, ZBufferPoint* p1, ZBufferPoint* p2) {
+	GLint xmin, xmax, ymin, ymax, zmax;
+	xmin = xmax = p0->x;
+	ymin = ymax = p0->y;
+	zmax = p0->z;
+	if (p1->x < xmin) xmin = p1->x;
+	if (p1->x > xmax) xmax = p1->x;
+	if (p2->x < xmin) xmin = p2->x;
+	if (p2->x > xmax) xmax = p2->x;
+	if (p1->y < ymin) ymin = p1->y;
+	if (p1->y > ymax) ymax = p1->y;
+	if (p2->y < ymin) ymin = p2->y;
+	if (p2->y > ymax) ymax = p2->y;
+	if (p1->z > zmax) zmax = p1->z;
+	if (p2->z > zmax) zmax = p2->z;
+	/* the interpolated depth may drift by up to one fractional unit per step, plus rounding */
+	zmax += (xmax - xmin) + (ymax - ymin) + 2;
+	return (zmax >> ZB_POINT_Z_FRAC_BITS) + 1;
+}
+
+GLint ZB_hizTriangle(ZBuffer* zb, ZBufferPoint* p0, ZBufferPoint* p1, ZBufferPoint* p2) {
+	GLint xmin, xmax, ymin, ymax;
+	if (zb->hiz == NULL)
+		return 0;
+	xmin = xmax = p0->x;
+	ymin = ymax = p0->y;
+	if (p1->x < xmin) xmin = p1->x;
+	if (p1->x > xmax) xmax = p1->x;
+	if (p2->x < xmin) xmin = p2->x;
+	if (p2->x > xmax) xmax = p2->x;
+	if (p1->y < ymin) ymin = p1->y;
+	if (p1->y > ymax) ymax = p1->y;
+	if (p2->y < ymin) ymin = p2->y;
+	if (p2->y > ymax) ymax = p2->y;
+	if (xmin < zb->clip_xmin) xmin = zb->clip_xmin;
+	if (ymin < zb->clip_ymin) ymin = zb->clip_ymin;
+	if (xmax > zb->clip_xmax) xmax = zb->clip_xmax;
+	if (ymax > zb->clip_ymax) ymax = zb->clip_ymax;
+	if (xmin > xmax || ymin > ymax)
+		return 1;
+	if (zb->depth_test && ZB_DEPTH_CULLS(zb->depth_func)) {
+		/* depth values only go up, the bounds of the blocks stay valid */
+		return ZB_hizOccluded(zb, xmin, ymin, xmax, ymax, ZB_hizNearest(p0, p1, p2));
+	}
+	if (zb->depth_write)
+		ZB_hizInvalidate(zb, xmin, ymin, xmax, ymax);
+	return 0;
+}
+
+#endif
@@ -1,7 +1,8 @@
 #include "../include/zbuffer.h"
+#include <math.h>
 #include <stdlib.h>
 
-#define ZCMP(z, zpix) (!(zbdt) || z >= (zpix))
+#define ZCMP(z, zpix) (!(zbdt) || ZB_DEPTH_PASS(zbdf, z, zpix))
 
 /* TODO: Implement point size. */
 /* TODO: Implement blending for lines and points. */
@@ -11,30 +12,33 @@ void ZB_plot(ZBuffer* zb, ZBufferPoint* p) {
 	GLint zz, y, x;
 	GLubyte zbdw = zb->depth_write;
 	GLubyte zbdt = zb->depth_test;
+	GLenum zbdf = zb->depth_func;
+	GLint zbcw = zb->color_write;
 	GLfloat zbps = zb->pointsize;
 	TGL_BLEND_VARS
+	ZB_FLUSH_TILES(zb);
 	zz = p->z >> ZB_POINT_Z_FRAC_BITS;
+	if (zbdw)
+		ZB_HIZ_INVALIDATE(zb, p->x - (GLint)zbps, p->y - (GLint)zbps, p->x + (GLint)zbps, p->y + (GLint)zbps);
 	
 	if (zbps == 1) {
-		GLushort* pz;
+		ZPIXEL* pz;
 		PIXEL* pp;
 		pz = zb->zbuf + (p->y * zb->xsize + p->x);
 		pp = (PIXEL*)((GLbyte*)zb->pbuf + zb->linesize * p->y + p->x * PSZB);
 
 		if (ZCMP(zz, *pz)) {
-#if TGL_FEATURE_BLEND == 1
-			if (!zb->enable_blend)
-				*pp = RGB_TO_PIXEL(p->r, p->g, p->b);
-			else
-				TGL_BLEND_FUNC_RGB(p->r, p->g, p->b, (*pp))
-#else
-			*pp = RGB_TO_PIXEL(p->r, p->g, p->b);
-#endif
+			if (zbcw) {
+				if (!ZB_MERGES_COLOR(zb))
+					*pp = RGBA_TO_PIXEL(p->r, p->g, p->b, ZB_ALPHA(p->a));
+				else
+					TGL_BLEND_FUNC_RGB(p->r, p->g, p->b, ZB_ALPHA(p->a), (*pp))
+			}
 			if (zbdw)
 				*pz = zz;
 		}
 	} else {
-		PIXEL col = RGB_TO_PIXEL(p->r, p->g, p->b);
+		PIXEL col = RGBA_TO_PIXEL(p->r, p->g, p->b, ZB_ALPHA(p->a));
 		GLfloat hzbps = zbps / 2.0f;
 		GLint bx = (GLfloat)p->x - hzbps;
 		GLint ex = (GLfloat)p->x + hzbps;
@@ -46,18 +50,16 @@ void ZB_plot(ZBuffer* zb, ZBufferPoint* p) {
 		ey = (ey > zb->ysize) ? zb->ysize : ey;
 		for (y = by; y < ey; y++)
 			for (x = bx; x < ex; x++) {
-				GLushort* pz = zb->zbuf + (y * zb->xsize + x);
+				ZPIXEL* pz = zb->zbuf + (y * zb->xsize + x);
 				PIXEL* pp = (PIXEL*)((GLbyte*)zb->pbuf + zb->linesize * y + x * PSZB);
 				
 				if (ZCMP(zz, *pz)) {
-#if TGL_FEATURE_BLEND == 1
-					if (!zb->enable_blend)
-						*pp = col;
-					else
-						TGL_BLEND_FUNC_RGB(p->r, p->g, p->b, (*pp))
-#else
-					*pp = col;
-#endif
+					if (zbcw) {
+						if (!ZB_MERGES_COLOR(zb))
+							*pp = col;
+						else
+							TGL_BLEND_FUNC_RGB(p->r, p->g, p->b, ZB_ALPHA(p->a), (*pp))
+					}
 					if (zbdw)
 						*pz = zz;
 				}
@@ -69,6 +71,7 @@ void ZB_plot(ZBuffer* zb, ZBufferPoint* p) {
 static void ZB_line_flat_z(ZBuffer* zb, ZBufferPoint* p1, ZBufferPoint* p2, GLint color) {
 	
 	GLubyte zbdt = zb->depth_test;
+	GLenum zbdf = zb->depth_func;
 	GLubyte zbdw = zb->depth_write;
 #include "zline.h"
 }
@@ -79,6 +82,18 @@ static void ZB_line_flat_z(ZBuffer* zb, ZBufferPoint* p1, ZBufferPoint* p2, GLin
 static void ZB_line_interp_z(ZBuffer* zb, ZBufferPoint* p1, ZBufferPoint* p2) {
 	
 	GLubyte zbdt = zb->depth_test;
+	GLenum zbdf = zb->depth_func;
+	GLubyte zbdw = zb->depth_write;
+#include "zline.h"
+}
+
+/* depth only line, see glColorMask */
+#define INTERP_Z
+#define DEPTH_ONLY
+static void ZB_line_depth(ZBuffer* zb, ZBufferPoint* p1, ZBufferPoint* p2) {
+
+	GLubyte zbdt = zb->depth_test;
+	GLenum zbdf = zb->depth_func;
 	GLubyte zbdw = zb->depth_write;
 #include "zline.h"
 }
@@ -97,11 +112,46 @@ static void ZB_line_interp(ZBuffer* zb, ZBufferPoint* p1, ZBufferPoint* p2) {
 #include "zline.h"
 }
 
+/* wide and antialiased lines are drawn by the polyline kernels */
+static GLint ZB_lineWide(ZBuffer* zb, ZBufferPoint* p1, ZBufferPoint* p2) {
+	ZBufferLinePoint q[2];
+	if (zb->linewidth == 1 && !zb->line_smooth)
+		return 0;
+	q[0].x = p1->x + 0.5f;
+	q[0].y = p1->y + 0.5f;
+	q[0].z = p1->z;
+	q[0].r = p1->r;
+	q[0].g = p1->g;
+	q[0].b = p1->b;
+	q[0].a = p1->a;
+	q[1].x = p2->x + 0.5f;
+	q[1].y = p2->y + 0.5f;
+	q[1].z = p2->z;
+	q[1].r = p2->r;
+	q[1].g = p2->g;
+	q[1].b = p2->b;
+	q[1].a = p2->a;
+	ZB_polyline(zb, q, 2, 1, 1);
+	return 1;
+}
+
 void ZB_line_z(ZBuffer* zb, ZBufferPoint* p1, ZBufferPoint* p2) {
 	GLint color1, color2;
-	
-	color1 = RGB_TO_PIXEL(p1->r, p1->g, p1->b);
-	color2 = RGB_TO_PIXEL(p2->r, p2->g, p2->b);
+	if (ZB_lineWide(zb, p1, p2))
+		return;
+	ZB_FLUSH_TILES(zb);
+	if (zb->depth_write)
+		ZB_HIZ_INVALIDATE(zb, (p1->x < p2->x) ? p1->x : p2->x, (p1->y < p2->y) ? p1->y : p2->y, (p1->x > p2->x) ? p1->x : p2->x,
+						  (p1->y > p2->y) ? p1->y : p2->y);
+
+	if (!zb->color_write) {
+		if (zb->depth_write)
+			ZB_line_depth(zb, p1, p2);
+		return;
+	}
+
+	color1 = RGBA_TO_PIXEL(p1->r, p1->g, p1->b, ZB_ALPHA(p1->a));
+	color2 = RGBA_TO_PIXEL(p2->r, p2->g, p2->b, ZB_ALPHA(p2->a));
 
 	/* choose if the line should have its color GLinterpolated or not */
 	if (color1 == color2) {
@@ -113,9 +163,14 @@ void ZB_line_z(ZBuffer* zb, ZBufferPoint* p1, ZBufferPoint* p2) {
 
 void ZB_line(ZBuffer* zb, ZBufferPoint* p1, ZBufferPoint* p2) {
 	GLint color1, color2;
+	if (ZB_lineWide(zb, p1, p2))
+		return;
+	ZB_FLUSH_TILES(zb);
+	if (!zb->color_write)
+		return;
 
-	color1 = RGB_TO_PIXEL(p1->r, p1->g, p1->b);
-	color2 = RGB_TO_PIXEL(p2->r, p2->g, p2->b);
+	color1 = RGBA_TO_PIXEL(p1->r, p1->g, p1->b, ZB_ALPHA(p1->a));
+	color2 = RGBA_TO_PIXEL(p2->r, p2->g, p2->b, ZB_ALPHA(p2->a));
 
 	/* choose if the line should have its color GLinterpolated or not */
 	if (color1 == color2) {
@@ -124,3 +179,260 @@ void ZB_line(ZBuffer* zb, ZBufferPoint* p1, ZBufferPoint* p2) {
 		ZB_line_interp(zb, p1, p2);
 	}
 }
+
+/*
+ Polylines. A thin segment steps through the pixel centers along its major axis, from its first point included to its
+ last point excluded, so that the joints of a polyline are drawn once. A wide or antialiased segment is made of the
+ pixels whose center is within half the line width of it, with round ends (and half a pixel more with GL_LINE_SMOOTH,
+ where alpha is scaled by the coverage); a pixel that the segment before or after it is closer to is left to that one.
+ Only those neighbours are checked: a pixel can still be drawn twice where a polyline crosses itself.
+*/
+
+#define LINE_VARS                                                                                                                                              \
+	ZPIXEL* zbuf = zb->zbuf;                                                                                                                                   \
+	GLbyte* pbuf = (GLbyte*)zb->pbuf;                                                                                                                          \
+	GLint xsize = zb->xsize, linesize = zb->linesize;                                                                                                          \
+	GLubyte zbdt = zb->depth_test;                                                                                                                             \
+	GLubyte zbdw = zb->depth_test && zb->depth_write;                                                                                                          \
+	GLenum zbdf = zb->depth_func;                                                                                                                              \
+	GLint zbcw = zb->color_write;                                                                                                                              \
+	GLint zbeb = ZB_MERGES_COLOR(zb);                                                                                                                          \
+	TGL_BLEND_VARS
+#define LINE_WRITE(pp, r, g, b, a)                                                                                                                             \
+	{                                                                                                                                                          \
+		if (zbeb)                                                                                                                                              \
+			TGL_BLEND_FUNC_RGB((r), (g), (b), (a), (*(pp)))                                                                                                    \
+		else                                                                                                                                                   \
+			*(pp) = RGBA_TO_PIXEL((r), (g), (b), (a));                                                                                                         \
+	}
+
+/* the pixel at x, y, with z, r, g, b like ZBufferPoint and a 0..255 alpha */
+#define LINE_PIXEL(x, y, z, r, g, b, a)                                                                                                                        \
+	{                                                                                                                                                          \
+		ZPIXEL* pz = zbuf + (y) * xsize + (x);                                                                                                                 \
+		GLint zz = (z) >> ZB_POINT_Z_FRAC_BITS;                                                                                                                \
+		if (ZCMP(zz, *pz)) {                                                                                                                                   \
+			if (zbcw) {                                                                                                                                        \
+				PIXEL* pp = (PIXEL*)(pbuf + linesize * (y) + (x) * PSZB);                                                                                      \
+				LINE_WRITE(pp, r, g, b, a)                                                                                                                     \
+			}                                                                                                                                                  \
+			if (zbdw)                                                                                                                                          \
+				*pz = zz;                                                                                                                                      \
+		}                                                                                                                                                      \
+	}
+
+/*
+ The pixel centers of a 1 pixel wide segment along its major axis: the first one is i, in steps of s, with n of them,
+ and the minor axis is u, in 16.16 fixed point, plus uinc per step. t is the parameter along p1 p2 at the first one.
+*/
+typedef struct {
+	GLint xmajor, i, s, n, u, uinc;
+	GLfloat t, dt;
+} ZBLineSteps;
+
+static inline void ZB_lineSteps(ZBuffer* zb, ZBufferLinePoint* p1, ZBufferLinePoint* p2, ZBLineSteps* d) {
+	GLint xmajor = fabsf(p2->x - p1->x) >= fabsf(p2->y - p1->y);
+	/* a is the major axis, u the other one */
+	GLfloat a1 = xmajor ? p1->x : p1->y, a2 = xmajor ? p2->x : p2->y;
+	GLfloat u1 = xmajor ? p1->y : p1->x, u2 = xmajor ? p2->y : p2->x;
+	GLint size = xmajor ? zb->xsize : zb->ysize, i1;
+
+	d->xmajor = xmajor;
+	if (a2 > a1) {
+		d->s = 1;
+		d->i = (GLint)ceilf(a1 - 0.5f);
+		i1 = (GLint)ceilf(a2 - 0.5f);
+		d->i = d->i < 0 ? 0 : d->i;
+		i1 = i1 > size ? size : i1;
+		d->n = i1 - d->i;
+	} else {
+		d->s = -1;
+		d->i = (GLint)floorf(a1 - 0.5f);
+		i1 = (GLint)floorf(a2 - 0.5f);
+		d->i = d->i > size - 1 ? size - 1 : d->i;
+		i1 = i1 < -1 ? -1 : i1;
+		d->n = d->i - i1;
+	}
+	if (d->n <= 0)
+		return;
+	d->dt = 1 / (a2 - a1);
+	d->t = (d->i + 0.5f - a1) * d->dt;
+	d->dt *= d->s;
+	d->u = (GLint)((u1 + d->t * (u2 - u1)) * 65536);
+	d->uinc = (GLint)(d->dt * (u2 - u1) * 65536);
+}
+
+/* the last pixel of the segment p1 p2, as an offset in the zbuffer, or -1 */
+static GLint ZB_polylineThinLast(ZBuffer* zb, ZBufferLinePoint* p1, ZBufferLinePoint* p2) {
+	ZBLineSteps d;
+	GLint i, m, umax;
+	ZB_lineSteps(zb, p1, p2, &d);
+	if (d.n <= 0)
+		return -1;
+	umax = (d.xmajor ? zb->ysize : zb->xsize) - 1;
+	i = d.i + (d.n - 1) * d.s;
+	m = (d.u + (d.n - 1) * d.uinc) >> 16;
+	m = m < 0 ? 0 : m > umax ? umax : m;
+	return d.xmajor ? m * zb->xsize + i : i * zb->xsize + m;
+}
+
+/*
+ A 1 pixel wide aliased segment, with the pixel of p2 when end is set. *prev is the last pixel drawn by the segment
+ before it, which is skipped: where the major axis changes, the first pixel can be the last one of that segment.
+*/
+static void ZB_polylineThin(ZBuffer* zb, ZBufferLinePoint* p1, ZBufferLinePoint* p2, GLint end, GLint* prev) {
+	LINE_VARS
+	ZBLineSteps d;
+	GLint i, n, u, uinc, umax, z, zinc, r, rinc, g, ginc, b, binc, a, ainc, x, y, m;
+	GLfloat t, dt;
+
+	ZB_lineSteps(zb, p1, p2, &d);
+	i = d.i;
+	n = d.n;
+	umax = (d.xmajor ? zb->ysize : xsize) - 1;
+	if (n > 0) {
+		t = d.t;
+		dt = d.dt;
+		u = d.u;
+		uinc = d.uinc;
+		z = p1->z + (GLint)(t * (p2->z - p1->z));
+		zinc = (GLint)(dt * (p2->z - p1->z));
+		r = p1->r + (GLint)(t * (p2->r - p1->r));
+		rinc = (GLint)(dt * (p2->r - p1->r));
+		g = p1->g + (GLint)(t * (p2->g - p1->g));
+		ginc = (GLint)(dt * (p2->g - p1->g));
+		b = p1->b + (GLint)(t * (p2->b - p1->b));
+		binc = (GLint)(dt * (p2->b - p1->b));
+		a = p1->a + (GLint)(t * (p2->a - p1->a));
+		ainc = (GLint)(dt * (p2->a - p1->a));
+		do {
+			m = u >> 16;
+			m = m < 0 ? 0 : m > umax ? umax : m;
+			x = d.xmajor ? i : m;
+			y = d.xmajor ? m : i;
+			if (y * xsize + x != *prev)
+				LINE_PIXEL(x, y, z, r, g, b, ZB_ALPHA(a))
+			*prev = y * xsize + x;
+			i += d.s;
+			u += uinc;
+			z += zinc;
+			r += rinc;
+			g += ginc;
+			b += binc;
+			a += ainc;
+		} while (--n);
+	}
+	if (end) {
+		x = (GLint)p2->x;
+		y = (GLint)p2->y;
+		x = x < 0 ? 0 : x > xsize - 1 ? xsize - 1 : x;
+		y = y < 0 ? 0 : y > zb->ysize - 1 ? zb->ysize - 1 : y;
+		if (y * xsize + x != *prev)
+			LINE_PIXEL(x, y, p2->z, p2->r, p2->g, p2->b, ZB_ALPHA(p2->a))
+	}
+}
+
+typedef struct {
+	GLfloat x, y, dx, dy, il2;
+} ZBLineSeg;
+
+static inline void ZB_lineSeg(ZBLineSeg* s, ZBufferLinePoint* p1, ZBufferLinePoint* p2) {
+	GLfloat l2;
+	s->x = p1->x;
+	s->y = p1->y;
+	s->dx = p2->x - p1->x;
+	s->dy = p2->y - p1->y;
+	l2 = s->dx * s->dx + s->dy * s->dy;
+	s->il2 = l2 > 0 ? 1 / l2 : 0;
+}
+
+/* the squared distance from x, y to s, and in t where along s the closest point is */
+static inline GLfloat ZB_lineSegDist2(const ZBLineSeg* s, GLfloat x, GLfloat y, GLfloat* t) {
+	GLfloat u = ((x - s->x) * s->dx + (y - s->y) * s->dy) * s->il2;
+	u = u < 0 ? 0 : u > 1 ? 1 : u;
+	x -= s->x + u * s->dx;
+	y -= s->y + u * s->dy;
+	*t = u;
+	return x * x + y * y;
+}
+
+/* a wide or antialiased segment p1 p2, after p0 p1 and before p2 p3 unless they are NULL */
+static void ZB_polylineWide(ZBuffer* zb, ZBufferLinePoint* p0, ZBufferLinePoint* p1, ZBufferLinePoint* p2, ZBufferLinePoint* p3, GLfloat hw,
+							GLint smooth) {
+	LINE_VARS
+	ZBLineSeg s, sp = {0}, sn = {0};
+	GLfloat r = smooth ? hw + 0.5f : hw, r2 = r * r, ext = 0, xa, xb, xc, px, py, t, tt, d2;
+	GLfloat bx0 = fminf(p1->x, p2->x) - r, bx1 = fmaxf(p1->x, p2->x) + r;
+	GLint x, y, xs, xe, ys, ye, a;
+
+	ZB_lineSeg(&s, p1, p2);
+	if (p0 != NULL)
+		ZB_lineSeg(&sp, p0, p1);
+	if (p3 != NULL)
+		ZB_lineSeg(&sn, p2, p3);
+	/* on a row, the pixels within r of the line are ext from where it crosses the row */
+	if (s.dy != 0)
+		ext = r * sqrtf(s.dx * s.dx + s.dy * s.dy) / fabsf(s.dy);
+	ys = (GLint)ceilf(fminf(p1->y, p2->y) - r - 0.5f);
+	ye = (GLint)floorf(fmaxf(p1->y, p2->y) + r - 0.5f);
+	ys = ys < 0 ? 0 : ys;
+	ye = ye > zb->ysize - 1 ? zb->ysize - 1 : ye;
+	for (y = ys; y <= ye; y++) {
+		py = y + 0.5f;
+		xa = bx0;
+		xb = bx1;
+		if (s.dy != 0) {
+			xc = s.x + (py - s.y) * s.dx / s.dy;
+			xa = fmaxf(xa, xc - ext);
+			xb = fminf(xb, xc + ext);
+		}
+		xs = (GLint)ceilf(xa - 0.5f);
+		xe = (GLint)floorf(xb - 0.5f);
+		xs = xs < 0 ? 0 : xs;
+		xe = xe > xsize - 1 ? xsize - 1 : xe;
+		for (x = xs; x <= xe; x++) {
+			px = x + 0.5f;
+			d2 = ZB_lineSegDist2(&s, px, py, &t);
+			if (d2 > r2)
+				continue;
+			if (p0 != NULL && ZB_lineSegDist2(&sp, px, py, &tt) <= d2)
+				continue;
+			if (p3 != NULL && ZB_lineSegDist2(&sn, px, py, &tt) < d2)
+				continue;
+			a = ZB_ALPHA(p1->a + (GLint)(t * (p2->a - p1->a)));
+			if (smooth)
+				a = TGL_MUL255(a, (GLint)(fminf(r - sqrtf(d2), 1) * 255));
+			LINE_PIXEL(x, y, p1->z + (GLint)(t * (p2->z - p1->z)), p1->r + (GLint)(t * (p2->r - p1->r)), p1->g + (GLint)(t * (p2->g - p1->g)),
+					   p1->b + (GLint)(t * (p2->b - p1->b)), a)
+		}
+	}
+}
+
+void ZB_polyline(ZBuffer* zb, ZBufferLinePoint* p, GLint n, GLint first, GLint last) {
+	GLint i, smooth = zb->line_smooth, prev;
+	GLfloat w = zb->linewidth;
+	ZBufferLinePoint *p1, *p2;
+
+	ZB_FLUSH_TILES(zb);
+	if (!zb->color_write && !(zb->depth_test && zb->depth_write))
+		return;
+	/* aliased lines are a whole number of pixels wide */
+	if (!smooth)
+		w = w < 1.5f ? 1 : floorf(w + 0.5f);
+	prev = first || w != 1 || smooth ? -1 : ZB_polylineThinLast(zb, p - 1, p);
+	for (i = 0; i < n - 1; i++) {
+		p1 = &p[i];
+		p2 = &p[i + 1];
+		if (zb->depth_test && zb->depth_write)
+			ZB_HIZ_INVALIDATE(zb, (GLint)(fminf(p1->x, p2->x) - w / 2 - 1), (GLint)(fminf(p1->y, p2->y) - w / 2 - 1),
+							  (GLint)(fmaxf(p1->x, p2->x) + w / 2 + 1), (GLint)(fmaxf(p1->y, p2->y) + w / 2 + 1));
+		if (w == 1 && !smooth)
+			ZB_polylineThin(zb, p1, p2, last && i == n - 2, &prev);
+		else
+			ZB_polylineWide(zb, i > 0 || !first ? p1 - 1 : NULL, p1, p2, i < n - 2 || !last ? p2 + 1 : NULL, w / 2, smooth);
+	}
+}
+
+#undef LINE_VARS
+#undef LINE_WRITE
+#undef LINE_PIXEL
@@ -4,13 +4,16 @@
 	register GLint a;
 	register PIXEL* pp;
 #if defined(INTERP_RGB)
-	register GLuint r, g, b;
+	register GLuint r, g, b, al;
 #endif
 #ifdef INTERP_RGB
-	register GLuint rinc, ginc, binc;
+	register GLuint rinc, ginc, binc, ainc;
+#endif
+#ifndef DEPTH_ONLY
+	PIXEL zbcm = zb->color_mask;
 #endif
 #ifdef INTERP_Z
-	register GLushort* pz;
+	register ZPIXEL* pz;
 	GLint zinc;
 	register GLint z, zz;
 #endif
@@ -31,14 +34,19 @@
 	dx = p2->x - p1->x;
 	dy = p2->y - p1->y;
 #ifdef INTERP_RGB
-	r = p2->r << 8;
-	g = p2->g << 8;
-	b = p2->b << 8;
+	/* pp starts at p1 */
+	r = p1->r << 8;
+	g = p1->g << 8;
+	b = p1->b << 8;
+	al = p1->a << 8;
 #endif
 
-#ifdef INTERP_RGB
+#if defined(DEPTH_ONLY)
+#define RGB(x)
+#define RGBPIXEL /* a comment */
+#elif defined(INTERP_RGB)
 #define RGB(x) x
-#define RGBPIXEL *pp = RGB_TO_PIXEL(r >> 8, g >> 8, b >> 8)
+#define RGBPIXEL *pp = ZB_MASK_PIXEL(RGBA_TO_PIXEL(r >> 8, g >> 8, b >> 8, ZB_ALPHA(al >> 8)), *pp, zbcm)
 	
 
 #else /* INTERP_RGB */
@@ -46,7 +54,7 @@
 #if TGL_FEATURE_RENDER_BITS == 24
 #define RGBPIXEL pp[0] = r, pp[1] = g, pp[2] = b
 #else
-#define RGBPIXEL *pp = color
+#define RGBPIXEL *pp = ZB_MASK_PIXEL(color, *pp, zbcm)
 
 #endif
 #endif /* INTERP_RGB */
@@ -71,7 +79,8 @@
 #define DRAWLINE(dx, dy, inc_1, inc_2)                                                                                                                         \
 	n = dx;                                                                                                                                                    \
 	ZZ(zinc = (p2->z - p1->z) / n);                                                                                                                            \
-	RGB(rinc = ((p2->r - p1->r) << 8) / n; ginc = ((p2->g - p1->g) << 8) / n; binc = ((p2->b - p1->b) << 8) / n);                                              \
+	RGB(rinc = ((p2->r - p1->r) << 8) / n; ginc = ((p2->g - p1->g) << 8) / n; binc = ((p2->b - p1->b) << 8) / n;                                               \
+	    ainc = ((p2->a - p1->a) << 8) / n);                                                                                                                    \
 	a = 2 * dy - dx;                                                                                                                                           \
 	dy = 2 * dy;                                                                                                                                               \
 	dx = 2 * dx - dy;                                                                                                                                          \
@@ -80,7 +89,7 @@
 	do {                                                                                                                                                       \
 		PUTPIXEL();                                                                                                                                            \
 		ZZ(z += zinc);                                                                                                                                         \
-		RGB(r += rinc; g += ginc; b += binc);                                                                                                                  \
+		RGB(r += rinc; g += ginc; b += binc; al += ainc);                                                                                                      \
 		if (a > 0) {                                                                                                                                           \
 			pp = (PIXEL*)((GLbyte*)pp + pp_inc_1);                                                                                                             \
 			ZZ(pz += (inc_1));                                                                                                                                 \
@@ -114,6 +123,7 @@
 
 #undef INTERP_Z
 #undef INTERP_RGB
+#undef DEPTH_ONLY
 
 /* GLinternal defines */
 #undef DRAWLINE
@@ -42,6 +42,7 @@ void gl_MulM3V3(V3* a, M4* b, V3* c);
 void gl_M4_MulV4(V4* a, M4* b, V4* c);
 void gl_M4_InvOrtho(M4* a, M4 b);
 void gl_M4_Inv(M4* a, M4* b);
+void gl_M3_Inv(M3* a, M3* m);
 void gl_M4_Mul(M4* c, M4* a, M4* b);
 void gl_M4_MulLeft(M4* c, M4* a);
 void gl_M4_Transpose(M4* a, M4* b);
@@ -84,5 +85,56 @@ static int gl_V3_Norm_Fast(V3* a) {
 	a->Z *= n;
 	return 0;
 }
+
+/* 1 / sqrt(x) for x >= 0, to float precision: the estimate of fastInvSqrt and three Newton steps. unlike sqrt, it vectorizes */
+static GLfloat gl_inv_sqrt(GLfloat x) {
+	GLint i;
+	GLfloat y;
+	memcpy(&i, &x, 4);
+	i = 0x5F3759DF - (i >> 1);
+	memcpy(&y, &i, 4);
+	y *= 1.5f - 0.5f * x * y * y;
+	y *= 1.5f - 0.5f * x * y * y;
+	y *= 1.5f - 0.5f * x * y * y;
+	return y;
+}
+
+/*
+ pow for lighting: exponent bits and polynomials, without branches, so loops over them vectorize.
+ the relative error is below 1e-5 for the exponents of glMaterial and glLight, up to 128.
+ the clamps are done on integers: the compiler turns a clamped float into a branch, to fold the constant it gives
+*/
+
+/* log2 of x, with x taken to FLT_MIN if it is smaller. the mantissa is taken to [sqrt(1/2), sqrt(2)), where the series in (m - 1) / (m + 1) converges fast */
+static GLfloat gl_fast_log2(GLfloat x) {
+	GLint i, e, up;
+	GLfloat m, z, z2;
+	memcpy(&i, &x, 4);
+	i = i < 0x00800000 ? 0x00800000 : i;
+	e = ((i >> 23) & 255) - 127;
+	i = (i & 0x007fffff) | 0x3f800000;
+	memcpy(&m, &i, 4);
+	up = m > 1.41421356f;
+	m *= up ? 0.5f : 1;
+	e += up;
+	z = (m - 1) / (m + 1);
+	z2 = z * z;
+	return e + z * (2.88539008f + z2 * (0.961796694f + z2 * (0.577078016f + z2 * 0.412198583f)));
+}
+
+/* 2^p for |p| < 2^31: 0 below 2^-126, and at most 2^128 */
+static GLfloat gl_fast_exp2(GLfloat p) {
+	GLint i, k;
+	GLfloat f, e;
+	k = (GLint)p;
+	k -= p < k;
+	f = p - k;
+	k = k > 127 ? 127 : k;
+	i = k < -126 ? 0 : (k + 127) << 23;
+	memcpy(&e, &i, 4);
+	return e * (1 + f * (0.69315449f + f * (0.240141818f + f * (0.0558603371f + f * (0.00894959042f + f * 0.00189375406f)))));
+}
+
+static GLfloat gl_fast_pow(GLfloat x, GLfloat y) { return gl_fast_exp2(y * gl_fast_log2(x)); }
 #endif
 
@@ -0,0 +1,135 @@
+#include "../include/GL/gl.h"
+#include "../include/zbuffer.h"
+#include "zgl.h"
+
+/*
+ glDrawPolyline, a line strip from packed arrays. Outside of display lists, and with lighting off, the points are
+ transformed and mapped to the viewport VERTEX_BATCH_SIZE at a time, and the runs of segments that need no clipping
+ are drawn by ZB_polyline, which joins them. The segments that cross the view volume are clipped by gl_draw_line.
+ The last segment of a batch waits for the next batch, so that ZB_polyline knows the segments on both sides of
+ every joint: the last 3 points are carried over.
+*/
+
+#define POLYLINE_CARRY 3
+#define POLYLINE_SIZE (VERTEX_BATCH_SIZE + POLYLINE_CARRY)
+
+/* points i0 to i0 + k - 1 to the clip coordinates, clip codes and window points of slots j0 to j0 + k - 1 */
+static void polyline_map(GLContext* c, const GLfloat* points, const GLfloat* colors, GLint i0, GLint k, GLint j0, GLfloat pc[4][POLYLINE_SIZE],
+						 GLint* cc, ZBufferLinePoint* q) {
+	GLfloat* m = &c->matrix_model_projection.m[0][0];
+	GLViewport* v = &c->viewport;
+	const GLfloat* p;
+	GLfloat winv, r, g, b, a;
+	GLint i, j;
+
+	for (i = 0; i < k; i++) {
+		p = points + 3 * (i0 + i);
+		pc[0][j0 + i] = p[0] * m[0] + p[1] * m[1] + p[2] * m[2] + m[3];
+		pc[1][j0 + i] = p[0] * m[4] + p[1] * m[5] + p[2] * m[6] + m[7];
+		pc[2][j0 + i] = p[0] * m[8] + p[1] * m[9] + p[2] * m[10] + m[11];
+		pc[3][j0 + i] = p[0] * m[12] + p[1] * m[13] + p[2] * m[14] + m[15];
+	}
+	for (j = j0; j < j0 + k; j++) {
+		cc[j] = gl_clipcode(pc[0][j], pc[1][j], pc[2][j], pc[3][j]);
+		if (cc[j] != 0)
+			continue;
+		winv = 1.0f / pc[3][j];
+		q[j].x = pc[0][j] * winv * v->scale.X + v->trans.X;
+		q[j].y = pc[1][j] * winv * v->scale.Y + v->trans.Y;
+		q[j].z = (GLint)(pc[2][j] * winv * v->scale.Z + v->trans.Z);
+	}
+	for (i = 0, j = j0; i < k; i++, j++) {
+		p = colors != NULL ? colors + 4 * (i0 + i) : c->current_color.v;
+		r = p[0];
+		g = p[1];
+		b = p[2];
+		a = clampf(p[3], 0, 1);
+		q[j].r = (GLint)(r * COLOR_CORRECTED_MULT_MASK + COLOR_MIN_MULT) & COLOR_MASK;
+		q[j].g = (GLint)(g * COLOR_CORRECTED_MULT_MASK + COLOR_MIN_MULT) & COLOR_MASK;
+		q[j].b = (GLint)(b * COLOR_CORRECTED_MULT_MASK + COLOR_MIN_MULT) & COLOR_MASK;
+		q[j].a = (GLint)(a * COLOR_CORRECTED_MULT_MASK + COLOR_MIN_MULT) & COLOR_MASK;
+	}
+}
+
+/* point i, in slot j, as a vertex for gl_draw_line */
+static void polyline_vertex(GLContext* c, GLVertex* v, const GLfloat* colors, GLint i, GLint j, GLfloat pc[4][POLYLINE_SIZE], GLint* cc) {
+	const GLfloat* p = colors != NULL ? colors + 4 * i : c->current_color.v;
+	v->pc.X = pc[0][j];
+	v->pc.Y = pc[1][j];
+	v->pc.Z = pc[2][j];
+	v->pc.W = pc[3][j];
+	v->color.X = p[0];
+	v->color.Y = p[1];
+	v->color.Z = p[2];
+	v->color.W = p[3];
+	v->clip_code = cc[j];
+}
+
+void glDrawPolyline(GLsizei n, const GLfloat* points, const GLfloat* colors) {
+	GLContext* c = gl_get_context();
+	GLfloat pc[4][POLYLINE_SIZE];
+	GLint cc[POLYLINE_SIZE];
+	ZBufferLinePoint q[POLYLINE_SIZE];
+	GLVertex v[2];
+	GLint i, i0, j, e, k, k0, end, l, strip;
+#include "error_check.h"
+#if TGL_FEATURE_ERROR_CHECK == 1
+	if (n < 0)
+#define ERROR_FLAG GL_INVALID_VALUE
+#include "error_check.h"
+#else
+	if (n < 0)
+		return;
+#endif
+	/* display lists keep the glColor and glVertex calls, and lit lines need the normals of the vertex pipeline */
+#if TGL_FEATURE_ALT_RENDERMODES == 1
+	if (c->render_mode != GL_RENDER)
+		strip = 1;
+	else
+#endif
+		strip = c->compile_flag || c->lighting_enabled || c->in_begin;
+	if (strip) {
+		glBegin(GL_LINE_STRIP);
+		for (i = 0; i < n; i++) {
+			if (colors != NULL)
+				glColor4f(colors[4 * i], colors[4 * i + 1], colors[4 * i + 2], colors[4 * i + 3]);
+			glVertex3f(points[3 * i], points[3 * i + 1], points[3 * i + 2]);
+		}
+		glEnd();
+		return;
+	}
+
+	gl_update_matrices(c);
+	k0 = 0;
+	for (i0 = 0; i0 < n; i0 += k) {
+		k = n - i0 < VERTEX_BATCH_SIZE ? n - i0 : VERTEX_BATCH_SIZE;
+		polyline_map(c, points, colors, i0, k, k0, pc, cc, q);
+		l = k0 + k;
+		/* the segments from slot j to j + 1 before end, the first one was left by the last batch */
+		end = i0 + k == n ? l - 1 : l - 2;
+		for (j = k0 == 0 ? 0 : 1; j < end; j = e) {
+			e = j + 1;
+			if ((cc[j] | cc[j + 1]) == 0) {
+				while (e < end && (cc[e] | cc[e + 1]) == 0)
+					e++;
+				ZB_polyline(c->zb, &q[j], e - j + 1, j == 0 || cc[j - 1] != 0, e + 1 == l || cc[e + 1] != 0);
+			} else if ((cc[j] & cc[j + 1]) == 0) {
+				polyline_vertex(c, &v[0], colors, i0 - k0 + j, j, pc, cc);
+				polyline_vertex(c, &v[1], colors, i0 - k0 + j + 1, j + 1, pc, cc);
+				gl_draw_line(&v[0], &v[1]);
+			}
+		}
+		if (i0 + k < n) {
+			for (j = 0; j < POLYLINE_CARRY; j++) {
+				for (e = 0; e < 4; e++)
+					pc[e][j] = pc[e][l - POLYLINE_CARRY + j];
+				cc[j] = cc[l - POLYLINE_CARRY + j];
+				q[j] = q[l - POLYLINE_CARRY + j];
+			}
+			k0 = POLYLINE_CARRY;
+		}
+	}
+	/* as with glColor, the color of the last point is left current */
+	if (colors != NULL && n > 0)
+		glColor4f(colors[4 * n - 4], colors[4 * n - 3], colors[4 * n - 2], colors[4 * n - 1]);
+}
@@ -5,10 +5,13 @@
 void glPostProcess(GLuint (*postprocess)(GLint x, GLint y, GLuint pixel, GLushort z)) {
 	GLint i, j;
 	GLContext* c = gl_get_context();
+	ZB_FLUSH_TILES(c->zb);
 #ifdef _OPENMP
 #pragma omp parallel for collapse(2)
 #endif
 	for (j = 0; j < c->zb->ysize; j++)
 		for (i = 0; i < c->zb->xsize; i++)
-			c->zb->pbuf[i + j * (c->zb->xsize)] = postprocess(i, j, c->zb->pbuf[i + j * (c->zb->xsize)], c->zb->zbuf[i + j * (c->zb->xsize)]);
+			/* the callback always gets 16 bit depth */
+			c->zb->pbuf[i + j * (c->zb->xsize)] =
+				postprocess(i, j, c->zb->pbuf[i + j * (c->zb->xsize)], (GLushort)(c->zb->zbuf[i + j * (c->zb->xsize)] >> (ZB_Z_BITS - 16)));
 }
@@ -97,7 +97,7 @@ void glDrawPixels(GLsizei width, GLsizei height, GLenum format, GLenum type, voi
 	p[3].p = data;
 	gl_add_op(p);
 }
-#define ZCMP(z, zpix) (!(zbdt) || z >= (zpix))
+#define ZCMP(z, zpix) (!(zbdt) || ZB_DEPTH_PASS(zbdf, z, zpix))
 #define CLIPTEST(_x, _y, _w, _h) ((0 <= _x) && (_w > _x) && (0 <= _y) && (_h > _y))
 void glopDrawPixels(GLParam* p) {
 	GLContext* c = gl_get_context();
@@ -109,10 +109,12 @@ void glopDrawPixels(GLParam* p) {
 	ZBuffer* zb = c->zb;
 	PIXEL* d = p[3].p;
 	PIXEL* pbuf = zb->pbuf;
-	GLushort* zbuf = zb->zbuf;
+	ZPIXEL* zbuf = zb->zbuf;
 
 	GLubyte zbdw = zb->depth_write;
 	GLubyte zbdt = zb->depth_test;
+	GLenum zbdf = zb->depth_func;
+	GLint zbcw = zb->color_write;
 	GLint tw = zb->xsize;
 	GLint th = zb->ysize;
 	GLfloat pzoomx = c->pzoomx;
@@ -121,13 +123,14 @@ void glopDrawPixels(GLParam* p) {
 	GLint zz = c->rasterpos_zz;
 #if TGL_FEATURE_BLEND_DRAW_PIXELS == 1
 	TGL_BLEND_VARS
-#endif
-#if TGL_FEATURE_BLEND == 1
-#if TGL_FEATURE_BLEND_DRAW_PIXELS == 1
 	GLuint zbeb = zb->enable_blend;
-#endif
+#else
+	PIXEL zbcm = zb->color_mask;
 #endif
 	if (!c->rasterposvalid)return;
+	ZB_FLUSH_TILES(zb);
+	if (zbdw)
+		ZB_HIZ_INVALIDATE(zb, 0, 0, tw - 1, th - 1);
 	
 #if TGL_FEATURE_ALT_RENDERMODES == 1
 	if (c->render_mode == GL_SELECT) {
@@ -156,22 +159,17 @@ void glopDrawPixels(GLParam* p) {
 			for (ty = rastoffset.v[1]; (GLfloat)ty > rastoffset.v[3]; ty--)
 				for (tx = rastoffset.v[0]; (GLfloat)tx < rastoffset.v[2]; tx++)
 					if (CLIPTEST(tx, ty, tw, th)) {
-						GLushort* pz = zbuf + (ty * tw + tx);
+						ZPIXEL* pz = zbuf + (ty * tw + tx);
 
 						if (ZCMP(zz, *pz)) {
-
-#if TGL_FEATURE_BLEND == 1
+							if (zbcw) {
 #if TGL_FEATURE_BLEND_DRAW_PIXELS == 1
-							if (!zbeb)
-								pbuf[tx + ty * tw] = col;
-							else
-								TGL_BLEND_FUNC(col, pbuf[tx + ty * tw])
-#else
-							pbuf[tx + ty * tw] = col;
-#endif
-#else
-							pbuf[tx + ty * tw] = col;
+								if (zbeb)
+									TGL_BLEND_FUNC(col, 255, pbuf[tx + ty * tw])
+								else
 #endif
+									pbuf[tx + ty * tw] = ZB_MASK_PIXEL(col, pbuf[tx + ty * tw], zbcm);
+							}
 							if (zbdw)
 								*pz = zz;
 						}
@@ -190,22 +188,17 @@ void glopDrawPixels(GLParam* p) {
 			for (ty = rastoffset.v[1]; (GLfloat)ty > rastoffset.v[3]; ty--)
 				for (tx = rastoffset.v[0]; (GLfloat)tx < rastoffset.v[2]; tx++)
 					if (CLIPTEST(tx, ty, tw, th)) {
-						GLushort* pz = zbuf + (ty * tw + tx);
+						ZPIXEL* pz = zbuf + (ty * tw + tx);
 
 						if (ZCMP(zz, *pz)) {
-
-#if TGL_FEATURE_BLEND == 1
+							if (zbcw) {
 #if TGL_FEATURE_BLEND_DRAW_PIXELS == 1
-							if (!zbeb)
-								pbuf[tx + ty * tw] = col;
-							else
-								TGL_BLEND_FUNC(col, pbuf[tx + ty * tw])
-#else
-							pbuf[tx + ty * tw] = col;
-#endif
-#else
-							pbuf[tx + ty * tw] = col;
+								if (zbeb)
+									TGL_BLEND_FUNC(col, 255, pbuf[tx + ty * tw])
+								else
 #endif
+									pbuf[tx + ty * tw] = ZB_MASK_PIXEL(col, pbuf[tx + ty * tw], zbcm);
+							}
 							if (zbdw)
 								*pz = zz;
 						}
@@ -0,0 +1,461 @@
+/*
+ * Vectorized span writers for the flat, smooth, depth only and blended triangle kernels.
+ *
+ * The scalar PUT_PIXEL macros in ztriangle.c stay the reference implementation. A span writer
+ * draws the leading multiple-of-lanes part of a scanline span (8 pixels per step with AVX2,
+ * 4 with SSE4.1), comparing and writing depth for all lanes at once and merging the colours
+ * through the depth mask. The remaining pixels go through PUT_PIXEL as usual.
+ * Integer arithmetic is the same as in the macros, so the output is bit identical.
+ *
+ * The writers are compiled with per-function target attributes and picked at runtime from
+ * the CPU features, so the library still runs on CPUs without AVX2 or SSE4.1.
+ */
+
+#include "../include/zbuffer.h"
+#include "msghandling.h"
+
+#if TGL_FEATURE_SIMD_SPANS == 1
+
+#if TGL_FEATURE_RENDER_BITS == 32 && defined(__GNUC__) && !defined(__TINYC__) && (defined(__x86_64__) || defined(__i386__))
+#define TGL_SPAN_X86 1
+#include <immintrin.h>
+#else
+#define TGL_SPAN_X86 0
+#endif
+
+#if TGL_SPAN_X86 == 1
+
+/* depth values are widened to 32 bit lanes. 16 bit depth is truncated on store, like in PUT_PIXEL */
+#if TGL_FEATURE_DEPTH_BITS == 16
+#define SPAN_ZMASK 0xffff
+#define SPAN_LOADZ_AVX2(_p) _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(_p)))
+#define SPAN_STOREZ_AVX2(_p, _v) _mm_storeu_si128((__m128i*)(_p), _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packus_epi32(_v, _v), 0x08)))
+#define SPAN_LOADZ_SSE4(_p) _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*)(_p)))
+#define SPAN_STOREZ_SSE4(_p, _v) _mm_storel_epi64((__m128i*)(_p), _mm_packus_epi32(_v, _v))
+#else
+#define SPAN_ZMASK -1
+#define SPAN_LOADZ_AVX2(_p) _mm256_loadu_si256((const __m256i*)(_p))
+#define SPAN_STOREZ_AVX2(_p, _v) _mm256_storeu_si256((__m256i*)(_p), _v)
+#define SPAN_LOADZ_SSE4(_p) _mm_loadu_si128((const __m128i*)(_p))
+#define SPAN_STOREZ_SSE4(_p, _v) _mm_storeu_si128((__m128i*)(_p), _v)
+#endif
+
+/* zz = z >> ZB_POINT_Z_FRAC_BITS and the depth test mask for 8 pixels */
+#define SPAN_DEPTH_AVX2()                                                                                                                                      \
+	zz = _mm256_srli_epi32(vz, ZB_POINT_Z_FRAC_BITS);                                                                                                          \
+	zpix = SPAN_LOADZ_AVX2(pz + i);                                                                                                                            \
+	mask = zbdt ? _mm256_xor_si256(_mm256_cmpgt_epi32(zpix, zz), ones) : ones;
+
+/* blend the new pixels and depth values into the buffers through the mask */
+#define SPAN_STORE_AVX2(col)                                                                                                                                   \
+	if (!_mm256_testz_si256(mask, mask)) {                                                                                                                     \
+		__m256i old = _mm256_loadu_si256((const __m256i*)(pp + i));                                                                                            \
+		_mm256_storeu_si256((__m256i*)(pp + i), _mm256_blendv_epi8(old, col, mask));                                                                           \
+		if (zbdw) {                                                                                                                                            \
+			__m256i nz = _mm256_blendv_epi8(zpix, _mm256_and_si256(zz, zmask), mask);                                                                          \
+			SPAN_STOREZ_AVX2(pz + i, nz);                                                                                                                      \
+		}                                                                                                                                                      \
+	}
+
+/* RGB_TO_PIXEL of the colour lanes */
+#define SPAN_RGB_AVX2()                                                                                                                                        \
+	_mm256_or_si256(_mm256_and_si256(vr, _mm256_set1_epi32(0xff0000)),                                                                                         \
+					_mm256_or_si256(_mm256_and_si256(_mm256_srai_epi32(vg, 8), _mm256_set1_epi32(0xff00)),                                                     \
+									_mm256_and_si256(_mm256_srai_epi32(vb, 16), _mm256_set1_epi32(0xff))))
+/* ZB_ALPHA of the alpha lanes */
+#define SPAN_ALPHA_AVX2()                                                                                                                                      \
+	_mm256_add_epi32(_mm256_and_si256(_mm256_srli_epi32(va, COLOR_SHIFT), _mm256_set1_epi32(0xff)),                                                            \
+					 _mm256_srli_epi32(_mm256_and_si256(_mm256_srli_epi32(va, COLOR_SHIFT), _mm256_set1_epi32(0xff)), 7))
+
+__attribute__((target("avx2"))) static GLint ZB_spanFlatAVX2(PIXEL* pp, ZPIXEL* pz, GLint n, GLuint z, GLint dzdx, PIXEL color, GLint zbdt,
+															 GLint zbdw) {
+	const __m256i ones = _mm256_set1_epi32(-1);
+	const __m256i zmask = _mm256_set1_epi32(SPAN_ZMASK);
+	const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	__m256i vz = _mm256_add_epi32(_mm256_set1_epi32((GLint)z), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(dzdx)));
+	__m256i vdz = _mm256_set1_epi32(dzdx * 8);
+	__m256i vcolor = _mm256_set1_epi32((GLint)color);
+	__m256i zz, zpix, mask;
+	GLint i;
+	n &= ~7;
+	for (i = 0; i < n; i += 8) {
+		SPAN_DEPTH_AVX2()
+		SPAN_STORE_AVX2(vcolor)
+		vz = _mm256_add_epi32(vz, vdz);
+	}
+	return n;
+}
+
+__attribute__((target("avx2"))) static GLint ZB_spanSmoothAVX2(PIXEL* pp, ZPIXEL* pz, GLint n, GLuint z, GLint dzdx, GLint r, GLint g, GLint b,
+															   GLint a, GLint drdx, GLint dgdx, GLint dbdx, GLint dadx, GLint zbdt, GLint zbdw) {
+	const __m256i ones = _mm256_set1_epi32(-1);
+	const __m256i zmask = _mm256_set1_epi32(SPAN_ZMASK);
+	const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	__m256i vz = _mm256_add_epi32(_mm256_set1_epi32((GLint)z), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(dzdx)));
+	__m256i vr = _mm256_add_epi32(_mm256_set1_epi32(r), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(drdx)));
+	__m256i vg = _mm256_add_epi32(_mm256_set1_epi32(g), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(dgdx)));
+	__m256i vb = _mm256_add_epi32(_mm256_set1_epi32(b), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(dbdx)));
+	__m256i va = _mm256_add_epi32(_mm256_set1_epi32(a), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(dadx)));
+	__m256i vdz = _mm256_set1_epi32(dzdx * 8);
+	__m256i vdr = _mm256_set1_epi32(drdx * 8);
+	__m256i vdg = _mm256_set1_epi32(dgdx * 8);
+	__m256i vdb = _mm256_set1_epi32(dbdx * 8);
+	__m256i vda = _mm256_set1_epi32(dadx * 8);
+	__m256i zz, zpix, mask, col;
+	GLint i;
+	n &= ~7;
+	for (i = 0; i < n; i += 8) {
+		SPAN_DEPTH_AVX2()
+		/* RGBA_TO_PIXEL */
+		col = _mm256_or_si256(SPAN_RGB_AVX2(), _mm256_slli_epi32(SPAN_ALPHA_AVX2(), 24));
+		SPAN_STORE_AVX2(col)
+		vz = _mm256_add_epi32(vz, vdz);
+		vr = _mm256_add_epi32(vr, vdr);
+		vg = _mm256_add_epi32(vg, vdg);
+		vb = _mm256_add_epi32(vb, vdb);
+		va = _mm256_add_epi32(va, vda);
+	}
+	return n;
+}
+
+__attribute__((target("avx2"))) static GLint ZB_spanDepthAVX2(ZPIXEL* pz, GLint n, GLuint z, GLint dzdx, GLint zbdt) {
+	const __m256i ones = _mm256_set1_epi32(-1);
+	const __m256i zmask = _mm256_set1_epi32(SPAN_ZMASK);
+	const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	__m256i vz = _mm256_add_epi32(_mm256_set1_epi32((GLint)z), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(dzdx)));
+	__m256i vdz = _mm256_set1_epi32(dzdx * 8);
+	__m256i zz, zpix, mask;
+	GLint i;
+	n &= ~7;
+	for (i = 0; i < n; i += 8) {
+		SPAN_DEPTH_AVX2()
+		if (!_mm256_testz_si256(mask, mask))
+			SPAN_STOREZ_AVX2(pz + i, _mm256_blendv_epi8(zpix, _mm256_and_si256(zz, zmask), mask));
+		vz = _mm256_add_epi32(vz, vdz);
+	}
+	return n;
+}
+
+#define SPAN_DEPTH_SSE4()                                                                                                                                      \
+	zz = _mm_srli_epi32(vz, ZB_POINT_Z_FRAC_BITS);                                                                                                             \
+	zpix = SPAN_LOADZ_SSE4(pz + i);                                                                                                                            \
+	mask = zbdt ? _mm_xor_si128(_mm_cmpgt_epi32(zpix, zz), ones) : ones;
+
+#define SPAN_STORE_SSE4(col)                                                                                                                                   \
+	if (!_mm_testz_si128(mask, mask)) {                                                                                                                        \
+		__m128i old = _mm_loadu_si128((const __m128i*)(pp + i));                                                                                               \
+		_mm_storeu_si128((__m128i*)(pp + i), _mm_blendv_epi8(old, col, mask));                                                                                 \
+		if (zbdw) {                                                                                                                                            \
+			__m128i nz = _mm_blendv_epi8(zpix, _mm_and_si128(zz, zmask), mask);                                                                                \
+			SPAN_STOREZ_SSE4(pz + i, nz);                                                                                                                      \
+		}                                                                                                                                                      \
+	}
+
+#define SPAN_RGB_SSE4()                                                                                                                                        \
+	_mm_or_si128(_mm_and_si128(vr, _mm_set1_epi32(0xff0000)),                                                                                                  \
+				 _mm_or_si128(_mm_and_si128(_mm_srai_epi32(vg, 8), _mm_set1_epi32(0xff00)), _mm_and_si128(_mm_srai_epi32(vb, 16), _mm_set1_epi32(0xff))))
+#define SPAN_ALPHA_SSE4()                                                                                                                                      \
+	_mm_add_epi32(_mm_and_si128(_mm_srli_epi32(va, COLOR_SHIFT), _mm_set1_epi32(0xff)),                                                                        \
+				  _mm_srli_epi32(_mm_and_si128(_mm_srli_epi32(va, COLOR_SHIFT), _mm_set1_epi32(0xff)), 7))
+
+__attribute__((target("sse4.1"))) static GLint ZB_spanFlatSSE4(PIXEL* pp, ZPIXEL* pz, GLint n, GLuint z, GLint dzdx, PIXEL color, GLint zbdt,
+															   GLint zbdw) {
+	const __m128i ones = _mm_set1_epi32(-1);
+	const __m128i zmask = _mm_set1_epi32(SPAN_ZMASK);
+	const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+	__m128i vz = _mm_add_epi32(_mm_set1_epi32((GLint)z), _mm_mullo_epi32(lanes, _mm_set1_epi32(dzdx)));
+	__m128i vdz = _mm_set1_epi32(dzdx * 4);
+	__m128i vcolor = _mm_set1_epi32((GLint)color);
+	__m128i zz, zpix, mask;
+	GLint i;
+	n &= ~3;
+	for (i = 0; i < n; i += 4) {
+		SPAN_DEPTH_SSE4()
+		SPAN_STORE_SSE4(vcolor)
+		vz = _mm_add_epi32(vz, vdz);
+	}
+	return n;
+}
+
+__attribute__((target("sse4.1"))) static GLint ZB_spanSmoothSSE4(PIXEL* pp, ZPIXEL* pz, GLint n, GLuint z, GLint dzdx, GLint r, GLint g, GLint b,
+																 GLint a, GLint drdx, GLint dgdx, GLint dbdx, GLint dadx, GLint zbdt, GLint zbdw) {
+	const __m128i ones = _mm_set1_epi32(-1);
+	const __m128i zmask = _mm_set1_epi32(SPAN_ZMASK);
+	const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+	__m128i vz = _mm_add_epi32(_mm_set1_epi32((GLint)z), _mm_mullo_epi32(lanes, _mm_set1_epi32(dzdx)));
+	__m128i vr = _mm_add_epi32(_mm_set1_epi32(r), _mm_mullo_epi32(lanes, _mm_set1_epi32(drdx)));
+	__m128i vg = _mm_add_epi32(_mm_set1_epi32(g), _mm_mullo_epi32(lanes, _mm_set1_epi32(dgdx)));
+	__m128i vb = _mm_add_epi32(_mm_set1_epi32(b), _mm_mullo_epi32(lanes, _mm_set1_epi32(dbdx)));
+	__m128i va = _mm_add_epi32(_mm_set1_epi32(a), _mm_mullo_epi32(lanes, _mm_set1_epi32(dadx)));
+	__m128i vdz = _mm_set1_epi32(dzdx * 4);
+	__m128i vdr = _mm_set1_epi32(drdx * 4);
+	__m128i vdg = _mm_set1_epi32(dgdx * 4);
+	__m128i vdb = _mm_set1_epi32(dbdx * 4);
+	__m128i vda = _mm_set1_epi32(dadx * 4);
+	__m128i zz, zpix, mask, col;
+	GLint i;
+	n &= ~3;
+	for (i = 0; i < n; i += 4) {
+		SPAN_DEPTH_SSE4()
+		col = _mm_or_si128(SPAN_RGB_SSE4(), _mm_slli_epi32(SPAN_ALPHA_SSE4(), 24));
+		SPAN_STORE_SSE4(col)
+		vz = _mm_add_epi32(vz, vdz);
+		vr = _mm_add_epi32(vr, vdr);
+		vg = _mm_add_epi32(vg, vdg);
+		vb = _mm_add_epi32(vb, vdb);
+		va = _mm_add_epi32(va, vda);
+	}
+	return n;
+}
+
+__attribute__((target("sse4.1"))) static GLint ZB_spanDepthSSE4(ZPIXEL* pz, GLint n, GLuint z, GLint dzdx, GLint zbdt) {
+	const __m128i ones = _mm_set1_epi32(-1);
+	const __m128i zmask = _mm_set1_epi32(SPAN_ZMASK);
+	const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+	__m128i vz = _mm_add_epi32(_mm_set1_epi32((GLint)z), _mm_mullo_epi32(lanes, _mm_set1_epi32(dzdx)));
+	__m128i vdz = _mm_set1_epi32(dzdx * 4);
+	__m128i zz, zpix, mask;
+	GLint i;
+	n &= ~3;
+	for (i = 0; i < n; i += 4) {
+		SPAN_DEPTH_SSE4()
+		if (!_mm_testz_si128(mask, mask))
+			SPAN_STOREZ_SSE4(pz + i, _mm_blendv_epi8(zpix, _mm_and_si128(zz, zmask), mask));
+		vz = _mm_add_epi32(vz, vdz);
+	}
+	return n;
+}
+
+#if TGL_FEATURE_BLEND == 1
+
+#define SPAN_BLEND_PARAMS                                                                                                                                      \
+	PIXEL *pp, ZPIXEL *pz, GLint n, GLuint z, GLint dzdx, GLint r, GLint g, GLint b, GLint a, GLint drdx, GLint dgdx, GLint dbdx, GLint dadx, GLint zbdt,      \
+		GLint zbdw
+#define SPAN_BLEND_ARGS pp, pz, n, z, dzdx, r, g, b, a, drdx, dgdx, dbdx, dadx, zbdt, zbdw
+
+/*
+ * Blending works on 16 bit channels: both pixels are unpacked, weighted with TGL_MUL255 and
+ * packed back with unsigned saturation, which is the TGL_CLAMPI of GL_FUNC_ADD. The alpha
+ * channel goes through the same factors as the colour.
+ */
+__attribute__((target("avx2"))) static inline __m256i ZB_mul255AVX2(__m256i x, __m256i w) {
+	__m256i t = _mm256_add_epi16(_mm256_mullo_epi16(x, w), _mm256_set1_epi16(128));
+	return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+/* mode is a constant ZB_SPAN_BLEND_*, each writer below gets its own copy */
+__attribute__((target("avx2"), always_inline)) static inline GLint ZB_spanBlendAVX2(SPAN_BLEND_PARAMS, const GLint mode) {
+	const __m256i ones = _mm256_set1_epi32(-1);
+	const __m256i zmask = _mm256_set1_epi32(SPAN_ZMASK);
+	const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i vz = _mm256_add_epi32(_mm256_set1_epi32((GLint)z), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(dzdx)));
+	__m256i vr = _mm256_add_epi32(_mm256_set1_epi32(r), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(drdx)));
+	__m256i vg = _mm256_add_epi32(_mm256_set1_epi32(g), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(dgdx)));
+	__m256i vb = _mm256_add_epi32(_mm256_set1_epi32(b), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(dbdx)));
+	__m256i va = _mm256_add_epi32(_mm256_set1_epi32(a), _mm256_mullo_epi32(lanes, _mm256_set1_epi32(dadx)));
+	__m256i vdz = _mm256_set1_epi32(dzdx * 8);
+	__m256i vdr = _mm256_set1_epi32(drdx * 8);
+	__m256i vdg = _mm256_set1_epi32(dgdx * 8);
+	__m256i vdb = _mm256_set1_epi32(dbdx * 8);
+	__m256i vda = _mm256_set1_epi32(dadx * 8);
+	__m256i zz, zpix, mask;
+	GLint i;
+	n &= ~7;
+	for (i = 0; i < n; i += 8) {
+		SPAN_DEPTH_AVX2()
+		if (!_mm256_testz_si256(mask, mask)) {
+			__m256i old = _mm256_loadu_si256((const __m256i*)(pp + i));
+			/* the source alpha is the weight itself */
+			__m256i w = SPAN_ALPHA_AVX2();
+			__m256i col = _mm256_or_si256(SPAN_RGB_AVX2(), _mm256_slli_epi32(w, 24));
+			if (mode == ZB_SPAN_BLEND_ADD) {
+				col = _mm256_adds_epu8(col, old);
+			} else {
+				/* copied to the four channels of each pixel */
+				__m256i wlo, whi, lo, hi;
+				w = _mm256_or_si256(w, _mm256_slli_epi32(w, 16));
+				wlo = _mm256_unpacklo_epi32(w, w);
+				whi = _mm256_unpackhi_epi32(w, w);
+				lo = ZB_mul255AVX2(_mm256_unpacklo_epi8(col, zero), wlo);
+				hi = ZB_mul255AVX2(_mm256_unpackhi_epi8(col, zero), whi);
+				if (mode == ZB_SPAN_BLEND_ALPHA) {
+					const __m256i full = _mm256_set1_epi16(255);
+					lo = _mm256_add_epi16(lo, ZB_mul255AVX2(_mm256_unpacklo_epi8(old, zero), _mm256_sub_epi16(full, wlo)));
+					hi = _mm256_add_epi16(hi, ZB_mul255AVX2(_mm256_unpackhi_epi8(old, zero), _mm256_sub_epi16(full, whi)));
+				} else {
+					lo = _mm256_add_epi16(lo, _mm256_unpacklo_epi8(old, zero));
+					hi = _mm256_add_epi16(hi, _mm256_unpackhi_epi8(old, zero));
+				}
+				col = _mm256_packus_epi16(lo, hi);
+			}
+			_mm256_storeu_si256((__m256i*)(pp + i), _mm256_blendv_epi8(old, col, mask));
+			if (zbdw)
+				SPAN_STOREZ_AVX2(pz + i, _mm256_blendv_epi8(zpix, _mm256_and_si256(zz, zmask), mask));
+		}
+		vz = _mm256_add_epi32(vz, vdz);
+		vr = _mm256_add_epi32(vr, vdr);
+		vg = _mm256_add_epi32(vg, vdg);
+		vb = _mm256_add_epi32(vb, vdb);
+		va = _mm256_add_epi32(va, vda);
+	}
+	return n;
+}
+
+__attribute__((target("avx2"))) static GLint ZB_spanBlendAddAVX2(SPAN_BLEND_PARAMS) { return ZB_spanBlendAVX2(SPAN_BLEND_ARGS, ZB_SPAN_BLEND_ADD); }
+__attribute__((target("avx2"))) static GLint ZB_spanBlendAlphaAVX2(SPAN_BLEND_PARAMS) { return ZB_spanBlendAVX2(SPAN_BLEND_ARGS, ZB_SPAN_BLEND_ALPHA); }
+__attribute__((target("avx2"))) static GLint ZB_spanBlendAlphaAddAVX2(SPAN_BLEND_PARAMS) {
+	return ZB_spanBlendAVX2(SPAN_BLEND_ARGS, ZB_SPAN_BLEND_ALPHA_ADD);
+}
+
+__attribute__((target("sse4.1"))) static inline __m128i ZB_mul255SSE4(__m128i x, __m128i w) {
+	__m128i t = _mm_add_epi16(_mm_mullo_epi16(x, w), _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+__attribute__((target("sse4.1"), always_inline)) static inline GLint ZB_spanBlendSSE4(SPAN_BLEND_PARAMS, const GLint mode) {
+	const __m128i ones = _mm_set1_epi32(-1);
+	const __m128i zmask = _mm_set1_epi32(SPAN_ZMASK);
+	const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+	const __m128i zero = _mm_setzero_si128();
+	__m128i vz = _mm_add_epi32(_mm_set1_epi32((GLint)z), _mm_mullo_epi32(lanes, _mm_set1_epi32(dzdx)));
+	__m128i vr = _mm_add_epi32(_mm_set1_epi32(r), _mm_mullo_epi32(lanes, _mm_set1_epi32(drdx)));
+	__m128i vg = _mm_add_epi32(_mm_set1_epi32(g), _mm_mullo_epi32(lanes, _mm_set1_epi32(dgdx)));
+	__m128i vb = _mm_add_epi32(_mm_set1_epi32(b), _mm_mullo_epi32(lanes, _mm_set1_epi32(dbdx)));
+	__m128i va = _mm_add_epi32(_mm_set1_epi32(a), _mm_mullo_epi32(lanes, _mm_set1_epi32(dadx)));
+	__m128i vdz = _mm_set1_epi32(dzdx * 4);
+	__m128i vdr = _mm_set1_epi32(drdx * 4);
+	__m128i vdg = _mm_set1_epi32(dgdx * 4);
+	__m128i vdb = _mm_set1_epi32(dbdx * 4);
+	__m128i vda = _mm_set1_epi32(dadx * 4);
+	__m128i zz, zpix, mask;
+	GLint i;
+	n &= ~3;
+	for (i = 0; i < n; i += 4) {
+		SPAN_DEPTH_SSE4()
+		if (!_mm_testz_si128(mask, mask)) {
+			__m128i old = _mm_loadu_si128((const __m128i*)(pp + i));
+			__m128i w = SPAN_ALPHA_SSE4();
+			__m128i col = _mm_or_si128(SPAN_RGB_SSE4(), _mm_slli_epi32(w, 24));
+			if (mode == ZB_SPAN_BLEND_ADD) {
+				col = _mm_adds_epu8(col, old);
+			} else {
+				__m128i wlo, whi, lo, hi;
+				w = _mm_or_si128(w, _mm_slli_epi32(w, 16));
+				wlo = _mm_unpacklo_epi32(w, w);
+				whi = _mm_unpackhi_epi32(w, w);
+				lo = ZB_mul255SSE4(_mm_unpacklo_epi8(col, zero), wlo);
+				hi = ZB_mul255SSE4(_mm_unpackhi_epi8(col, zero), whi);
+				if (mode == ZB_SPAN_BLEND_ALPHA) {
+					const __m128i full = _mm_set1_epi16(255);
+					lo = _mm_add_epi16(lo, ZB_mul255SSE4(_mm_unpacklo_epi8(old, zero), _mm_sub_epi16(full, wlo)));
+					hi = _mm_add_epi16(hi, ZB_mul255SSE4(_mm_unpackhi_epi8(old, zero), _mm_sub_epi16(full, whi)));
+				} else {
+					lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(old, zero));
+					hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(old, zero));
+				}
+				col = _mm_packus_epi16(lo, hi);
+			}
+			_mm_storeu_si128((__m128i*)(pp + i), _mm_blendv_epi8(old, col, mask));
+			if (zbdw)
+				SPAN_STOREZ_SSE4(pz + i, _mm_blendv_epi8(zpix, _mm_and_si128(zz, zmask), mask));
+		}
+		vz = _mm_add_epi32(vz, vdz);
+		vr = _mm_add_epi32(vr, vdr);
+		vg = _mm_add_epi32(vg, vdg);
+		vb = _mm_add_epi32(vb, vdb);
+		va = _mm_add_epi32(va, vda);
+	}
+	return n;
+}
+
+__attribute__((target("sse4.1"))) static GLint ZB_spanBlendAddSSE4(SPAN_BLEND_PARAMS) { return ZB_spanBlendSSE4(SPAN_BLEND_ARGS, ZB_SPAN_BLEND_ADD); }
+__attribute__((target("sse4.1"))) static GLint ZB_spanBlendAlphaSSE4(SPAN_BLEND_PARAMS) { return ZB_spanBlendSSE4(SPAN_BLEND_ARGS, ZB_SPAN_BLEND_ALPHA); }
+__attribute__((target("sse4.1"))) static GLint ZB_spanBlendAlphaAddSSE4(SPAN_BLEND_PARAMS) {
+	return ZB_spanBlendSSE4(SPAN_BLEND_ARGS, ZB_SPAN_BLEND_ALPHA_ADD);
+}
+
+#endif /* TGL_FEATURE_BLEND */
+
+#endif /* TGL_SPAN_X86 */
+
+#if TGL_FEATURE_BLEND == 1
+/*
+ * Portable blend span writers: the per pixel blend macro with the blend state known at compile
+ * time, so the factor and equation switches fold away. They draw the whole span.
+ */
+#define SPAN_BLEND_C(name, _sfactor, _dfactor)                                                                                                                 \
+	static GLint name(PIXEL* pp, ZPIXEL* pz, GLint n, GLuint z, GLint dzdx, GLint r, GLint g, GLint b, GLint a, GLint drdx, GLint dgdx, GLint dbdx, GLint dadx, \
+					  GLint zbdt, GLint zbdw) {                                                                                                                \
+		const GLuint zbblendeq = GL_FUNC_ADD, sfactor = _sfactor, dfactor = _dfactor;                                                                          \
+		const PIXEL zbcm = ZB_COLOR_MASK_ALL;                                                                                                                  \
+		GLint i;                                                                                                                                               \
+		for (i = 0; i < n; i++) {                                                                                                                              \
+			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
+			if ((!zbdt) || (zz >= pz[i])) {                                                                                                                    \
+				register GLint alpha = ZB_ALPHA(a);                                                                                                            \
+				TGL_BLEND_FUNC_RGB(r, g, b, alpha, pp[i]);                                                                                                     \
+				if (zbdw)                                                                                                                                      \
+					pz[i] = zz;                                                                                                                                \
+			}                                                                                                                                                  \
+			z += dzdx;                                                                                                                                         \
+			r += drdx;                                                                                                                                         \
+			g += dgdx;                                                                                                                                         \
+			b += dbdx;                                                                                                                                         \
+			a += dadx;                                                                                                                                         \
+		}                                                                                                                                                      \
+		return n;                                                                                                                                              \
+	}
+
+SPAN_BLEND_C(ZB_spanBlendAddC, GL_ONE, GL_ONE)
+SPAN_BLEND_C(ZB_spanBlendAlphaC, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA)
+SPAN_BLEND_C(ZB_spanBlendAlphaAddC, GL_SRC_ALPHA, GL_ONE)
+
+ZB_spanBlendFunc ZB_spanBlend(ZBuffer* zb) {
+	/* the blend kernels also draw a partial glColorMask, with or without blending */
+	if (!zb->enable_blend || zb->color_mask != ZB_COLOR_MASK_ALL || zb->blendeq != GL_FUNC_ADD)
+		return NULL;
+	if (zb->sfactor == GL_ONE && zb->dfactor == GL_ONE)
+		return zb->span_blend[ZB_SPAN_BLEND_ADD];
+	if (zb->sfactor == GL_SRC_ALPHA && zb->dfactor == GL_ONE_MINUS_SRC_ALPHA)
+		return zb->span_blend[ZB_SPAN_BLEND_ALPHA];
+	if (zb->sfactor == GL_SRC_ALPHA && zb->dfactor == GL_ONE)
+		return zb->span_blend[ZB_SPAN_BLEND_ALPHA_ADD];
+	return NULL;
+}
+#endif
+
+void ZB_initSpans(ZBuffer* zb) {
+	zb->span_flat = NULL;
+	zb->span_smooth = NULL;
+	zb->span_depth = NULL;
+#if TGL_FEATURE_BLEND == 1
+	zb->span_blend[ZB_SPAN_BLEND_ADD] = ZB_spanBlendAddC;
+	zb->span_blend[ZB_SPAN_BLEND_ALPHA] = ZB_spanBlendAlphaC;
+	zb->span_blend[ZB_SPAN_BLEND_ALPHA_ADD] = ZB_spanBlendAlphaAddC;
+#endif
+#if TGL_SPAN_X86 == 1
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		zb->span_flat = ZB_spanFlatAVX2;
+		zb->span_smooth = ZB_spanSmoothAVX2;
+		zb->span_depth = ZB_spanDepthAVX2;
+#if TGL_FEATURE_BLEND == 1
+		zb->span_blend[ZB_SPAN_BLEND_ADD] = ZB_spanBlendAddAVX2;
+		zb->span_blend[ZB_SPAN_BLEND_ALPHA] = ZB_spanBlendAlphaAVX2;
+		zb->span_blend[ZB_SPAN_BLEND_ALPHA_ADD] = ZB_spanBlendAlphaAddAVX2;
+#endif
+	} else if (__builtin_cpu_supports("sse4.1")) {
+		zb->span_flat = ZB_spanFlatSSE4;
+		zb->span_smooth = ZB_spanSmoothSSE4;
+		zb->span_depth = ZB_spanDepthSSE4;
+#if TGL_FEATURE_BLEND == 1
+		zb->span_blend[ZB_SPAN_BLEND_ADD] = ZB_spanBlendAddSSE4;
+		zb->span_blend[ZB_SPAN_BLEND_ALPHA] = ZB_spanBlendAlphaSSE4;
+		zb->span_blend[ZB_SPAN_BLEND_ALPHA_ADD] = ZB_spanBlendAlphaAddSSE4;
+#endif
+	}
+#endif
+}
+
+#endif
@@ -44,6 +44,7 @@ void glopPlotPixel(GLParam* p) {
 	GLContext* c = gl_get_context();
 	GLint x = p[1].i;
 	PIXEL pix = p[2].ui;
+	ZB_FLUSH_TILES(c->zb);
 	c->zb->pbuf[x] = pix;
 	
 }
@@ -0,0 +1,235 @@
+/*
+ * Deferred, tile-binned triangle rasterization.
+ *
+ * Triangles are set up once by the geometry pipeline, then queued together with a snapshot
+ * of the zbuffer state they were submitted with, and binned into TGL_TILE_DIM sized screen tiles.
+ * At flush time every tile is drawn by its own thread, replaying its bin in submission order
+ * through the regular ZB_fillTriangle* functions with the scissor set to the tile.
+ * No two threads ever touch the same zbuf/pbuf pixel, and the result matches immediate mode.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/zbuffer.h"
+#include "msghandling.h"
+
+#if TGL_FEATURE_TILED_RASTER == 1
+
+#define TGL_TILE_DIM (1 << TGL_TILE_POW2)
+
+typedef struct {
+	ZB_fillTriangleFunc fill;
+	GLint state; /* index into ZBTiles.states */
+	ZBufferPoint p[3];
+} ZBTileTriangle;
+
+typedef struct {
+	GLint* tris;
+	GLint count, max;
+} ZBTileBin;
+
+struct ZBTiles {
+	ZBTileTriangle* tris;
+	GLint ntris, maxtris;
+	ZBuffer* states;
+	GLint nstates, maxstates;
+	ZBTileBin* bins;
+	GLint xtiles, ytiles;
+	/* flushes so far, see ZB_tileBatch */
+	GLuint batch;
+};
+
+/* grow an array to hold at least "need" elements. returns 0 when out of memory. */
+static GLint ZB_tileGrow(void** array, GLint* max, GLint need, GLint elemsize) {
+	GLint newmax;
+	void* newarray;
+	if (need <= *max)
+		return 1;
+	newmax = *max ? *max : 64;
+	while (newmax < need)
+		newmax *= 2;
+	newarray = gl_malloc(newmax * elemsize);
+	if (newarray == NULL)
+		return 0;
+	if (*array) {
+		memcpy(newarray, *array, *max * elemsize);
+		gl_free(*array);
+	}
+	*array = newarray;
+	*max = newmax;
+	return 1;
+}
+
+static void ZB_freeTiles(struct ZBTiles* t) {
+	GLint i;
+	for (i = 0; i < t->xtiles * t->ytiles; i++)
+		if (t->bins[i].tris)
+			gl_free(t->bins[i].tris);
+	if (t->bins)
+		gl_free(t->bins);
+	if (t->tris)
+		gl_free(t->tris);
+	if (t->states)
+		gl_free(t->states);
+	gl_free(t);
+}
+
+GLint ZB_setTiledRaster(ZBuffer* zb, GLint enable) {
+	struct ZBTiles* t;
+	if (zb->tiles) {
+		ZB_flushTiles(zb);
+		ZB_freeTiles(zb->tiles);
+		zb->tiles = NULL;
+	}
+	if (!enable)
+		return 1;
+	t = gl_zalloc(sizeof(struct ZBTiles));
+	if (t == NULL)
+		return 0;
+	t->xtiles = (zb->xsize + TGL_TILE_DIM - 1) >> TGL_TILE_POW2;
+	t->ytiles = (zb->ysize + TGL_TILE_DIM - 1) >> TGL_TILE_POW2;
+	t->bins = gl_zalloc(t->xtiles * t->ytiles * sizeof(ZBTileBin));
+	if (t->bins == NULL) {
+		gl_free(t);
+		return 0;
+	}
+	zb->tiles = t;
+	return 1;
+}
+
+void ZB_discardTiles(ZBuffer* zb) {
+	struct ZBTiles* t = zb->tiles;
+	GLint i;
+	if (t == NULL || t->ntris == 0)
+		return;
+	for (i = 0; i < t->xtiles * t->ytiles; i++)
+		t->bins[i].count = 0;
+	t->ntris = 0;
+	t->nstates = 0;
+	t->batch++;
+}
+
+GLuint ZB_tileBatch(ZBuffer* zb) {
+	struct ZBTiles* t = zb->tiles;
+	if (t == NULL || t->ntris == 0)
+		return 0;
+	return t->batch + 1;
+}
+
+void ZB_queueTriangle(ZBuffer* zb, ZB_fillTriangleFunc fill, ZBufferPoint* p0, ZBufferPoint* p1, ZBufferPoint* p2) {
+	struct ZBTiles* t = zb->tiles;
+	ZBTileTriangle* tri;
+	GLint xmin, xmax, ymin, ymax, tx, ty, index;
+
+	/* screen bounding box, in tiles */
+	xmin = xmax = p0->x;
+	ymin = ymax = p0->y;
+	if (p1->x < xmin) xmin = p1->x;
+	if (p1->x > xmax) xmax = p1->x;
+	if (p2->x < xmin) xmin = p2->x;
+	if (p2->x > xmax) xmax = p2->x;
+	if (p1->y < ymin) ymin = p1->y;
+	if (p1->y > ymax) ymax = p1->y;
+	if (p2->y < ymin) ymin = p2->y;
+	if (p2->y > ymax) ymax = p2->y;
+	if (xmin < 0) xmin = 0;
+	if (ymin < 0) ymin = 0;
+	if (xmax > zb->xsize - 1) xmax = zb->xsize - 1;
+	if (ymax > zb->ysize - 1) ymax = zb->ysize - 1;
+	if (xmin > xmax || ymin > ymax)
+		return;
+	xmin >>= TGL_TILE_POW2;
+	xmax >>= TGL_TILE_POW2;
+	ymin >>= TGL_TILE_POW2;
+	ymax >>= TGL_TILE_POW2;
+
+	if (t->ntris >= TGL_TILE_MAX_TRIANGLES)
+		ZB_flushTiles(zb);
+
+	/* the zbuffer state only changes between batches, so it is stored once per change */
+	if (t->nstates == 0 || memcmp(&t->states[t->nstates - 1], zb, sizeof(ZBuffer))) {
+		if (!ZB_tileGrow((void**)&t->states, &t->maxstates, t->nstates + 1, sizeof(ZBuffer)))
+			goto immediate;
+		memcpy(&t->states[t->nstates++], zb, sizeof(ZBuffer));
+	}
+	if (!ZB_tileGrow((void**)&t->tris, &t->maxtris, t->ntris + 1, sizeof(ZBTileTriangle)))
+		goto immediate;
+	for (ty = ymin; ty <= ymax; ty++)
+		for (tx = xmin; tx <= xmax; tx++) {
+			ZBTileBin* bin = &t->bins[tx + ty * t->xtiles];
+			if (!ZB_tileGrow((void**)&bin->tris, &bin->max, bin->count + 1, sizeof(GLint)))
+				goto immediate;
+		}
+	index = t->ntris;
+	for (ty = ymin; ty <= ymax; ty++)
+		for (tx = xmin; tx <= xmax; tx++) {
+			ZBTileBin* bin = &t->bins[tx + ty * t->xtiles];
+			bin->tris[bin->count++] = index;
+		}
+	tri = &t->tris[t->ntris++];
+	tri->fill = fill;
+	tri->state = t->nstates - 1;
+	tri->p[0] = *p0;
+	tri->p[1] = *p1;
+	tri->p[2] = *p2;
+	return;
+
+immediate:
+	/* out of memory: keep the submission order and draw it right away */
+	ZB_flushTiles(zb);
+	fill(zb, p0, p1, p2);
+}
+
+static void ZB_drawTile(struct ZBTiles* t, ZBuffer* zb, GLint tile) {
+	ZBTileBin* bin = &t->bins[tile];
+	ZBuffer tzb;
+	GLint i, state = -1;
+	GLint x0 = (tile % t->xtiles) << TGL_TILE_POW2;
+	GLint y0 = (tile / t->xtiles) << TGL_TILE_POW2;
+	GLint x1 = x0 + TGL_TILE_DIM - 1;
+	GLint y1 = y0 + TGL_TILE_DIM - 1;
+	if (x1 > zb->xsize - 1)
+		x1 = zb->xsize - 1;
+	if (y1 > zb->ysize - 1)
+		y1 = zb->ysize - 1;
+
+	for (i = 0; i < bin->count; i++) {
+		ZBTileTriangle* tri = &t->tris[bin->tris[i]];
+		ZBufferPoint q0, q1, q2;
+		if (tri->state != state) {
+			state = tri->state;
+			memcpy(&tzb, &t->states[state], sizeof(ZBuffer));
+			tzb.tiles = NULL;
+			tzb.clip_xmin = x0;
+			tzb.clip_xmax = x1;
+			tzb.clip_ymin = y0;
+			tzb.clip_ymax = y1;
+		}
+		/* the fill functions use the points as scratch space */
+		q0 = tri->p[0];
+		q1 = tri->p[1];
+		q2 = tri->p[2];
+		tri->fill(&tzb, &q0, &q1, &q2);
+	}
+	bin->count = 0;
+}
+
+void ZB_flushTiles(ZBuffer* zb) {
+	struct ZBTiles* t = zb->tiles;
+	GLint i, ntiles;
+	if (t == NULL || t->ntris == 0)
+		return;
+	ntiles = t->xtiles * t->ytiles;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for (i = 0; i < ntiles; i++)
+		if (t->bins[i].count)
+			ZB_drawTile(t, zb, i);
+	t->ntris = 0;
+	t->nstates = 0;
+	t->batch++;
+}
+
+#endif
@@ -3,13 +3,6 @@
 #include <stdlib.h>
 
 
-
-
-/* TODO: Switch from scanline rasterizer to easily parallelized cross product rasterizer.*/
-static GLfloat edgeFunction(GLfloat ax, GLfloat ay, GLfloat bx, GLfloat by, GLfloat cx, GLfloat cy) {
-	return (cx - ax) * (by - ay) - (cy - ay) * (bx - ax);
-}
-
 #if TGL_FEATURE_RENDER_BITS == 32
 #elif TGL_FEATURE_RENDER_BITS == 16
 #else
@@ -41,450 +34,317 @@ static GLfloat edgeFunction(GLfloat ax, GLfloat ay, GLfloat bx, GLfloat by, GLfl
 #define NODRAWTEST(c) /* a comment */
 #endif
 
-#define ZCMP(z, zpix, _a, c) (((!zbdt) || (z >= zpix)) STIPTEST(_a) NODRAWTEST(c))
-#define ZCMPSIMP(z, zpix, _a, crabapple) (((!zbdt) || (z >= zpix)) STIPTEST(_a))
-
-void ZB_fillTriangleFlat(ZBuffer* zb, ZBufferPoint* p0, ZBufferPoint* p1, ZBufferPoint* p2) {
-	GLubyte zbdt = zb->depth_test;
-	GLubyte zbdw = zb->depth_write;
-	GLuint color;
-	TGL_BLEND_VARS
-	TGL_STIPPLEVARS
-
-#undef INTERP_Z
-#undef INTERP_RGB
-#undef INTERP_ST
-#undef INTERP_STZ
-
-#define INTERP_Z
-
-
-#define DRAW_INIT()                                                                                                                                            \
-	{ color = RGB_TO_PIXEL(p2->r, p2->g, p2->b); }
-
-#define PUT_PIXEL(_a)                                                                                                                                          \
-	{                                                                                                                                                          \
-		{                                                                                                                                                      \
-			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
-			if (ZCMPSIMP(zz, pz[_a], _a, color)) {                                                                                                             \
-				TGL_BLEND_FUNC(color, (pp[_a])) /*pp[_a] = color;*/                                                                                            \
-				if (zbdw)                                                                                                                                      \
-					pz[_a] = zz;                                                                                                                               \
-			}                                                                                                                                                  \
-		}                                                                                                                                                      \
-		z += dzdx;                                                                                                                                             \
-	}
+#if TGL_FEATURE_SIMD_SPANS == 1
+/* the span writers know nothing about the stipple pattern */
+#if TGL_FEATURE_POLYGON_STIPPLE == 1
+#define TGL_SPANS_ON (ZB_DEPTH_SPANS && !zb->dostipple)
+#else
+#define TGL_SPANS_ON ZB_DEPTH_SPANS
+#endif
+#define TGL_SPANVARS(_type, _func) _type zbspan = TGL_SPANS_ON ? zb->_func : NULL;
+#else
+#define TGL_SPANVARS(_type, _func) /* a comment */
+#endif
+
+#if TGL_FEATURE_SIMD_SPANS == 1 && TGL_FEATURE_BLEND == 1
+/* the blend span writer depends on the blend state, it is picked once per triangle */
+#define TGL_BLENDSPANVARS ZB_spanBlendFunc zbspan = TGL_SPANS_ON ? ZB_spanBlend(zb) : NULL;
+#else
+#define TGL_BLENDSPANVARS /* a comment */
+#endif
+
+#define ZCMP(z, zpix, _a, c) ((ZB_DEPTH_TEST(z, zpix)) STIPTEST(_a) NODRAWTEST(c))
+#define ZCMPSIMP(z, zpix, _a, crabapple) ((ZB_DEPTH_TEST(z, zpix)) STIPTEST(_a))
 
-#include "ztriangle.h"
+void ZB_setTexture(ZBuffer* zb, PIXEL* texture, GLint xsize, GLint ysize) {
+	zb->current_texture = texture;
+	zb->texture_xsize = xsize;
+	zb->texture_ysize = ysize;
 }
 
-void ZB_fillTriangleFlatNOBLEND(ZBuffer* zb, ZBufferPoint* p0, ZBufferPoint* p1, ZBufferPoint* p2) {
-	PIXEL color = RGB_TO_PIXEL(p2->r, p2->g, p2->b);
-	GLubyte zbdw = zb->depth_write;
-	GLubyte zbdt = zb->depth_test;
-	TGL_STIPPLEVARS
-#undef INTERP_Z
-#undef INTERP_RGB
-#undef INTERP_ST
-#undef INTERP_STZ
-#define INTERP_Z
-
-#define DRAW_INIT()                                                                                                                                            \
-	{}
-
-#define PUT_PIXEL(_a)                                                                                                                                          \
-	{                                                                                                                                                          \
-		{                                                                                                                                                      \
-			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
-			if (ZCMPSIMP(zz, pz[_a], _a, 0)) {                                                                                                                 \
-				pp[_a] = color;                                                                                                                                \
-				if (zbdw)                                                                                                                                      \
-					pz[_a] = zz;                                                                                                                               \
-			}                                                                                                                                                  \
-		}                                                                                                                                                      \
-		z += dzdx;                                                                                                                                             \
+#if TGL_FEATURE_TEXTURE_FILTER == 1
+
+GLint ZB_setTextureFilter(ZBuffer* zb, PIXEL* mipmap, GLint min_filter, GLint mag_filter) {
+	GLint l, w = zb->texture_xsize, h = zb->texture_ysize;
+	zb->texture_levels[0] = zb->current_texture;
+	zb->texture_max_level = 0;
+	if (mipmap != NULL && min_filter != GL_NEAREST && min_filter != GL_LINEAR) {
+		for (l = 1; w > 1 || h > 1; l++) {
+			w = ZB_TEXTURE_LEVEL_SIZE(w, 1);
+			h = ZB_TEXTURE_LEVEL_SIZE(h, 1);
+			zb->texture_levels[l] = mipmap;
+			mipmap += w * h;
+		}
+		zb->texture_max_level = l - 1;
 	}
-
-#include "ztriangle.h"
+	/* *_MIPMAP_LINEAR is sampled like *_MIPMAP_NEAREST, from the nearest level only */
+	zb->texture_min_linear = (min_filter == GL_LINEAR || min_filter == GL_LINEAR_MIPMAP_NEAREST || min_filter == GL_LINEAR_MIPMAP_LINEAR);
+	zb->texture_mag_linear = (mag_filter == GL_LINEAR);
+	return zb->texture_max_level || zb->texture_min_linear || zb->texture_mag_linear;
 }
 
 /*
- * Smooth filled triangle.
- * The code below is very tricky :)
+ * Picks the mip level from the texel footprint of a pixel, given the derivatives of s and t along x and y.
+ * rho^2 is the squared length of the longest footprint axis in texels of level 0, and the level is
+ * round(log2(rho)), read off the float exponent (the mantissa makes it a piecewise linear log2).
+ * rho <= 1 is magnification.
  */
-
-void ZB_fillTriangleSmooth(ZBuffer* zb, ZBufferPoint* p0, ZBufferPoint* p1, ZBufferPoint* p2) {
-	GLubyte zbdw = zb->depth_write;
-	GLubyte zbdt = zb->depth_test;
-	TGL_BLEND_VARS
-	TGL_STIPPLEVARS
-
-#define INTERP_Z
-#define INTERP_RGB
-
-#define SAR_RND_TO_ZERO(v, n) (v / (1 << n))
-
-#if TGL_FEATURE_RENDER_BITS == 32
-#define DRAW_INIT()                                                                                                                                            \
-	{}
-#define PUT_PIXEL(_a)                                                                                                                                          \
-	{                                                                                                                                                          \
-		{                                                                                                                                                      \
-			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
-			if (ZCMPSIMP(zz, pz[_a], _a, 0)) {                                                                                                                 \
-				/*pp[_a] = RGB_TO_PIXEL(or1, og1, ob1);*/                                                                                                      \
-				TGL_BLEND_FUNC_RGB(or1, og1, ob1, (pp[_a]));                                                                                                   \
-				if (zbdw)                                                                                                                                      \
-					pz[_a] = zz;                                                                                                                               \
-			}                                                                                                                                                  \
-		}                                                                                                                                                      \
-		z += dzdx;                                                                                                                                             \
-		og1 += dgdx;                                                                                                                                           \
-		or1 += drdx;                                                                                                                                           \
-		ob1 += dbdx;                                                                                                                                           \
-	}
-
-
-#elif TGL_FEATURE_RENDER_BITS == 16
-
-#define DRAW_INIT()                                                                                                                                            \
-	{}
-
-#define PUT_PIXEL(_a)                                                                                                                                          \
-	{                                                                                                                                                          \
-		{                                                                                                                                                      \
-			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
-			if (ZCMPSIMP(zz, pz[_a], _a, 0)) {                                                                                                                 \
-				/*pp[_a] = RGB_TO_PIXEL(or1, og1, ob1);*/                                                                                                      \
-				TGL_BLEND_FUNC_RGB(or1, og1, ob1, (pp[_a]));                                                                                                   \
-                                                                                                                                                               \
-				if (zbdw)                                                                                                                                      \
-					pz[_a] = zz;                                                                                                                               \
-			}                                                                                                                                                  \
-		}                                                                                                                                                      \
-		z += dzdx;                                                                                                                                             \
-		og1 += dgdx;                                                                                                                                           \
-		or1 += drdx;                                                                                                                                           \
-		ob1 += dbdx;                                                                                                                                           \
+static inline PIXEL* ZB_textureLevel(ZBuffer* zb, GLint* xsize, GLint* ysize, GLint* linear, GLfloat dsdx, GLfloat dtdx, GLfloat dsdy, GLfloat dtdy) {
+	union {
+		GLfloat f;
+		GLint i;
+	} rho2;
+	GLfloat x, y;
+	GLint l;
+	x = (GLfloat)zb->texture_xsize / (1 << ZB_ST_FRAC_BITS);
+	y = (GLfloat)zb->texture_ysize / (1 << (ZB_ST_FRAC_BITS + ZB_POINT_T_FRAC_BITS - ZB_POINT_S_FRAC_BITS));
+	dsdx *= x;
+	dsdy *= x;
+	dtdx *= y;
+	dtdy *= y;
+	x = dsdx * dsdx + dtdx * dtdx;
+	y = dsdy * dsdy + dtdy * dtdy;
+	rho2.f = x > y ? x : y;
+	if (rho2.i <= (127 << 23)) {
+		*xsize = zb->texture_xsize;
+		*ysize = zb->texture_ysize;
+		*linear = zb->texture_mag_linear;
+		return zb->texture_levels[0];
 	}
+	l = (rho2.i - (127 << 23) + (1 << 23)) >> 24;
+	if (l > zb->texture_max_level)
+		l = zb->texture_max_level;
+	*xsize = ZB_TEXTURE_LEVEL_SIZE(zb->texture_xsize, l);
+	*ysize = ZB_TEXTURE_LEVEL_SIZE(zb->texture_ysize, l);
+	*linear = zb->texture_min_linear;
+	return zb->texture_levels[l];
+}
 
+/*
+ * Bilinear filtering with 8 bit weights. The channels are weighted two at a time:
+ * 0x00rr00bb and 0x00aa00gg in 32 bit mode, 0x0gg0rb (the 5R6G5B channels spread apart) in 16 bit mode.
+ */
+#if TGL_FEATURE_RENDER_BITS == 32
+#define TEXEL_LERP(a, b, f)                                                                                                                                    \
+	(((((a) & 0xff00ff) * (256 - (f)) + ((b) & 0xff00ff) * (f)) >> 8) & 0xff00ff) |                                                                            \
+		(((((a) >> 8) & 0xff00ff) * (256 - (f)) + (((b) >> 8) & 0xff00ff) * (f)) & 0xff00ff00)
+#else
+#define TEXEL_SPREAD(c) (((c) | ((c) << 16)) & 0x07e0f81f)
+#define TEXEL_LERP(a, b, f) ((((a) * (32 - ((f) >> 3)) + (b) * ((f) >> 3)) >> 5) & 0x07e0f81f)
 #endif
 
-#include "ztriangle.h"
-} 
-
-void ZB_fillTriangleSmoothNOBLEND(ZBuffer* zb, ZBufferPoint* p0, ZBufferPoint* p1, ZBufferPoint* p2) {
-
-	GLubyte zbdw = zb->depth_write;
-	GLubyte zbdt = zb->depth_test;
-	TGL_STIPPLEVARS
+static inline PIXEL ZB_textureBilinear(PIXEL* texture, GLuint s, GLuint t, GLint xsize, GLint ysize) {
+	GLint x0, x1, y0, y1, fx, fy;
+	GLuint c0, c1;
+	/* texel coordinates with 8 fractional bits. texel centers are half a texel in */
+	x0 = (GLint)((ZB_S_FRAC(s) * xsize) >> (ZB_ST_FRAC_BITS - 8)) - 128;
+	y0 = (GLint)((ZB_T_FRAC(t) * ysize) >> (ZB_ST_FRAC_BITS - 8)) - 128;
+	if (x0 < 0)
+		x0 += xsize << 8;
+	if (y0 < 0)
+		y0 += ysize << 8;
+	fx = x0 & 0xff;
+	fy = y0 & 0xff;
+	x0 >>= 8;
+	y0 >>= 8;
+	x1 = x0 + 1 < xsize ? x0 + 1 : 0;
+	y1 = (y0 + 1 < ysize ? y0 + 1 : 0) * xsize;
+	y0 *= xsize;
+#if TGL_FEATURE_RENDER_BITS == 32
+	c0 = TEXEL_LERP(texture[x0 + y0], texture[x1 + y0], fx);
+	c1 = TEXEL_LERP(texture[x0 + y1], texture[x1 + y1], fx);
+	return TEXEL_LERP(c0, c1, fy);
+#else
+	c0 = TEXEL_LERP(TEXEL_SPREAD(texture[x0 + y0]), TEXEL_SPREAD(texture[x1 + y0]), fx);
+	c1 = TEXEL_LERP(TEXEL_SPREAD(texture[x0 + y1]), TEXEL_SPREAD(texture[x1 + y1]), fx);
+	c0 = TEXEL_LERP(c0, c1, fy);
+	return (PIXEL)(c0 | (c0 >> 16));
+#endif
+}
 
-#define INTERP_Z
-#define INTERP_RGB
+#endif
 
-#define SAR_RND_TO_ZERO(v, n) (v / (1 << n))
+#if TGL_FEATURE_TEXTURE_COMPRESSION == 1
 
+/* 5R6G5B to a texel, the 8 bit channels are rounded the usual way: the top bits repeat in the bottom */
 #if TGL_FEATURE_RENDER_BITS == 32
-#define DRAW_INIT()                                                                                                                                            \
-	{}
-
-#if TGL_FEATURE_NO_DRAW_COLOR != 1
-#define PUT_PIXEL(_a)                                                                                                                                          \
-	{                                                                                                                                                          \
-		{                                                                                                                                                      \
-			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
-			if (ZCMPSIMP(zz, pz[_a], _a, 0)) {                                                                                                                 \
-				pp[_a] = RGB_TO_PIXEL(or1, og1, ob1);                                                                                                          \
-				if (zbdw)                                                                                                                                      \
-					pz[_a] = zz;                                                                                                                               \
-			}                                                                                                                                                  \
-		}                                                                                                                                                      \
-		z += dzdx;                                                                                                                                             \
-		og1 += dgdx;                                                                                                                                           \
-		or1 += drdx;                                                                                                                                           \
-		ob1 += dbdx;                                                                                                                                           \
-	}
+#define BC1_TEXEL(r, g, b) (0xff000000 | ((r) << 16) | ((g) << 8) | (b))
 #else
-#define PUT_PIXEL(_a)                                                                                                                                          \
-	{                                                                                                                                                          \
-		{                                                                                                                                                      \
-			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
-			/*c = RGB_TO_PIXEL(or1, og1, ob1);*/                                                                                                               \
-			if (ZCMPSIMP(zz, pz[_a], _a, 0)) {                                                                                                                 \
-				pp[_a] = RGB_TO_PIXEL(or1, og1, ob1);                                                                                                          \
-				if (zbdw)                                                                                                                                      \
-					pz[_a] = zz;                                                                                                                               \
-			}                                                                                                                                                  \
-		}                                                                                                                                                      \
-		z += dzdx;                                                                                                                                             \
-		og1 += dgdx;                                                                                                                                           \
-		or1 += drdx;                                                                                                                                           \
-		ob1 += dbdx;                                                                                                                                           \
-	}
+#define BC1_TEXEL(r, g, b) ((((r) & 0xf8) << 8) | (((g) & 0xfc) << 3) | ((b) >> 3))
 #endif
 
-#elif TGL_FEATURE_RENDER_BITS == 16
+/* the palette of a block: two colors, and two blends of them or one blend and black */
+static void ZB_decodeBC1(PIXEL* palette, const GLubyte* block) {
+	GLuint c0 = block[0] | (block[1] << 8), c1 = block[2] | (block[3] << 8);
+	GLint r0 = (c0 >> 8) & 0xf8, g0 = (c0 >> 3) & 0xfc, b0 = (c0 << 3) & 0xf8;
+	GLint r1 = (c1 >> 8) & 0xf8, g1 = (c1 >> 3) & 0xfc, b1 = (c1 << 3) & 0xf8;
+	r0 |= r0 >> 5;
+	g0 |= g0 >> 6;
+	b0 |= b0 >> 5;
+	r1 |= r1 >> 5;
+	g1 |= g1 >> 6;
+	b1 |= b1 >> 5;
+	palette[0] = BC1_TEXEL(r0, g0, b0);
+	palette[1] = BC1_TEXEL(r1, g1, b1);
+	if (c0 > c1) {
+		palette[2] = BC1_TEXEL((2 * r0 + r1) / 3, (2 * g0 + g1) / 3, (2 * b0 + b1) / 3);
+		palette[3] = BC1_TEXEL((r0 + 2 * r1) / 3, (g0 + 2 * g1) / 3, (b0 + 2 * b1) / 3);
+	} else {
+		/* the transparent texel of 1 bit alpha BC1, RGB images are opaque */
+		palette[2] = BC1_TEXEL((r0 + r1) / 2, (g0 + g1) / 2, (b0 + b1) / 2);
+		palette[3] = BC1_TEXEL(0, 0, 0);
+	}
+}
 
-#define DRAW_INIT()                                                                                                                                            \
-	{}
-
-#define PUT_PIXEL(_a)                                                                                                                                          \
-	{                                                                                                                                                          \
-		{                                                                                                                                                      \
-			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
-			if (ZCMPSIMP(zz, pz[_a], _a, 0)) {                                                                                                                 \
-				pp[_a] = RGB_TO_PIXEL(or1, og1, ob1);                                                                                                          \
-                                                                                                                                                               \
-				if (zbdw)                                                                                                                                      \
-					pz[_a] = zz;                                                                                                                               \
-			}                                                                                                                                                  \
-		}                                                                                                                                                      \
-		z += dzdx;                                                                                                                                             \
-		og1 += dgdx;                                                                                                                                           \
-		or1 += drdx;                                                                                                                                           \
-		ob1 += dbdx;                                                                                                                                           \
+/* texel (s, t) of a BC1 texture of any size, the palette of its block is decoded into the cache first if needed */
+static inline PIXEL ZB_textureBC1(ZBBlockCache* cache, const GLubyte* blocks, GLuint s, GLuint t, GLint xsize, GLint ysize) {
+	GLint x = (ZB_S_FRAC(s) * xsize) >> ZB_ST_FRAC_BITS;
+	GLint y = (ZB_T_FRAC(t) * ysize) >> ZB_ST_FRAC_BITS;
+	GLint b = (y >> 2) * ((xsize + 3) >> 2) + (x >> 2);
+	GLint e = b & (ZB_BLOCK_CACHE_SIZE - 1);
+	if (cache->block[e] != b + 1) {
+		const GLubyte* block = blocks + b * ZB_BC1_BLOCK_SIZE;
+		cache->block[e] = b + 1;
+		cache->bits[e] = block[4] | (block[5] << 8) | (block[6] << 16) | ((GLuint)block[7] << 24);
+		ZB_decodeBC1(cache->palette[e], block);
 	}
+	return cache->palette[e][(cache->bits[e] >> (((x & 3) | ((y & 3) << 2)) << 1)) & 3];
+}
 
 #endif
-/* End of 16 bit mode stuff*/
-#include "ztriangle.h"
-} 
 
 /*
+ * The kernels are compiled once per common depth function, with the comparison built into ZCMP
+ * instead of being selected per pixel. The GL_LEQUAL set keeps the public names and still
+ * honours zb->depth_test at runtime, so it can be called directly like it always could.
+ * Note that larger z is closer: GL_LESS passes when z > zpix.
+ */
 
+/* two steps, so that the kernel name can itself be a macro (see ztritex.h) */
+#define ZB_PASTE_(a, b) a##b
+#define ZB_PASTE(a, b) ZB_PASTE_(a, b)
+
+#define ZB_DEPTH_KERNEL(name) void name
+#define TGL_DEPTHVARS GLubyte zbdt = zb->depth_test;
+#define ZB_DEPTH_TEST(z, zpix) (!zbdt) || (z >= zpix)
+#define ZB_DEPTH_SPANS 1
+#define ZB_DEPTH_SPAN_ZBDT zbdt
+#include "ztrifill.h"
+
+#if TGL_FEATURE_DEPTH_FUNC == 1
+
+#define ZB_DEPTH_KERNEL(name) static void ZB_PASTE(name, Always)
+#define TGL_DEPTHVARS /* a comment */
+#define ZB_DEPTH_TEST(z, zpix) 1
+#define ZB_DEPTH_SPANS 1
+#define ZB_DEPTH_SPAN_ZBDT 0
+#include "ztrifill.h"
+
+#define ZB_DEPTH_KERNEL(name) static void ZB_PASTE(name, Less)
+#define TGL_DEPTHVARS /* a comment */
+#define ZB_DEPTH_TEST(z, zpix) z > zpix
+#define ZB_DEPTH_SPANS 0
+#define ZB_DEPTH_SPAN_ZBDT 0
+#include "ztrifill.h"
+
+#define ZB_DEPTH_KERNEL(name) static void ZB_PASTE(name, Equal)
+#define TGL_DEPTHVARS /* a comment */
+#define ZB_DEPTH_TEST(z, zpix) z == zpix
+#define ZB_DEPTH_SPANS 0
+#define ZB_DEPTH_SPAN_ZBDT 0
+#include "ztrifill.h"
 
-			TEXTURE MAPPED TRIANGLES
-               Section_Header
-
-
-
-
-*/
-void ZB_setTexture(ZBuffer* zb, PIXEL* texture) { zb->current_texture = texture; }
-
-
-#if 1
-
-#define DRAW_LINE_TRI_TEXTURED()                                                                                                                               \
-	{                                                                                                                                                          \
-		register GLushort* pz;                                                                                                                                 \
-		register PIXEL* pp;                                                                                                                                    \
-		register GLuint s, t, z;                                                                                                                               \
-		register GLint n;                                                                                                                                      \
-		OR1OG1OB1DECL                                                                                                                                          \
-		GLfloat sz, tz, fzl, zinv;                                                                                                                             \
-		n = (x2 >> 16) - x1;                                                                                                                                   \
-		fzl = (GLfloat)z1;                                                                                                                                     \
-		zinv = 1.0 / fzl;                                                                                                                                      \
-		pp = (PIXEL*)((GLbyte*)pp1 + x1 * PSZB);                                                                                                               \
-		pz = pz1 + x1;                                                                                                                                         \
-		z = z1;                                                                                                                                                \
-		sz = sz1;                                                                                                                                              \
-		tz = tz1;                                                                                                                                              \
-		while (n >= (NB_INTERP - 1)) {                                                                                                                         \
-			register GLint dsdx, dtdx;                                                                                                                         \
-			{                                                                                                                                                  \
-				GLfloat ss, tt;                                                                                                                                \
-				ss = (sz * zinv);                                                                                                                              \
-				tt = (tz * zinv);                                                                                                                              \
-				s = (GLint)ss;                                                                                                                                 \
-				t = (GLint)tt;                                                                                                                                 \
-				dsdx = (GLint)((dszdx - ss * fdzdx) * zinv);                                                                                                   \
-				dtdx = (GLint)((dtzdx - tt * fdzdx) * zinv);                                                                                                   \
-			}                                                                                                                                                  \
-			fzl += fndzdx;                                                                                                                                     \
-			zinv = 1.0 / fzl;                                                                                                                                  \
-			PUT_PIXEL(0); /*the_x++;*/                                                                                                                         \
-			PUT_PIXEL(1); /*the_x++;*/                                                                                                                         \
-			PUT_PIXEL(2); /*the_x++;*/                                                                                                                         \
-			PUT_PIXEL(3); /*the_x++;*/                                                                                                                         \
-			PUT_PIXEL(4); /*the_x++;*/                                                                                                                         \
-			PUT_PIXEL(5); /*the_x++;*/                                                                                                                         \
-			PUT_PIXEL(6); /*the_x++;*/                                                                                                                         \
-			PUT_PIXEL(7); /*the_x-=7;*/                                                                                                                        \
-			pz += NB_INTERP;                                                                                                                                   \
-			pp += NB_INTERP; /*the_x+=NB_INTERP * PSZB;*/                                                                                                      \
-			n -= NB_INTERP;                                                                                                                                    \
-			sz += ndszdx;                                                                                                                                      \
-			tz += ndtzdx;                                                                                                                                      \
-		}                                                                                                                                                      \
-		{                                                                                                                                                      \
-			register GLint dsdx, dtdx;                                                                                                                         \
-			{                                                                                                                                                  \
-				GLfloat ss, tt;                                                                                                                                \
-				ss = (sz * zinv);                                                                                                                              \
-				tt = (tz * zinv);                                                                                                                              \
-				s = (GLint)ss;                                                                                                                                 \
-				t = (GLint)tt;                                                                                                                                 \
-				dsdx = (GLint)((dszdx - ss * fdzdx) * zinv);                                                                                                   \
-				dtdx = (GLint)((dtzdx - tt * fdzdx) * zinv);                                                                                                   \
-			}                                                                                                                                                  \
-			while (n >= 0) {                                                                                                                                   \
-				PUT_PIXEL(0);                                                                                                                                  \
-				pz += 1;                                                                                                                                       \
-				/*pp = (PIXEL*)((GLbyte*)pp + PSZB);*/                                                                                                         \
-				pp++;                                                                                                                                          \
-				n -= 1;                                                                                                                                        \
-			}                                                                                                                                                  \
-		}                                                                                                                                                      \
-	} 
-
-void ZB_fillTriangleMappingPerspective(ZBuffer* zb, ZBufferPoint* p0, ZBufferPoint* p1, ZBufferPoint* p2) {
-	PIXEL* texture;
-
-	GLubyte zbdw = zb->depth_write;
-	GLubyte zbdt = zb->depth_test;
-	TGL_BLEND_VARS
-	TGL_STIPPLEVARS
-#define INTERP_Z
-#define INTERP_STZ
-#define INTERP_RGB
-
-
-#define NB_INTERP 8
-
-#define DRAW_INIT()                                                                                                                                            \
-	{                                                                                                                                                          \
-		texture = zb->current_texture;                                                                                                                         \
-		fdzdx = (GLfloat)dzdx;                                                                                                                                 \
-		fndzdx = NB_INTERP * fdzdx;                                                                                                                            \
-		ndszdx = NB_INTERP * dszdx;                                                                                                                            \
-		ndtzdx = NB_INTERP * dtzdx;                                                                                                                            \
-	}
-#if TGL_FEATURE_LIT_TEXTURES == 1
-#define OR1OG1OB1DECL                                                                                                                                          \
-	register GLint or1, og1, ob1;                                                                                                                              \
-	or1 = r1;                                                                                                                                                  \
-	og1 = g1;                                                                                                                                                  \
-	ob1 = b1;
-#define OR1G1B1INCR                                                                                                                                            \
-	og1 += dgdx;                                                                                                                                               \
-	or1 += drdx;                                                                                                                                               \
-	ob1 += dbdx;
+/*
+ * GL_GREATER, GL_GEQUAL and GL_NOTEQUAL share one set that compares at runtime. The low three bits of
+ * the function are its less, equal and greater flags (GL_LEQUAL is 0x203), so the test is branch free.
+ */
+#define ZB_DEPTH_KERNEL(name) static void ZB_PASTE(name, Other)
+#define TGL_DEPTHVARS GLint zbdf = zb->depth_func & 7;
+#define ZB_DEPTH_TEST(z, zpix) (((z > zpix) | ((z == zpix) << 1) | ((z < zpix) << 2)) & zbdf)
+#define ZB_DEPTH_SPANS 0
+#define ZB_DEPTH_SPAN_ZBDT 0
+#include "ztrifill.h"
+
+/* GL_NEVER: nothing passes */
+static void ZB_fillTriangleNever(ZBuffer* zb, ZBufferPoint* p0, ZBufferPoint* p1, ZBufferPoint* p2) {}
+#define ZB_FILL_NEVER {ZB_fillTriangleNever, ZB_fillTriangleNever}
+#if TGL_FEATURE_TEXTURE_FILTER == 1
+#define ZB_FILL_NEVER_FILTERED , ZB_FILL_NEVER
 #else
-#define OR1OG1OB1DECL /*A comment*/
-#define OR1G1B1INCR   /*Another comment*/
-#define or1 COLOR_MULT_MASK
-#define og1 COLOR_MULT_MASK
-#define ob1 COLOR_MULT_MASK
+#define ZB_FILL_NEVER_FILTERED /* a comment */
 #endif
-#if TGL_FEATURE_NO_DRAW_COLOR != 1
-
-#define PUT_PIXEL(_a)                                                                                                                                          \
-	{                                                                                                                                                          \
-		{                                                                                                                                                      \
-			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
-			if (ZCMPSIMP(zz, pz[_a], _a, 0)) {                                                                                                                 \
-				/*pp[_a] = RGB_MIX_FUNC(or1, og1, ob1, TEXTURE_SAMPLE(texture, s, t));*/                                                                       \
-				TGL_BLEND_FUNC(RGB_MIX_FUNC(or1, og1, ob1, (TEXTURE_SAMPLE(texture, s, t))), (pp[_a]));                                                        \
-				if (zbdw)                                                                                                                                      \
-					pz[_a] = zz;                                                                                                                               \
-			}                                                                                                                                                  \
-		}                                                                                                                                                      \
-		z += dzdx;                                                                                                                                             \
-		s += dsdx;                                                                                                                                             \
-		t += dtdx;                                                                                                                                             \
-		OR1G1B1INCR                                                                                                                                            \
-	}
+#if TGL_FEATURE_TEXTURE_COMPRESSION == 1
+#define ZB_FILL_NEVER_BC1 , ZB_FILL_NEVER
 #else
-#define PUT_PIXEL(_a)                                                                                                                                          \
-	{                                                                                                                                                          \
-		{                                                                                                                                                      \
-			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
-			PIXEL c = TEXTURE_SAMPLE(texture, s, t);                                                                                                           \
-			if (ZCMP(zz, pz[_a], _a, c)) {                                                                                                                     \
-				TGL_BLEND_FUNC(RGB_MIX_FUNC(or1, og1, ob1, c), (pp[_a]));                                                                                      \
-				if (zbdw)                                                                                                                                      \
-					pz[_a] = zz;                                                                                                                               \
-			}                                                                                                                                                  \
-		}                                                                                                                                                      \
-		z += dzdx;                                                                                                                                             \
-		s += dsdx;                                                                                                                                             \
-		t += dtdx;                                                                                                                                             \
-		OR1G1B1INCR                                                                                                                                            \
-	}
+#define ZB_FILL_NEVER_BC1 /* a comment */
+#endif
+#define ZB_FILL_NEVER_SET {ZB_FILL_NEVER, ZB_FILL_NEVER, ZB_FILL_NEVER, ZB_FILL_NEVER, ZB_FILL_NEVER ZB_FILL_NEVER_FILTERED ZB_FILL_NEVER_BC1}
+#if TGL_FEATURE_HALFSPACE_RASTER == 1
+#define ZB_FILL_DEPTH_NEVER {ZB_FILL_NEVER_SET, ZB_FILL_NEVER_SET}
+#else
+#define ZB_FILL_DEPTH_NEVER {ZB_FILL_NEVER_SET}
 #endif
-#define DRAW_LINE()                                                                                                                                            \
-	{ DRAW_LINE_TRI_TEXTURED() }
 
-#include "ztriangle.h"
-}
+#define ZB_FILL_SET(_s)                                                                                                                                        \
+	{{ZB_fillTriangleFlatNOBLEND##_s, ZB_fillTriangleFlat##_s},                                                                                               \
+	 {ZB_fillTriangleSmoothNOBLEND##_s, ZB_fillTriangleSmooth##_s},                                                                                           \
+	 {ZB_fillTriangleMappingPerspectiveNOBLEND##_s, ZB_fillTriangleMappingPerspective##_s},                                                                   \
+	 {ZB_fillTriangleDepthOnly##_s, ZB_fillTriangleDepthOnly##_s},                                                                                           \
+	 {ZB_fillTriangleMappingPerspectiveSizedNOBLEND##_s, ZB_fillTriangleMappingPerspectiveSized##_s} ZB_FILL_FILTERED(_s) ZB_FILL_BC1(_s)}
+#define ZB_FILL_SET_HALFSPACE(_s)                                                                                                                              \
+	{{ZB_fillTriangleHalfSpaceFlatNOBLEND##_s, ZB_fillTriangleHalfSpaceFlat##_s},                                                                             \
+	 {ZB_fillTriangleHalfSpaceSmoothNOBLEND##_s, ZB_fillTriangleHalfSpaceSmooth##_s},                                                                         \
+	 {ZB_fillTriangleHalfSpaceMappingPerspectiveNOBLEND##_s, ZB_fillTriangleHalfSpaceMappingPerspective##_s},                                                 \
+	 {ZB_fillTriangleHalfSpaceDepthOnly##_s, ZB_fillTriangleHalfSpaceDepthOnly##_s},                                                                         \
+	 {ZB_fillTriangleHalfSpaceMappingPerspectiveSizedNOBLEND##_s, ZB_fillTriangleHalfSpaceMappingPerspectiveSized##_s} ZB_FILL_FILTERED_HALFSPACE(_s) ZB_FILL_BC1_HALFSPACE(_s)}
 
-void ZB_fillTriangleMappingPerspectiveNOBLEND(ZBuffer* zb, ZBufferPoint* p0, ZBufferPoint* p1, ZBufferPoint* p2) {
-	PIXEL* texture;
-	
-	GLubyte zbdw = zb->depth_write;
-	GLubyte zbdt = zb->depth_test;
-	TGL_STIPPLEVARS
-#define INTERP_Z
-#define INTERP_STZ
-#define INTERP_RGB
-
-#define NB_INTERP 8
-
-#define DRAW_INIT()                                                                                                                                            \
-	{                                                                                                                                                          \
-		texture = zb->current_texture;                                                                                                                         \
-		fdzdx = (GLfloat)dzdx;                                                                                                                                 \
-		fndzdx = NB_INTERP * fdzdx;                                                                                                                            \
-		ndszdx = NB_INTERP * dszdx;                                                                                                                            \
-		ndtzdx = NB_INTERP * dtzdx;                                                                                                                            \
-	}
-#if TGL_FEATURE_LIT_TEXTURES == 1
-#define OR1OG1OB1DECL                                                                                                                                          \
-	register GLint or1, og1, ob1;                                                                                                                              \
-	or1 = r1;                                                                                                                                                  \
-	og1 = g1;                                                                                                                                                  \
-	ob1 = b1;
-#define OR1G1B1INCR                                                                                                                                            \
-	og1 += dgdx;                                                                                                                                               \
-	or1 += drdx;                                                                                                                                               \
-	ob1 += dbdx;
 #else
-#define OR1OG1OB1DECL /*A comment*/
-#define OR1G1B1INCR   /*Another comment*/
-#define or1 COLOR_MULT_MASK
-#define og1 COLOR_MULT_MASK
-#define ob1 COLOR_MULT_MASK
+
+/* glDepthFunc is recorded, but every function draws with GL_LEQUAL */
+#define ZB_FILL_DEPTH_NEVER ZB_FILL_DEPTH()
+#define ZB_FILL_SET(_s)                                                                                                                                        \
+	{{ZB_fillTriangleFlatNOBLEND, ZB_fillTriangleFlat},                                                                                                       \
+	 {ZB_fillTriangleSmoothNOBLEND, ZB_fillTriangleSmooth},                                                                                                   \
+	 {ZB_fillTriangleMappingPerspectiveNOBLEND, ZB_fillTriangleMappingPerspective},                                                                           \
+	 {ZB_fillTriangleDepthOnly, ZB_fillTriangleDepthOnly},                                                                                                   \
+	 {ZB_fillTriangleMappingPerspectiveSizedNOBLEND, ZB_fillTriangleMappingPerspectiveSized} ZB_FILL_FILTERED() ZB_FILL_BC1()}
+#define ZB_FILL_SET_HALFSPACE(_s)                                                                                                                              \
+	{{ZB_fillTriangleHalfSpaceFlatNOBLEND, ZB_fillTriangleHalfSpaceFlat},                                                                                     \
+	 {ZB_fillTriangleHalfSpaceSmoothNOBLEND, ZB_fillTriangleHalfSpaceSmooth},                                                                                 \
+	 {ZB_fillTriangleHalfSpaceMappingPerspectiveNOBLEND, ZB_fillTriangleHalfSpaceMappingPerspective},                                                         \
+	 {ZB_fillTriangleHalfSpaceDepthOnly, ZB_fillTriangleHalfSpaceDepthOnly},                                                                                 \
+	 {ZB_fillTriangleHalfSpaceMappingPerspectiveSizedNOBLEND, ZB_fillTriangleHalfSpaceMappingPerspectiveSized} ZB_FILL_FILTERED_HALFSPACE() ZB_FILL_BC1_HALFSPACE()}
+
 #endif
-#if TGL_FEATURE_NO_DRAW_COLOR != 1
-#define PUT_PIXEL(_a)                                                                                                                                          \
-	{                                                                                                                                                          \
-		{                                                                                                                                                      \
-			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
-			if (ZCMPSIMP(zz, pz[_a], _a, 0)) {                                                                                                                 \
-				pp[_a] = RGB_MIX_FUNC(or1, og1, ob1, TEXTURE_SAMPLE(texture, s, t));                                                                           \
-				if (zbdw)                                                                                                                                      \
-					pz[_a] = zz;                                                                                                                               \
-			}                                                                                                                                                  \
-		}                                                                                                                                                      \
-		z += dzdx;                                                                                                                                             \
-		s += dsdx;                                                                                                                                             \
-		t += dtdx;                                                                                                                                             \
-		OR1G1B1INCR                                                                                                                                            \
-	}
+
+#if TGL_FEATURE_TEXTURE_FILTER == 1
+#define ZB_FILL_FILTERED(_s) , {ZB_fillTriangleMappingPerspectiveFilteredNOBLEND##_s, ZB_fillTriangleMappingPerspectiveFiltered##_s}
+#define ZB_FILL_FILTERED_HALFSPACE(_s) , {ZB_fillTriangleHalfSpaceMappingPerspectiveFilteredNOBLEND##_s, ZB_fillTriangleHalfSpaceMappingPerspectiveFiltered##_s}
 #else
-#define PUT_PIXEL(_a)                                                                                                                                          \
-	{                                                                                                                                                          \
-		{                                                                                                                                                      \
-			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
-			PIXEL c = TEXTURE_SAMPLE(texture, s, t);                                                                                                           \
-			if (ZCMP(zz, pz[_a], _a, c)) {                                                                                                                     \
-				pp[_a] = RGB_MIX_FUNC(or1, og1, ob1, c);                                                                                                       \
-				/*TGL_BLEND_FUNC(RGB_MIX_FUNC(or1, og1, ob1, c), (pp[_a]));*/                                                                                  \
-				if (zbdw)                                                                                                                                      \
-					pz[_a] = zz;                                                                                                                               \
-			}                                                                                                                                                  \
-		}                                                                                                                                                      \
-		z += dzdx;                                                                                                                                             \
-		s += dsdx;                                                                                                                                             \
-		t += dtdx;                                                                                                                                             \
-		OR1G1B1INCR                                                                                                                                            \
-	}
+#define ZB_FILL_FILTERED(_s) /* a comment */
+#define ZB_FILL_FILTERED_HALFSPACE(_s) /* a comment */
+#endif
+#if TGL_FEATURE_TEXTURE_COMPRESSION == 1
+#define ZB_FILL_BC1(_s) , {ZB_fillTriangleMappingPerspectiveBC1NOBLEND##_s, ZB_fillTriangleMappingPerspectiveBC1##_s}
+#define ZB_FILL_BC1_HALFSPACE(_s) , {ZB_fillTriangleHalfSpaceMappingPerspectiveBC1NOBLEND##_s, ZB_fillTriangleHalfSpaceMappingPerspectiveBC1##_s}
+#else
+#define ZB_FILL_BC1(_s) /* a comment */
+#define ZB_FILL_BC1_HALFSPACE(_s) /* a comment */
+#endif
+
+#if TGL_FEATURE_HALFSPACE_RASTER == 1
+#define ZB_FILL_DEPTH(_s) {ZB_FILL_SET(_s), ZB_FILL_SET_HALFSPACE(_s)}
+#else
+#define ZB_FILL_DEPTH(_s) {ZB_FILL_SET(_s)}
 #endif
-#define DRAW_LINE()                                                                                                                                            \
-	{ DRAW_LINE_TRI_TEXTURED() }
-#include "ztriangle.h"
-}
 
-#endif 
+const ZB_fillTriangleFunc ZB_fillTriangleFuncs[8][ZB_RASTERIZERS][ZB_FILL_MODES][2] = {
+	ZB_FILL_DEPTH_NEVER,	 /* GL_NEVER */
+	ZB_FILL_DEPTH(Less),	 /* GL_LESS */
+	ZB_FILL_DEPTH(Equal),	 /* GL_EQUAL */
+	ZB_FILL_DEPTH(),		 /* GL_LEQUAL */
+	ZB_FILL_DEPTH(Other),	 /* GL_GREATER */
+	ZB_FILL_DEPTH(Other),	 /* GL_NOTEQUAL */
+	ZB_FILL_DEPTH(Other),	 /* GL_GEQUAL */
+	ZB_FILL_DEPTH(Always),	 /* GL_ALWAYS */
+};
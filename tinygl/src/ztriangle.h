@@ -21,14 +21,15 @@ Things to keep in mind:
 
 {
 	GLfloat fdx1, fdx2, fdy1, fdy2;
-	GLushort* pz1;
+	ZPIXEL* pz1;
 	PIXEL* pp1;
 
 	GLint part;
 	GLint dx1, dy1, dx2, dy2;
-#if TGL_FEATURE_POLYGON_STIPPLE == 1
 	GLint the_y;
-#endif
+	/* scissor rectangle, inclusive. see ZBuffer clip_* */
+	GLint cxmin = zb->clip_xmin, cxmax = zb->clip_xmax;
+	GLint cymin = zb->clip_ymin, cymax = zb->clip_ymax;
 	GLint error, derror;
 	GLint x1, dxdy_min, dxdy_max;
 	/* warning: x2 is multiplied by 2^16 */
@@ -42,6 +43,9 @@ Things to keep in mind:
 	GLint g1, dgdx, dgdy, dgdl_min, dgdl_max;
 	GLint b1, dbdx, dbdy, dbdl_min, dbdl_max;
 #endif
+#ifdef INTERP_ALPHA
+	GLint a1, dadx, dady, dadl_min, dadl_max;
+#endif
 #ifdef INTERP_ST
 	GLint s1, dsdx, dsdy, dsdl_min, dsdl_max;
 	GLint t1, dtdx, dtdy, dtdl_min, dtdl_max;
@@ -69,6 +73,12 @@ Things to keep in mind:
 		p2 = t;
 	}
 
+#if TGL_FEATURE_HIZ == 1
+	/* entirely behind what the zbuffer already holds */
+	if (ZB_hizTriangle(zb, p0, p1, p2))
+		return;
+#endif
+
 	/* we compute dXdx and dXdy for all GLinterpolated values */
 	fdx1 = p1->x - p0->x; 
 	fdy1 = p1->y - p0->y; 
@@ -122,6 +132,15 @@ Things to keep in mind:
 		}
 #endif
 
+#ifdef INTERP_ALPHA
+		{
+			d1 = p1->a - p0->a;
+			d2 = p2->a - p0->a;
+			dadx = (GLint)(fdy2 * d1 - fdy1 * d2);
+			dady = (GLint)(fdx1 * d2 - fdx2 * d1);
+		}
+#endif
+
 #ifdef INTERP_ST
 		{
 			d1 = p1->s - p0->s;
@@ -167,9 +186,7 @@ Things to keep in mind:
 	/* screen coordinates */
 
 	pp1 = (PIXEL*)(zb->pbuf) + zb->xsize * p0->y; 
-#if TGL_FEATURE_POLYGON_STIPPLE == 1
 	the_y = p0->y;
-#endif
 	pz1 = zb->zbuf + p0->y * zb->xsize;
 
 	DRAW_INIT();
@@ -250,6 +267,11 @@ Things to keep in mind:
 				dbdl_min = (dbdy + dbdx * dxdy_min);
 				dbdl_max = dbdl_min + dbdx;
 #endif
+#ifdef INTERP_ALPHA
+				a1 = l1->a;
+				dadl_min = (dady + dadx * dxdy_min);
+				dadl_max = dadl_min + dadx;
+#endif
 #ifdef INTERP_ST
 				s1 = l1->s;
 				dsdl_min = (dsdy + dsdx * dxdy_min);
@@ -283,18 +305,26 @@ Things to keep in mind:
 
 		while (nb_lines > 0) {
 			nb_lines--;
+			/* scanlines below the scissor rectangle are never drawn */
+			if (the_y > cymax)
+				return;
+			/* scanlines above it only step the edges */
+			if (the_y >= cymin)
 #ifndef DRAW_LINE
 			/* generic draw line */
 			{
 				register PIXEL* pp;
 				register GLint n;
 #ifdef INTERP_Z
-				register GLushort* pz;
+				register ZPIXEL* pz;
 				register GLuint z;
 #endif
 #ifdef INTERP_RGB
 				register GLint or1, og1, ob1;
 #endif
+#ifdef INTERP_ALPHA
+				register GLint oa1;
+#endif
 #ifdef INTERP_ST
 				register GLuint s, t;
 #endif
@@ -314,6 +344,9 @@ Things to keep in mind:
 				og1 = g1;
 				ob1 = b1;
 #endif
+#ifdef INTERP_ALPHA
+				oa1 = a1;
+#endif
 #ifdef INTERP_ST
 				s = s1;
 				t = t1;
@@ -321,6 +354,32 @@ Things to keep in mind:
 #ifdef INTERP_STZ
 
 
+#endif
+				if ((x2 >> 16) > cxmax)
+					n -= (x2 >> 16) - cxmax;
+				if (x1 < cxmin) {
+					register GLint skip = cxmin - x1;
+					n -= skip;
+					pp += skip;
+#ifdef INTERP_Z
+					pz += skip;
+					z += skip * dzdx;
+#endif
+#ifdef INTERP_RGB
+					or1 += skip * drdx;
+					og1 += skip * dgdx;
+					ob1 += skip * dbdx;
+#endif
+#ifdef INTERP_ALPHA
+					oa1 += skip * dadx;
+#endif
+#ifdef INTERP_ST
+					s += skip * dsdx;
+					t += skip * dtdx;
+#endif
+				}
+#ifdef PUT_SPAN
+				PUT_SPAN();
 #endif
 				while (n >= 3) {
 					PUT_PIXEL(0); /*the_x++;*/
@@ -362,6 +421,9 @@ Things to keep in mind:
 				g1 += dgdl_max;
 				b1 += dbdl_max;
 #endif
+#ifdef INTERP_ALPHA
+				a1 += dadl_max;
+#endif
 #ifdef INTERP_ST
 				s1 += dsdl_max;
 				t1 += dtdl_max;
@@ -380,6 +442,9 @@ Things to keep in mind:
 				g1 += dgdl_min;
 				b1 += dbdl_min;
 #endif
+#ifdef INTERP_ALPHA
+				a1 += dadl_min;
+#endif
 #ifdef INTERP_ST
 				s1 += dsdl_min;
 				t1 += dtdl_min;
@@ -396,9 +461,7 @@ Things to keep in mind:
 			/* screen coordinates */
 			
 			pp1 += zb->xsize;
-#if TGL_FEATURE_POLYGON_STIPPLE == 1
 			the_y++;
-#endif
 			pz1 += zb->xsize;
 		}
 	}
@@ -406,9 +469,11 @@ Things to keep in mind:
 
 #undef INTERP_Z
 #undef INTERP_RGB
+#undef INTERP_ALPHA
 #undef INTERP_ST
 #undef INTERP_STZ
 
 #undef DRAW_INIT
 #undef DRAW_LINE
 #undef PUT_PIXEL
+#undef PUT_SPAN
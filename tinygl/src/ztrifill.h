@@ -0,0 +1,525 @@
+/*
+ * The triangle fill kernels. ztriangle.c includes this file once per depth function, with:
+ *
+ * ZB_DEPTH_KERNEL(name) - the return type and name of each kernel
+ * TGL_DEPTHVARS - locals ZB_DEPTH_TEST needs
+ * ZB_DEPTH_TEST(z, zpix) - the depth comparison, used by ZCMP
+ * ZB_DEPTH_SPANS - 1 if the vectorized span writers implement that comparison
+ * ZB_DEPTH_SPAN_ZBDT - their zbdt argument
+ */
+
+ZB_DEPTH_KERNEL(ZB_fillTriangleFlat)(ZBuffer* zb, ZBufferPoint* p0, ZBufferPoint* p1, ZBufferPoint* p2) {
+	TGL_DEPTHVARS
+	GLubyte zbdw = zb->depth_write;
+	GLuint color;
+	TGL_BLEND_VARS
+	TGL_STIPPLEVARS
+	TGL_BLENDSPANVARS
+
+#undef INTERP_Z
+#undef INTERP_RGB
+#undef INTERP_ST
+#undef INTERP_STZ
+
+#define INTERP_Z
+
+
+#define DRAW_INIT()                                                                                                                                            \
+	{ color = RGB_TO_PIXEL(p2->r, p2->g, p2->b); }
+
+#define PUT_PIXEL(_a)                                                                                                                                          \
+	{                                                                                                                                                          \
+		{                                                                                                                                                      \
+			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
+			if (ZCMPSIMP(zz, pz[_a], _a, color)) {                                                                                                             \
+				TGL_BLEND_FUNC(color, ZB_ALPHA(p2->a), (pp[_a])) /*pp[_a] = color;*/                                                                           \
+				if (zbdw)                                                                                                                                      \
+					pz[_a] = zz;                                                                                                                               \
+			}                                                                                                                                                  \
+		}                                                                                                                                                      \
+		z += dzdx;                                                                                                                                             \
+	}
+
+#if TGL_FEATURE_SIMD_SPANS == 1 && TGL_FEATURE_BLEND == 1
+#define PUT_SPAN()                                                                                                                                             \
+	if (zbspan && n >= 7) {                                                                                                                                    \
+		register GLint done = zbspan(pp, pz, n + 1, z, dzdx, GET_REDDER(color), GET_GREENER(color), GET_BLUEER(color), p2->a, 0, 0, 0, 0,                      \
+									 ZB_DEPTH_SPAN_ZBDT, zbdw);                                                                                                \
+		pp += done;                                                                                                                                            \
+		pz += done;                                                                                                                                            \
+		z += done * dzdx;                                                                                                                                      \
+		n -= done;                                                                                                                                             \
+	}
+#endif
+
+#include "ztriangle.h"
+}
+
+ZB_DEPTH_KERNEL(ZB_fillTriangleFlatNOBLEND)(ZBuffer* zb, ZBufferPoint* p0, ZBufferPoint* p1, ZBufferPoint* p2) {
+	PIXEL color = RGBA_TO_PIXEL(p2->r, p2->g, p2->b, ZB_ALPHA(p2->a));
+	GLubyte zbdw = zb->depth_write;
+	TGL_DEPTHVARS
+	TGL_STIPPLEVARS
+	TGL_SPANVARS(ZB_spanFlatFunc, span_flat)
+#undef INTERP_Z
+#undef INTERP_RGB
+#undef INTERP_ST
+#undef INTERP_STZ
+#define INTERP_Z
+
+#define DRAW_INIT()                                                                                                                                            \
+	{}
+
+#define PUT_PIXEL(_a)                                                                                                                                          \
+	{                                                                                                                                                          \
+		{                                                                                                                                                      \
+			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
+			if (ZCMPSIMP(zz, pz[_a], _a, 0)) {                                                                                                                 \
+				pp[_a] = color;                                                                                                                                \
+				if (zbdw)                                                                                                                                      \
+					pz[_a] = zz;                                                                                                                               \
+			}                                                                                                                                                  \
+		}                                                                                                                                                      \
+		z += dzdx;                                                                                                                                             \
+	}
+
+#if TGL_FEATURE_SIMD_SPANS == 1
+#define PUT_SPAN()                                                                                                                                             \
+	if (zbspan && n >= 7) {                                                                                                                                    \
+		register GLint done = zbspan(pp, pz, n + 1, z, dzdx, color, ZB_DEPTH_SPAN_ZBDT, zbdw);                                                                 \
+		pp += done;                                                                                                                                            \
+		pz += done;                                                                                                                                            \
+		z += done * dzdx;                                                                                                                                      \
+		n -= done;                                                                                                                                             \
+	}
+#endif
+
+#include "ztriangle.h"
+}
+
+/*
+ * Depth only triangle, for glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, ...).
+ * Only z is interpolated, and the caller skips it entirely when depth writes are off.
+ */
+
+ZB_DEPTH_KERNEL(ZB_fillTriangleDepthOnly)(ZBuffer* zb, ZBufferPoint* p0, ZBufferPoint* p1, ZBufferPoint* p2) {
+	TGL_DEPTHVARS
+	TGL_STIPPLEVARS
+	TGL_SPANVARS(ZB_spanDepthFunc, span_depth)
+#undef INTERP_Z
+#undef INTERP_RGB
+#undef INTERP_ST
+#undef INTERP_STZ
+#define INTERP_Z
+
+#define DRAW_INIT()                                                                                                                                            \
+	{}
+
+#define PUT_PIXEL(_a)                                                                                                                                          \
+	{                                                                                                                                                          \
+		{                                                                                                                                                      \
+			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
+			if (ZCMPSIMP(zz, pz[_a], _a, 0))                                                                                                                   \
+				pz[_a] = zz;                                                                                                                                   \
+		}                                                                                                                                                      \
+		z += dzdx;                                                                                                                                             \
+	}
+
+#if TGL_FEATURE_SIMD_SPANS == 1
+#define PUT_SPAN()                                                                                                                                             \
+	if (zbspan && n >= 7) {                                                                                                                                    \
+		register GLint done = zbspan(pz, n + 1, z, dzdx, ZB_DEPTH_SPAN_ZBDT);                                                                                  \
+		pp += done;                                                                                                                                            \
+		pz += done;                                                                                                                                            \
+		z += done * dzdx;                                                                                                                                      \
+		n -= done;                                                                                                                                             \
+	}
+#endif
+
+#include "ztriangle.h"
+}
+
+/*
+ * Smooth filled triangle.
+ * The code below is very tricky :)
+ */
+
+ZB_DEPTH_KERNEL(ZB_fillTriangleSmooth)(ZBuffer* zb, ZBufferPoint* p0, ZBufferPoint* p1, ZBufferPoint* p2) {
+	GLubyte zbdw = zb->depth_write;
+	TGL_DEPTHVARS
+	TGL_BLEND_VARS
+	TGL_STIPPLEVARS
+	TGL_BLENDSPANVARS
+
+#define INTERP_Z
+#define INTERP_RGB
+#define INTERP_ALPHA
+
+#define SAR_RND_TO_ZERO(v, n) (v / (1 << n))
+
+#if TGL_FEATURE_RENDER_BITS == 32
+#define DRAW_INIT()                                                                                                                                            \
+	{}
+#define PUT_PIXEL(_a)                                                                                                                                          \
+	{                                                                                                                                                          \
+		{                                                                                                                                                      \
+			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
+			if (ZCMPSIMP(zz, pz[_a], _a, 0)) {                                                                                                                 \
+				/*pp[_a] = RGB_TO_PIXEL(or1, og1, ob1);*/                                                                                                      \
+				TGL_BLEND_FUNC_RGB(or1, og1, ob1, ZB_ALPHA(oa1), (pp[_a]));                                                                                    \
+				if (zbdw)                                                                                                                                      \
+					pz[_a] = zz;                                                                                                                               \
+			}                                                                                                                                                  \
+		}                                                                                                                                                      \
+		z += dzdx;                                                                                                                                             \
+		og1 += dgdx;                                                                                                                                           \
+		or1 += drdx;                                                                                                                                           \
+		ob1 += dbdx;                                                                                                                                           \
+		oa1 += dadx;                                                                                                                                           \
+	}
+
+
+#elif TGL_FEATURE_RENDER_BITS == 16
+
+#define DRAW_INIT()                                                                                                                                            \
+	{}
+
+#define PUT_PIXEL(_a)                                                                                                                                          \
+	{                                                                                                                                                          \
+		{                                                                                                                                                      \
+			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
+			if (ZCMPSIMP(zz, pz[_a], _a, 0)) {                                                                                                                 \
+				/*pp[_a] = RGB_TO_PIXEL(or1, og1, ob1);*/                                                                                                      \
+				TGL_BLEND_FUNC_RGB(or1, og1, ob1, ZB_ALPHA(oa1), (pp[_a]));                                                                                    \
+                                                                                                                                                               \
+				if (zbdw)                                                                                                                                      \
+					pz[_a] = zz;                                                                                                                               \
+			}                                                                                                                                                  \
+		}                                                                                                                                                      \
+		z += dzdx;                                                                                                                                             \
+		og1 += dgdx;                                                                                                                                           \
+		or1 += drdx;                                                                                                                                           \
+		ob1 += dbdx;                                                                                                                                           \
+		oa1 += dadx;                                                                                                                                           \
+	}
+
+#endif
+
+#if TGL_FEATURE_SIMD_SPANS == 1 && TGL_FEATURE_BLEND == 1
+#define PUT_SPAN()                                                                                                                                             \
+	if (zbspan && n >= 7) {                                                                                                                                    \
+		register GLint done = zbspan(pp, pz, n + 1, z, dzdx, or1, og1, ob1, oa1, drdx, dgdx, dbdx, dadx, ZB_DEPTH_SPAN_ZBDT, zbdw);                            \
+		pp += done;                                                                                                                                            \
+		pz += done;                                                                                                                                            \
+		z += done * dzdx;                                                                                                                                      \
+		or1 += done * drdx;                                                                                                                                    \
+		og1 += done * dgdx;                                                                                                                                    \
+		ob1 += done * dbdx;                                                                                                                                    \
+		oa1 += done * dadx;                                                                                                                                    \
+		n -= done;                                                                                                                                             \
+	}
+#endif
+
+#include "ztriangle.h"
+} 
+
+ZB_DEPTH_KERNEL(ZB_fillTriangleSmoothNOBLEND)(ZBuffer* zb, ZBufferPoint* p0, ZBufferPoint* p1, ZBufferPoint* p2) {
+
+	GLubyte zbdw = zb->depth_write;
+	TGL_DEPTHVARS
+	TGL_STIPPLEVARS
+	TGL_SPANVARS(ZB_spanSmoothFunc, span_smooth)
+
+#define INTERP_Z
+#define INTERP_RGB
+#define INTERP_ALPHA
+
+#define SAR_RND_TO_ZERO(v, n) (v / (1 << n))
+
+#if TGL_FEATURE_RENDER_BITS == 32
+#define DRAW_INIT()                                                                                                                                            \
+	{}
+
+#if TGL_FEATURE_NO_DRAW_COLOR != 1
+#define PUT_PIXEL(_a)                                                                                                                                          \
+	{                                                                                                                                                          \
+		{                                                                                                                                                      \
+			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
+			if (ZCMPSIMP(zz, pz[_a], _a, 0)) {                                                                                                                 \
+				pp[_a] = RGBA_TO_PIXEL(or1, og1, ob1, ZB_ALPHA(oa1));                                                                                          \
+				if (zbdw)                                                                                                                                      \
+					pz[_a] = zz;                                                                                                                               \
+			}                                                                                                                                                  \
+		}                                                                                                                                                      \
+		z += dzdx;                                                                                                                                             \
+		og1 += dgdx;                                                                                                                                           \
+		or1 += drdx;                                                                                                                                           \
+		ob1 += dbdx;                                                                                                                                           \
+		oa1 += dadx;                                                                                                                                           \
+	}
+#else
+#define PUT_PIXEL(_a)                                                                                                                                          \
+	{                                                                                                                                                          \
+		{                                                                                                                                                      \
+			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
+			if (ZCMPSIMP(zz, pz[_a], _a, 0)) {                                                                                                                 \
+				pp[_a] = RGBA_TO_PIXEL(or1, og1, ob1, ZB_ALPHA(oa1));                                                                                          \
+				if (zbdw)                                                                                                                                      \
+					pz[_a] = zz;                                                                                                                               \
+			}                                                                                                                                                  \
+		}                                                                                                                                                      \
+		z += dzdx;                                                                                                                                             \
+		og1 += dgdx;                                                                                                                                           \
+		or1 += drdx;                                                                                                                                           \
+		ob1 += dbdx;                                                                                                                                           \
+		oa1 += dadx;                                                                                                                                           \
+	}
+#endif
+
+#elif TGL_FEATURE_RENDER_BITS == 16
+
+#define DRAW_INIT()                                                                                                                                            \
+	{}
+
+#define PUT_PIXEL(_a)                                                                                                                                          \
+	{                                                                                                                                                          \
+		{                                                                                                                                                      \
+			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
+			if (ZCMPSIMP(zz, pz[_a], _a, 0)) {                                                                                                                 \
+				pp[_a] = RGBA_TO_PIXEL(or1, og1, ob1, ZB_ALPHA(oa1));                                                                                          \
+                                                                                                                                                               \
+				if (zbdw)                                                                                                                                      \
+					pz[_a] = zz;                                                                                                                               \
+			}                                                                                                                                                  \
+		}                                                                                                                                                      \
+		z += dzdx;                                                                                                                                             \
+		og1 += dgdx;                                                                                                                                           \
+		or1 += drdx;                                                                                                                                           \
+		ob1 += dbdx;                                                                                                                                           \
+		oa1 += dadx;                                                                                                                                           \
+	}
+
+#endif
+/* End of 16 bit mode stuff*/
+#if TGL_FEATURE_SIMD_SPANS == 1
+#define PUT_SPAN()                                                                                                                                             \
+	if (zbspan && n >= 7) {                                                                                                                                    \
+		register GLint done = zbspan(pp, pz, n + 1, z, dzdx, or1, og1, ob1, oa1, drdx, dgdx, dbdx, dadx, ZB_DEPTH_SPAN_ZBDT, zbdw);                            \
+		pp += done;                                                                                                                                            \
+		pz += done;                                                                                                                                            \
+		z += done * dzdx;                                                                                                                                      \
+		or1 += done * drdx;                                                                                                                                    \
+		og1 += done * dgdx;                                                                                                                                    \
+		ob1 += done * dbdx;                                                                                                                                    \
+		oa1 += done * dadx;                                                                                                                                    \
+		n -= done;                                                                                                                                             \
+	}
+#endif
+#include "ztriangle.h"
+} 
+
+/*
+
+
+			TEXTURE MAPPED TRIANGLES
+               Section_Header
+
+
+
+
+*/
+
+#define ZB_TEX_KERNEL(name, blend) name##blend
+#define TEXTURE_VARS /* a comment */
+#define TEXTURE_LOD(ss, tt, fdzdy) /* a comment */
+#define TEXTURE_FETCH(s, t) TEXTURE_SAMPLE(texture, s, t)
+#include "ztritex.h"
+
+/* textures of other sizes */
+#define ZB_TEX_KERNEL(name, blend) name##Sized##blend
+#define TEXTURE_VARS GLint texw = zb->texture_xsize, texh = zb->texture_ysize;
+#define TEXTURE_LOD(ss, tt, fdzdy) /* a comment */
+#define TEXTURE_FETCH(s, t) TEXTURE_SIZED_SAMPLE(texture, s, t, texw, texh)
+#include "ztritex.h"
+
+#if TGL_FEATURE_TEXTURE_FILTER == 1
+/* the level and filter are picked per NB_INTERP pixels, or per half-space block row, see ZB_textureLevel */
+#define ZB_TEX_KERNEL(name, blend) name##Filtered##blend
+#define TEXTURE_VARS GLint texw = zb->texture_xsize, texh = zb->texture_ysize, texlinear = 0;
+#define TEXTURE_LOD(ss, tt, fdzdy)                                                                                                                             \
+	texture = ZB_textureLevel(zb, &texw, &texh, &texlinear, (GLfloat)dsdx, (GLfloat)dtdx, (dszdy - (ss) * (fdzdy)) * zinv, (dtzdy - (tt) * (fdzdy)) * zinv)
+#define TEXTURE_FETCH(s, t) (texlinear ? ZB_textureBilinear(texture, s, t, texw, texh) : TEXTURE_SIZED_SAMPLE(texture, s, t, texw, texh))
+#include "ztritex.h"
+#endif
+
+#if TGL_FEATURE_TEXTURE_COMPRESSION == 1
+/* texture points at BC1 blocks, see ZB_textureBC1 */
+#define ZB_TEX_KERNEL(name, blend) name##BC1##blend
+#define TEXTURE_VARS                                                                                                                                           \
+	GLint texw = zb->texture_xsize, texh = zb->texture_ysize;                                                                                                  \
+	ZBBlockCache texcache = {{0}};
+#define TEXTURE_LOD(ss, tt, fdzdy) /* a comment */
+#define TEXTURE_FETCH(s, t) ZB_textureBC1(&texcache, (const GLubyte*)texture, s, t, texw, texh)
+#include "ztritex.h"
+#endif
+
+#if TGL_FEATURE_HALFSPACE_RASTER == 1
+
+/*
+
+			HALF-SPACE TRIANGLES
+               Section_Header
+
+ Same pixel kernels as above, driven by the block based edge function rasterizer in zhalfspace.h.
+ Selected with ZB_setRasterizer(zb, ZB_RASTER_HALFSPACE). The texture mapped ones are in ztritex.h.
+
+*/
+
+ZB_DEPTH_KERNEL(ZB_fillTriangleHalfSpaceFlat)(ZBuffer* zb, ZBufferPoint* p0, ZBufferPoint* p1, ZBufferPoint* p2) {
+	TGL_DEPTHVARS
+	GLubyte zbdw = zb->depth_write;
+	PIXEL color = RGB_TO_PIXEL(p2->r, p2->g, p2->b);
+	TGL_BLEND_VARS
+	TGL_STIPPLEVARS
+#define INTERP_Z
+
+#define DRAW_INIT()                                                                                                                                            \
+	{}
+
+#define PUT_PIXEL(_a)                                                                                                                                          \
+	{                                                                                                                                                          \
+		{                                                                                                                                                      \
+			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
+			if (ZCMPSIMP(zz, pz[_a], _a, 0)) {                                                                                                                 \
+				TGL_BLEND_FUNC(color, ZB_ALPHA(p2->a), (pp[_a]))                                                                                               \
+				if (zbdw)                                                                                                                                      \
+					pz[_a] = zz;                                                                                                                               \
+			}                                                                                                                                                  \
+		}                                                                                                                                                      \
+		z += dzdx;                                                                                                                                             \
+	}
+
+#include "zhalfspace.h"
+}
+
+ZB_DEPTH_KERNEL(ZB_fillTriangleHalfSpaceFlatNOBLEND)(ZBuffer* zb, ZBufferPoint* p0, ZBufferPoint* p1, ZBufferPoint* p2) {
+	TGL_DEPTHVARS
+	GLubyte zbdw = zb->depth_write;
+	PIXEL color = RGBA_TO_PIXEL(p2->r, p2->g, p2->b, ZB_ALPHA(p2->a));
+	TGL_STIPPLEVARS
+#define INTERP_Z
+
+#define DRAW_INIT()                                                                                                                                            \
+	{}
+
+#define PUT_PIXEL(_a)                                                                                                                                          \
+	{                                                                                                                                                          \
+		{                                                                                                                                                      \
+			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
+			if (ZCMPSIMP(zz, pz[_a], _a, 0)) {                                                                                                                 \
+				pp[_a] = color;                                                                                                                                \
+				if (zbdw)                                                                                                                                      \
+					pz[_a] = zz;                                                                                                                               \
+			}                                                                                                                                                  \
+		}                                                                                                                                                      \
+		z += dzdx;                                                                                                                                             \
+	}
+
+#include "zhalfspace.h"
+}
+
+ZB_DEPTH_KERNEL(ZB_fillTriangleHalfSpaceDepthOnly)(ZBuffer* zb, ZBufferPoint* p0, ZBufferPoint* p1, ZBufferPoint* p2) {
+	TGL_DEPTHVARS
+	TGL_STIPPLEVARS
+#undef INTERP_Z
+#undef INTERP_RGB
+#undef INTERP_ST
+#undef INTERP_STZ
+#define INTERP_Z
+
+#define DRAW_INIT()                                                                                                                                            \
+	{}
+
+#define PUT_PIXEL(_a)                                                                                                                                          \
+	{                                                                                                                                                          \
+		{                                                                                                                                                      \
+			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
+			if (ZCMPSIMP(zz, pz[_a], _a, 0))                                                                                                                   \
+				pz[_a] = zz;                                                                                                                                   \
+		}                                                                                                                                                      \
+		z += dzdx;                                                                                                                                             \
+	}
+
+#include "zhalfspace.h"
+}
+
+ZB_DEPTH_KERNEL(ZB_fillTriangleHalfSpaceSmooth)(ZBuffer* zb, ZBufferPoint* p0, ZBufferPoint* p1, ZBufferPoint* p2) {
+	GLubyte zbdw = zb->depth_write;
+	TGL_DEPTHVARS
+	TGL_BLEND_VARS
+	TGL_STIPPLEVARS
+#define INTERP_Z
+#define INTERP_RGB
+#define INTERP_ALPHA
+
+#define DRAW_INIT()                                                                                                                                            \
+	{}
+
+#define PUT_PIXEL(_a)                                                                                                                                          \
+	{                                                                                                                                                          \
+		{                                                                                                                                                      \
+			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
+			if (ZCMPSIMP(zz, pz[_a], _a, 0)) {                                                                                                                 \
+				TGL_BLEND_FUNC_RGB(or1, og1, ob1, ZB_ALPHA(oa1), (pp[_a]));                                                                                    \
+				if (zbdw)                                                                                                                                      \
+					pz[_a] = zz;                                                                                                                               \
+			}                                                                                                                                                  \
+		}                                                                                                                                                      \
+		z += dzdx;                                                                                                                                             \
+		og1 += dgdx;                                                                                                                                           \
+		or1 += drdx;                                                                                                                                           \
+		ob1 += dbdx;                                                                                                                                           \
+		oa1 += dadx;                                                                                                                                           \
+	}
+
+#include "zhalfspace.h"
+}
+
+ZB_DEPTH_KERNEL(ZB_fillTriangleHalfSpaceSmoothNOBLEND)(ZBuffer* zb, ZBufferPoint* p0, ZBufferPoint* p1, ZBufferPoint* p2) {
+	GLubyte zbdw = zb->depth_write;
+	TGL_DEPTHVARS
+	TGL_STIPPLEVARS
+#define INTERP_Z
+#define INTERP_RGB
+#define INTERP_ALPHA
+
+#define DRAW_INIT()                                                                                                                                            \
+	{}
+
+#define PUT_PIXEL(_a)                                                                                                                                          \
+	{                                                                                                                                                          \
+		{                                                                                                                                                      \
+			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
+			if (ZCMPSIMP(zz, pz[_a], _a, 0)) {                                                                                                                 \
+				pp[_a] = RGBA_TO_PIXEL(or1, og1, ob1, ZB_ALPHA(oa1));                                                                                          \
+				if (zbdw)                                                                                                                                      \
+					pz[_a] = zz;                                                                                                                               \
+			}                                                                                                                                                  \
+		}                                                                                                                                                      \
+		z += dzdx;                                                                                                                                             \
+		og1 += dgdx;                                                                                                                                           \
+		or1 += drdx;                                                                                                                                           \
+		ob1 += dbdx;                                                                                                                                           \
+		oa1 += dadx;                                                                                                                                           \
+	}
+
+#include "zhalfspace.h"
+}
+
+#endif
+
+#undef ZB_DEPTH_KERNEL
+#undef TGL_DEPTHVARS
+#undef ZB_DEPTH_TEST
+#undef ZB_DEPTH_SPANS
+#undef ZB_DEPTH_SPAN_ZBDT
@@ -0,0 +1,420 @@
+/*
+ * Perspective correct texture mapped triangles, for both rasterizers.
+ *
+ * Included by ztrifill.h once for the unfiltered kernels, and once more for the filtered ones
+ * when TGL_FEATURE_TEXTURE_FILTER is enabled. The includer defines:
+ * ZB_TEX_KERNEL(name, blend) the name of a kernel, blend is NOBLEND or empty
+ * TEXTURE_VARS               the sampler state of a triangle
+ * TEXTURE_LOD(ss, tt, fdzdy) run whenever s, t, dsdx and dtdx are recomputed, i.e. once per NB_INTERP pixels
+ *                            on a scanline or once per half-space block row
+ * TEXTURE_FETCH(s, t)        the texel at s, t
+ */
+
+#define DRAW_LINE_TRI_TEXTURED()                                                                                                                               \
+	{                                                                                                                                                          \
+		register ZPIXEL* pz;                                                                                                                                   \
+		register PIXEL* pp;                                                                                                                                    \
+		register GLuint s, t, z;                                                                                                                               \
+		register GLint n;                                                                                                                                      \
+		OR1OG1OB1DECL                                                                                                                                          \
+		GLfloat sz, tz, fzl, zinv;                                                                                                                             \
+		n = (x2 >> 16) - x1;                                                                                                                                   \
+		fzl = (GLfloat)z1;                                                                                                                                     \
+		zinv = 1.0 / fzl;                                                                                                                                      \
+		pp = (PIXEL*)((GLbyte*)pp1 + x1 * PSZB);                                                                                                               \
+		pz = pz1 + x1;                                                                                                                                         \
+		z = z1;                                                                                                                                                \
+		sz = sz1;                                                                                                                                              \
+		tz = tz1;                                                                                                                                              \
+		if ((x2 >> 16) > cxmax)                                                                                                                                \
+			n -= (x2 >> 16) - cxmax;                                                                                                                           \
+		if (x1 < cxmin) {                                                                                                                                      \
+			/* step over the scissored pixels exactly like the loops below would */                                                                            \
+			register GLint skip = cxmin - x1;                                                                                                                  \
+			while (skip >= NB_INTERP) {                                                                                                                        \
+				fzl += fndzdx;                                                                                                                                 \
+				pz += NB_INTERP;                                                                                                                               \
+				pp += NB_INTERP;                                                                                                                               \
+				z += NB_INTERP * dzdx;                                                                                                                         \
+				OR1G1B1SKIP(NB_INTERP)                                                                                                                         \
+				n -= NB_INTERP;                                                                                                                                \
+				skip -= NB_INTERP;                                                                                                                             \
+				sz += ndszdx;                                                                                                                                  \
+				tz += ndtzdx;                                                                                                                                  \
+			}                                                                                                                                                  \
+			zinv = 1.0 / fzl;                                                                                                                                  \
+			if (skip) {                                                                                                                                        \
+				register GLint dsdx, dtdx;                                                                                                                     \
+				{                                                                                                                                              \
+					GLfloat ss, tt;                                                                                                                            \
+					ss = (sz * zinv);                                                                                                                          \
+					tt = (tz * zinv);                                                                                                                          \
+					s = (GLint)ss;                                                                                                                             \
+					t = (GLint)tt;                                                                                                                             \
+					dsdx = (GLint)((dszdx - ss * fdzdx) * zinv);                                                                                               \
+					dtdx = (GLint)((dtzdx - tt * fdzdx) * zinv);                                                                                               \
+					TEXTURE_LOD(ss, tt, (GLfloat)dzdy);                                                                                                        \
+				}                                                                                                                                              \
+				pz += skip;                                                                                                                                    \
+				pp += skip;                                                                                                                                    \
+				z += skip * dzdx;                                                                                                                              \
+				s += skip * dsdx;                                                                                                                              \
+				t += skip * dtdx;                                                                                                                              \
+				OR1G1B1SKIP(skip)                                                                                                                              \
+				n -= skip;                                                                                                                                     \
+				for (skip = NB_INTERP - skip; skip > 0 && n >= 0; skip--) {                                                                                    \
+					PUT_PIXEL(0);                                                                                                                              \
+					pz += 1;                                                                                                                                   \
+					pp++;                                                                                                                                      \
+					n -= 1;                                                                                                                                    \
+				}                                                                                                                                              \
+				fzl += fndzdx;                                                                                                                                 \
+				zinv = 1.0 / fzl;                                                                                                                              \
+				sz += ndszdx;                                                                                                                                  \
+				tz += ndtzdx;                                                                                                                                  \
+			}                                                                                                                                                  \
+		}                                                                                                                                                      \
+		while (n >= (NB_INTERP - 1)) {                                                                                                                         \
+			register GLint dsdx, dtdx;                                                                                                                         \
+			{                                                                                                                                                  \
+				GLfloat ss, tt;                                                                                                                                \
+				ss = (sz * zinv);                                                                                                                              \
+				tt = (tz * zinv);                                                                                                                              \
+				s = (GLint)ss;                                                                                                                                 \
+				t = (GLint)tt;                                                                                                                                 \
+				dsdx = (GLint)((dszdx - ss * fdzdx) * zinv);                                                                                                   \
+				dtdx = (GLint)((dtzdx - tt * fdzdx) * zinv);                                                                                                   \
+				TEXTURE_LOD(ss, tt, (GLfloat)dzdy);                                                                                                            \
+			}                                                                                                                                                  \
+			fzl += fndzdx;                                                                                                                                     \
+			zinv = 1.0 / fzl;                                                                                                                                  \
+			PUT_PIXEL(0); /*the_x++;*/                                                                                                                         \
+			PUT_PIXEL(1); /*the_x++;*/                                                                                                                         \
+			PUT_PIXEL(2); /*the_x++;*/                                                                                                                         \
+			PUT_PIXEL(3); /*the_x++;*/                                                                                                                         \
+			PUT_PIXEL(4); /*the_x++;*/                                                                                                                         \
+			PUT_PIXEL(5); /*the_x++;*/                                                                                                                         \
+			PUT_PIXEL(6); /*the_x++;*/                                                                                                                         \
+			PUT_PIXEL(7); /*the_x-=7;*/                                                                                                                        \
+			pz += NB_INTERP;                                                                                                                                   \
+			pp += NB_INTERP; /*the_x+=NB_INTERP * PSZB;*/                                                                                                      \
+			n -= NB_INTERP;                                                                                                                                    \
+			sz += ndszdx;                                                                                                                                      \
+			tz += ndtzdx;                                                                                                                                      \
+		}                                                                                                                                                      \
+		{                                                                                                                                                      \
+			register GLint dsdx, dtdx;                                                                                                                         \
+			{                                                                                                                                                  \
+				GLfloat ss, tt;                                                                                                                                \
+				ss = (sz * zinv);                                                                                                                              \
+				tt = (tz * zinv);                                                                                                                              \
+				s = (GLint)ss;                                                                                                                                 \
+				t = (GLint)tt;                                                                                                                                 \
+				dsdx = (GLint)((dszdx - ss * fdzdx) * zinv);                                                                                                   \
+				dtdx = (GLint)((dtzdx - tt * fdzdx) * zinv);                                                                                                   \
+				TEXTURE_LOD(ss, tt, (GLfloat)dzdy);                                                                                                            \
+			}                                                                                                                                                  \
+			while (n >= 0) {                                                                                                                                   \
+				PUT_PIXEL(0);                                                                                                                                  \
+				pz += 1;                                                                                                                                       \
+				/*pp = (PIXEL*)((GLbyte*)pp + PSZB);*/                                                                                                         \
+				pp++;                                                                                                                                          \
+				n -= 1;                                                                                                                                        \
+			}                                                                                                                                                  \
+		}                                                                                                                                                      \
+	} 
+
+ZB_DEPTH_KERNEL(ZB_TEX_KERNEL(ZB_fillTriangleMappingPerspective, ))(ZBuffer* zb, ZBufferPoint* p0, ZBufferPoint* p1, ZBufferPoint* p2) {
+	PIXEL* texture;
+	TEXTURE_VARS
+
+	GLubyte zbdw = zb->depth_write;
+	TGL_DEPTHVARS
+	TGL_BLEND_VARS
+	TGL_STIPPLEVARS
+#define INTERP_Z
+#define INTERP_STZ
+#define INTERP_RGB
+
+
+#define NB_INTERP 8
+
+#define DRAW_INIT()                                                                                                                                            \
+	{                                                                                                                                                          \
+		texture = zb->current_texture;                                                                                                                         \
+		fdzdx = (GLfloat)dzdx;                                                                                                                                 \
+		fndzdx = NB_INTERP * fdzdx;                                                                                                                            \
+		ndszdx = NB_INTERP * dszdx;                                                                                                                            \
+		ndtzdx = NB_INTERP * dtzdx;                                                                                                                            \
+	}
+#if TGL_FEATURE_LIT_TEXTURES == 1
+#define INTERP_ALPHA
+#define OR1OG1OB1DECL                                                                                                                                          \
+	register GLint or1, og1, ob1, oa1;                                                                                                                         \
+	or1 = r1;                                                                                                                                                  \
+	og1 = g1;                                                                                                                                                  \
+	ob1 = b1;                                                                                                                                                  \
+	oa1 = a1;
+#define OR1G1B1INCR                                                                                                                                            \
+	og1 += dgdx;                                                                                                                                               \
+	or1 += drdx;                                                                                                                                               \
+	ob1 += dbdx;                                                                                                                                               \
+	oa1 += dadx;
+#define OR1G1B1SKIP(_n)                                                                                                                                        \
+	og1 += (_n) * dgdx;                                                                                                                                        \
+	or1 += (_n) * drdx;                                                                                                                                        \
+	ob1 += (_n) * dbdx;                                                                                                                                        \
+	oa1 += (_n) * dadx;
+#else
+#define OR1OG1OB1DECL /*A comment*/
+#define OR1G1B1INCR   /*Another comment*/
+#define OR1G1B1SKIP(_n) /*Another comment*/
+#define or1 COLOR_MULT_MASK
+#define og1 COLOR_MULT_MASK
+#define ob1 COLOR_MULT_MASK
+#define oa1 COLOR_CORRECTED_MULT_MASK
+#endif
+#if TGL_FEATURE_NO_DRAW_COLOR != 1
+
+#define PUT_PIXEL(_a)                                                                                                                                          \
+	{                                                                                                                                                          \
+		{                                                                                                                                                      \
+			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
+			if (ZCMPSIMP(zz, pz[_a], _a, 0)) {                                                                                                                 \
+				PIXEL c = TEXTURE_FETCH(s, t);                                                                                                                 \
+				TGL_BLEND_FUNC(RGB_MIX_FUNC(or1, og1, ob1, c), TGL_MUL255(ZB_ALPHA(oa1), GET_ALPHA(c)), (pp[_a]));                                             \
+				if (zbdw)                                                                                                                                      \
+					pz[_a] = zz;                                                                                                                               \
+			}                                                                                                                                                  \
+		}                                                                                                                                                      \
+		z += dzdx;                                                                                                                                             \
+		s += dsdx;                                                                                                                                             \
+		t += dtdx;                                                                                                                                             \
+		OR1G1B1INCR                                                                                                                                            \
+	}
+#else
+#define PUT_PIXEL(_a)                                                                                                                                          \
+	{                                                                                                                                                          \
+		{                                                                                                                                                      \
+			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
+			PIXEL c = TEXTURE_FETCH(s, t);                                                                                                                     \
+			if (ZCMP(zz, pz[_a], _a, c)) {                                                                                                                     \
+				TGL_BLEND_FUNC(RGB_MIX_FUNC(or1, og1, ob1, c), TGL_MUL255(ZB_ALPHA(oa1), GET_ALPHA(c)), (pp[_a]));                                             \
+				if (zbdw)                                                                                                                                      \
+					pz[_a] = zz;                                                                                                                               \
+			}                                                                                                                                                  \
+		}                                                                                                                                                      \
+		z += dzdx;                                                                                                                                             \
+		s += dsdx;                                                                                                                                             \
+		t += dtdx;                                                                                                                                             \
+		OR1G1B1INCR                                                                                                                                            \
+	}
+#endif
+#define DRAW_LINE()                                                                                                                                            \
+	{ DRAW_LINE_TRI_TEXTURED() }
+
+#include "ztriangle.h"
+#if TGL_FEATURE_LIT_TEXTURES != 1
+#undef or1
+#undef og1
+#undef ob1
+#undef oa1
+#endif
+}
+
+ZB_DEPTH_KERNEL(ZB_TEX_KERNEL(ZB_fillTriangleMappingPerspective, NOBLEND))(ZBuffer* zb, ZBufferPoint* p0, ZBufferPoint* p1, ZBufferPoint* p2) {
+	PIXEL* texture;
+	TEXTURE_VARS
+	
+	GLubyte zbdw = zb->depth_write;
+	TGL_DEPTHVARS
+	TGL_STIPPLEVARS
+#define INTERP_Z
+#define INTERP_STZ
+#define INTERP_RGB
+
+#define NB_INTERP 8
+
+#define DRAW_INIT()                                                                                                                                            \
+	{                                                                                                                                                          \
+		texture = zb->current_texture;                                                                                                                         \
+		fdzdx = (GLfloat)dzdx;                                                                                                                                 \
+		fndzdx = NB_INTERP * fdzdx;                                                                                                                            \
+		ndszdx = NB_INTERP * dszdx;                                                                                                                            \
+		ndtzdx = NB_INTERP * dtzdx;                                                                                                                            \
+	}
+#if TGL_FEATURE_LIT_TEXTURES == 1
+#define INTERP_ALPHA
+#define OR1OG1OB1DECL                                                                                                                                          \
+	register GLint or1, og1, ob1, oa1;                                                                                                                         \
+	or1 = r1;                                                                                                                                                  \
+	og1 = g1;                                                                                                                                                  \
+	ob1 = b1;                                                                                                                                                  \
+	oa1 = a1;
+#define OR1G1B1INCR                                                                                                                                            \
+	og1 += dgdx;                                                                                                                                               \
+	or1 += drdx;                                                                                                                                               \
+	ob1 += dbdx;                                                                                                                                               \
+	oa1 += dadx;
+#define OR1G1B1SKIP(_n)                                                                                                                                        \
+	og1 += (_n) * dgdx;                                                                                                                                        \
+	or1 += (_n) * drdx;                                                                                                                                        \
+	ob1 += (_n) * dbdx;                                                                                                                                        \
+	oa1 += (_n) * dadx;
+#else
+#define OR1OG1OB1DECL /*A comment*/
+#define OR1G1B1INCR   /*Another comment*/
+#define OR1G1B1SKIP(_n) /*Another comment*/
+#define or1 COLOR_MULT_MASK
+#define og1 COLOR_MULT_MASK
+#define ob1 COLOR_MULT_MASK
+#define oa1 COLOR_CORRECTED_MULT_MASK
+#endif
+#if TGL_FEATURE_NO_DRAW_COLOR != 1
+#define PUT_PIXEL(_a)                                                                                                                                          \
+	{                                                                                                                                                          \
+		{                                                                                                                                                      \
+			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
+			if (ZCMPSIMP(zz, pz[_a], _a, 0)) {                                                                                                                 \
+				pp[_a] = RGBA_MIX_FUNC(or1, og1, ob1, ZB_ALPHA(oa1), TEXTURE_FETCH(s, t));                                                                     \
+				if (zbdw)                                                                                                                                      \
+					pz[_a] = zz;                                                                                                                               \
+			}                                                                                                                                                  \
+		}                                                                                                                                                      \
+		z += dzdx;                                                                                                                                             \
+		s += dsdx;                                                                                                                                             \
+		t += dtdx;                                                                                                                                             \
+		OR1G1B1INCR                                                                                                                                            \
+	}
+#else
+#define PUT_PIXEL(_a)                                                                                                                                          \
+	{                                                                                                                                                          \
+		{                                                                                                                                                      \
+			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
+			PIXEL c = TEXTURE_FETCH(s, t);                                                                                                                     \
+			if (ZCMP(zz, pz[_a], _a, c)) {                                                                                                                     \
+				pp[_a] = RGBA_MIX_FUNC(or1, og1, ob1, ZB_ALPHA(oa1), c);                                                                                       \
+				if (zbdw)                                                                                                                                      \
+					pz[_a] = zz;                                                                                                                               \
+			}                                                                                                                                                  \
+		}                                                                                                                                                      \
+		z += dzdx;                                                                                                                                             \
+		s += dsdx;                                                                                                                                             \
+		t += dtdx;                                                                                                                                             \
+		OR1G1B1INCR                                                                                                                                            \
+	}
+#endif
+#define DRAW_LINE()                                                                                                                                            \
+	{ DRAW_LINE_TRI_TEXTURED() }
+#include "ztriangle.h"
+#if TGL_FEATURE_LIT_TEXTURES != 1
+#undef or1
+#undef og1
+#undef ob1
+#undef oa1
+#endif
+}
+
+#if TGL_FEATURE_HALFSPACE_RASTER == 1
+
+ZB_DEPTH_KERNEL(ZB_TEX_KERNEL(ZB_fillTriangleHalfSpaceMappingPerspective, ))(ZBuffer* zb, ZBufferPoint* p0, ZBufferPoint* p1, ZBufferPoint* p2) {
+	PIXEL* texture;
+	TEXTURE_VARS
+	GLubyte zbdw = zb->depth_write;
+	TGL_DEPTHVARS
+	TGL_BLEND_VARS
+	TGL_STIPPLEVARS
+#define INTERP_Z
+#define INTERP_STZ
+#if TGL_FEATURE_LIT_TEXTURES == 1
+#define INTERP_RGB
+#define INTERP_ALPHA
+#else
+#define or1 COLOR_MULT_MASK
+#define og1 COLOR_MULT_MASK
+#define ob1 COLOR_MULT_MASK
+#define oa1 COLOR_CORRECTED_MULT_MASK
+#endif
+
+#define DRAW_INIT()                                                                                                                                            \
+	{ texture = zb->current_texture; }
+
+#define PUT_PIXEL(_a)                                                                                                                                          \
+	{                                                                                                                                                          \
+		{                                                                                                                                                      \
+			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
+			PIXEL c = TEXTURE_FETCH(s, t);                                                                                                                     \
+			if (ZCMP(zz, pz[_a], _a, c)) {                                                                                                                     \
+				TGL_BLEND_FUNC(RGB_MIX_FUNC(or1, og1, ob1, c), TGL_MUL255(ZB_ALPHA(oa1), GET_ALPHA(c)), (pp[_a]));                                             \
+				if (zbdw)                                                                                                                                      \
+					pz[_a] = zz;                                                                                                                               \
+			}                                                                                                                                                  \
+		}                                                                                                                                                      \
+		z += dzdx;                                                                                                                                             \
+		s += dsdx;                                                                                                                                             \
+		t += dtdx;                                                                                                                                             \
+		OR1G1B1INCR                                                                                                                                            \
+	}
+
+#include "zhalfspace.h"
+#if TGL_FEATURE_LIT_TEXTURES != 1
+#undef or1
+#undef og1
+#undef ob1
+#undef oa1
+#endif
+}
+
+ZB_DEPTH_KERNEL(ZB_TEX_KERNEL(ZB_fillTriangleHalfSpaceMappingPerspective, NOBLEND))(ZBuffer* zb, ZBufferPoint* p0, ZBufferPoint* p1, ZBufferPoint* p2) {
+	PIXEL* texture;
+	TEXTURE_VARS
+	GLubyte zbdw = zb->depth_write;
+	TGL_DEPTHVARS
+	TGL_STIPPLEVARS
+#define INTERP_Z
+#define INTERP_STZ
+#if TGL_FEATURE_LIT_TEXTURES == 1
+#define INTERP_RGB
+#define INTERP_ALPHA
+#else
+#define or1 COLOR_MULT_MASK
+#define og1 COLOR_MULT_MASK
+#define ob1 COLOR_MULT_MASK
+#define oa1 COLOR_CORRECTED_MULT_MASK
+#endif
+
+#define DRAW_INIT()                                                                                                                                            \
+	{ texture = zb->current_texture; }
+
+#define PUT_PIXEL(_a)                                                                                                                                          \
+	{                                                                                                                                                          \
+		{                                                                                                                                                      \
+			register GLuint zz = z >> ZB_POINT_Z_FRAC_BITS;                                                                                                    \
+			PIXEL c = TEXTURE_FETCH(s, t);                                                                                                                     \
+			if (ZCMP(zz, pz[_a], _a, c)) {                                                                                                                     \
+				pp[_a] = RGBA_MIX_FUNC(or1, og1, ob1, ZB_ALPHA(oa1), c);                                                                                       \
+				if (zbdw)                                                                                                                                      \
+					pz[_a] = zz;                                                                                                                               \
+			}                                                                                                                                                  \
+		}                                                                                                                                                      \
+		z += dzdx;                                                                                                                                             \
+		s += dsdx;                                                                                                                                             \
+		t += dtdx;                                                                                                                                             \
+		OR1G1B1INCR                                                                                                                                            \
+	}
+
+#include "zhalfspace.h"
+#if TGL_FEATURE_LIT_TEXTURES != 1
+#undef or1
+#undef og1
+#undef ob1
+#undef oa1
+#endif
+}
+
+#endif
+
+#undef ZB_TEX_KERNEL
+#undef TEXTURE_VARS
+#undef TEXTURE_LOD
+#undef TEXTURE_FETCH